@@ -16,8 +16,49 @@
 #endif
 
 #define AUTOTUNE_GRID 1
+#ifndef BLOCK_SIZE
 #define BLOCK_SIZE 2048
-#define CACHE_LINE 48
+#endif
+#define CACHE_LINE 256
+#define CACHE_LOOKAHEAD 4
+#define CACHE_RETRY 1000
+#define CACHE_RUN 8
+#define STREAM_NUM 4
+#ifndef STAGE_SIZE
+#define STAGE_SIZE 4194304
+#endif
+#define STAGE_NUM 2
+#ifndef DISK_CACHE
+#define DISK_CACHE 4294967296
+#endif
+#define CJ_FILE_MAGIC "CJMATRIX"
+#define CJ_FILE_VERSION 1
+#define CJ_FILE_ALIGN 65536
+#define TILE_ALIGN_PAGE 4096
+#define TILE_ALIGN_LINE 64
+#ifndef REFINE_ITERMAX
+#define REFINE_ITERMAX 30
+#endif
+#ifndef RBT_DEPTH
+#define RBT_DEPTH 2
+#endif
+#ifndef EIG_NB
+#define EIG_NB 64
+#endif
+#define KERNEL_MC 192
+#define KERNEL_KC 256
+#define KERNEL_NC 4080
+#define KERNEL_TB 64
+#define CACHE_BUDGET 0.8
+#define CACHE_SLAB_MIN 12
+#define CACHE_SLAB_CLASS 16
+#ifndef HOST_DEV_MEMORY
+#define HOST_DEV_MEMORY 1073741824
+#endif
+#define LINK_PCI 6.0
+#define LINK_PEER 12.0
+#define LINK_HOST 20.0
+#define LINK_DISK 2.0
 #define MAX_WORKER 8
 #define MAX_DEV 4
 #define MAX_GPU 4
@@ -46,7 +87,7 @@
 
 typedef enum {CJ_RED, CJ_GREEN, CJ_BLUE, CJ_YELLOW, CJ_PURPLE, CJ_ORANGE, CJ_BLACK} cj_Color;
 
-typedef enum {CJ_EVENT, CJ_DISTRIBUTION, CJ_DQUEUE, CJ_TASK, CJ_VERTEX, CJ_EDGE, CJ_MATRIX, CJ_CSC, CJ_SPARSE, CJ_CONSTANT} cj_objType;
+typedef enum {CJ_EVENT, CJ_DISTRIBUTION, CJ_DQUEUE, CJ_TASK, CJ_VERTEX, CJ_EDGE, CJ_MATRIX, CJ_CSC, CJ_SPARSE, CJ_CONSTANT, CJ_FILE} cj_objType;
 
 typedef enum {CJ_DOUBLE, CJ_SINGLE, CJ_COMPLEX, CJ_DCOMPLEX, CJ_INT32, CJ_INT64} cj_eleType;
 
@@ -56,6 +97,12 @@ typedef enum {CJ_TOP, CJ_BOTTOM, CJ_LEFT, CJ_RIGHT} cj_Side;
 
 typedef enum {CJ_TL, CJ_TR, CJ_BL, CJ_BR} cj_Quadrant;
 
+typedef enum {CJ_NOTRANS, CJ_TRANS} cj_Trans;
+
+typedef enum {CJ_LOWER, CJ_UPPER} cj_Uplo;
+
+typedef enum {CJ_NONUNIT, CJ_UNIT} cj_Diag;
+
 typedef enum {ALLOCATED_ONLY, NOTREADY, QUEUED, RUNNING, DONE, CANCELLED} cj_taskStatus;
 
 typedef enum {PRI_HIGH, PRI_LOW} cj_taskPriority;
@@ -65,9 +112,13 @@ typedef enum {TRUE, FALSE} cj_Bool;
 typedef enum {WORKER_SLEEPING, WORKER_RUNNING} cj_workerStatus;
 
 //do we need to add CJ_TASK_SYRK?
-typedef enum {CJ_TASK_GEMM, CJ_TASK_TRSM, CJ_TASK_SYRK, CJ_TASK_POTRF} cj_taskType;
+typedef enum {CJ_TASK_GEMM, CJ_TASK_TRSM, CJ_TASK_TRMM, CJ_TASK_SYRK, CJ_TASK_SYR2K, CJ_TASK_SYMM, CJ_TASK_POTRF, CJ_TASK_GETRF, CJ_TASK_TSTRF, CJ_TASK_GESSM, CJ_TASK_SSSSM, CJ_TASK_GEQRT, CJ_TASK_TPQRT, CJ_TASK_GEMQRT, CJ_TASK_TPMQRT, CJ_TASK_SYTRF, CJ_TASK_TRSMD, CJ_TASK_GEMDM, CJ_TASK_DIAG, CJ_TASK_SYRBT, CJ_TASK_GERBT, CJ_TASK_TRTRI, CJ_TASK_LAUUM, CJ_TASK_LOGDET, CJ_TASK_ROTG, CJ_TASK_ROT, CJ_TASK_TRANS, CJ_TASK_SBTRD, CJ_TASK_STEBZ, CJ_TASK_STEIN, CJ_TASK_ORMTR, CJ_TASK_LOAD, CJ_TASK_STORE, CJ_TASK_COPY} cj_taskType;
 
-typedef enum {CJ_DEV_CPU, CJ_DEV_CUDA, CJ_DEV_MIC} cj_devType;
+/* data layout of a matrix or a matrix file: column major, or each tile contiguous
+ * with the tiles in column major order or in Morton (Z) order */
+typedef enum {CJ_LAYOUT_COLUMN, CJ_LAYOUT_TILE, CJ_LAYOUT_MORTON} cj_layoutType;
+
+typedef enum {CJ_DEV_CPU, CJ_DEV_CUDA, CJ_DEV_MIC, CJ_DEV_HOST} cj_devType;
 
 //run_begin, run_end, fetch_begin, fetch_end, prefetch, wait_prefetch, init, terminate
 typedef enum {CJ_EVENT_TASK_RUN_BEG, CJ_EVENT_TASK_RUN_END, CJ_EVENT_FETCH_BEG, CJ_EVENT_FETCH_END, 
@@ -75,6 +126,15 @@ typedef enum {CJ_EVENT_TASK_RUN_BEG, CJ_EVENT_TASK_RUN_END, CJ_EVENT_FETCH_BEG,
 
 typedef enum {CJ_CACHE_CLEAN, CJ_CACHE_DIRTY} cj_cacheStatus; 
 
+/* data-movement counters, then tasks issued next to others in flight on a device
+ * and the waits between its streams; the last three count bytes */
+typedef enum {CJ_STAT_HIT, CJ_STAT_MISS, CJ_STAT_EVICT, CJ_STAT_WRITE_BACK, CJ_STAT_PREFETCH_HIT, 
+  CJ_STAT_PREFETCH_WASTE, CJ_STAT_OVERLAP, CJ_STAT_STREAM_WAIT, CJ_STAT_H2D, CJ_STAT_D2H, CJ_STAT_D2D, CJ_STAT_NUM} cj_statType;
+
+/* MOESI states of a copy: the owner holds a MODIFIED or OWNED (dirty shared) copy,
+ * an INFLIGHT copy is being transferred and not valid yet */
+typedef enum {CJ_INVALID, CJ_SHARED, CJ_EXCLUSIVE, CJ_OWNED, CJ_MODIFIED, CJ_INFLIGHT} cj_cohState;
+
 /**
  *  Thread mutex
  */ 
@@ -82,15 +142,31 @@ struct lock_s {
   pthread_mutex_t lock;
 };
 
+/* data-movement counters of a device or a matrix, indexed by cj_statType */
+struct stats_s {
+  long long count[CJ_STAT_NUM];
+};
+
 /**
  *  Distribution is used to descripe the locality of an object in the 
  *  distributed memory environment.
  */
 struct distribution_s {
-  cj_Bool avail[MAX_DEV + 1];            /// available device and CPU
+  cj_cohState state[MAX_DEV + 1];        /// coherence state of the copy on device and CPU
+  cj_Bool avail[MAX_DEV + 1];            /// available device and CPU (a valid copy, not in flight)
+  int owner;                             /// location answering for the latest data (0 for CPU)
   struct device_s *device[MAX_DEV + 1];  /// device pointers array
   int line[MAX_DEV + 1];                 /// cache line id array
+  int fanout[MAX_DEV + 1];               /// copies served by each location since the last write
+  int reader[MAX_DEV + 1];               /// transfers in flight reading each copy
   struct lock_s lock;                    /// mutex for modifying the distribution
+  pthread_cond_t arrive;                 /// signaled when a transfer lands
+  cj_Bool prefetched[MAX_DEV + 1];       /// copy brought by a prefetch and not used yet
+  int heat;                              /// transfers of the tile since the last reset
+  struct object_s *tile;                 /// the whole tile, which the copies move
+  struct object_s *lru;                  /// entry of the tile in the LRU queue of the disk tier
+  cj_Bool resident;                      /// tile of a disk-backed matrix held in main memory
+  int nwaiter;                           /// workers waiting for a transfer
 };
 
 /**
@@ -121,6 +197,52 @@ struct matrix_s {
   /* the memory base for the matrix */
   struct matrix_s *base;
   char *buff;
+  /* layout of buff, and the byte offsets of the tiles (tile (i, j) at i + j*mb)
+   * if they are stored contiguously */
+  cj_layoutType layout;
+  size_t *tile_off;
+  /* TRUE if buff is page-locked and can be copied to a device directly */
+  cj_Bool pinned;
+  /* file mapped at buff for a disk-backed matrix (-1 if none), the offset of
+   * the mapping in the file and its length */
+  int fd;
+  size_t map_off;
+  size_t map_len;
+  /* data movement of the tiles, kept by the base matrix */
+  struct stats_s stats;
+};
+
+/**
+ *  Header of a tiled matrix file, followed by the offsets of the tiles in
+ *  column major order (int64_t each) and by the data.
+ */
+struct file_header_s {
+  char magic[8];                         /// CJ_FILE_MAGIC
+  int32_t version;                       /// CJ_FILE_VERSION
+  int32_t eletype;                       /// cj_eleType of the elements
+  int32_t elelen;                        /// element length in bytes
+  int32_t layout;                        /// cj_layoutType of the data
+  int64_t m;                             /// number of rows
+  int64_t n;                             /// number of columns
+  int64_t tile;                          /// tile size
+  int64_t data;                          /// offset of the data, page-aligned
+};
+
+/**
+ *  An open matrix file shared by the tasks loading or storing its tiles.
+ */
+struct file_s {
+  struct file_header_s header;
+  char *name;                            /// name the file was opened with
+  int fd;
+  int mb;                                /// number of tile rows in the file
+  int nb;                                /// number of tile columns in the file
+  int offm;                              /// origin of the file in the matrix
+  int offn;
+  int64_t *offset;                       /// offsets of the tiles
+  cj_Bool store;                         /// TRUE if the tiles are written
+  int remaining;                         /// tasks not done with the file
+  struct file_s *next;                   /// next file with tasks in flight
 };
 
 struct csc_s {
@@ -151,7 +273,8 @@ struct task_s {
   cj_taskType tasktype;
   struct worker_s *worker;
   char name[64];
-  char label[64];
+  /* long enough for the constants and tile indices of the BLAS labels */
+  char label[128];
   int id;
   struct lock_s tsk_lock;
   float cost;
@@ -165,6 +288,15 @@ struct task_s {
   struct object_s *out;
   /* Argument list */
   struct object_s *arg;
+  /* Integer arguments of the kernel, e.g. side, uplo, trans and diag of TRSM */
+  int iarg[4];
+  /* Host function of a task of cj_Lapack_task_function */
+  void (*host) (struct task_s*, struct matrix_s**, char**, int*);
+  /* Pivots of an LU tile task, ordered like the tile they belong to, T of the
+   * block reflector of a QR tile task, column major, ordered like the pivots, the
+   * ldt butterfly weights of an RBT task, or the D of an LDL' tile task */
+  char *t;
+  int ldt;
 /*  
   struct object_s *arg_in;
   struct object_s *arg_out;
@@ -210,6 +342,8 @@ struct object_s {
     struct csc_s    *csc;
     struct sparse_s *sparse;
     struct event_s  *event;
+    struct file_s   *file;
+    struct constant_s *constant;
   };
   struct object_s *prev;
   struct object_s *next;
@@ -218,8 +352,10 @@ struct object_s {
 
 struct profile_s {
   struct object_s *worker_timeline[MAX_WORKER];
+  struct lock_s stats_lock;
 };
 
+
 /* */
 struct autotune_s {
   /* mkl_sgemm... Do we need the mkl_ssyrk routine? */
@@ -248,8 +384,15 @@ struct worker_s {
   int device_id;
   pthread_t threadid;
   struct cj_s *cj_ptr;
-  struct object_s *write_back;
   struct task_s *current_task;
+  /* cache lines pinned by the running task and by the prefetched task */
+  int run_pin[CACHE_LINE];
+  int nrun_pin;
+  int pre_pin[CACHE_LINE];
+  int npre_pin;
+  /* tiles whose prefetch is in flight */
+  struct distribution_s *pre_dist[CACHE_LINE];
+  int npre_dist;
 };
 
 struct schedule_s {
@@ -271,6 +414,7 @@ struct cj_s {
   int nworker;
   int ngpu;
   int nmic;
+  int nhost;
   struct schedule_s schedule;
   struct worker_s **worker;
   struct device_s *device[MAX_DEV];
@@ -282,11 +426,29 @@ struct cache_s {
   /* CJ_CACHE_CLEAN, CJ_CACHE_DIRTY} */
   cj_cacheStatus status[CACHE_LINE];
   struct object_s *obj_ptr[CACHE_LINE];
+  /* memory block of the line, allocated on the first use (0 if none) */
   uintptr_t dev_ptr[CACHE_LINE];
+  /* slab class of the block (-1 if none) and leading dimension of the tile */
+  int slab[CACHE_LINE];
+  int ld[CACHE_LINE];
+  /* line whose block holds this line's tile (-1 if the line has a block of its
+   * own), and number of lines placed in this line's block */
+  int parent[CACHE_LINE];
+  int share[CACHE_LINE];
   char *hos_ptr[CACHE_LINE];
   int last_use[CACHE_LINE];
-  int fifo;
-  size_t line_size;
+  /* number of running or prefetching tasks holding the line */
+  int ref_count[CACHE_LINE];
+  /* logical clock for the LRU replacement */
+  int clock;
+  /* number of queued tasks inspected before evicting a line (0 disables) */
+  int lookahead;
+  /* device memory the cache may hold and memory held now, in bytes */
+  size_t budget;
+  size_t used;
+  /* released blocks kept for reuse, one stack per slab class */
+  uintptr_t free_ptr[CACHE_SLAB_CLASS][CACHE_LINE];
+  int nfree[CACHE_SLAB_CLASS];
 };
 
 struct device_s {
@@ -296,8 +458,26 @@ struct device_s {
   struct cache_s cache;
   int bindid;
   int bandwidth;
+  /* modelled bandwidth (GB/s) from the host (0) and from each device (id + 1), 0 if no direct link */
+  float link[MAX_DEV + 1];
+  /* stream 0 copies, streams 1..STREAM_NUM each run a task in flight holding its cache lines */
+  int stream_next;
+  int stream_line[STREAM_NUM + 1][CACHE_LINE];
+  cj_Bool stream_write[STREAM_NUM + 1][CACHE_LINE];
+  int nstream_line[STREAM_NUM + 1];
+  struct stats_s stats;
+  /* pinned buffers staging copies from pageable memory, in turns */
+  struct lock_s stage_lock;
+  char *stage[STAGE_NUM];
+  /* pinned workspace lent to the kernels of the bound worker */
+  char *work;
+  size_t work_size;
 #ifdef CJ_HAVE_CUDA
-  cudaStream_t stream[2];
+  cudaEvent_t stage_event[STAGE_NUM];
+  cudaStream_t stream[STREAM_NUM + 1];
+  /* recorded after the task of a stream and after the last kernel writing a line */
+  cudaEvent_t stream_event[STREAM_NUM + 1];
+  cudaEvent_t line_event[CACHE_LINE];
   cublasHandle_t handle;
 #endif
 };
@@ -317,7 +497,9 @@ typedef struct cj_s cj_t;
 typedef struct autotune_s cj_Autotune;
 typedef struct distribution_s cj_Distribution;
 typedef struct event_s cj_Event;
+typedef struct constant_s cj_Constant;
 typedef struct profile_s cj_Profile;
+typedef struct stats_s  cj_Stats;
 typedef struct dqueue_s cj_Dqueue;
 typedef struct task_s   cj_Task;
 typedef struct matrix_s cj_Matrix;
@@ -327,16 +509,40 @@ typedef struct object_s cj_Object;
 typedef struct vertex_s cj_Vertex;
 typedef struct edge_s   cj_Edge;
 typedef struct lock_s   cj_Lock;
+typedef struct file_header_s cj_FileHeader;
+typedef struct file_s   cj_File;
+
 
+/* cj_Lock function prototypes */
+void cj_Lock_new (cj_Lock*);
+void cj_Lock_delete (cj_Lock*);
+void cj_Lock_acquire (cj_Lock*);
+void cj_Lock_release (cj_Lock*);
+cj_Bool cj_Lock_try (cj_Lock*);
 
 /* cj API function prototypes */
 void cj_Init (int);
 void cj_Term ();
+void cj_Device_emulate (int);
+long long cj_Device_stats (int, cj_statType);
+void cj_Device_stats_reset ();
+void cj_Stats_print ();
 void cj_Queue_begin ();
 void cj_Queue_end ();
+void cj_Sync ();
 
 /* cj_Distribution function prototypes */
 cj_Distribution *cj_Distribution_new();
+int cj_Distribution_source (cj_Distribution*, int);
+void cj_Distribution_set_state (cj_Distribution*, int, cj_cohState);
+void cj_Distribution_read (cj_Distribution*, int, int);
+void cj_Distribution_write (cj_Distribution*, int);
+void cj_Distribution_write_back (cj_Distribution*, cj_Object*);
+void cj_Distribution_evict (cj_Distribution*, int, cj_Object*);
+void cj_Distribution_fetch (cj_Distribution*, int, cj_Object*);
+void cj_Distribution_wait (cj_Distribution*);
+void cj_Distribution_wake (cj_Distribution*);
+void cj_Distribution_trace (void (*)(cj_Distribution*, int, cj_cohState, cj_cohState));
 
 /* cj_Task function prototypes */
 cj_Task *cj_Task_new ();
@@ -347,42 +553,134 @@ void cj_Task_dependencies_update (cj_Object*);
 
 /* cj_Worker function prototypes */
 float cj_Worker_estimate_cost (cj_Task*, cj_Worker*);
-void cj_Worker_wait_prefetch (cj_Worker*, int, int);
+void cj_Worker_wait_prefetch (cj_Worker*, int);
+cj_Bool cj_Worker_lookahead (int, cj_Object*, int);
+char *cj_Worker_get_buff (cj_Worker*, cj_Matrix*, int*);
 
 void cj_Autotune_init ();
 cj_Autotune *cj_Autotune_get_ptr ();
 
 
 void cj_Gemm_nn_task_function (void*);
+void cj_Gemm_nt_task_function (void*);
+void cj_Gemm_tn_task_function (void*);
+void cj_Gemm_tt_task_function (void*);
 void cj_Gemm_nn (cj_Object*, cj_Object*, cj_Object*);
+void cj_Gemm_nt (cj_Object*, cj_Object*, cj_Object*);
+void cj_Gemm (cj_Trans, cj_Trans, cj_Object*, cj_Object*, cj_Object*, cj_Object*, cj_Object*);
 extern void sgemm_ (char*, char*, int*, int*, int*, float*, float*, int*, float*, int*, float*, float*, int*);
 extern void dgemm_ (char*, char*, int*, int*, int*, double*, double*, int*, double*, int*, double*, double*, int*);
 
-void cj_Syrk_ln_task_function (void*);
+void cj_Syrk_task_function (void*);
 void cj_Syrk_ln_task (cj_Object*, cj_Object*, cj_Object*, cj_Object*);
 void cj_Syrk_ln_blk_var1 (cj_Object*, cj_Object*);
 void cj_Syrk_ln_blk_var2 (cj_Object*, cj_Object*);
 void cj_Syrk_ln_blk_var5 (cj_Object*, cj_Object*);
 void cj_Syrk_ln (cj_Object*, cj_Object*);
+void cj_Syrk (cj_Uplo, cj_Trans, cj_Object*, cj_Object*, cj_Object*, cj_Object*);
 extern void ssyrk_ (char*, char*, int*, int*, float*, float*, int*, float*, float*, int*);
 extern void dsyrk_ (char*, char*, int*, int*, double*, double*, int*, double*, double*, int*);
 
+void cj_Syr2k_task_function (void*);
+void cj_Syr2k (cj_Uplo, cj_Trans, cj_Object*, cj_Object*, cj_Object*, cj_Object*, cj_Object*);
+extern void ssyr2k_ (char*, char*, int*, int*, float*, float*, int*, float*, int*, float*, float*, int*);
+extern void dsyr2k_ (char*, char*, int*, int*, double*, double*, int*, double*, int*, double*, double*, int*);
+
+void cj_Symm_task_function (void*);
+void cj_Symm (cj_Side, cj_Uplo, cj_Object*, cj_Object*, cj_Object*, cj_Object*, cj_Object*);
+extern void ssymm_ (char*, char*, int*, int*, float*, float*, int*, float*, int*, float*, float*, int*);
+extern void dsymm_ (char*, char*, int*, int*, double*, double*, int*, double*, int*, double*, double*, int*);
+
 
 void cj_Trsm_rlt (cj_Object*, cj_Object*);
-void cj_Trsm_rlt_task_function (void*);
+void cj_Trsm_rln (cj_Object*, cj_Object*);
+void cj_Trsm_task_function (void*);
+void cj_Trsm (cj_Side, cj_Uplo, cj_Trans, cj_Diag, cj_Object*, cj_Object*, cj_Object*);
 extern void strsm_ (char*, char*, char*, char*, int*, int*, float*, float*, int*, float*, int*);
 extern void dtrsm_ (char*, char*, char*, char*, int*, int*, double*, double*, int*, double*, int*);
 
+void cj_Trmm_task_function (void*);
+void cj_Trmm (cj_Side, cj_Uplo, cj_Trans, cj_Diag, cj_Object*, cj_Object*, cj_Object*);
+extern void strmm_ (char*, char*, char*, char*, int*, int*, float*, float*, int*, float*, int*);
+extern void dtrmm_ (char*, char*, char*, char*, int*, int*, double*, double*, int*, double*, int*);
+
+void cj_Kernel_sgemm (char*, char*, int*, int*, int*, float*, float*, int*, float*, int*, float*, float*, int*);
+void cj_Kernel_dgemm (char*, char*, int*, int*, int*, double*, double*, int*, double*, int*, double*, double*, int*);
+void cj_Kernel_ssyrk (char*, char*, int*, int*, float*, float*, int*, float*, float*, int*);
+void cj_Kernel_dsyrk (char*, char*, int*, int*, double*, double*, int*, double*, double*, int*);
+void cj_Kernel_ssyr2k (char*, char*, int*, int*, float*, float*, int*, float*, int*, float*, float*, int*);
+void cj_Kernel_dsyr2k (char*, char*, int*, int*, double*, double*, int*, double*, int*, double*, double*, int*);
+void cj_Kernel_ssymm (char*, char*, int*, int*, float*, float*, int*, float*, int*, float*, float*, int*);
+void cj_Kernel_dsymm (char*, char*, int*, int*, double*, double*, int*, double*, int*, double*, double*, int*);
+void cj_Kernel_strmm (char*, char*, char*, char*, int*, int*, float*, float*, int*, float*, int*);
+void cj_Kernel_dtrmm (char*, char*, char*, char*, int*, int*, double*, double*, int*, double*, int*);
+void cj_Kernel_spotrf (char*, int*, float*, int*, int*);
+void cj_Kernel_dpotrf (char*, int*, double*, int*, int*);
+void cj_Kernel_strtri (char*, char*, int*, float*, int*, int*);
+void cj_Kernel_dtrtri (char*, char*, int*, double*, int*, int*);
+void cj_Kernel_slauum (char*, int*, float*, int*, int*);
+void cj_Kernel_dlauum (char*, int*, double*, int*, int*);
+void cj_Kernel_sgetrf (int*, int*, float*, int*, int*, int*);
+void cj_Kernel_dgetrf (int*, int*, double*, int*, int*, int*);
+void cj_Kernel_sgessm (int*, int*, int*, float*, int*, float*, int*);
+void cj_Kernel_dgessm (int*, int*, int*, double*, int*, double*, int*);
+void cj_Kernel_ststrf (int*, int*, float*, int*, float*, int*, int*, int*);
+void cj_Kernel_dtstrf (int*, int*, double*, int*, double*, int*, int*, int*);
+void cj_Kernel_sssssm (int*, int*, int*, float*, int*, float*, int*, float*, int*, int*);
+void cj_Kernel_dssssm (int*, int*, int*, double*, int*, double*, int*, double*, int*, int*);
+void cj_Kernel_sgeqrt (int*, int*, float*, int*, float*, int*);
+void cj_Kernel_dgeqrt (int*, int*, double*, int*, double*, int*);
+void cj_Kernel_sgemqrt (char*, int*, int*, int*, float*, int*, float*, int*, float*, int*);
+void cj_Kernel_dgemqrt (char*, int*, int*, int*, double*, int*, double*, int*, double*, int*);
+void cj_Kernel_stpqrt (int*, int*, int*, float*, int*, float*, int*, float*, int*);
+void cj_Kernel_dtpqrt (int*, int*, int*, double*, int*, double*, int*, double*, int*);
+void cj_Kernel_stpmqrt (char*, int*, int*, int*, int*, float*, int*, float*, int*, float*, int*, float*, int*);
+void cj_Kernel_dtpmqrt (char*, int*, int*, int*, int*, double*, int*, double*, int*, double*, int*, double*, int*);
+void cj_Kernel_ssytrf_nopiv (int*, float*, int*, int*);
+void cj_Kernel_dsytrf_nopiv (int*, double*, int*, int*);
+void cj_Kernel_strsmd (int*, int*, float*, int*, float*, int*);
+void cj_Kernel_dtrsmd (int*, int*, double*, int*, double*, int*);
+void cj_Kernel_sgemdm (char*, int*, int*, int*, float*, int*, float*, int*, float*, int*, float*, int*);
+void cj_Kernel_dgemdm (char*, int*, int*, int*, double*, int*, double*, int*, double*, int*, double*, int*);
+void cj_Kernel_strsm (char*, char*, char*, char*, int*, int*, float*, float*, int*, float*, int*);
+void cj_Kernel_dtrsm (char*, char*, char*, char*, int*, int*, double*, double*, int*, double*, int*);
+
+void cj_Copy_task_function (void*);
+void cj_Copy (cj_Object*, cj_Object*);
+void cj_Axpy_task_function (void*);
+void cj_Axpy (cj_Object*, cj_Object*);
+
 
 void cj_Cache_read_in (cj_Device*, int, cj_Object*);
 void cj_Cache_write_back (cj_Device*, int, cj_Object*);
 void cj_Cache_async_write_back (cj_Device*, int, cj_Object*);
+int  cj_Cache_line (cj_Device*, cj_Object*);
+int  cj_Cache_line_size (cj_Device*, cj_Object*, size_t);
+int  cj_Cache_line_share (cj_Device*, cj_Object*, int, size_t);
+void cj_Cache_read_in_run (cj_Device*, int*, cj_Object**, int, int);
+void cj_Cache_read_peer (cj_Device*, int, cj_Object*, cj_Device*, int);
 int  cj_Cache_fetch (cj_Device*, cj_Object*);
+void cj_Cache_pin (cj_Device*, int);
+void cj_Cache_unpin (cj_Device*, int);
 void cj_Cache_sync (cj_Device*);
+void cj_Cache_line_wait (cj_Device*, int);
 void cj_Device_sync (cj_Device*);
+int  cj_Device_stream_begin (cj_Device*);
+void cj_Device_stream_use (cj_Device*, int, int, cj_Bool);
+void cj_Device_stream_end (cj_Device*, int);
+void cj_Device_stream_retire (cj_Device*, int);
+void cj_Device_drain (cj_Device*);
+uintptr_t cj_Device_malloc (size_t, cj_devType);
+void cj_Device_free (uintptr_t, cj_devType);
+char *cj_Device_malloc_host (size_t, cj_devType);
+void cj_Device_free_host (char*, cj_devType);
+char *cj_Device_workspace (cj_Device*, size_t);
+void cj_Device_stage_h2d (uintptr_t, size_t, char*, size_t, size_t, size_t, cj_Device*);
+void cj_Device_stage_d2h (char*, size_t, uintptr_t, size_t, size_t, size_t, cj_Device*);
 
 cj_Device *cj_Device_new (cj_devType, int);
 void cj_Device_bind (cj_Worker*, cj_Device*);
+void cj_Device_link (cj_Device*, cj_Device*);
 
 /* memcpy from device to host */
 void cj_Device_memcpy_d2h (char*, uintptr_t, size_t, cj_Device*);
@@ -391,6 +689,9 @@ void cj_Device_memcpy_h2d (uintptr_t, char*, size_t, cj_Device*);
 void cj_Device_memcpy2d_d2h (char*, size_t, uintptr_t, size_t, size_t, size_t, cj_Device*);
 void cj_Device_async_memcpy2d_d2h (char*, size_t, uintptr_t, size_t, size_t, size_t, cj_Device*);
 void cj_Device_memcpy2d_h2d (uintptr_t, size_t, char*, size_t, size_t, size_t, cj_Device*);
+/* memcpy between two devices */
+void cj_Device_memcpy2d_d2d (uintptr_t, size_t, cj_Device*, uintptr_t, size_t, cj_Device*, size_t, size_t);
+void cj_Device_host_memcpy2d (char*, size_t, char*, size_t, size_t, size_t);
 
 
 void cj_Graph_init ();
@@ -408,13 +709,53 @@ cj_Vertex *cj_Vertex_new ();
 void cj_Edge_set (cj_Object*, cj_Object*, cj_Object*, cj_Bool);
 cj_Edge *cj_Edge_new ();
 
+void cj_Lapack_task_function (void*);
+
 void cj_Chol_l_task_function (void*);
 void cj_Chol_l (cj_Object*);
+void cj_Chol_l_partial (cj_Object*, int);
+int  cj_Chol_solve_mixed (cj_Object*, cj_Object*, cj_Object*);
+void cj_Chol_solve (cj_Object*, cj_Object*);
+void cj_Chol_inverse (cj_Object*);
+void cj_Chol_logdet (cj_Object*, double*);
+void cj_Chol_update (cj_Object*, cj_Object*);
+void cj_Chol_downdate (cj_Object*, cj_Object*);
 #ifdef CJ_HAVE_CUDA
-void hybrid_dpotrf (cublasHandle_t*, int, double*, int, int*);
+void hybrid_dpotrf (cublasHandle_t*, int, double*, int, double*, int*);
+size_t hybrid_dpotrf_lwork (int);
 #endif
 extern void spotrf_ (char*, int*, float*, int*, int*);
 extern void dpotrf_ (char*, int*, double*, int*, int*);
+extern void strtri_ (char*, char*, int*, float*, int*, int*);
+extern void dtrtri_ (char*, char*, int*, double*, int*, int*);
+extern void slauum_ (char*, int*, float*, int*, int*);
+extern void dlauum_ (char*, int*, double*, int*, int*);
+
+void cj_Lu (cj_Object*, int*);
+void cj_Lu_solve (cj_Object*, int*, cj_Object*);
+extern void sgetrf_ (int*, int*, float*, int*, int*, int*);
+extern void dgetrf_ (int*, int*, double*, int*, int*, int*);
+extern void slaswp_ (int*, float*, int*, int*, int*, int*, int*);
+extern void dlaswp_ (int*, double*, int*, int*, int*, int*, int*);
+
+void cj_Qr (cj_Object*, cj_Object*);
+void cj_Qr_solve (cj_Object*, cj_Object*, cj_Object*);
+extern void sgeqrt_ (int*, int*, int*, float*, int*, float*, int*, float*, int*);
+extern void dgeqrt_ (int*, int*, int*, double*, int*, double*, int*, double*, int*);
+extern void sgemqrt_ (char*, char*, int*, int*, int*, int*, float*, int*, float*, int*, float*, int*, float*, int*);
+extern void dgemqrt_ (char*, char*, int*, int*, int*, int*, double*, int*, double*, int*, double*, int*, double*, int*);
+extern void stpqrt_ (int*, int*, int*, int*, float*, int*, float*, int*, float*, int*, float*, int*);
+extern void dtpqrt_ (int*, int*, int*, int*, double*, int*, double*, int*, double*, int*, double*, int*);
+extern void stpmqrt_ (char*, char*, int*, int*, int*, int*, int*, float*, int*, float*, int*, float*, int*,
+    float*, int*, float*, int*);
+extern void dtpmqrt_ (char*, char*, int*, int*, int*, int*, int*, double*, int*, double*, int*, double*, int*,
+    double*, int*, double*, int*);
+
+void cj_Ldlt (cj_Object*, cj_Object*);
+void cj_Ldlt_solve (cj_Object*, cj_Object*, cj_Object*);
+void cj_Ldlt_inertia (cj_Object*, int*);
+
+void cj_Eig (cj_Object*, double*, cj_Object*);
 
 
 /* cj_Object function prototypes */
@@ -422,9 +763,27 @@ cj_Object *cj_Object_new (cj_objType);
 cj_Object *cj_Object_append (cj_objType, void*);
 void cj_Object_acquire (cj_Object*);
 
+/* cj_Constant function prototypes */
+void cj_Constant_set (cj_Object*, double);
+double cj_Constant_get (cj_Object*);
+
 /* cj_Matrix function prototypes */
 void cj_Matrix_duplicate (cj_Object*, cj_Object*);
+void cj_Matrix_tile (cj_Object*, cj_Object*, int, int);
 void cj_Matrix_set (cj_Object*, int, int);
+void cj_Matrix_attach (cj_Object*, int, int, char*);
+void cj_Matrix_detach (cj_Object*);
+void cj_Matrix_set_layout (cj_Object*, cj_layoutType);
+void cj_Matrix_set_eletype (cj_Object*, cj_eleType);
+size_t cj_Matrix_tile_offsets (int, int, size_t, cj_layoutType, size_t*);
+char *cj_Matrix_addr (cj_Matrix*, int, int, int*);
+void cj_Matrix_set_disk (cj_Object*, int, int, const char*);
+void cj_Matrix_flush_disk (cj_Object*);
+void cj_Disk_map (cj_Object*, int, int, int, size_t, cj_Bool);
+void cj_Disk_budget (size_t);
+void cj_Disk_touch (cj_Object*);
+void cj_Disk_prefetch (cj_Object*);
+cj_Bool cj_Disk_resident (cj_Object*);
 void cj_Matrix_set_identity (cj_Object*);
 void cj_Matrix_set_lowertril_one (cj_Object*);
 void cj_Matrix_set_special_chol (cj_Object*);
@@ -447,6 +806,8 @@ void cj_Matrix_cont_with_3x3_to_2x2 (cj_Object*, cj_Object*, cj_Object*, cj_Obje
                                      cj_Object*, cj_Object*, cj_Object*, cj_Object*, cj_Object*,
                                                                                      cj_Quadrant);
 
+/* element (i, j) of a base matrix, of the given C type */
+#define cj_Matrix_elem(a, type, i, j) (*(type *) cj_Matrix_addr(a, i, j, NULL))
 #define cj_Matrix_get_distribution(a) a->base->dist[a->offm/BLOCK_SIZE][a->offn/BLOCKSIZE]
 
 /* cj_Dqueue function prototypes */
@@ -456,11 +817,24 @@ cj_Object *cj_Dqueue_pop_head (cj_Object*);
 void cj_Dqueue_push_tail (cj_Object*, cj_Object*);
 cj_Object *cj_Dqueue_pop_tail (cj_Object*);
 void cj_Dqueue_clear (cj_Object*);
+void cj_Dqueue_remove (cj_Object*, cj_Object*);
 
 cj_Event *cj_Event_new ();
+cj_Constant *cj_Constant_new ();
 void cj_Profile_worker_record (cj_Worker*, cj_eveType);
 void cj_Profile_init ();
 void cj_Profile_output_timeline ();
+void cj_Stats_count (cj_Device*, cj_Object*, cj_statType, long long);
+long long cj_Matrix_stats (cj_Object*, cj_statType);
+void cj_Matrix_stats_reset (cj_Object*);
+void cj_Matrix_output_heat (cj_Object*, const char*);
+
+void cj_File_load_task_function (void*);
+void cj_File_store_task_function (void*);
+void cj_Matrix_store (cj_Object*, const char*, cj_layoutType);
+void cj_Matrix_load (cj_Object*, const char*);
+void cj_Matrix_map (cj_Object*, const char*, cj_Bool);
+void cj_File_wait (const char*);
 
 cj_Csc *cj_Csc_new ();
 cj_Sparse *cj_Sparse_new ();
@@ -9,6 +9,8 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <unistd.h>
+#include <errno.h>
+#include <sched.h>
 
 #include <cj.h>
 
@@ -16,6 +18,8 @@
 static cj_t cj;
 static int taskid = 0;
 static cj_Bool cj_queue_enable = FALSE;
+static int cj_host_device = 0;
+static void (*cj_coherence_trace) (cj_Distribution*, int, cj_cohState, cj_cohState) = NULL;
 
 /**
  *  @brief cj_error
@@ -64,6 +68,18 @@ void cj_Lock_acquire (cj_Lock *lock) {
   if (ret) cj_error("Lock_acquire", "Could not acquire locks properly.");
 }
 
+/**
+ * @brief  This function will try to acquire the mutex without blocking.
+ * @param  *lock lock pointer 
+ * @return TRUE if the mutex has been acquired
+ */
+cj_Bool cj_Lock_try (cj_Lock *lock) {
+  int ret = pthread_mutex_trylock(&(lock->lock));
+  if (ret == 0) return TRUE;
+  if (ret != EBUSY) cj_error("Lock_try", "Could not try locks properly.");
+  return FALSE;
+}
+
 /**
  * @brief  This function will release the mutex.
  * @param  *lock lock pointer 
@@ -89,18 +105,291 @@ cj_Distribution *cj_Distribution_new () {
 
   int i;
   for (i = 0; i < MAX_DEV + 1; i++) {
+    dist->state[i] = CJ_INVALID;
     dist->avail[i] = FALSE;
     if (i > 0) {
       /* Be careful, here the index is different. */
       dist->device[i] = cj.device[i - 1];
     }
     dist->line[i]  = -1;
+    dist->fanout[i] = 0;
+    dist->reader[i] = 0;
+    dist->prefetched[i] = FALSE;
   }
+  dist->heat = 0;
+  dist->tile = NULL;
+  dist->lru = NULL;
+  dist->resident = FALSE;
+  /* The main memory holds the only copy. */
+  dist->state[0] = CJ_EXCLUSIVE;
   dist->avail[0] = TRUE;
+  dist->owner    = 0;
+  dist->nwaiter  = 0;
   cj_Lock_new(&dist->lock);
+  if (pthread_cond_init(&dist->arrive, NULL)) cj_error("Distribution_new", "Could not initial condition properly.");
   return dist;
 }
 
+/**
+ * @brief  Wait until a transfer of the tile lands. The lock is released 
+ *         while waiting and held again on return.
+ * @param  *dist distribution pointer
+ */
+void cj_Distribution_wait (cj_Distribution *dist) {
+  dist->nwaiter ++;
+  pthread_cond_wait(&dist->arrive, &dist->lock.lock);
+  dist->nwaiter --;
+}
+
+/**
+ * @brief  Wake up the workers waiting for a transfer of the tile. Call it 
+ *         with the lock held.
+ * @param  *dist distribution pointer
+ */
+void cj_Distribution_wake (cj_Distribution *dist) {
+  if (dist->nwaiter > 0) pthread_cond_broadcast(&dist->arrive);
+}
+
+/**
+ * @brief  Register a function called on every state transition of a copy,
+ *         with the distribution, the location, the old and the new state.
+ *         Pass NULL to stop tracing.
+ * @param  *trace callback function pointer
+ */
+void cj_Distribution_trace (void (*trace)(cj_Distribution*, int, cj_cohState, cj_cohState)) {
+  cj_coherence_trace = trace;
+}
+
+/**
+ * @brief  Move the copy at a location to a new state. This is the only place
+ *         where the states change, avail and the cache line status follow
+ *         them. Call it with the lock held.
+ * @param  *dist distribution pointer
+ * @param  loc location (0 for the host, device id + 1 otherwise)
+ * @param  state new state
+ */
+void cj_Distribution_set_state (cj_Distribution *dist, int loc, cj_cohState state) {
+  cj_cohState old = dist->state[loc];
+
+  dist->state[loc] = state;
+  dist->avail[loc] = (state == CJ_INVALID || state == CJ_INFLIGHT) ? FALSE : TRUE;
+  if (loc > 0 && dist->line[loc] != -1) {
+    dist->device[loc]->cache.status[dist->line[loc]] = 
+      (state == CJ_MODIFIED || state == CJ_OWNED) ? CJ_CACHE_DIRTY : CJ_CACHE_CLEAN;
+  }
+  /* A prefetched copy dropped before any task used it was moved for nothing. */
+  if (state == CJ_INVALID && dist->prefetched[loc] == TRUE) {
+    cj_Stats_count(dist->device[loc], 
+        (dist->line[loc] != -1) ? dist->device[loc]->cache.obj_ptr[dist->line[loc]] : NULL, 
+        CJ_STAT_PREFETCH_WASTE, 1);
+    dist->prefetched[loc] = FALSE;
+  }
+  if (state == CJ_INVALID && loc > 0) dist->line[loc] = -1;
+  if (old != state && cj_coherence_trace) (*cj_coherence_trace)(dist, loc, old, state);
+}
+
+/**
+ * @brief  A copy has been made at dest from the one at src. Both are shared
+ *         now, a modified source keeps answering for the data (owned), so 
+ *         the main memory is not refreshed.
+ * @param  *dist distribution pointer
+ * @param  dest destination location
+ * @param  src source location
+ */
+void cj_Distribution_read (cj_Distribution *dist, int dest, int src) {
+  if (dist->state[src] == CJ_MODIFIED) cj_Distribution_set_state(dist, src, CJ_OWNED);
+  else if (dist->state[src] == CJ_EXCLUSIVE) cj_Distribution_set_state(dist, src, CJ_SHARED);
+  cj_Distribution_set_state(dist, dest, CJ_SHARED);
+  dist->fanout[src] ++;
+}
+
+/**
+ * @brief  The copy at dest has been written. Every other copy is invalidated
+ *         and dest becomes the owner.
+ * @param  *dist distribution pointer
+ * @param  dest location of the writer
+ */
+void cj_Distribution_write (cj_Distribution *dist, int dest) {
+  int i;
+  for (i = 0; i < MAX_DEV + 1; i++) {
+    if (i != dest && dist->state[i] != CJ_INVALID) cj_Distribution_set_state(dist, i, CJ_INVALID);
+    dist->fanout[i] = 0;
+  }
+  /* The main memory is the backing store, its only copy is never dirty. */
+  cj_Distribution_set_state(dist, dest, (dest == 0) ? CJ_EXCLUSIVE : CJ_MODIFIED);
+  dist->owner = dest;
+}
+
+/**
+ * @brief  Refresh the copy in main memory from the owner, if it is stale. 
+ *         The owner becomes a clean sharer and the main memory the owner.
+ * @param  *dist distribution pointer
+ * @param  *target the tile
+ */
+void cj_Distribution_write_back (cj_Distribution *dist, cj_Object *target) {
+  int owner = dist->owner;
+
+  if (dist->state[0] != CJ_INVALID) return;
+  if (owner == 0 || dist->state[owner] == CJ_INVALID) {
+    cj_error("Distribution_write_back", "no owner of the latest data.");
+  }
+  cj_Cache_write_back(dist->device[owner], dist->line[owner], target);
+  cj_Distribution_set_state(dist, owner, CJ_SHARED);
+  cj_Distribution_set_state(dist, 0, CJ_SHARED);
+  dist->fanout[owner] ++;
+  dist->owner = 0;
+}
+
+/**
+ * @brief  Make a valid copy of the tile at dest. The copy is marked in flight
+ *         and the lock is only held to change states, so others can use the
+ *         tile meanwhile. Whoever needs a copy already in flight waits for it
+ *         instead of issuing another transfer. A device without a direct link
+ *         to the source is served through the main memory. Call it with the
+ *         lock held; on return the copy is valid and the lock held again.
+ * @param  *dist distribution pointer
+ * @param  dest destination location (0 for the host, device id + 1 otherwise)
+ * @param  *target the tile
+ */
+void cj_Distribution_fetch (cj_Distribution *dist, int dest, cj_Object *target) {
+  cj_Device *device = (dest == 0) ? NULL : dist->device[dest];
+  int src, src_line, line_id, retry = 0, i;
+
+  while (dist->avail[dest] == FALSE) {
+    /* Share a transfer already on the way. */
+    if (dist->state[dest] == CJ_INFLIGHT) {
+      cj_Distribution_wait(dist);
+      continue;
+    }
+    src = cj_Distribution_source(dist, dest);
+    if (src == -1) {
+      for (i = 0; i < MAX_DEV + 1; i++) if (dist->state[i] == CJ_INFLIGHT) break;
+      if (i == MAX_DEV + 1) cj_error("Distribution_fetch", "no valid copy of the tile.");
+      cj_Distribution_wait(dist);
+      continue;
+    }
+
+    /* A device without a direct link to the source reads a valid main 
+     * memory copy, and only otherwise has it refreshed first. */
+    if (src != 0 && dest != 0 && device->link[src] == 0.0 && dist->avail[0] == TRUE) src = 0;
+
+    /* Refresh the main memory from a device. */
+    if (src != 0 && (dest == 0 || device->link[src] == 0.0)) {
+      if (dist->state[0] == CJ_INFLIGHT) {
+        cj_Distribution_wait(dist);
+        continue;
+      }
+      src      = dist->owner;
+      src_line = dist->line[src];
+      cj_Distribution_set_state(dist, 0, CJ_INFLIGHT);
+      dist->reader[src] ++;
+      cj_Lock_release(&dist->lock);
+      fprintf(stderr, RED "Cache_writeback: %d\n" NONE, src - 1);
+      cj_Cache_write_back(dist->device[src], src_line, target);
+      cj_Lock_acquire(&dist->lock);
+      dist->reader[src] --;
+      cj_Distribution_set_state(dist, src, CJ_SHARED);
+      cj_Distribution_set_state(dist, 0, CJ_SHARED);
+      dist->fanout[src] ++;
+      dist->owner = 0;
+      cj_Distribution_wake(dist);
+      continue;
+    }
+
+    line_id = cj_Cache_line(device, target);
+    if (line_id == -1) {
+      /* The lines left may belong to tiles locked by other workers for a 
+       * moment, so step back and retry before giving up. */
+      if (retry ++ == CACHE_RETRY) cj_error("Distribution_fetch", "every cache line is pinned.");
+      cj_Lock_release(&dist->lock);
+      /* Lines may be held by tasks in flight on the device. */
+      cj_Device_drain(device);
+      sched_yield();
+      cj_Lock_acquire(&dist->lock);
+      continue;
+    }
+    src_line = dist->line[src];
+    dist->line[dest] = line_id;
+    cj_Distribution_set_state(dist, dest, CJ_INFLIGHT);
+    dist->reader[src] ++;
+    cj_Lock_release(&dist->lock);
+    if (src == 0) cj_Cache_read_in(device, line_id, target);
+    else cj_Cache_read_peer(device, line_id, target, dist->device[src], src_line);
+    cj_Cache_sync(device);
+    fprintf(stderr, RED "(%d) Cache_fetch: %d from %d\n" NONE, dest - 1, line_id, src - 1);
+    cj_Lock_acquire(&dist->lock);
+    dist->reader[src] --;
+    cj_Distribution_read(dist, dest, src);
+    cj_Distribution_wake(dist);
+  }
+}
+
+/**
+ * @brief  Drop the copy at a device whose cache line is evicted. An owner 
+ *         hands the data over to another device sharing it, and only writes
+ *         back to main memory if it held the last copy.
+ * @param  *dist distribution pointer
+ * @param  loc location of the evicted copy
+ * @param  *target the tile
+ */
+void cj_Distribution_evict (cj_Distribution *dist, int loc, cj_Object *target) {
+  int i, heir = -1, nvalid = 0;
+
+  cj_Stats_count(dist->device[loc], target, CJ_STAT_EVICT, 1);
+  if (dist->owner == loc) {
+    for (i = 1; i < MAX_DEV + 1; i++) {
+      /* A copy still in flight has no data to hand over yet. */
+      if (i == loc || dist->state[i] == CJ_INVALID || dist->state[i] == CJ_INFLIGHT) continue;
+      if (heir == -1) heir = i;
+      nvalid ++;
+    }
+    if (heir != -1) {
+      cj_Distribution_set_state(dist, heir, (nvalid == 1) ? CJ_MODIFIED : CJ_OWNED);
+      dist->owner = heir;
+    }
+    else {
+      cj_Distribution_write_back(dist, target);
+      cj_Distribution_set_state(dist, 0, CJ_EXCLUSIVE);
+    }
+  }
+  cj_Distribution_set_state(dist, loc, CJ_INVALID);
+}
+
+/**
+ * @brief  Choose the copy a location should read a tile from. Each valid copy
+ *         is scored by its modelled link bandwidth to the destination, a copy
+ *         without a direct link by the two hops through the host, unless the
+ *         host copy is valid. The score
+ *         is shared among the copies a location has already served, so a tile
+ *         read by several devices spreads out along a tree instead of being
+ *         sent from one place again and again. Call it with the lock held.
+ * @param  *dist distribution pointer
+ * @param  dest destination location (0 for the host, device id + 1 otherwise)
+ * @return source location, or -1 if there is no valid copy
+ */
+int cj_Distribution_source (cj_Distribution *dist, int dest) {
+  int i, src = -1;
+  float bw, score, best = 0.0;
+
+  for (i = 0; i < MAX_DEV + 1; i++) {
+    if (i == dest || dist->avail[i] == FALSE) continue;
+    if (dest == 0) bw = dist->device[i]->link[0];
+    else if (i == 0) bw = dist->device[dest]->link[0];
+    else {
+      bw = dist->device[dest]->link[i];
+      /* The two hops go through the main memory, a valid copy there is read instead. */
+      if (bw == 0.0 && dist->avail[0] == TRUE) continue;
+      if (bw == 0.0) bw = 1.0/(1.0/dist->device[i]->link[0] + 1.0/dist->device[dest]->link[0]);
+    }
+    score = bw/(1 + dist->fanout[i]);
+    if (src == -1 || score > best) {
+      src  = i;
+      best = score;
+    }
+  }
+  return src;
+}
+
 
 /* ---------------------------------------------------------------------
  * cj_Task
@@ -312,6 +601,42 @@ void cj_Task_dependencies_update (cj_Object *target) {
  * */
 
 
+/* Whether the tiles of disk-backed matrices read by a task are resident. */
+cj_Bool cj_Worker_resident (cj_Task *task) {
+  cj_Object *arg_I = task->arg->dqueue->head;
+  while (arg_I) {
+    if (arg_I->objtype == CJ_MATRIX && cj_Disk_resident(arg_I) == FALSE) return FALSE;
+    arg_I = arg_I->next;
+  }
+  return TRUE;
+}
+
+/**
+ * @brief  Start reading the tiles of disk-backed matrices needed by the 
+ *         first queued tasks of a worker, so that the disk works while the
+ *         current task runs.
+ * @param  *worker the worker
+ */
+void cj_Worker_prefetch_disk (cj_Worker *worker) {
+  cj_Schedule *schedule = &cj.schedule;
+  cj_Object *tile[CACHE_LINE];
+  int i, ntile = 0;
+
+  cj_Lock_acquire(&schedule->ready_queue_lock[worker->id]);
+  {
+    cj_Object *now = schedule->ready_queue[worker->id]->dqueue->head;
+    for (i = 0; now && i < CACHE_LOOKAHEAD; i++, now = now->next) {
+      cj_Object *arg_I = now->task->arg->dqueue->head;
+      for (; arg_I && ntile < CACHE_LINE; arg_I = arg_I->next) {
+        if (arg_I->objtype == CJ_MATRIX && cj_Disk_resident(arg_I) == FALSE) tile[ntile ++] = arg_I;
+      }
+    }
+  }
+  cj_Lock_release(&schedule->ready_queue_lock[worker->id]);
+
+  for (i = 0; i < ntile; i++) cj_Disk_prefetch(tile[i]);
+}
+
 /**
  * @brief  Fetch a task from the ready queue.
  * @param  *worker the target worker
@@ -320,7 +645,16 @@ void cj_Task_dependencies_update (cj_Object *target) {
  */
 cj_Object *cj_Worker_wait_dqueue (cj_Worker *worker) {
   cj_Schedule *schedule = &cj.schedule;
-  cj_Object *task = cj_Dqueue_pop_head(schedule->ready_queue[worker->id]);
+  cj_Object *task = schedule->ready_queue[worker->id]->dqueue->head;
+  int i;
+
+  /* A task whose tiles are all in main memory goes before those waiting for
+   * the disk. */
+  for (i = 0; task && i < CACHE_LOOKAHEAD; i++, task = task->next) {
+    if (cj_Worker_resident(task->task) == TRUE) break;
+  }
+  if (task && i < CACHE_LOOKAHEAD) cj_Dqueue_remove(schedule->ready_queue[worker->id], task);
+  else task = cj_Dqueue_pop_head(schedule->ready_queue[worker->id]);
   /*
      if (task) fprintf(stderr, YELLOW "  Worker_wait_dqueue (%d, %s): \n" NONE, task->task->id, task->task->name);
      else {
@@ -331,81 +665,267 @@ cj_Object *cj_Worker_wait_dqueue (cj_Worker *worker) {
   return task;
 }
 
+/**
+ * @brief  Check whether one of the first tasks waiting in a worker's ready
+ *         queue will read the target. Used by the device cache to keep tiles
+ *         which are about to be needed.
+ * @param  id worker id
+ * @param  *target matrix object
+ * @param  depth number of queued tasks to inspect
+ * @return TRUE if the target will be read
+ */
+cj_Bool cj_Worker_lookahead (int id, cj_Object *target, int depth) {
+  cj_Schedule *schedule = &cj.schedule;
+  cj_Matrix   *matrix   = target->matrix;
+  cj_Bool      found    = FALSE;
+  int i = 0;
+
+  if (id < 0 || id >= MAX_WORKER || target->objtype != CJ_MATRIX) return FALSE;
+
+  /* Critical section : access ready_queue. */
+  cj_Lock_acquire(&schedule->ready_queue_lock[id]);
+  {
+    cj_Object *now = schedule->ready_queue[id]->dqueue->head;
+    while (now && i < depth && found == FALSE) {
+      cj_Object *arg_I = now->task->arg->dqueue->head;
+      while (arg_I) {
+        if (arg_I->objtype == CJ_MATRIX && arg_I->rwtype != CJ_W) {
+          cj_Matrix *arg = arg_I->matrix;
+          if (arg->base == matrix->base && 
+              arg->offm/BLOCK_SIZE == matrix->offm/BLOCK_SIZE && 
+              arg->offn/BLOCK_SIZE == matrix->offn/BLOCK_SIZE) found = TRUE;
+        }
+        arg_I = arg_I->next;
+      }
+      now = now->next;
+      i ++;
+    }
+  }
+  cj_Lock_release(&schedule->ready_queue_lock[id]);
+
+  return found;
+}
+
+/**
+ * @brief  Return the memory a worker computes on for a tile: the cache line
+ *         holding the tile for a device worker, the main memory otherwise.
+ * @param  *worker the executing worker
+ * @param  *matrix the tile
+ * @param  *ld return the leading dimension of the buffer
+ * @return buffer pointer (a device pointer for CUDA workers)
+ */
+char *cj_Worker_get_buff (cj_Worker *worker, cj_Matrix *matrix, int *ld) {
+  cj_Matrix       *base = matrix->base;
+  cj_Distribution *dist;
+  int dest = worker->device_id + 1;
+
+  if (worker->device_id == -1) return cj_Matrix_addr(base, matrix->offm, matrix->offn, ld);
+
+  dist = base->dist[matrix->offm/BLOCK_SIZE][matrix->offn/BLOCK_SIZE];
+  if (dist->avail[dest] == FALSE || dist->line[dest] == -1) {
+    cj_error("Worker_get_buff", "No propriate distribution.");
+  }
+  /* The line holds the whole tile. */
+  *ld = dist->device[dest]->cache.ld[dist->line[dest]];
+  return (char *) dist->device[dest]->cache.dev_ptr[dist->line[dest]] +
+    ((size_t) (matrix->offn%BLOCK_SIZE)*(*ld) + matrix->offm%BLOCK_SIZE)*matrix->elelen;
+}
+
+/* Release the cache lines pinned for the prefetched task. */
+void cj_Worker_release_prefetch (cj_Worker *worker) {
+  int i;
+  for (i = 0; i < worker->npre_pin; i++) {
+    cj_Cache_unpin(cj.device[worker->device_id], worker->pre_pin[i]);
+  }
+  worker->npre_pin = 0;
+}
+
+/* Release the cache lines pinned for the running task. */
+void cj_Worker_release_run (cj_Worker *worker) {
+  int i;
+  for (i = 0; i < worker->nrun_pin; i++) {
+    cj_Cache_unpin(cj.device[worker->device_id], worker->run_pin[i]);
+  }
+  worker->nrun_pin = 0;
+}
+
 /* This routine is going to gather all required memory. It will lock the
  * distribution all required object and will release them after the execution
- * is finished. */
+ * is finished. Every cache line used by the task is pinned until the task 
+ * has been executed. */
 void cj_Worker_fetch (cj_Task *task, cj_Worker *worker) {
-  cj_Object *arg_I = task->arg->dqueue->head;
-  int i;
+  cj_Object *arg_I;
+  int k;
+  int dest = worker->device_id + 1;
+  int narg = cj_Dqueue_get_size(task->arg);
+  cj_Bool pinned[narg + 1];
+
+  /* Pin the arguments already on the device first, so that fetching the
+   * others can never evict them. */
+  arg_I = task->arg->dqueue->head;
+  for (k = 0; arg_I; k ++, arg_I = arg_I->next) {
+    pinned[k] = FALSE;
+    if (arg_I->objtype == CJ_MATRIX && worker->device_id != -1) {
+      cj_Matrix       *matrix = arg_I->matrix;
+      cj_Distribution *dist   = matrix->base->dist[matrix->offm/BLOCK_SIZE][matrix->offn/BLOCK_SIZE];
+
+      cj_Lock_acquire(&dist->lock);
+      {
+        if (dist->avail[dest] == TRUE) {
+          cj_Cache_pin(dist->device[dest], dist->line[dest]);
+          worker->run_pin[worker->nrun_pin ++] = dist->line[dest];
+          pinned[k] = TRUE;
+          cj_Stats_count(dist->device[dest], arg_I, CJ_STAT_HIT, 1);
+          if (dist->prefetched[dest] == TRUE) {
+            cj_Stats_count(dist->device[dest], arg_I, CJ_STAT_PREFETCH_HIT, 1);
+            dist->prefetched[dest] = FALSE;
+          }
+        }
+      }
+      cj_Lock_release(&dist->lock);
+    }
+  }
+  /* The prefetched lines are held by the pins above from now on. */
+  if (worker->device_id != -1) cj_Worker_release_prefetch(worker);
+
   /* Iterate all the arguments of the task */
-  while (arg_I) {
-    if (arg_I->objtype == CJ_MATRIX) {
+  arg_I = task->arg->dqueue->head;
+  for (k = 0; arg_I; k ++, arg_I = arg_I->next) {
+    if (arg_I->objtype == CJ_MATRIX && pinned[k] == FALSE) {
       cj_Matrix       *matrix = arg_I->matrix;
       cj_Matrix       *base   = matrix->base;
       cj_Distribution *dist   = base->dist[matrix->offm/BLOCK_SIZE][matrix->offn/BLOCK_SIZE];
-      
-      int dest = worker->device_id + 1;
 
       /* Acquire the distribution lock */
       cj_Lock_acquire(&dist->lock);
       {
         /* if the matrix has no latest copy on this worker */
-        if (dist->avail[dest] == FALSE) {
-          /* if there is no copy in the main memory of CPU */
-          if (dist->avail[0] == FALSE) {
-            for (i = 1; i < MAX_DEV + 1; i++) {
-              if (dist->avail[i] == TRUE) {
-                /* Sync Write Back */
-                fprintf(stderr, RED "(%d) Cache_writeback: %d\n" NONE, worker->device_id, i - 1);
-                /* pick a location from the distribution and write back */
-                cj_Cache_write_back(dist->device[i], dist->line[i], arg_I);
-                dist->avail[0] = TRUE;
-                break;
-              }
-            }
-          }
-          if (worker->device_id != -1) {
-            dist->line[dest]  = cj_Cache_fetch(dist->device[dest], arg_I);
-            dist->avail[dest] = TRUE;
-            fprintf(stderr, RED "(%d) Cache_fetch: %d\n" NONE, worker->device_id, dist->line[dest]);
-          }
+        if (worker->device_id != -1) {
+          cj_Stats_count(dist->device[dest], arg_I, (dist->avail[dest] == TRUE) ? CJ_STAT_HIT : CJ_STAT_MISS, 1);
         }
+        cj_Distribution_fetch(dist, dest, dist->tile);
+        if (worker->device_id == -1) cj_Disk_touch(arg_I);
         /* Lock the cache line here. */
+        if (worker->device_id != -1) {
+          cj_Cache_pin(dist->device[dest], dist->line[dest]);
+          worker->run_pin[worker->nrun_pin ++] = dist->line[dest];
+        }
       }
       cj_Lock_release(&dist->lock);
     }
-    arg_I = arg_I->next;
   }
   if (worker->device_id != -1) {
     cj_Cache_sync(cj.device[worker->device_id]);
   }
 }
 
-int cj_Worker_prefetch_d2h (cj_Worker *worker) {
-  cj_Object *object = worker->write_back->dqueue->head;
-  if (!object) return 0;
+/* Order tiles by matrix, tile column and tile row. */
+static int cj_Worker_tile_order (cj_Matrix *a, cj_Matrix *b) {
+  if (a->base != b->base) return ((uintptr_t) a->base < (uintptr_t) b->base) ? -1 : 1;
+  if (a->offn != b->offn) return (a->offn < b->offn) ? -1 : 1;
+  if (a->offm != b->offm) return (a->offm < b->offm) ? -1 : 1;
+  return 0;
+}
 
-  if (object->objtype == CJ_MATRIX) {
-    cj_Matrix       *matrix = object->matrix;
-    cj_Matrix       *base   = matrix->base;
-    cj_Distribution *dist   = base->dist[matrix->offm/BLOCK_SIZE][matrix->offn/BLOCK_SIZE];
+/* Whether tile b lies right below tile a, so that both are one strided copy,
+ * or one flat copy if the tiles are stored contiguously. */
+static cj_Bool cj_Worker_tile_below (cj_Matrix *a, cj_Matrix *b) {
+  cj_Matrix *base = a->base;
+  if (a->base == b->base && a->offn == b->offn && a->n == b->n && 
+      a->m == BLOCK_SIZE && b->offm == a->offm + BLOCK_SIZE) {
+    if (base->layout == CJ_LAYOUT_COLUMN) return TRUE;
+    if (cj_Matrix_addr(base, b->offm, b->offn, NULL) == 
+        cj_Matrix_addr(base, a->offm, a->offn, NULL) + (size_t) a->m*a->n*base->elelen) return TRUE;
+  }
+  return FALSE;
+}
 
-    int dest = worker->device_id + 1;
+/* Whether the tile can be prefetched from main memory to dest. */
+static cj_Bool cj_Worker_prefetchable (cj_Distribution *dist, int dest) {
+  if (dist->avail[dest] == FALSE && dist->state[dest] != CJ_INFLIGHT && dist->avail[0] == TRUE) return TRUE;
+  return FALSE;
+}
 
-    if (dist->avail[0] == TRUE) {
-      object = cj_Dqueue_pop_head(worker->write_back);
-      return 0;
+/**
+ * @brief  Prefetch the runs of vertically adjacent tiles read by the first 
+ *         queued tasks of a device worker. Each run is moved by one strided 
+ *         copy into cache lines sharing a block, instead of one copy per 
+ *         tile. The lines are held like those of the prefetched task. A run
+ *         is cut to fit the largest slab, tiles left alone are moved one by
+ *         one. Its block is rounded up to a power of two like any other,
+ *         so a run of three tiles takes the space of four.
+ * @param  *worker the device worker
+ */
+void cj_Worker_prefetch_runs (cj_Worker *worker) {
+  cj_Schedule *schedule = &cj.schedule;
+  cj_Device   *device   = cj.device[worker->device_id];
+  cj_Object   *tile[CACHE_LINE/2], *run[CACHE_RUN];
+  int dest = worker->device_id + 1, depth = max(device->cache.lookahead, 1);
+  int i, j, k, ld, ntile = 0, nrun, line[CACHE_RUN];
+  size_t len;
+
+  /* Gather the tiles worth a prefetch, sorted so that runs are contiguous.
+   * Their states are only a hint here and checked again under the lock. */
+  cj_Lock_acquire(&schedule->ready_queue_lock[worker->id]);
+  {
+    cj_Object *now = schedule->ready_queue[worker->id]->dqueue->head;
+    for (i = 0; now && i < depth; i++, now = now->next) {
+      cj_Object *arg_I = now->task->arg->dqueue->head;
+      for (; arg_I && ntile < CACHE_LINE/2; arg_I = arg_I->next) {
+        if (arg_I->objtype != CJ_MATRIX) continue;
+        cj_Matrix *matrix = arg_I->matrix;
+        cj_Distribution *dist = matrix->base->dist[matrix->offm/BLOCK_SIZE][matrix->offn/BLOCK_SIZE];
+        if (cj_Worker_prefetchable(dist, dest) == FALSE) continue;
+        matrix = dist->tile->matrix;
+        for (j = ntile; j > 0 && cj_Worker_tile_order(matrix, tile[j - 1]->matrix) < 0; j--);
+        if (j > 0 && cj_Worker_tile_order(matrix, tile[j - 1]->matrix) == 0) continue;
+        for (k = ntile; k > j; k--) tile[k] = tile[k - 1];
+        tile[j] = dist->tile;
+        ntile ++;
+      }
     }
-    if (dist->avail[dest] == FALSE) {
-      object = cj_Dqueue_pop_head(worker->write_back);
-      return 0;
-      //cj_error("cj_Worker_prefetch_d2h", "missing distribution");
+  }
+  cj_Lock_release(&schedule->ready_queue_lock[worker->id]);
+
+  for (i = 0; i < ntile; i = j) {
+    /* The tiles are stacked in one block with the height of the run. */
+    for (ld = tile[i]->matrix->m, j = i + 1; j < ntile && j - i < CACHE_RUN && 
+        cj_Worker_tile_below(tile[j - 1]->matrix, tile[j]->matrix) == TRUE &&
+        (size_t) (ld + tile[j]->matrix->m)*tile[i]->matrix->n*tile[i]->matrix->elelen <= 
+        (size_t) 1 << (CACHE_SLAB_MIN + CACHE_SLAB_CLASS - 1); j++) ld += tile[j]->matrix->m;
+    if (j - i < 2) continue;
+    len = (size_t) ld*tile[i]->matrix->n*tile[i]->matrix->elelen;
+
+    /* The run stops at the first tile which cannot be taken. */
+    for (nrun = 0, k = i; k < j && nrun == k - i; k++) {
+      cj_Matrix       *matrix = tile[k]->matrix;
+      cj_Distribution *dist   = matrix->base->dist[matrix->offm/BLOCK_SIZE][matrix->offn/BLOCK_SIZE];
+
+      cj_Lock_acquire(&dist->lock);
+      {
+        if (cj_Worker_prefetchable(dist, dest) == TRUE) {
+          size_t step = (matrix->base->layout == CJ_LAYOUT_COLUMN) ? BLOCK_SIZE : (size_t) BLOCK_SIZE*matrix->n;
+          int line_id = (nrun == 0) ? cj_Cache_line_size(device, tile[k], len) : 
+            cj_Cache_line_share(device, tile[k], line[0], nrun*step*matrix->elelen);
+          if (line_id != -1) {
+            dist->line[dest] = line_id;
+            cj_Distribution_set_state(dist, dest, CJ_INFLIGHT);
+            dist->reader[0] ++;
+            worker->pre_dist[worker->npre_dist ++] = dist;
+            cj_Cache_pin(device, line_id);
+            worker->pre_pin[worker->npre_pin ++] = line_id;
+            line[nrun] = line_id;
+            run[nrun ++] = tile[k];
+          }
+        }
+      }
+      cj_Lock_release(&dist->lock);
+    }
+    if (nrun > 0) {
+      cj_Cache_read_in_run(device, line, run, nrun, ld);
+      fprintf(stderr, GREEN "(%d) Cache_prefetch_h2d: %d (run of %d)\n" NONE, worker->device_id, line[0], nrun);
     }
-    /* This is an async write back and will be sync later. */
-    cj_Cache_async_write_back(dist->device[dest], dist->line[dest], object);
-    fprintf(stderr, GREEN "(%d) Cache_prefetch_d2h: %d\n" NONE, worker->device_id, dist->line[dest]);
   }
-  return 1;
 }
 
 //host to device
@@ -418,6 +938,9 @@ int cj_Worker_prefetch_h2d (cj_Worker *worker) {
   if (task) arg_I = task->task->arg->dqueue->head;
   else return 0;
 
+  /* Adjacent tiles go first, the tiles left are moved one by one. */
+  cj_Worker_prefetch_runs(worker);
+
   while (arg_I) {
     if (arg_I->objtype == CJ_MATRIX) {
       cj_Matrix       *matrix = arg_I->matrix;
@@ -426,53 +949,52 @@ int cj_Worker_prefetch_h2d (cj_Worker *worker) {
 
       int dest = worker->device_id + 1;
 
-      if (dist->avail[dest] == FALSE) {
-        if (dist->avail[0] == TRUE) {
-          /* This is an async fetch and will be sync later. */
-          dist->line[dest]  = cj_Cache_fetch(dist->device[dest], arg_I);
-          dist->avail[dest] = TRUE;
-          fprintf(stderr, GREEN "(%d) Cache_prefetch_h2d: %d\n" NONE, worker->device_id, dist->line[dest]);
+      cj_Lock_acquire(&dist->lock);
+      {
+        if (dist->avail[dest] == FALSE && dist->state[dest] != CJ_INFLIGHT && dist->avail[0] == TRUE) {
+          /* This is an async fetch and will be sync later. Never wait for a
+           * line, the task will fetch it itself. */
+          int line_id = cj_Cache_line(dist->device[dest], dist->tile);
+          if (line_id != -1) {
+            dist->line[dest] = line_id;
+            cj_Distribution_set_state(dist, dest, CJ_INFLIGHT);
+            dist->reader[0] ++;
+            worker->pre_dist[worker->npre_dist ++] = dist;
+            cj_Cache_read_in(dist->device[dest], line_id, dist->tile);
+            fprintf(stderr, GREEN "(%d) Cache_prefetch_h2d: %d\n" NONE, worker->device_id, dist->line[dest]);
+          }
+        }
+        /* Hold the line until the prefetched task is fetched. */
+        if (dist->line[dest] != -1) {
+          cj_Cache_pin(dist->device[dest], dist->line[dest]);
+          worker->pre_pin[worker->npre_pin ++] = dist->line[dest];
         }
       }
+      cj_Lock_release(&dist->lock);
     }
     arg_I = arg_I->next;
   }
   return 1;
 }
 
-void cj_Worker_wait_prefetch (cj_Worker *worker, int h2d, int d2h) {
-  if (h2d || d2h) {
+void cj_Worker_wait_prefetch (cj_Worker *worker, int h2d) {
+  int i, dest = worker->device_id + 1;
+  if (h2d) {
     cj_Cache_sync(cj.device[worker->device_id]);    
   }
-  if (d2h) {
-    cj_Object *object = cj_Dqueue_pop_head(worker->write_back);
-    if (!object) cj_error("cj_Worker_wait_prefetch", "missing object in write_back queue");
-    if (object->objtype == CJ_MATRIX) {
-      cj_Matrix       *matrix = object->matrix;
-      cj_Matrix       *base   = matrix->base;
-      cj_Distribution *dist   = base->dist[matrix->offm/BLOCK_SIZE][matrix->offn/BLOCK_SIZE];
-
-      int dest = worker->device_id + 1;
-      cj_Cache        *cache  = &dist->device[dest]->cache;
-
-      /* Critical Section */
-      cj_Lock_acquire(&dist->lock);
-      {
-        dist->avail[0] = TRUE;
-      }
-      cj_Lock_release(&dist->lock);
-
-      if (cache->status[dist->line[dest]] == CJ_CACHE_DIRTY) {
-        cache->status[dist->line[dest]] = CJ_CACHE_CLEAN;
-      }
+  /* The prefetched copies have landed. */
+  for (i = 0; i < worker->npre_dist; i++) {
+    cj_Distribution *dist = worker->pre_dist[i];
+    cj_Lock_acquire(&dist->lock);
+    {
+      dist->reader[0] --;
+      cj_Distribution_read(dist, dest, 0);
+      dist->prefetched[dest] = TRUE;
+      cj_Distribution_wake(dist);
     }
+    cj_Lock_release(&dist->lock);
   }
-}
-
-void cj_Worker_wait_execute (cj_Worker *worker) {
-  if (worker->device_id != -1) {
-    cj_Device_sync(cj.device[worker->device_id]);
-  }
+  worker->npre_dist = 0;
 }
 
 cj_Worker *cj_Worker_new (cj_devType devtype, int id) {
@@ -488,28 +1010,130 @@ cj_Worker *cj_Worker_new (cj_devType devtype, int id) {
   worker->id           = id;
   worker->device_id    = -1;
   worker->cj_ptr       = &cj;
-  worker->write_back   = cj_Object_new(CJ_DQUEUE); 
   worker->current_task = NULL;
+  worker->nrun_pin     = 0;
+  worker->npre_pin     = 0;
+  worker->npre_dist    = 0;
 
   fprintf(stderr, "  }\n"); 
   return worker;
 }
 
 /* performance model. Estimate the time cost for both computation and communication of CPU and GPU */
+/* Time (ms) to move the first tile of a task over a link (GB/s). */
+static float cj_Worker_io_cost (cj_Task *task, float link) {
+  cj_Matrix *matrix = task->arg->dqueue->head->matrix;
+  return (float) matrix->m*matrix->n*matrix->elelen/(link*1.0e+6);
+}
+
+/* Time (ms) to stage the tiles of a task from a device to main memory, and back
+ * for the RW ones. */
+static float cj_Worker_stage_cost (cj_Task *task) {
+  cj_Object *arg_I;
+  cj_Matrix *matrix;
+  float cost = 0.0;
+
+  for (arg_I = task->arg->dqueue->head; arg_I; arg_I = arg_I->next) {
+    if (arg_I->objtype != CJ_MATRIX) continue;
+    matrix = arg_I->matrix;
+    cost += ((arg_I->rwtype == CJ_RW) ? 2 : 1)*(float) matrix->m*matrix->n*matrix->elelen/(LINK_PCI*1.0e+6);
+  }
+  return cost;
+}
+
+/* Time (ms) a worker computes a task. The GEMM-like tiles and the Cholesky
+ * one have cuBLAS kernels; the kernels of the other factorizations run on the
+ * host through cj_Lapack_host_kernel, which stages their tiles on a CUDA
+ * worker. */
+static float cj_Worker_comp_cost (cj_Task *task, cj_Worker *worker) {
+  cj_Autotune *model = cj_Autotune_get_ptr();
+  cj_Bool cuda = (worker->devtype == CJ_DEV_CUDA) ? TRUE : FALSE;
+  float comp_cost = 0.0;
+
+  switch (task->tasktype) {
+    /* A tile of SYMM or SYR2K takes the flops of a GEMM one. */
+    case CJ_TASK_GEMM:
+    case CJ_TASK_SYMM:
+    case CJ_TASK_SYR2K:
+      return (cuda == TRUE) ? model->cublas_dgemm[0] : model->mkl_dgemm[0];
+    case CJ_TASK_SYRK:
+      return (cuda == TRUE) ? model->cublas_dsyrk[0] : model->mkl_dsyrk[0];
+    case CJ_TASK_TRSM:
+    case CJ_TASK_TRMM:
+      return (cuda == TRUE) ? model->cublas_dtrsm[0] : model->mkl_dtrsm[0];
+    case CJ_TASK_POTRF:
+      return (cuda == TRUE) ? model->hybrid_dpotrf[0] : model->mkl_dpotrf[0];
+    /* Tiles of files are staged through main memory on a device. */
+    case CJ_TASK_LOAD:
+    case CJ_TASK_STORE:
+      comp_cost = cj_Worker_io_cost(task, LINK_DISK);
+      if (worker->device_id != -1) comp_cost += cj_Worker_io_cost(task, LINK_PCI);
+      return comp_cost;
+    case CJ_TASK_COPY:
+      return cj_Worker_io_cost(task, LINK_HOST);
+    /* An LU tile takes about twice the flops of a Cholesky one. */
+    case CJ_TASK_GETRF:
+    case CJ_TASK_TSTRF:
+      comp_cost = 2*model->mkl_dpotrf[0];
+      break;
+    case CJ_TASK_GESSM:
+    case CJ_TASK_TRSMD:
+      comp_cost = model->mkl_dtrsm[0];
+      break;
+    /* GEQRT takes four times the flops of a Cholesky tile, TPQRT and GEMQRT those
+     * of a GEMM and TPMQRT twice as many. */
+    case CJ_TASK_GEQRT:
+      comp_cost = 4*model->mkl_dpotrf[0];
+      break;
+    case CJ_TASK_TPMQRT:
+      comp_cost = 2*model->mkl_dgemm[0];
+      break;
+    /* The LDL' tiles are costed as their Cholesky counterparts, TRTRI and LAUUM
+     * as a Cholesky tile. */
+    case CJ_TASK_SYTRF:
+    case CJ_TASK_TRTRI:
+    case CJ_TASK_LAUUM:
+      comp_cost = model->mkl_dpotrf[0];
+      break;
+    /* A tile of Cholesky rotations takes three times the flops of a GEMM one. */
+    case CJ_TASK_ROTG:
+    case CJ_TASK_ROT:
+      comp_cost = 3*model->mkl_dgemm[0];
+      break;
+    /* The butterflies and diagonal scalings of LDL', the log-determinant and
+     * the tile transpositions of the eigensolver are a pass over their tiles. */
+    case CJ_TASK_DIAG:
+    case CJ_TASK_SYRBT:
+    case CJ_TASK_GERBT:
+    case CJ_TASK_LOGDET:
+    case CJ_TASK_TRANS:
+      comp_cost = cj_Worker_io_cost(task, LINK_HOST);
+      break;
+    /* SSSSM, TPQRT, GEMQRT and GEMDM take the flops of a GEMM tile; the band,
+     * tridiagonal and back-transformation tasks of the eigensolver are costed
+     * as one. */
+    case CJ_TASK_SSSSM:
+    case CJ_TASK_TPQRT:
+    case CJ_TASK_GEMQRT:
+    case CJ_TASK_GEMDM:
+    case CJ_TASK_SBTRD:
+    case CJ_TASK_STEBZ:
+    case CJ_TASK_STEIN:
+    case CJ_TASK_ORMTR:
+      comp_cost = model->mkl_dgemm[0];
+      break;
+  }
+  /* The factorization kernels above run on the host. */
+  if (cuda == TRUE) comp_cost += cj_Worker_stage_cost(task);
+  return comp_cost;
+}
+
 float cj_Worker_estimate_cost (cj_Task *task, cj_Worker *worker) {
   /* Here it is very similar to a construct function in C++/Java. We implement in C */
   cj_Autotune *model = cj_Autotune_get_ptr(); 
-  float comp_cost = 0.0, comm_cost = 0.0, cost = 0.0;
-
-  if (worker->devtype == CJ_DEV_CUDA) {
-    if (task->function == &cj_Gemm_nn_task_function)
-      comp_cost = model->cublas_dgemm[0];
-    if (task->function == &cj_Syrk_ln_task_function)
-      comp_cost = model->cublas_dsyrk[0];
-    if (task->function == &cj_Trsm_rlt_task_function)
-      comp_cost = model->cublas_dtrsm[0];
-    if (task->function == &cj_Chol_l_task_function)
-      comp_cost = model->hybrid_dpotrf[0];
+  float comp_cost = cj_Worker_comp_cost(task, worker), comm_cost = 0.0, cost = 0.0;
+
+  if (worker->devtype == CJ_DEV_CUDA || worker->devtype == CJ_DEV_HOST) {
     /* Scan through all arguments. */
     cj_Object *arg_I = task->arg->dqueue->head;
     while (arg_I) {
@@ -533,14 +1157,6 @@ float cj_Worker_estimate_cost (cj_Task *task, cj_Worker *worker) {
     }
   }
   else if (worker->devtype == CJ_DEV_CPU) {
-    if (task->function == &cj_Gemm_nn_task_function)
-      comp_cost = model->mkl_dgemm[0];
-    if (task->function == &cj_Syrk_ln_task_function)
-      comp_cost = model->mkl_dsyrk[0];
-    if (task->function == &cj_Trsm_rlt_task_function)
-      comp_cost = model->mkl_dtrsm[0];
-    if (task->function == &cj_Chol_l_task_function)
-      comp_cost = model->mkl_dpotrf[0];
     cj_Object *arg_I = task->arg->dqueue->head;
     while (arg_I) {
       if (arg_I->objtype == CJ_MATRIX) {
@@ -567,7 +1183,7 @@ int cj_Worker_execute (cj_Task *task, cj_Worker *worker) {
   task->status = RUNNING;
   task->worker = worker;
   worker->current_task = task;
-  int i;
+  int s = 0;
 
   //fprintf(stderr, "%s\n", task->name);
 
@@ -579,21 +1195,40 @@ int cj_Worker_execute (cj_Task *task, cj_Worker *worker) {
   //fprintf(stderr, "before wait prefetch\n");
   
   /* prefetch.... */
-  int d2h = cj_Worker_prefetch_d2h(worker);
+  cj_Worker_prefetch_disk(worker);
   int h2d = cj_Worker_prefetch_h2d(worker);
   //fprintf(stderr, "after prefetch\n");
   //usleep((unsigned int) task->cost);
   //fprintf(stderr, "after fetch\n");
   
-  /* Change cache status here. */
+  /* A device task is issued on a stream of its own and the worker moves on
+   * without waiting. The stream holds the lines of the task until it is 
+   * retired, later tasks and copies out of the lines wait for it on the 
+   * device. */
+  if (worker->device_id != -1) {
+    cj_Device *device = cj.device[worker->device_id];
+    cj_Object *arg_I  = task->arg->dqueue->head;
+    s = cj_Device_stream_begin(device);
+    while (arg_I) {
+      if (arg_I->objtype == CJ_MATRIX) {
+        cj_Matrix       *matrix = arg_I->matrix;
+        cj_Distribution *dist   = matrix->base->dist[matrix->offm/BLOCK_SIZE][matrix->offn/BLOCK_SIZE];
+        cj_Device_stream_use(device, s, dist->line[worker->device_id + 1], 
+            (arg_I->rwtype == CJ_R) ? FALSE : TRUE);
+      }
+      arg_I = arg_I->next;
+    }
+  }
+
   /* Kernel function is here... */
   cj_Profile_worker_record(worker, CJ_EVENT_TASK_RUN_BEG);
   (*task->function)((void *) task);
-  cj_Worker_wait_execute(worker);
+  if (worker->device_id != -1) cj_Device_stream_end(cj.device[worker->device_id], s);
   cj_Profile_worker_record(worker, CJ_EVENT_TASK_RUN_END);
 
 
-  /* if did prefech or write back, then update the distribution of those prefectched objects*/
+  /* The written tiles are owned by this worker now. Their main memory copies
+   * are only refreshed when someone needs them there. */
   cj_Object *arg_I = task->arg->dqueue->head;
   while (arg_I) {
     if (arg_I->objtype == CJ_MATRIX) {
@@ -604,25 +1239,19 @@ int cj_Worker_execute (cj_Task *task, cj_Worker *worker) {
       int dest = worker->device_id + 1;
 
       if (arg_I->rwtype == CJ_W || arg_I->rwtype == CJ_RW) {
-
         /* Critical Section */
         cj_Lock_acquire(&dist->lock);
         {
-          for (i = 0; i < MAX_DEV + 1; i++) {
-            if (i != dest) {
-              dist->avail[i] = FALSE;
-              dist->line[i] = -1;
-            }
-          }
+          cj_Distribution_write(dist, dest);
         }
         cj_Lock_release(&dist->lock);
-        cj_Dqueue_push_tail(worker->write_back, cj_Object_append(CJ_MATRIX, (void *) matrix));
       }
     }
     arg_I = arg_I->next;
   }
 
-  cj_Worker_wait_prefetch(worker, h2d, d2h);
+  cj_Worker_wait_prefetch(worker, h2d);
+  if (worker->device_id != -1) cj_Worker_release_run(worker);
   worker->current_task = NULL;
 
   return 1;
@@ -642,6 +1271,9 @@ void *cj_Worker_entry_point (void *arg) {
 #endif      
       fprintf(stderr, YELLOW "  Worker_entry_point (%d): device(%d) \n" NONE, id, me->device_id);
     }
+    else if (me->devtype == CJ_DEV_HOST) {
+      fprintf(stderr, YELLOW "  Worker_entry_point (%d): host device(%d) \n" NONE, id, me->device_id);
+    }
   }
 
   while (1) {
@@ -671,6 +1303,7 @@ void *cj_Worker_entry_point (void *arg) {
     int ntask = cj_Dqueue_get_size(cj_Graph_vertex_get());
     if (cj.terminate == TRUE && schedule->ntask == ntask) break;
   }
+  if (me->device_id != -1) cj_Device_drain(cj.device[me->device_id]);
 
   return NULL;
 }
@@ -706,6 +1339,24 @@ void cj_Queue_end() {
   cj_queue_enable = FALSE;
 }
 
+/* Wait until every task submitted so far has finished. Results can then be
+ * read on the host with cj_Object_acquire, and more tasks submitted. */
+void cj_Sync() {
+  cj_Schedule *schedule = &cj.schedule;
+  int ntask;
+
+  while (1) {
+    ntask = cj_Dqueue_get_size(cj_Graph_vertex_get());
+    cj_Lock_acquire(&schedule->ntask_lock);
+    if (schedule->ntask == ntask) {
+      cj_Lock_release(&schedule->ntask_lock);
+      break;
+    }
+    cj_Lock_release(&schedule->ntask_lock);
+    sched_yield();
+  }
+}
+
 /* ---------------------------------------------------------------------
  * cj_Schedule
  * ---------------------------------------------------------------------
@@ -727,6 +1378,50 @@ void cj_Schedule_init() {
   cj_Lock_new(&schedule->mic_lock);
 }
 
+/**
+ * @brief  Emulate devices in host memory. Each emulated device owns a worker
+ *         and a software cache like a GPU, but copies with memcpy and runs
+ *         the CPU kernels on its cache lines. Call it before cj_Init.
+ * @param  ndevice number of emulated devices
+ */
+void cj_Device_emulate (int ndevice) {
+  if (ndevice < 0 || ndevice > MAX_DEV) cj_error("Device_emulate", "invalid number of devices.");
+  cj_host_device = ndevice;
+}
+
+/**
+ * @brief  Return a data-movement counter of a device.
+ * @param  device_id device id
+ * @param  type counter
+ * @return count, or bytes for transfers
+ */
+long long cj_Device_stats (int device_id, cj_statType type) {
+  if (device_id < 0 || device_id >= cj.ngpu + cj.nmic + cj.nhost) cj_error("Device_stats", "invalid device.");
+  return cj.device[device_id]->stats.count[type];
+}
+
+/* Clear the data-movement counters of every device. */
+void cj_Device_stats_reset () {
+  int i, j;
+  for (i = 0; i < cj.ngpu + cj.nmic + cj.nhost; i++) {
+    for (j = 0; j < CJ_STAT_NUM; j++) cj.device[i]->stats.count[j] = 0;
+  }
+}
+
+/* Print the data-movement counters of every device. */
+void cj_Stats_print () {
+  int i;
+  fprintf(stderr, "  dev      hit     miss    evict  wr_back  pre_hit pre_wast  overlap   s_wait    H2D(MB)    D2H(MB)    D2D(MB)\n");
+  for (i = 0; i < cj.ngpu + cj.nmic + cj.nhost; i++) {
+    long long *count = cj.device[i]->stats.count;
+    fprintf(stderr, "  %3d %8lld %8lld %8lld %8lld %8lld %8lld %8lld %8lld %10.2f %10.2f %10.2f\n", i, 
+        count[CJ_STAT_HIT], count[CJ_STAT_MISS], count[CJ_STAT_EVICT], count[CJ_STAT_WRITE_BACK], 
+        count[CJ_STAT_PREFETCH_HIT], count[CJ_STAT_PREFETCH_WASTE], 
+        count[CJ_STAT_OVERLAP], count[CJ_STAT_STREAM_WAIT], 
+        count[CJ_STAT_H2D]/1048576.0, count[CJ_STAT_D2H]/1048576.0, count[CJ_STAT_D2D]/1048576.0);
+  }
+}
+
 void cj_Init(int nworker) {
   fprintf(stderr, RED "Init : \n" NONE); 
   fprintf(stderr, "{\n"); 
@@ -735,7 +1430,7 @@ void cj_Init(int nworker) {
   cudaDeviceReset();
 #endif
 
-  int i, ret;
+  int i, j, ret;
   void *(*worker_entry_point)(void *);
   cj.terminate = FALSE;
   cj_Profile_init();
@@ -753,8 +1448,16 @@ void cj_Init(int nworker) {
     if (!cj.worker[i]) cj_error("Init", "memory allocation failed.");
   }
 
+#ifdef CJ_HAVE_CUDA
   cj.ngpu = GPU_NUM;
+#else
+  cj.ngpu = 0;
+#endif
   cj.nmic = 0;
+  cj.nhost = cj_host_device;
+  if (cj.ngpu + cj.nmic + cj.nhost > min(MAX_DEV, nworker - 1)) {
+    cj_error("Init", "Every device needs a worker thread of its own.");
+  }
   for (i = 0; i < cj.ngpu; i++) {
     cj.device[i] = cj_Device_new(CJ_DEV_CUDA, i); 
     cj_Device_bind(cj.worker[i + 1], cj.device[i]);
@@ -763,6 +1466,13 @@ void cj_Init(int nworker) {
     cj.device[i] = cj_Device_new(CJ_DEV_MIC, i);
     cj_Device_bind(cj.worker[i + 1], cj.device[i]);
   }
+  for (i = cj.ngpu + cj.nmic; i < cj.ngpu + cj.nmic + cj.nhost; i++) {
+    cj.device[i] = cj_Device_new(CJ_DEV_HOST, i);
+    cj_Device_bind(cj.worker[i + 1], cj.device[i]);
+  }
+  for (i = 0; i < cj.ngpu + cj.nmic + cj.nhost; i++) {
+    for (j = 0; j < cj.ngpu + cj.nmic + cj.nhost; j++) cj_Device_link(cj.device[i], cj.device[j]);
+  }
 
 
   /* Set up pthread_create parameters. */
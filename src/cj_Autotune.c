@@ -51,7 +51,7 @@ void cj_Autotune_cublas () {
   float fone = 1.0, fmone = -1.0;
   double done = 1.0, dmone = -1.0;
   float *A, *B, *C;
-  double *dA, *dB, *dC, *hA;
+  double *dA, *dB, *dC, *hA, *work;
   int info;
 
   cublasStatus_t status;
@@ -130,10 +130,12 @@ void cj_Autotune_cublas () {
     fprintf(stderr, "  cublasDtrsm(%d, %d, %d) : %f ms\n", nb, nb, nb, time_ms);	
     autotune->cublas_dtrsm[i] = time_ms;
 
+    cudaMallocHost((void**)&work, hybrid_dpotrf_lwork(nb));
     cudaEventRecord(beg, 0);
-    hybrid_dpotrf (&handle, nb, dA, ld, &info);
+    hybrid_dpotrf (&handle, nb, dA, ld, work, &info);
     cudaEventRecord(end, 0);
     cudaEventSynchronize(end);
+    cudaFreeHost(work);
     cudaEventElapsedTime(&time_ms, beg, end);
     fprintf(stderr, "  hybridDpotrf(%d, %d, %d) : %f ms\n", nb, nb, nb, time_ms);	
     autotune->hybrid_dpotrf[i] = time_ms;
@@ -174,17 +176,17 @@ void cj_Autotune_mkl () {
   for (i = 0; i < AUTOTUNE_GRID; i++) {
     nb = (i + 1)*BLOCK_SIZE;
     t = clock();
-    sgemm_("N", "N", &nb, &nb, &nb, &fmone, A, &ld, B, &ld, &fone, C, &ld);
+    cj_Kernel_sgemm("N", "N", &nb, &nb, &nb, &fmone, A, &ld, B, &ld, &fone, C, &ld);
     time_ms = ((float) (clock() - t))/1000;
     fprintf(stderr, "  Sgemm(%d, %d, %d) : %f ms\n", nb, nb, nb, time_ms);	
     autotune->mkl_sgemm[i] = time_ms;
     t = clock();
-    ssyrk_("L", "N", &nb, &nb, &fmone, A, &ld, &fone, C, &ld);
+    cj_Kernel_ssyrk("L", "N", &nb, &nb, &fmone, A, &ld, &fone, C, &ld);
     time_ms = ((float) (clock() - t))/1000;
     fprintf(stderr, "  Ssyrk(%d, %d, %d) : %f ms\n", nb, nb, nb, time_ms);	
     autotune->mkl_ssyrk[i] = time_ms;
     t = clock();
-    strsm_("R", "L", "T", "N", &nb, &nb, &fone, A, &ld, B, &ld);
+    cj_Kernel_strsm("R", "L", "T", "N", &nb, &nb, &fone, A, &ld, B, &ld);
     time_ms = ((float) (clock() - t))/1000;
     fprintf(stderr, "  Strsm(%d, %d, %d) : %f ms\n", nb, nb, nb, time_ms);	
     autotune->mkl_strsm[i] = time_ms;
@@ -193,22 +195,22 @@ void cj_Autotune_mkl () {
   for (i = 0; i < AUTOTUNE_GRID; i++) {
     nb = (i + 1)*BLOCK_SIZE;
     t = clock();
-    dgemm_("N", "N", &nb, &nb, &nb, &dmone, dA, &ld, dB, &ld, &done, dC, &ld);
+    cj_Kernel_dgemm("N", "N", &nb, &nb, &nb, &dmone, dA, &ld, dB, &ld, &done, dC, &ld);
     time_ms = ((float) (clock() - t))/1000;
     fprintf(stderr, "  Dgemm(%d, %d, %d) : %f ms\n", nb, nb, nb, time_ms);	
     autotune->mkl_dgemm[i] = time_ms;
     t = clock();
-    dsyrk_("L", "N", &nb, &nb, &dmone, dA, &ld, &done, dC, &ld);
+    cj_Kernel_dsyrk("L", "N", &nb, &nb, &dmone, dA, &ld, &done, dC, &ld);
     time_ms = ((float) (clock() - t))/1000;
     fprintf(stderr, "  Dsyrk(%d, %d, %d) : %f ms\n", nb, nb, nb, time_ms);	
     autotune->mkl_dsyrk[i] = time_ms;
     t = clock();
-    dtrsm_("R", "L", "T", "N", &nb, &nb, &done, dA, &ld, dB, &ld);
+    cj_Kernel_dtrsm("R", "L", "T", "N", &nb, &nb, &done, dA, &ld, dB, &ld);
     time_ms = ((float) (clock() - t))/1000;
     fprintf(stderr, "  Dtrsm(%d, %d, %d) : %f ms\n", nb, nb, nb, time_ms);	
     autotune->mkl_dtrsm[i] = time_ms;
     t = clock();
-    dpotrf_("L", &nb, dA, &ld, &info);
+    cj_Kernel_dpotrf("L", &nb, dA, &ld, &info);
     time_ms = ((float) (clock() - t))/1000;
     fprintf(stderr, "  Dpotrf(%d, %d, %d) : %f ms\n", nb, nb, nb, time_ms);	
     autotune->mkl_dpotrf[i] = time_ms;
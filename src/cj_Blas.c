@@ -18,75 +18,63 @@ void cj_Blas_error (const char *func_name, char* msg_text) {
   exit(0);
 }
 
-void cj_Gemm_nn_task_function (void *task_ptr) {
+/* C:= alpha * op(A) * op(B) + beta * C on one tile of C, alpha and beta follow C in the arguments. */
+static void cj_Gemm_kernel (void *task_ptr, cj_Trans transa, cj_Trans transb) {
   cj_Task *task = (cj_Task *) task_ptr;
   cj_Worker *worker = task->worker;
   cj_devType devtype = worker->devtype;
   int device_id = worker->device_id;
-  int dest = device_id + 1;
+  int lda, ldb, ldc, k;
+  double alpha, beta;
 
   cj_Object *A, *B, *C;
   cj_Matrix *a, *b, *c;
+  char *a_ptr, *b_ptr, *c_ptr;
   A = task->arg->dqueue->head;
   B = A->next;
   C = B->next;
+  alpha = cj_Constant_get(C->next);
+  beta  = cj_Constant_get(C->next->next);
   a = A->matrix;
   b = B->matrix;
   c = C->matrix;
+  k = (transa == CJ_NOTRANS) ? a->n : a->m;
+  a_ptr = cj_Worker_get_buff(worker, a, &lda);
+  b_ptr = cj_Worker_get_buff(worker, b, &ldb);
+  c_ptr = cj_Worker_get_buff(worker, c, &ldc);
 
   if (device_id != -1 && devtype == CJ_DEV_CUDA) {
 #ifdef CJ_HAVE_CUDA
     cudaSetDevice(device_id);
     cj_Device *device = worker->cj_ptr->device[device_id];
-    cj_Cache *cache = &(device->cache);
     cublasHandle_t *handle = &(device->handle);
+    cublasOperation_t opa = (transa == CJ_NOTRANS) ? CUBLAS_OP_N : CUBLAS_OP_T;
+    cublasOperation_t opb = (transb == CJ_NOTRANS) ? CUBLAS_OP_N : CUBLAS_OP_T;
     cublasStatus_t status;
-    cj_Distribution *dist_a = a->base->dist[a->offm/BLOCK_SIZE][a->offn/BLOCK_SIZE];
-    cj_Distribution *dist_b = b->base->dist[b->offm/BLOCK_SIZE][b->offn/BLOCK_SIZE];
-    cj_Distribution *dist_c = c->base->dist[c->offm/BLOCK_SIZE][c->offn/BLOCK_SIZE];
-    if (dist_a->avail[dest] != TRUE || dist_b->avail[dest] != TRUE || dist_c->avail[dest]) {
-      cj_Blas_error("cj_Gemm_nn_task_function", "No propriate distribution.");
-    }
 
     if (a->eletype == CJ_SINGLE) { 
-      float f_one = 1.0;
-	  float f_mone = -1.0;
-      float *a_buff = (float *) cache->dev_ptr[dist_a->line[dest]];
-      float *b_buff = (float *) cache->dev_ptr[dist_b->line[dest]];
-      float *c_buff = (float *) cache->dev_ptr[dist_c->line[dest]];
-      status = cublasSgemm(*handle, CUBLAS_OP_N, CUBLAS_OP_N, c->m, a->n, c->n, &f_one, a_buff, BLOCK_SIZE, 
-          b_buff, BLOCK_SIZE, &f_one, c_buff, BLOCK_SIZE);
+      float f_alpha = (float) alpha;
+      float f_beta  = (float) beta;
+      status = cublasSgemm(*handle, opa, opb, c->m, c->n, k, &f_alpha, (float *) a_ptr, lda, 
+          (float *) b_ptr, ldb, &f_beta, (float *) c_ptr, ldc);
     }
     else {
-      double f_one = 1.0;
-	  double f_mone = -1.0;
-      double *a_buff = (double *) cache->dev_ptr[dist_a->line[dest]];
-      double *b_buff = (double *) cache->dev_ptr[dist_b->line[dest]];
-      double *c_buff = (double *) cache->dev_ptr[dist_c->line[dest]];
-      //fprintf(stderr, "%d, %d, %d, %d\n", c->m, a->n, c->n, BLOCK_SIZE);
-      //fprintf(stderr, "%d, %d, %d\n", (int) a_buff, (int) b_buff, (int) c_buff);
-      status = cublasDgemm(*handle, CUBLAS_OP_N, CUBLAS_OP_N, c->m, a->n, c->n, &f_one, a_buff, BLOCK_SIZE, 
-          b_buff, BLOCK_SIZE, &f_one, c_buff, BLOCK_SIZE);
+      status = cublasDgemm(*handle, opa, opb, c->m, c->n, k, &alpha, (double *) a_ptr, lda, 
+          (double *) b_ptr, ldb, &beta, (double *) c_ptr, ldc);
     }
-    if (status != CUBLAS_STATUS_SUCCESS) cj_Blas_error("cj_Gemm_nn_task_function", "cublas failure");
+    if (status != CUBLAS_STATUS_SUCCESS) cj_Blas_error("cj_Gemm_kernel", "cublas failure");
 #endif
   }
   else {
+    char *ta = (transa == CJ_NOTRANS) ? "N" : "T";
+    char *tb = (transb == CJ_NOTRANS) ? "N" : "T";
     if (a->eletype == CJ_SINGLE) {
-      float f_one = 1.0;
-	  float f_mone = -1.0;
-      float *a_buff = (float *) (a->base->buff) + (a->base->m)*(a->offn) + a->offm;
-      float *b_buff = (float *) (b->base->buff) + (b->base->m)*(b->offn) + b->offm;
-      float *c_buff = (float *) (c->base->buff) + (c->base->m)*(c->offn) + c->offm;
-      sgemm_("N", "N", &(c->m), &(a->n), &(c->n), &f_one, a_buff, &(a->base->m), b_buff, &(b->base->m), &f_one, c_buff, &(c->base->m));
+      float f_alpha = (float) alpha;
+      float f_beta  = (float) beta;
+      cj_Kernel_sgemm(ta, tb, &(c->m), &(c->n), &k, &f_alpha, (float *) a_ptr, &lda, (float *) b_ptr, &ldb, &f_beta, (float *) c_ptr, &ldc);
     }
     else {
-      double f_one = 1.0;
-	  double f_mone = -1.0;
-      double *a_buff = (double *) (a->base->buff) + (a->base->m)*(a->offn) + a->offm;
-      double *b_buff = (double *) (b->base->buff) + (b->base->m)*(b->offn) + b->offm;
-      double *c_buff = (double *) (c->base->buff) + (c->base->m)*(c->offn) + c->offm;
-      dgemm_("N", "N", &(c->m), &(a->n), &(c->n), &f_one, a_buff, &(a->base->m), b_buff, &(b->base->m), &f_one, c_buff, &(c->base->m));
+      cj_Kernel_dgemm(ta, tb, &(c->m), &(c->n), &k, &alpha, (double *) a_ptr, &lda, (double *) b_ptr, &ldb, &beta, (double *) c_ptr, &ldc);
     }
   }
 
@@ -97,10 +85,28 @@ void cj_Gemm_nn_task_function (void *task_ptr) {
       c->offm/BLOCK_SIZE, c->offn/BLOCK_SIZE);  
 }
 
-void cj_Gemm_nn_task(cj_Object *alpha, cj_Object *A, cj_Object *B, cj_Object *beta, cj_Object *C) {
+void cj_Gemm_nn_task_function (void *task_ptr) {
+  cj_Gemm_kernel(task_ptr, CJ_NOTRANS, CJ_NOTRANS);
+}
+
+void cj_Gemm_nt_task_function (void *task_ptr) {
+  cj_Gemm_kernel(task_ptr, CJ_NOTRANS, CJ_TRANS);
+}
+
+void cj_Gemm_tn_task_function (void *task_ptr) {
+  cj_Gemm_kernel(task_ptr, CJ_TRANS, CJ_NOTRANS);
+}
+
+void cj_Gemm_tt_task_function (void *task_ptr) {
+  cj_Gemm_kernel(task_ptr, CJ_TRANS, CJ_TRANS);
+}
+
+static void cj_Gemm_task (cj_Trans transa, cj_Trans transb, 
+    cj_Object *alpha, cj_Object *A, cj_Object *B, cj_Object *beta, cj_Object *C) {
   /* Gemm will read A, B, C and write C. */
-  cj_Object *A_copy, *B_copy, *C_copy, *task;
+  cj_Object *A_copy, *B_copy, *C_copy, *alpha_copy, *beta_copy, *task;
   cj_Matrix *a, *b, *c;
+  void (*function)(void*);
   
   /* Generate copies of A, B and C. */
   A_copy = cj_Object_new(CJ_MATRIX);
@@ -110,18 +116,21 @@ void cj_Gemm_nn_task(cj_Object *alpha, cj_Object *A, cj_Object *B, cj_Object *be
   cj_Matrix_duplicate(B, B_copy);
   cj_Matrix_duplicate(C, C_copy);
 
+  /* The scalars are taken by value, the caller may change them after submission. */
+  alpha_copy = cj_Object_new(CJ_CONSTANT);
+  beta_copy  = cj_Object_new(CJ_CONSTANT);
+  cj_Constant_set(alpha_copy, cj_Constant_get(alpha));
+  cj_Constant_set(beta_copy,  cj_Constant_get(beta));
+
   a = A_copy->matrix; b = B_copy->matrix; c = C_copy->matrix;
-  /*
-     fprintf(stderr, "          a->base : %d\n", (int)a->base);
-     fprintf(stderr, "          b->base : %d\n", (int)b->base);
-     fprintf(stderr, "          c->base : %d\n", (int)c->base);
-     fprintf(stderr, "          a->offm : %d, a->offn : %d\n", a->offm, a->offn);
-     fprintf(stderr, "          b->offm : %d, b->offn : %d\n", b->offm, b->offn);
-     fprintf(stderr, "          c->offm : %d, c->offn : %d\n", c->offm, c->offn);
-  */   
+
+  if (transa == CJ_NOTRANS) 
+    function = (transb == CJ_NOTRANS) ? &cj_Gemm_nn_task_function : &cj_Gemm_nt_task_function;
+  else
+    function = (transb == CJ_NOTRANS) ? &cj_Gemm_tn_task_function : &cj_Gemm_tt_task_function;
 
   task = cj_Object_new(CJ_TASK);
-  cj_Task_set(task->task, CJ_TASK_GEMM, &cj_Gemm_nn_task_function);
+  cj_Task_set(task->task, CJ_TASK_GEMM, function);
 
   /* Pushing arguments. */
   cj_Object *arg_A = cj_Object_append(CJ_MATRIX, a);
@@ -130,20 +139,67 @@ void cj_Gemm_nn_task(cj_Object *alpha, cj_Object *A, cj_Object *B, cj_Object *be
   arg_A->rwtype = CJ_R;
   arg_B->rwtype = CJ_R;
   arg_C->rwtype = CJ_RW;
+  alpha_copy->rwtype = CJ_R;
+  beta_copy->rwtype  = CJ_R;
   cj_Dqueue_push_tail(task->task->arg, arg_A);
   cj_Dqueue_push_tail(task->task->arg, arg_B);
   cj_Dqueue_push_tail(task->task->arg, arg_C);
+  cj_Dqueue_push_tail(task->task->arg, alpha_copy);
+  cj_Dqueue_push_tail(task->task->arg, beta_copy);
 
   /* Setup task name. */
-  snprintf(task->task->name,  64, "Gemm_nn%d", task->task->id);
-  snprintf(task->task->label, 64, "C%d%d-=A%d%d*B%d%d",
-      c->offm/BLOCK_SIZE, c->offn/BLOCK_SIZE,
-      a->offm/BLOCK_SIZE, a->offn/BLOCK_SIZE,
-      b->offm/BLOCK_SIZE, b->offn/BLOCK_SIZE );
+  snprintf(task->task->name,  64, "Gemm_%c%c%d", 
+      (transa == CJ_NOTRANS) ? 'n' : 't', (transb == CJ_NOTRANS) ? 'n' : 't', task->task->id);
+  snprintf(task->task->label, 128, "C%d%d=%g*A%d%d%s*B%d%d%s+%g*C",
+      c->offm/BLOCK_SIZE, c->offn/BLOCK_SIZE, cj_Constant_get(alpha),
+      a->offm/BLOCK_SIZE, a->offn/BLOCK_SIZE, (transa == CJ_NOTRANS) ? "" : "'",
+      b->offm/BLOCK_SIZE, b->offn/BLOCK_SIZE, (transb == CJ_NOTRANS) ? "" : "'",
+      cj_Constant_get(beta));
 
   cj_Task_dependency_analysis(task);
 }
 
+void cj_Gemm_nn_task(cj_Object *alpha, cj_Object *A, cj_Object *B, cj_Object *beta, cj_Object *C) {
+  cj_Gemm_task(CJ_NOTRANS, CJ_NOTRANS, alpha, A, B, beta, C);
+}
+
+void cj_Gemm_nt_task(cj_Object *alpha, cj_Object *A, cj_Object *B, cj_Object *beta, cj_Object *C) {
+  cj_Gemm_task(CJ_NOTRANS, CJ_TRANS, alpha, A, B, beta, C);
+}
+
+/* C:= alpha * op(A) * op(B) + beta * C on tiles, C: m*n, op(A): m*k, op(B): k*n. 
+ * beta is applied by the first update of each tile of C, the others accumulate. */
+static void cj_Gemm_tiles (cj_Trans transa, cj_Trans transb, 
+    cj_Object *alpha, cj_Object *A, cj_Object *B, cj_Object *beta, cj_Object *C) {
+  cj_Matrix *c = C->matrix;
+  cj_Object *A_tile, *B_tile, *C_tile, *one;
+  int i, j, p;
+  int k = (transa == CJ_NOTRANS) ? A->matrix->n : A->matrix->m;
+
+  A_tile = cj_Object_new(CJ_MATRIX);
+  B_tile = cj_Object_new(CJ_MATRIX);
+  C_tile = cj_Object_new(CJ_MATRIX);
+  cj_Matrix_duplicate(A, A_tile);
+  cj_Matrix_duplicate(B, B_tile);
+  cj_Matrix_duplicate(C, C_tile);
+  one = cj_Object_new(CJ_CONSTANT);
+  cj_Constant_set(one, 1.0);
+
+  for (j = 0; j < c->n; j += BLOCK_SIZE) {
+    for (i = 0; i < c->m; i += BLOCK_SIZE) {
+      for (p = 0; p < k; p += BLOCK_SIZE) {
+        /* op(A)(i, p) and op(B)(p, j), stored transposed if op is a transpose. */
+        if (transa == CJ_NOTRANS) cj_Matrix_tile(A, A_tile, i, p);
+        else cj_Matrix_tile(A, A_tile, p, i);
+        if (transb == CJ_NOTRANS) cj_Matrix_tile(B, B_tile, p, j);
+        else cj_Matrix_tile(B, B_tile, j, p);
+        cj_Matrix_tile(C, C_tile, i, j);
+        cj_Gemm_task(transa, transb, alpha, A_tile, B_tile, (p == 0) ? beta : one, C_tile);
+      }
+    }
+  }
+}
+
 void cj_Gebp_nn(cj_Object *A, cj_Object *B, cj_Object *C) {
   fprintf(stderr, RED "        Gebp_nn (A(%d, %d), B(%d, %d), C(%d, %d)): \n" NONE, 
       A->matrix->m, A->matrix->n,
@@ -153,7 +209,8 @@ void cj_Gebp_nn(cj_Object *A, cj_Object *B, cj_Object *C) {
   cj_Object *alpha, *beta;
   alpha = cj_Object_new(CJ_CONSTANT);
   beta  = cj_Object_new(CJ_CONSTANT);
-  /* TODO : Constant constructor */
+  cj_Constant_set(alpha, 1.0);
+  cj_Constant_set(beta,  1.0);
   cj_Gemm_nn_task(alpha, A, B, beta, C);
   fprintf(stderr, "        }\n");
 }
@@ -247,6 +304,8 @@ void cj_Gemm_nn_blk_var1 (cj_Object *A, cj_Object *B, cj_Object *C) {
     cj_Object *alpha, *beta;
     alpha = cj_Object_new(CJ_CONSTANT);
     beta  = cj_Object_new(CJ_CONSTANT);
+    cj_Constant_set(alpha, 1.0);
+    cj_Constant_set(beta,  1.0);
     cj_Gemm_nn_task(alpha, A1, B1, beta, C);
     /* ------------------------------------------------------------------ */
 
@@ -353,133 +412,6 @@ void cj_Gemm_nn_blk_var5 (cj_Object *A, cj_Object *B, cj_Object *C) {
   fprintf(stderr, "}\n");
 }
 
-void cj_Gemm_nt_task_function (void *task_ptr) {
-	cj_Task *task = (cj_Task *) task_ptr;
-	cj_Worker *worker = task->worker;
-	cj_devType devtype = worker->devtype;
-	int device_id = worker->device_id;
-  int dest = device_id + 1;
-
-	cj_Object *A, *B, *C;
-	cj_Matrix *a, *b, *c;
-	A = task->arg->dqueue->head;
-	B = A->next;
-	C = B->next;
-	a = A->matrix;
-	b = B->matrix;
-	c = C->matrix;
-
-	if (device_id != -1 && devtype == CJ_DEV_CUDA) {
-#ifdef CJ_HAVE_CUDA
-		cudaSetDevice(device_id);
-		cj_Device *device = worker->cj_ptr->device[device_id];
-		cj_Cache *cache = &(device->cache);
-		cublasHandle_t *handle = &(device->handle);
-		cublasStatus_t status;
-
-    cj_Distribution *dist_a = a->base->dist[a->offm/BLOCK_SIZE][a->offn/BLOCK_SIZE];
-    cj_Distribution *dist_b = b->base->dist[b->offm/BLOCK_SIZE][b->offn/BLOCK_SIZE];
-    cj_Distribution *dist_c = c->base->dist[c->offm/BLOCK_SIZE][c->offn/BLOCK_SIZE];
-    if (dist_a->avail[dest] != TRUE || dist_b->avail[dest] != TRUE || dist_c->avail[dest]) {
-      cj_Blas_error("cj_Gemm_nn_task_function", "No propriate distribution.");
-    }
-
-		if (a->eletype == CJ_SINGLE) { 
-		  float f_one = 1.0;
-		  float f_mone = -1.0;
-		  float *a_buff = (float *) cache->dev_ptr[dist_a->line[dest]];
-		  float *b_buff = (float *) cache->dev_ptr[dist_b->line[dest]];
-		  float *c_buff = (float *) cache->dev_ptr[dist_c->line[dest]];
-		  status = cublasSgemm(*handle, CUBLAS_OP_N, CUBLAS_OP_T, c->m, a->n, c->n, &f_mone, a_buff, BLOCK_SIZE, 
-								 b_buff, BLOCK_SIZE, &f_one, c_buff, BLOCK_SIZE);
-		}
-		else {
-			double f_one = 1.0;
-			double f_mone = -1.0;
-      double *a_buff = (double *) cache->dev_ptr[dist_a->line[dest]];
-      double *b_buff = (double *) cache->dev_ptr[dist_b->line[dest]];
-      double *c_buff = (double *) cache->dev_ptr[dist_c->line[dest]];
-			//fprintf(stderr, "%d, %d, %d, %d\n", c->m, a->n, c->n, BLOCK_SIZE);
-			//fprintf(stderr, "%d, %d, %d\n", (int) a_buff, (int) b_buff, (int) c_buff);
-			status = cublasDgemm(*handle, CUBLAS_OP_N, CUBLAS_OP_T, c->m, a->n, c->n, &f_mone, a_buff, BLOCK_SIZE, 
-								 b_buff, BLOCK_SIZE, &f_one, c_buff, BLOCK_SIZE);
-		}
-		if (status != CUBLAS_STATUS_SUCCESS) cj_Blas_error("cj_Gemm_nt_task_function", "cublas failure");
-#endif
-	}
-	else {
-		if (a->eletype == CJ_SINGLE) {
-			float f_one = 1.0;
-			float f_mone = -1.0;
-			float *a_buff = (float *) (a->base->buff) + (a->base->m)*(a->offn) + a->offm;
-			float *b_buff = (float *) (b->base->buff) + (b->base->m)*(b->offn) + b->offm;
-			float *c_buff = (float *) (c->base->buff) + (c->base->m)*(c->offn) + c->offm;
-			sgemm_("N", "T", &(c->m), &(a->n), &(c->n), &f_mone, a_buff, &(a->base->m), b_buff, &(b->base->m), &f_one, c_buff, &(c->base->m));
-		}
-		else {
-			double f_one = 1.0;
-			double f_mone = -1.0;
-			double *a_buff = (double *) (a->base->buff) + (a->base->m)*(a->offn) + a->offm;
-			double *b_buff = (double *) (b->base->buff) + (b->base->m)*(b->offn) + b->offm;
-			double *c_buff = (double *) (c->base->buff) + (c->base->m)*(c->offn) + c->offm;
-			dgemm_("N", "T", &(c->m), &(a->n), &(c->n), &f_mone, a_buff, &(a->base->m), b_buff, &(b->base->m), &f_one, c_buff, &(c->base->m));
-		}
-	}
-
-	fprintf(stderr, YELLOW "  Worker_execute %d (%d, %s), A(%d, %d), B(%d, %d), C(%d, %d): \n" NONE, 
-			task->worker->id, task->id, task->name,
-			a->offm/BLOCK_SIZE, a->offn/BLOCK_SIZE, 
-			b->offm/BLOCK_SIZE, b->offn/BLOCK_SIZE,  
-			c->offm/BLOCK_SIZE, c->offn/BLOCK_SIZE);  
-}
-
-void cj_Gemm_nt_task(cj_Object *alpha, cj_Object *A, cj_Object *B, cj_Object *beta, cj_Object *C) {
-	/* Gemm will read A, B, C and write C. */
-	cj_Object *A_copy, *B_copy, *C_copy, *task;
-	cj_Matrix *a, *b, *c;
-
-	/* Generate copies of A, B and C. */
-	A_copy = cj_Object_new(CJ_MATRIX);
-	B_copy = cj_Object_new(CJ_MATRIX);
-	C_copy = cj_Object_new(CJ_MATRIX);
-	cj_Matrix_duplicate(A, A_copy);
-	cj_Matrix_duplicate(B, B_copy);
-	cj_Matrix_duplicate(C, C_copy);
-
-	a = A_copy->matrix; b = B_copy->matrix; c = C_copy->matrix;
-	/*
-     fprintf(stderr, "          a->base : %d\n", (int)a->base);
-     fprintf(stderr, "          b->base : %d\n", (int)b->base);
-     fprintf(stderr, "          c->base : %d\n", (int)c->base);
-     fprintf(stderr, "          a->offm : %d, a->offn : %d\n", a->offm, a->offn);
-     fprintf(stderr, "          b->offm : %d, b->offn : %d\n", b->offm, b->offn);
-     fprintf(stderr, "          c->offm : %d, c->offn : %d\n", c->offm, c->offn);
-	 */   
-
-	task = cj_Object_new(CJ_TASK);
-	cj_Task_set(task->task, CJ_TASK_GEMM, &cj_Gemm_nt_task_function);
-
-	/* Pushing arguments. */
-	cj_Object *arg_A = cj_Object_append(CJ_MATRIX, a);
-	cj_Object *arg_B = cj_Object_append(CJ_MATRIX, b);
-	cj_Object *arg_C = cj_Object_append(CJ_MATRIX, c);
-	arg_A->rwtype = CJ_R;
-	arg_B->rwtype = CJ_R;
-	arg_C->rwtype = CJ_RW;
-	cj_Dqueue_push_tail(task->task->arg, arg_A);
-	cj_Dqueue_push_tail(task->task->arg, arg_B);
-	cj_Dqueue_push_tail(task->task->arg, arg_C);
-
-	/* Setup task name. */
-  snprintf(task->task->name,  64, "Gemm_nt%d", task->task->id);
-  snprintf(task->task->label, 64, "C%d%d-=A%d%d*B%d%d'",
-      c->offm/BLOCK_SIZE, c->offn/BLOCK_SIZE,
-      a->offm/BLOCK_SIZE, a->offn/BLOCK_SIZE,
-      b->offm/BLOCK_SIZE, b->offn/BLOCK_SIZE );
-
-	cj_Task_dependency_analysis(task);
-}
-
 void cj_Gemm_nt_blk_var5(cj_Object *A, cj_Object *B, cj_Object *C) {
 	cj_Object *AL,    *AR,       *A0,  *A1,  *A2;	
 	cj_Object *BL,    *BR,       *B0,  *B1,  *B2;
@@ -522,6 +454,8 @@ void cj_Gemm_nt_blk_var5(cj_Object *A, cj_Object *B, cj_Object *C) {
 		cj_Object *alpha, *beta;
 		alpha = cj_Object_new(CJ_CONSTANT);
 		beta  = cj_Object_new(CJ_CONSTANT);
+		cj_Constant_set(alpha, -1.0);
+		cj_Constant_set(beta,   1.0);
 		cj_Gemm_nt_task(alpha, A1, B1, beta, C); 
 
 		/*------------------------------------------------------------*/
@@ -671,68 +605,102 @@ void cj_Gemm_nt_blk_var1 (cj_Object *A, cj_Object *B, cj_Object *C) {
 
 }
 
-void cj_Syrk_ln_task_function (void *task_ptr) {
-  //fprintf(stderr, "Inside syrk_ln_task\n");
-
+/* SYRK, SYR2K or SYMM on one tile of C, chosen by the task type. SYRK reads A, C, the
+ * others A, B, C; alpha and beta follow C and the flags side, uplo and trans are in task->iarg.
+ *   SYRK:  C:= alpha * op(A) * op(A)' + beta * C
+ *   SYR2K: C:= alpha * (op(A) * op(B)' + op(B) * op(A)') + beta * C
+ *   SYMM:  C:= alpha * A * B + beta * C (left) or alpha * B * A + beta * C (right) */
+static void cj_Symmetric_kernel (void *task_ptr) {
   cj_Task *task = (cj_Task *) task_ptr;
   cj_Worker *worker = task->worker;
   cj_devType devtype = worker->devtype;
   int device_id = worker->device_id;
-  int dest = device_id + 1;
+  cj_Side side   = (cj_Side)  task->iarg[0];
+  cj_Uplo uplo   = (cj_Uplo)  task->iarg[1];
+  cj_Trans trans = (cj_Trans) task->iarg[2];
+  int lda, ldb = 1, ldc, k;
+  double alpha, beta;
 
-  cj_Object *A, *C;
-  cj_Matrix *a, *c;
+  cj_Object *A, *B, *C;
+  cj_Matrix *a, *b = NULL, *c;
+  char *a_ptr, *b_ptr = NULL, *c_ptr;
   A = task->arg->dqueue->head;
-  C = A->next;
+  B = (task->tasktype == CJ_TASK_SYRK) ? NULL : A->next;
+  C = B ? B->next : A->next;
+  alpha = cj_Constant_get(C->next);
+  beta  = cj_Constant_get(C->next->next);
   a = A->matrix;
   c = C->matrix;
+  k = (trans == CJ_NOTRANS) ? a->n : a->m;
+  a_ptr = cj_Worker_get_buff(worker, a, &lda);
+  if (B) {
+    b = B->matrix;
+    b_ptr = cj_Worker_get_buff(worker, b, &ldb);
+  }
+  c_ptr = cj_Worker_get_buff(worker, c, &ldc);
+
   if (device_id != -1 && devtype == CJ_DEV_CUDA) {
 #ifdef CJ_HAVE_CUDA
     cudaSetDevice(device_id);
     cj_Device *device = worker->cj_ptr->device[device_id];
-    cj_Cache *cache = &(device->cache);
     cublasHandle_t *handle = &(device->handle);
+    cublasSideMode_t sm = (side == CJ_LEFT) ? CUBLAS_SIDE_LEFT : CUBLAS_SIDE_RIGHT;
+    cublasFillMode_t u = (uplo == CJ_LOWER) ? CUBLAS_FILL_MODE_LOWER : CUBLAS_FILL_MODE_UPPER;
+    cublasOperation_t t = (trans == CJ_NOTRANS) ? CUBLAS_OP_N : CUBLAS_OP_T;
     cublasStatus_t status;
-    cj_Distribution *dist_a = a->base->dist[a->offm/BLOCK_SIZE][a->offn/BLOCK_SIZE];
-    cj_Distribution *dist_c = c->base->dist[c->offm/BLOCK_SIZE][c->offn/BLOCK_SIZE];
-    if (dist_a->avail[dest] != TRUE || dist_c->avail[dest]) {
-      cj_Blas_error("cj_Gemm_nn_task_function", "No propriate distribution.");
-    }
 
     if (a->eletype == CJ_SINGLE) { 
-      float f_one = 1.0;
-      float f_mone = -1.0;
-      float *a_buff = (float *) cache->dev_ptr[dist_a->line[dest]];
-      float *c_buff = (float *) cache->dev_ptr[dist_c->line[dest]];
-      status = cublasSsyrk(*handle, CUBLAS_FILL_MODE_LOWER, CUBLAS_OP_N, c->m, a->n, &f_mone, a_buff, BLOCK_SIZE, 
-          &f_one, c_buff, BLOCK_SIZE);
+      float f_alpha = (float) alpha;
+      float f_beta  = (float) beta;
+      if (task->tasktype == CJ_TASK_SYRK)
+        status = cublasSsyrk(*handle, u, t, c->m, k, &f_alpha, (float *) a_ptr, lda, 
+            &f_beta, (float *) c_ptr, ldc);
+      else if (task->tasktype == CJ_TASK_SYR2K)
+        status = cublasSsyr2k(*handle, u, t, c->m, k, &f_alpha, (float *) a_ptr, lda, 
+            (float *) b_ptr, ldb, &f_beta, (float *) c_ptr, ldc);
+      else
+        status = cublasSsymm(*handle, sm, u, c->m, c->n, &f_alpha, (float *) a_ptr, lda, 
+            (float *) b_ptr, ldb, &f_beta, (float *) c_ptr, ldc);
     }
     else {
-      double f_one = 1.0;
-      double f_mone = -1.0;
-      double *a_buff = (double *) cache->dev_ptr[dist_a->line[dest]];
-      double *c_buff = (double *) cache->dev_ptr[dist_c->line[dest]];
-      fprintf(stderr, "%d, %d\n", (int) a_buff, (int) c_buff);
-      status = cublasDsyrk(*handle, CUBLAS_FILL_MODE_LOWER, CUBLAS_OP_N, c->m, a->n, &f_mone, a_buff, BLOCK_SIZE, 
-          &f_one, c_buff, BLOCK_SIZE);
+      if (task->tasktype == CJ_TASK_SYRK)
+        status = cublasDsyrk(*handle, u, t, c->m, k, &alpha, (double *) a_ptr, lda, 
+            &beta, (double *) c_ptr, ldc);
+      else if (task->tasktype == CJ_TASK_SYR2K)
+        status = cublasDsyr2k(*handle, u, t, c->m, k, &alpha, (double *) a_ptr, lda, 
+            (double *) b_ptr, ldb, &beta, (double *) c_ptr, ldc);
+      else
+        status = cublasDsymm(*handle, sm, u, c->m, c->n, &alpha, (double *) a_ptr, lda, 
+            (double *) b_ptr, ldb, &beta, (double *) c_ptr, ldc);
     }
-    if (status != CUBLAS_STATUS_SUCCESS) cj_Blas_error("cj_Syrk_ln_task_function", "cublas failure");
+    if (status != CUBLAS_STATUS_SUCCESS) cj_Blas_error("cj_Symmetric_kernel", "cublas failure");
 #endif
   }
   else {
+    char *sm = (side == CJ_LEFT) ? "L" : "R";
+    char *u = (uplo == CJ_LOWER) ? "L" : "U";
+    char *t = (trans == CJ_NOTRANS) ? "N" : "T";
     if (a->eletype == CJ_SINGLE) {
-      float f_one = 1.0;
-	  float f_mone = -1.0;
-      float *a_buff = (float *) (a->base->buff) + (a->base->m)*(a->offn) + a->offm;  //Row-major order???
-      float *c_buff = (float *) (c->base->buff) + (c->base->m)*(c->offn) + c->offm;
-      ssyrk_("L", "N", &(c->m), &(a->n), &f_mone, a_buff, &(a->base->m), &f_one, c_buff, &(c->base->m)); //Column-major order??
+      float f_alpha = (float) alpha;
+      float f_beta  = (float) beta;
+      if (task->tasktype == CJ_TASK_SYRK)
+        cj_Kernel_ssyrk(u, t, &(c->m), &k, &f_alpha, (float *) a_ptr, &lda, &f_beta, (float *) c_ptr, &ldc);
+      else if (task->tasktype == CJ_TASK_SYR2K)
+        cj_Kernel_ssyr2k(u, t, &(c->m), &k, &f_alpha, (float *) a_ptr, &lda, (float *) b_ptr, &ldb, 
+            &f_beta, (float *) c_ptr, &ldc);
+      else
+        cj_Kernel_ssymm(sm, u, &(c->m), &(c->n), &f_alpha, (float *) a_ptr, &lda, (float *) b_ptr, &ldb, 
+            &f_beta, (float *) c_ptr, &ldc);
     }
     else {
-      double f_one = 1.0;
-	  double f_mone = -1.0;
-      double *a_buff = (double *) (a->base->buff) + (a->base->m)*(a->offn) + a->offm;
-      double *c_buff = (double *) (c->base->buff) + (c->base->m)*(c->offn) + c->offm;
-      dsyrk_("L", "N", &(c->m), &(a->n), &f_mone, a_buff, &(a->base->m), &f_one, c_buff, &(c->base->m));
+      if (task->tasktype == CJ_TASK_SYRK)
+        cj_Kernel_dsyrk(u, t, &(c->m), &k, &alpha, (double *) a_ptr, &lda, &beta, (double *) c_ptr, &ldc);
+      else if (task->tasktype == CJ_TASK_SYR2K)
+        cj_Kernel_dsyr2k(u, t, &(c->m), &k, &alpha, (double *) a_ptr, &lda, (double *) b_ptr, &ldb, 
+            &beta, (double *) c_ptr, &ldc);
+      else
+        cj_Kernel_dsymm(sm, u, &(c->m), &(c->n), &alpha, (double *) a_ptr, &lda, (double *) b_ptr, &ldb, 
+            &beta, (double *) c_ptr, &ldc);
     }
   }
 
@@ -742,68 +710,90 @@ void cj_Syrk_ln_task_function (void *task_ptr) {
       c->offm/BLOCK_SIZE, c->offn/BLOCK_SIZE);  
 }
 
-void cj_Trsm_rlt_task_function (void *task_ptr) {
-  fprintf(stderr, "Inside trsm_rlt_task\n");
+void cj_Syrk_task_function (void *task_ptr) {
+  cj_Symmetric_kernel(task_ptr);
+}
+
+void cj_Syr2k_task_function (void *task_ptr) {
+  cj_Symmetric_kernel(task_ptr);
+}
+
+void cj_Symm_task_function (void *task_ptr) {
+  cj_Symmetric_kernel(task_ptr);
+}
 
+/* B:= B * tril(A)^(-T) or B:= B * tril(A)^(-1) on one tile of B. */
+/* B:= alpha * op(A)^(-1) * B, alpha * B * op(A)^(-1) (solve) or alpha * op(A) * B, 
+ * alpha * B * op(A) on one tile of B. The flags are in task->iarg, alpha follows B. */
+static void cj_Triangular_kernel (void *task_ptr, cj_Bool solve) {
   cj_Task *task = (cj_Task *) task_ptr;
   cj_Worker *worker = task->worker;
   cj_devType devtype = worker->devtype;
   int device_id = worker->device_id;
-  int dest = device_id + 1;
+  cj_Side side  = (cj_Side)  task->iarg[0];
+  cj_Uplo uplo  = (cj_Uplo)  task->iarg[1];
+  cj_Trans trans = (cj_Trans) task->iarg[2];
+  cj_Diag diag  = (cj_Diag)  task->iarg[3];
+  int lda, ldb;
+  double alpha;
 
   cj_Object *A, *B;
   cj_Matrix *a, *b;
+  char *a_ptr, *b_ptr;
   A = task->arg->dqueue->head;
   B = A->next;
+  alpha = cj_Constant_get(B->next);
   a = A->matrix;
   b = B->matrix;
+  a_ptr = cj_Worker_get_buff(worker, a, &lda);
+  b_ptr = cj_Worker_get_buff(worker, b, &ldb);
+
   if (device_id != -1 && devtype == CJ_DEV_CUDA) {
 #ifdef CJ_HAVE_CUDA
     cudaSetDevice(device_id);
     cj_Device *device = worker->cj_ptr->device[device_id];
-    cj_Cache *cache = &(device->cache);
     cublasHandle_t *handle = &(device->handle);
+    cublasSideMode_t s = (side == CJ_LEFT) ? CUBLAS_SIDE_LEFT : CUBLAS_SIDE_RIGHT;
+    cublasFillMode_t u = (uplo == CJ_LOWER) ? CUBLAS_FILL_MODE_LOWER : CUBLAS_FILL_MODE_UPPER;
+    cublasOperation_t t = (trans == CJ_NOTRANS) ? CUBLAS_OP_N : CUBLAS_OP_T;
+    cublasDiagType_t d = (diag == CJ_UNIT) ? CUBLAS_DIAG_UNIT : CUBLAS_DIAG_NON_UNIT;
     cublasStatus_t status;
-    cj_Distribution *dist_a = a->base->dist[a->offm/BLOCK_SIZE][a->offn/BLOCK_SIZE];
-    cj_Distribution *dist_b = b->base->dist[b->offm/BLOCK_SIZE][b->offn/BLOCK_SIZE];
-    if (dist_a->avail[dest] != TRUE || dist_b->avail[dest]) {
-      cj_Blas_error("cj_Gemm_nn_task_function", "No propriate distribution.");
-    }
 
     if (a->eletype == CJ_SINGLE) { 
-      float f_one = 1.0;
-      float f_mone = -1.0;
-      float *a_buff = (float *) cache->dev_ptr[dist_a->line[dest]];
-      float *b_buff = (float *) cache->dev_ptr[dist_b->line[dest]];
-      status = cublasStrsm(*handle, CUBLAS_SIDE_RIGHT, CUBLAS_FILL_MODE_LOWER, CUBLAS_OP_T, CUBLAS_DIAG_NON_UNIT, b->m, a->n, &f_one, a_buff, BLOCK_SIZE, b_buff, BLOCK_SIZE); 
+      float f_alpha = (float) alpha;
+      if (solve == TRUE)
+        status = cublasStrsm(*handle, s, u, t, d, b->m, b->n, &f_alpha, (float *) a_ptr, lda, (float *) b_ptr, ldb); 
+      else
+        status = cublasStrmm(*handle, s, u, t, d, b->m, b->n, &f_alpha, (float *) a_ptr, lda, (float *) b_ptr, ldb,
+            (float *) b_ptr, ldb); 
     }
     else {
-      double f_one = 1.0;
-      double f_mone = -1.0;
-      double *a_buff = (double *) cache->dev_ptr[dist_a->line[dest]];
-      double *b_buff = (double *) cache->dev_ptr[dist_b->line[dest]];
-      fprintf(stderr, "%d, %d\n", (int) a_buff, (int) b_buff);
-      status = cublasDtrsm(*handle, CUBLAS_SIDE_RIGHT, CUBLAS_FILL_MODE_LOWER, CUBLAS_OP_T, CUBLAS_DIAG_NON_UNIT, b->m, a->n, &f_one, a_buff, BLOCK_SIZE, b_buff, BLOCK_SIZE); 
+      if (solve == TRUE)
+        status = cublasDtrsm(*handle, s, u, t, d, b->m, b->n, &alpha, (double *) a_ptr, lda, (double *) b_ptr, ldb); 
+      else
+        status = cublasDtrmm(*handle, s, u, t, d, b->m, b->n, &alpha, (double *) a_ptr, lda, (double *) b_ptr, ldb,
+            (double *) b_ptr, ldb); 
     }
-    if (status != CUBLAS_STATUS_SUCCESS) cj_Blas_error("cj_Syrk_ln_task_function", "cublas failure");
+    if (status != CUBLAS_STATUS_SUCCESS) cj_Blas_error("cj_Triangular_kernel", "cublas failure");
 #endif
   }
   else {
+    char *s = (side == CJ_LEFT) ? "L" : "R";
+    char *u = (uplo == CJ_LOWER) ? "L" : "U";
+    char *t = (trans == CJ_NOTRANS) ? "N" : "T";
+    char *d = (diag == CJ_UNIT) ? "U" : "N";
     if (a->eletype == CJ_SINGLE) {
-      float f_one = 1.0;
-	  float f_mone = -1.0;
-      float *a_buff = (float *) (a->base->buff) + (a->base->m)*(a->offn) + a->offm;  //Row-major order???
-      float *b_buff = (float *) (b->base->buff) + (b->base->m)*(b->offn) + b->offm;
-      strsm_("R", "L", "T", "N", &(b->m), &(b->n), &f_one, a_buff, &(a->base->n), b_buff, &(b->base->m));
-
+      float f_alpha = (float) alpha;
+      if (solve == TRUE)
+        cj_Kernel_strsm(s, u, t, d, &(b->m), &(b->n), &f_alpha, (float *) a_ptr, &lda, (float *) b_ptr, &ldb);
+      else
+        cj_Kernel_strmm(s, u, t, d, &(b->m), &(b->n), &f_alpha, (float *) a_ptr, &lda, (float *) b_ptr, &ldb);
     }
     else {
-      double f_one = 1.0;
-	  double f_mone = -1.0;
-      double *a_buff = (double *) (a->base->buff) + (a->base->m)*(a->offn) + a->offm;
-      double *b_buff = (double *) (b->base->buff) + (b->base->m)*(b->offn) + b->offm;
-      dtrsm_("R", "L", "T", "N", &(b->m), &(b->n), &f_one, a_buff, &(a->base->n), b_buff, &(b->base->m));
-
+      if (solve == TRUE)
+        cj_Kernel_dtrsm(s, u, t, d, &(b->m), &(b->n), &alpha, (double *) a_ptr, &lda, (double *) b_ptr, &ldb);
+      else
+        cj_Kernel_dtrmm(s, u, t, d, &(b->m), &(b->n), &alpha, (double *) a_ptr, &lda, (double *) b_ptr, &ldb);
     }
   }
 
@@ -813,72 +803,322 @@ void cj_Trsm_rlt_task_function (void *task_ptr) {
       b->offm/BLOCK_SIZE, b->offn/BLOCK_SIZE);  
 }
 
-void cj_Trsm_rlt_task(cj_Object *A, cj_Object *B) {
-  /* Trsm will read A, B and write B. */
-  cj_Object *A_copy, *B_copy, *task;
+void cj_Trsm_task_function (void *task_ptr) {
+  cj_Triangular_kernel(task_ptr, TRUE);
+}
+
+void cj_Trmm_task_function (void *task_ptr) {
+  cj_Triangular_kernel(task_ptr, FALSE);
+}
+
+static void cj_Triangular_task (cj_Bool solve, cj_Side side, cj_Uplo uplo, cj_Trans trans, cj_Diag diag, 
+    cj_Object *alpha, cj_Object *A, cj_Object *B) {
+  /* Trsm and Trmm will read A, B and write B. */
+  cj_Object *A_copy, *B_copy, *alpha_copy, *task;
   cj_Matrix *a, *b;
 
-  /* Generate copies of A and C. */
+  /* Generate copies of A and B. */
   A_copy = cj_Object_new(CJ_MATRIX);
   B_copy = cj_Object_new(CJ_MATRIX);
   cj_Matrix_duplicate(A, A_copy);
   cj_Matrix_duplicate(B, B_copy);
+  alpha_copy = cj_Object_new(CJ_CONSTANT);
+  cj_Constant_set(alpha_copy, cj_Constant_get(alpha));
 
   a = A_copy->matrix; b = B_copy->matrix;
   task = cj_Object_new(CJ_TASK);
-  cj_Task_set(task->task, CJ_TASK_TRSM, &cj_Trsm_rlt_task_function);
+  if (solve == TRUE) cj_Task_set(task->task, CJ_TASK_TRSM, &cj_Trsm_task_function);
+  else cj_Task_set(task->task, CJ_TASK_TRMM, &cj_Trmm_task_function);
+  task->task->iarg[0] = side;
+  task->task->iarg[1] = uplo;
+  task->task->iarg[2] = trans;
+  task->task->iarg[3] = diag;
 
   /* Pushing arguments. */
   cj_Object *arg_A = cj_Object_append(CJ_MATRIX, a);
   cj_Object *arg_B = cj_Object_append(CJ_MATRIX, b);
   arg_A->rwtype = CJ_R;
   arg_B->rwtype = CJ_RW;
+  alpha_copy->rwtype = CJ_R;
   cj_Dqueue_push_tail(task->task->arg, arg_A);
   cj_Dqueue_push_tail(task->task->arg, arg_B);
-
-  /* Setup task name. */
-  snprintf(task->task->name,  64, "Trsm_rlt%d", task->task->id);
-  snprintf(task->task->label, 64, "B%d%d=B%d%d*A%d%d^-t", 
-      b->offm/BLOCK_SIZE, b->offn/BLOCK_SIZE,
-      b->offm/BLOCK_SIZE, b->offn/BLOCK_SIZE,
-      a->offm/BLOCK_SIZE, a->offn/BLOCK_SIZE );
+  cj_Dqueue_push_tail(task->task->arg, alpha_copy);
+
+  /* Setup task name, e.g. Trsm_rlt for the right side, lower triangular, transposed. */
+  snprintf(task->task->name,  64, "%s_%c%c%c%s%d", (solve == TRUE) ? "Trsm" : "Trmm", 
+      (side == CJ_LEFT) ? 'l' : 'r', (uplo == CJ_LOWER) ? 'l' : 'u', (trans == CJ_NOTRANS) ? 'n' : 't',
+      (diag == CJ_UNIT) ? "u" : "", task->task->id);
+  if (side == CJ_LEFT) {
+    snprintf(task->task->label, 128, "B%d%d=%g*A%d%d^%s*B%d%d", 
+        b->offm/BLOCK_SIZE, b->offn/BLOCK_SIZE, cj_Constant_get(alpha),
+        a->offm/BLOCK_SIZE, a->offn/BLOCK_SIZE, (solve == TRUE) ? ((trans == CJ_NOTRANS) ? "-1" : "-t") : 
+        ((trans == CJ_NOTRANS) ? "1" : "t"), b->offm/BLOCK_SIZE, b->offn/BLOCK_SIZE);
+  }
+  else {
+    snprintf(task->task->label, 128, "B%d%d=%g*B%d%d*A%d%d^%s", 
+        b->offm/BLOCK_SIZE, b->offn/BLOCK_SIZE, cj_Constant_get(alpha), b->offm/BLOCK_SIZE, b->offn/BLOCK_SIZE,
+        a->offm/BLOCK_SIZE, a->offn/BLOCK_SIZE, (solve == TRUE) ? ((trans == CJ_NOTRANS) ? "-1" : "-t") : 
+        ((trans == CJ_NOTRANS) ? "1" : "t"));
+  }
 
   cj_Task_dependency_analysis(task);
 }
 
-void cj_Syrk_ln_task(cj_Object *alpha, cj_Object *A, cj_Object *beta, cj_Object *C) {
-  /* Syrk will read A, C and write C. */
-  cj_Object *A_copy, *C_copy, *task;
-  cj_Matrix *a, *b, *c;
+void cj_Trsm_rlt_task(cj_Object *A, cj_Object *B) {
+  cj_Object *one = cj_Object_new(CJ_CONSTANT);
+  cj_Constant_set(one, 1.0);
+  cj_Triangular_task(TRUE, CJ_RIGHT, CJ_LOWER, CJ_TRANS, CJ_NONUNIT, one, A, B);
+}
+
+void cj_Trsm_rln_task(cj_Object *A, cj_Object *B) {
+  cj_Object *one = cj_Object_new(CJ_CONSTANT);
+  cj_Constant_set(one, 1.0);
+  cj_Triangular_task(TRUE, CJ_RIGHT, CJ_LOWER, CJ_NOTRANS, CJ_NONUNIT, one, A, B);
+}
+
+/* op(A)(i, j) as a tile of A, read transposed by the task if trans is set. */
+static void cj_Triangular_op_tile (cj_Object *A, cj_Object *T, cj_Trans trans, int i, int j) {
+  if (trans == CJ_NOTRANS) cj_Matrix_tile(A, T, i, j);
+  else cj_Matrix_tile(A, T, j, i);
+}
+
+/* TRSM (solve) or TRMM on tiles, A: na*na, B: na*n (left) or m*na (right). 
+ * The diagonal tiles of A are swept in the order the solve or the product needs
+ * them; each step is one task per tile row or column of B, so independent right
+ * hand sides proceed in parallel. For TRSM alpha is applied by the first step,
+ * through the beta of its updates. */
+static void cj_Triangular_tiles (cj_Bool solve, cj_Side side, cj_Uplo uplo, cj_Trans trans, cj_Diag diag, 
+    cj_Object *alpha, cj_Object *A, cj_Object *B) {
+  cj_Matrix *b = B->matrix;
+  cj_Object *A_tile, *Bk_tile, *Bl_tile, *one, *minus_one, *lalpha;
+  int na = A->matrix->m, nt = (na + BLOCK_SIZE - 1)/BLOCK_SIZE;
+  int nb = (side == CJ_LEFT) ? b->n : b->m;
+  int s, k, l, j;
+  /* op(A) is lower triangular if A is lower and not transposed, or upper and transposed. */
+  cj_Bool lower = ((uplo == CJ_LOWER) == (trans == CJ_NOTRANS)) ? TRUE : FALSE;
+  /* A solve starts from the unknowns that depend on no others, a product from the 
+   * results that need the input of the others. */
+  cj_Bool forward = (((side == CJ_LEFT) == (lower == TRUE)) == (solve == TRUE)) ? TRUE : FALSE;
+
+  A_tile  = cj_Object_new(CJ_MATRIX);
+  Bk_tile = cj_Object_new(CJ_MATRIX);
+  Bl_tile = cj_Object_new(CJ_MATRIX);
+  cj_Matrix_duplicate(A, A_tile);
+  cj_Matrix_duplicate(B, Bk_tile);
+  cj_Matrix_duplicate(B, Bl_tile);
+  one = cj_Object_new(CJ_CONSTANT);
+  minus_one = cj_Object_new(CJ_CONSTANT);
+  cj_Constant_set(one, 1.0);
+  cj_Constant_set(minus_one, -1.0);
+
+  for (s = 0; s < nt; s++) {
+    k = ((forward == TRUE) ? s : nt - 1 - s)*BLOCK_SIZE;
+    lalpha = (solve == FALSE || s == 0) ? alpha : one;
+    for (j = 0; j < nb; j += BLOCK_SIZE) {
+      if (side == CJ_LEFT) cj_Matrix_tile(B, Bk_tile, k, j);
+      else cj_Matrix_tile(B, Bk_tile, j, k);
+      cj_Matrix_tile(A, A_tile, k, k);
+      cj_Triangular_task(solve, side, uplo, trans, diag, lalpha, A_tile, Bk_tile);
+
+      /* Tiles later in the sweep. */
+      for (l = 0; l < na; l += BLOCK_SIZE) {
+        if ((forward == TRUE) ? l <= k : l >= k) continue;
+        if (side == CJ_LEFT) cj_Matrix_tile(B, Bl_tile, l, j);
+        else cj_Matrix_tile(B, Bl_tile, j, l);
+        if (solve == TRUE) {
+          /* Bl:= lalpha * Bl - op(A)(l, k) * Bk, or lalpha * Bl - Bk * op(A)(k, l) */
+          if (side == CJ_LEFT) {
+            cj_Triangular_op_tile(A, A_tile, trans, l, k);
+            cj_Gemm_task(trans, CJ_NOTRANS, minus_one, A_tile, Bk_tile, lalpha, Bl_tile);
+          }
+          else {
+            cj_Triangular_op_tile(A, A_tile, trans, k, l);
+            cj_Gemm_task(CJ_NOTRANS, trans, minus_one, Bk_tile, A_tile, lalpha, Bl_tile);
+          }
+        }
+        else {
+          /* Bk:= Bk + alpha * op(A)(k, l) * Bl, or Bk + alpha * Bl * op(A)(l, k) */
+          if (side == CJ_LEFT) {
+            cj_Triangular_op_tile(A, A_tile, trans, k, l);
+            cj_Gemm_task(trans, CJ_NOTRANS, alpha, A_tile, Bl_tile, one, Bk_tile);
+          }
+          else {
+            cj_Triangular_op_tile(A, A_tile, trans, l, k);
+            cj_Gemm_task(CJ_NOTRANS, trans, alpha, Bl_tile, A_tile, one, Bk_tile);
+          }
+        }
+      }
+    }
+  }
+}
 
-  /* Generate copies of A and C. */
+/* One SYRK, SYR2K or SYMM task on a tile of C, B is NULL for SYRK. */
+static void cj_Symmetric_task (cj_taskType tasktype, cj_Side side, cj_Uplo uplo, cj_Trans trans, 
+    cj_Object *alpha, cj_Object *A, cj_Object *B, cj_Object *beta, cj_Object *C) {
+  /* Syrk will read A, C, Syr2k and Symm A, B, C, and all write C. */
+  cj_Object *A_copy, *B_copy, *C_copy, *alpha_copy, *beta_copy, *task;
+  cj_Matrix *a, *c;
+  void (*function)(void*);
+
+  /* Generate copies of A, B and C. */
   A_copy = cj_Object_new(CJ_MATRIX);
   C_copy = cj_Object_new(CJ_MATRIX);
   cj_Matrix_duplicate(A, A_copy);
   cj_Matrix_duplicate(C, C_copy);
+  alpha_copy = cj_Object_new(CJ_CONSTANT);
+  beta_copy  = cj_Object_new(CJ_CONSTANT);
+  cj_Constant_set(alpha_copy, cj_Constant_get(alpha));
+  cj_Constant_set(beta_copy,  cj_Constant_get(beta));
 
   a = A_copy->matrix; c = C_copy->matrix;
+  if (tasktype == CJ_TASK_SYRK) function = &cj_Syrk_task_function;
+  else if (tasktype == CJ_TASK_SYR2K) function = &cj_Syr2k_task_function;
+  else function = &cj_Symm_task_function;
   task = cj_Object_new(CJ_TASK);
-  cj_Task_set(task->task, CJ_TASK_SYRK, &cj_Syrk_ln_task_function);
+  cj_Task_set(task->task, tasktype, function);
+  task->task->iarg[0] = side;
+  task->task->iarg[1] = uplo;
+  task->task->iarg[2] = trans;
 
   /* Pushing arguments. */
   cj_Object *arg_A = cj_Object_append(CJ_MATRIX, a);
-  cj_Object *arg_C = cj_Object_append(CJ_MATRIX, c);
   arg_A->rwtype = CJ_R;
-  arg_C->rwtype = CJ_RW;
   cj_Dqueue_push_tail(task->task->arg, arg_A);
+  if (B) {
+    B_copy = cj_Object_new(CJ_MATRIX);
+    cj_Matrix_duplicate(B, B_copy);
+    cj_Object *arg_B = cj_Object_append(CJ_MATRIX, B_copy->matrix);
+    arg_B->rwtype = CJ_R;
+    cj_Dqueue_push_tail(task->task->arg, arg_B);
+  }
+  cj_Object *arg_C = cj_Object_append(CJ_MATRIX, c);
+  arg_C->rwtype = CJ_RW;
+  alpha_copy->rwtype = CJ_R;
+  beta_copy->rwtype  = CJ_R;
   cj_Dqueue_push_tail(task->task->arg, arg_C);
-
-  /* Setup task name. */
-  snprintf(task->task->name, 64, "Syrk_ln%d", task->task->id); 
-  snprintf(task->task->label, 64, "C%d%d -= A%d%d*A%d%d'", 
-      c->offm/BLOCK_SIZE, c->offn/BLOCK_SIZE,
-      a->offm/BLOCK_SIZE, a->offn/BLOCK_SIZE,
-      a->offm/BLOCK_SIZE, a->offn/BLOCK_SIZE);
+  cj_Dqueue_push_tail(task->task->arg, alpha_copy);
+  cj_Dqueue_push_tail(task->task->arg, beta_copy);
+
+  /* Setup task name, e.g. Syrk_ln, Syr2k_ut or Symm_rl. */
+  if (tasktype == CJ_TASK_SYMM)
+    snprintf(task->task->name, 64, "Symm_%c%c%d", (side == CJ_LEFT) ? 'l' : 'r', 
+        (uplo == CJ_LOWER) ? 'l' : 'u', task->task->id);
+  else
+    snprintf(task->task->name, 64, "%s_%c%c%d", (tasktype == CJ_TASK_SYRK) ? "Syrk" : "Syr2k", 
+        (uplo == CJ_LOWER) ? 'l' : 'u', (trans == CJ_NOTRANS) ? 'n' : 't', task->task->id);
+  snprintf(task->task->label, 128, "C%d%d=%g*%s(A%d%d)+%g*C", 
+      c->offm/BLOCK_SIZE, c->offn/BLOCK_SIZE, cj_Constant_get(alpha), 
+      (tasktype == CJ_TASK_SYRK) ? "syrk" : ((tasktype == CJ_TASK_SYR2K) ? "syr2k" : "symm"),
+      a->offm/BLOCK_SIZE, a->offn/BLOCK_SIZE, cj_Constant_get(beta));
 
   cj_Task_dependency_analysis(task);
 }
 
+void cj_Syrk_ln_task(cj_Object *alpha, cj_Object *A, cj_Object *beta, cj_Object *C) {
+  cj_Symmetric_task(CJ_TASK_SYRK, CJ_LEFT, CJ_LOWER, CJ_NOTRANS, alpha, A, NULL, beta, C);
+}
+
+/* SYRK (B is NULL) or SYR2K on tiles, C: n*n, op(A), op(B): n*k. Only the tiles of
+ * the triangle uplo of C get tasks: the diagonal ones a SYRK or SYR2K, the others
+ * plain GEMMs, so the work is half that of the full product. */
+static void cj_Syrk_tiles (cj_Uplo uplo, cj_Trans trans, 
+    cj_Object *alpha, cj_Object *A, cj_Object *B, cj_Object *beta, cj_Object *C) {
+  cj_Matrix *c = C->matrix;
+  cj_Object *Ai_tile, *Aj_tile, *Bi_tile, *Bj_tile, *C_tile, *one, *lbeta;
+  cj_Trans transb = (trans == CJ_NOTRANS) ? CJ_TRANS : CJ_NOTRANS;
+  int i, j, p;
+  int k = (trans == CJ_NOTRANS) ? A->matrix->n : A->matrix->m;
+
+  Ai_tile = cj_Object_new(CJ_MATRIX);
+  Aj_tile = cj_Object_new(CJ_MATRIX);
+  Bi_tile = cj_Object_new(CJ_MATRIX);
+  Bj_tile = cj_Object_new(CJ_MATRIX);
+  C_tile  = cj_Object_new(CJ_MATRIX);
+  cj_Matrix_duplicate(A, Ai_tile);
+  cj_Matrix_duplicate(A, Aj_tile);
+  if (B) {
+    cj_Matrix_duplicate(B, Bi_tile);
+    cj_Matrix_duplicate(B, Bj_tile);
+  }
+  cj_Matrix_duplicate(C, C_tile);
+  one = cj_Object_new(CJ_CONSTANT);
+  cj_Constant_set(one, 1.0);
+
+  for (j = 0; j < c->n; j += BLOCK_SIZE) {
+    for (i = (uplo == CJ_LOWER) ? j : 0; i < ((uplo == CJ_LOWER) ? c->m : j + 1); i += BLOCK_SIZE) {
+      cj_Matrix_tile(C, C_tile, i, j);
+      for (p = 0; p < k; p += BLOCK_SIZE) {
+        lbeta = (p == 0) ? beta : one;
+        /* Rows i and j of op(A) and op(B). */
+        cj_Triangular_op_tile(A, Ai_tile, trans, i, p);
+        cj_Triangular_op_tile(A, Aj_tile, trans, j, p);
+        if (B) {
+          cj_Triangular_op_tile(B, Bi_tile, trans, i, p);
+          cj_Triangular_op_tile(B, Bj_tile, trans, j, p);
+        }
+        if (i == j) {
+          cj_Symmetric_task(B ? CJ_TASK_SYR2K : CJ_TASK_SYRK, CJ_LEFT, uplo, trans, 
+              alpha, Ai_tile, B ? Bi_tile : NULL, lbeta, C_tile);
+        }
+        else if (B) {
+          /* C(i, j):= alpha * (op(A)(i, p) * op(B)(j, p)' + op(B)(i, p) * op(A)(j, p)') + lbeta * C(i, j) */
+          cj_Gemm_task(trans, transb, alpha, Ai_tile, Bj_tile, lbeta, C_tile);
+          cj_Gemm_task(trans, transb, alpha, Bi_tile, Aj_tile, one, C_tile);
+        }
+        else {
+          /* C(i, j):= alpha * op(A)(i, p) * op(A)(j, p)' + lbeta * C(i, j) */
+          cj_Gemm_task(trans, transb, alpha, Ai_tile, Aj_tile, lbeta, C_tile);
+        }
+      }
+    }
+  }
+}
+
+/* SYMM on tiles, C: m*n, A: m*m (left) or n*n (right). A(i, p) of the symmetric A
+ * is the stored tile, the transpose of its mirror, or for i = p a SYMM task, so
+ * only the triangle uplo of A is read. */
+static void cj_Symm_tiles (cj_Side side, cj_Uplo uplo, 
+    cj_Object *alpha, cj_Object *A, cj_Object *B, cj_Object *beta, cj_Object *C) {
+  cj_Matrix *c = C->matrix;
+  cj_Object *A_tile, *B_tile, *C_tile, *one, *lbeta;
+  cj_Trans transa;
+  int i, j, p, r, q;
+  int na = A->matrix->m;
+
+  A_tile = cj_Object_new(CJ_MATRIX);
+  B_tile = cj_Object_new(CJ_MATRIX);
+  C_tile = cj_Object_new(CJ_MATRIX);
+  cj_Matrix_duplicate(A, A_tile);
+  cj_Matrix_duplicate(B, B_tile);
+  cj_Matrix_duplicate(C, C_tile);
+  one = cj_Object_new(CJ_CONSTANT);
+  cj_Constant_set(one, 1.0);
+
+  for (j = 0; j < c->n; j += BLOCK_SIZE) {
+    for (i = 0; i < c->m; i += BLOCK_SIZE) {
+      cj_Matrix_tile(C, C_tile, i, j);
+      for (p = 0; p < na; p += BLOCK_SIZE) {
+        lbeta = (p == 0) ? beta : one;
+        /* The tile (r, q) of A in the product: A(i, p) * B(p, j) or B(i, p) * A(p, j). */
+        r = (side == CJ_LEFT) ? i : p;
+        q = (side == CJ_LEFT) ? p : j;
+        if (side == CJ_LEFT) cj_Matrix_tile(B, B_tile, p, j);
+        else cj_Matrix_tile(B, B_tile, i, p);
+        if (r == q) {
+          cj_Matrix_tile(A, A_tile, r, r);
+          cj_Symmetric_task(CJ_TASK_SYMM, side, uplo, CJ_NOTRANS, alpha, A_tile, B_tile, lbeta, C_tile);
+          continue;
+        }
+        /* Stored below the diagonal for lower, above for upper. */
+        transa = ((uplo == CJ_LOWER) == (r > q)) ? CJ_NOTRANS : CJ_TRANS;
+        cj_Triangular_op_tile(A, A_tile, transa, r, q);
+        if (side == CJ_LEFT) cj_Gemm_task(transa, CJ_NOTRANS, alpha, A_tile, B_tile, lbeta, C_tile);
+        else cj_Gemm_task(CJ_NOTRANS, transa, alpha, B_tile, A_tile, lbeta, C_tile);
+      }
+    }
+  }
+}
+
 void cj_Syrk_ln_blk_var1 (cj_Object *A, cj_Object *C) {
 	cj_Object *AT,    *A0,
 	*AB,    *A1,
@@ -1065,6 +1305,8 @@ void cj_Syrk_ln_blk_var5 (cj_Object *A, cj_Object *C) {
     cj_Object *alpha, *beta;
     alpha = cj_Object_new(CJ_CONSTANT);
     beta  = cj_Object_new(CJ_CONSTANT);
+    cj_Constant_set(alpha, -1.0);
+    cj_Constant_set(beta,   1.0);
     cj_Syrk_ln_task(alpha, A1, beta, C);
     /* ------------------------------------------------------------------ */
 
@@ -1288,6 +1530,126 @@ void cj_Trsm_rlt_blk_var2 (cj_Object *A, cj_Object *B)
 
 
 
+void cj_Trsm_rln_blk_var3 (cj_Object *A, cj_Object *B)
+{
+  cj_Object *BT,              *B0,
+            *BB,              *B1,
+                              *B2;
+
+  fprintf(stderr, "  Trsm_rln_blk_var3 (A(%d, %d), B(%d, %d)): \n", 
+	  A->matrix->m, A->matrix->n,
+	  B->matrix->m, B->matrix->n);
+  fprintf(stderr, "  {\n");
+
+  BT = cj_Object_new(CJ_MATRIX); B0 = cj_Object_new(CJ_MATRIX);
+  BB = cj_Object_new(CJ_MATRIX); B1 = cj_Object_new(CJ_MATRIX);
+  B2 = cj_Object_new(CJ_MATRIX);
+
+  int b;
+
+  cj_Matrix_part_2x1( B,    BT, 
+                            BB,            0, CJ_TOP );
+
+  while ( BT->matrix->m < B->matrix->m ){
+    b = min(BB->matrix->m, BLOCK_SIZE);
+
+    cj_Matrix_repart_2x1_to_3x1( BT,                B0, 
+                        /* ** */            /* ** */
+                                                    B1, 
+                                 BB,                B2,        b, CJ_BOTTOM );
+
+    /*------------------------------------------------------------*/
+
+    /* B1 = B1 / tril( A ); */
+    cj_Trsm_rln_task(A, B1);
+
+    /*------------------------------------------------------------*/
+
+    cj_Matrix_cont_with_3x1_to_2x1( BT,                B0, 
+                                                       B1, 
+                                 /* ** */           /* ** */
+                                    BB,                B2,     CJ_TOP );
+  }
+
+  fprintf(stderr, "  }\n");
+}
+
+/* Sweeps A from the bottom right, since the last columns of B are solved first. */
+void cj_Trsm_rln_blk_var2 (cj_Object *A, cj_Object *B)
+{
+  cj_Object *ATL,   *ATR,      *A00, *A01, *A02, 
+            *ABL,   *ABR,      *A10, *A11, *A12,
+                               *A20, *A21, *A22;
+
+  cj_Object *BL,    *BR,       *B0,  *B1,  *B2;
+
+  fprintf(stderr, "Trsm_rln_blk_var2 (A(%d, %d), B(%d, %d)): \n", 
+	  A->matrix->m, A->matrix->n,
+	  B->matrix->m, B->matrix->n);
+  fprintf(stderr, "{\n");
+
+  ATL = cj_Object_new(CJ_MATRIX); ATR = cj_Object_new(CJ_MATRIX); 
+  A00 = cj_Object_new(CJ_MATRIX); A01 = cj_Object_new(CJ_MATRIX); A02 = cj_Object_new(CJ_MATRIX);
+
+  ABL = cj_Object_new(CJ_MATRIX); ABR = cj_Object_new(CJ_MATRIX);
+  A10 = cj_Object_new(CJ_MATRIX); A11 = cj_Object_new(CJ_MATRIX); A12 = cj_Object_new(CJ_MATRIX);
+  A20 = cj_Object_new(CJ_MATRIX); A21 = cj_Object_new(CJ_MATRIX); A22 = cj_Object_new(CJ_MATRIX);
+
+  BL = cj_Object_new(CJ_MATRIX); BR = cj_Object_new(CJ_MATRIX);
+  B0 = cj_Object_new(CJ_MATRIX); B1 = cj_Object_new(CJ_MATRIX); B2 = cj_Object_new(CJ_MATRIX);
+
+  int b;
+
+  cj_Matrix_part_2x2( A,    ATL, ATR,
+                            ABL, ABR,     0, 0, CJ_BR );
+
+  cj_Matrix_part_1x2( B,    BL,  BR,      0, CJ_RIGHT );
+
+  while ( ABR->matrix->m < A->matrix->m ){
+
+    /* The last block may be partial, the others stay on tile boundaries. */
+    b = (ATL->matrix->m - 1)%BLOCK_SIZE + 1;
+
+    cj_Matrix_repart_2x2_to_3x3( ATL, /**/ ATR,       A00, A01, /**/ A02,
+                                                      A10, A11, /**/ A12,
+                              /* ************* */   /* ******************** */
+                                 ABL, /**/ ABR,       A20, A21, /**/ A22,
+                                 b, b, CJ_TL );
+
+    cj_Matrix_repart_1x2_to_1x3( BL,  /**/ BR,        B0, B1, /**/ B2,
+                                 b, CJ_LEFT );
+
+    /*------------------------------------------------------------*/
+
+    /* B1 = B1 - B2 * A21; */
+    if (B2->matrix->n > 0) {
+      cj_Object *alpha, *beta;
+      alpha = cj_Object_new(CJ_CONSTANT);
+      beta  = cj_Object_new(CJ_CONSTANT);
+      cj_Constant_set(alpha, -1.0);
+      cj_Constant_set(beta,   1.0);
+      cj_Gemm_tiles(CJ_NOTRANS, CJ_NOTRANS, alpha, B2, A21, beta, B1);
+    }
+
+    /* B1 = B1 / tril( A11 ); */
+    cj_Trsm_rln_blk_var3(A11, B1);
+
+    /*------------------------------------------------------------*/
+
+    cj_Matrix_cont_with_3x3_to_2x2( ATL, /**/ ATR,       A00, /**/ A01, A02,
+                                 /* ************** */  /* ****************** */
+                                                         A10, /**/ A11, A12,
+                                    ABL, /**/ ABR,       A20, /**/ A21, A22,
+                                    CJ_BR );
+
+    cj_Matrix_cont_with_1x3_to_1x2( BL,  /**/ BR,       B0, /**/ B1, B2,
+                                    CJ_RIGHT );
+
+  }
+
+  fprintf(stderr, "}\n");
+}
+
 /* C:= alpha * A * B + beta * C, alpha = 1, beta = 1, A: m*k, B: k*n, C: m*n */
 void cj_Gemm_nn (cj_Object *A, cj_Object *B, cj_Object *C) {
   cj_Matrix *a, *b, *c;
@@ -1342,6 +1704,370 @@ void cj_Trsm_rlt (cj_Object *A, cj_Object *B) {
   cj_Queue_begin();
 }
 
+/* B:= BA^(-1) or B:=B / tril(A), A is lower triangular, A: n*n, B: m*n  */
+void cj_Trsm_rln (cj_Object *A, cj_Object *B) {
+  cj_Matrix *a, *b;
+  if (!A || !B) 
+    cj_Blas_error("trsm_rln", "matrices haven't been initialized yet.");
+  if (!A->matrix || !B->matrix)
+    cj_Blas_error("trsm_rln", "Object types are not matrix type.");
+  a = A->matrix;
+  b = B->matrix;
+  if ((a->m != a->n) || (b->n != a->m)) 
+    cj_Blas_error("trsm_rln", "matrices dimension aren't matched.");
+
+  cj_Queue_end();
+  cj_Trsm_rln_blk_var2(A, B);
+  cj_Queue_begin();
+}
+
+/* C:= C - A * B', A: m*k, B: n*k, C: m*n */
+void cj_Gemm_nt (cj_Object *A, cj_Object *B, cj_Object *C) {
+  cj_Matrix *a, *b, *c;
+  if (!A || !B || !C) 
+    cj_Blas_error("gemm_nt", "matrices haven't been initialized yet.");
+  if (!A->matrix || !B->matrix || !C->matrix)
+    cj_Blas_error("gemm_nt", "Object types are not matrix type.");
+  a = A->matrix;
+  b = B->matrix;
+  c = C->matrix;
+  if ((c->m != a->m) || (c->n != b->m) || (a->n != b->n)) 
+    cj_Blas_error("gemm_nt", "matrices dimension aren't matched.");
+
+  cj_Queue_end();
+  cj_Gemm_nt_blk_var1(A, B, C);
+  cj_Queue_begin();
+}
+
+/* C:= alpha * op(A) * op(B) + beta * C, op(X) = X or X', op(A): m*k, op(B): k*n, C: m*n */
+void cj_Gemm (cj_Trans transA, cj_Trans transB, 
+    cj_Object *alpha, cj_Object *A, cj_Object *B, cj_Object *beta, cj_Object *C) {
+  cj_Matrix *a, *b, *c;
+  int am, an, bm, bn;
+  if (!alpha || !A || !B || !beta || !C) 
+    cj_Blas_error("gemm", "matrices haven't been initialized yet.");
+  if (alpha->objtype != CJ_CONSTANT || beta->objtype != CJ_CONSTANT)
+    cj_Blas_error("gemm", "alpha and beta are not constants.");
+  if (A->objtype != CJ_MATRIX || B->objtype != CJ_MATRIX || C->objtype != CJ_MATRIX)
+    cj_Blas_error("gemm", "Object types are not matrix type.");
+  a = A->matrix;
+  b = B->matrix;
+  c = C->matrix;
+  am = (transA == CJ_NOTRANS) ? a->m : a->n;
+  an = (transA == CJ_NOTRANS) ? a->n : a->m;
+  bm = (transB == CJ_NOTRANS) ? b->m : b->n;
+  bn = (transB == CJ_NOTRANS) ? b->n : b->m;
+  if ((c->m != am) || (c->n != bn) || (an != bm)) 
+    cj_Blas_error("gemm", "matrices dimension aren't matched.");
+  if (c->m == 0 || c->n == 0) return;
+  /* Every task carries a product, so C can only be left as it is without one. */
+  if (an == 0) {
+    if (cj_Constant_get(beta) == 1.0) return;
+    cj_Blas_error("gemm", "inner dimension is zero.");
+  }
+
+  cj_Queue_end();
+  cj_Gemm_tiles(transA, transB, alpha, A, B, beta, C);
+  cj_Queue_begin();
+}
+
+static void cj_Triangular_check (const char *func_name, cj_Side side, cj_Object *alpha, cj_Object *A, cj_Object *B) {
+  cj_Matrix *a, *b;
+  if (!alpha || !A || !B) 
+    cj_Blas_error(func_name, "matrices haven't been initialized yet.");
+  if (alpha->objtype != CJ_CONSTANT)
+    cj_Blas_error(func_name, "alpha is not a constant.");
+  if (A->objtype != CJ_MATRIX || B->objtype != CJ_MATRIX)
+    cj_Blas_error(func_name, "Object types are not matrix type.");
+  a = A->matrix;
+  b = B->matrix;
+  if ((a->m != a->n) || (((side == CJ_LEFT) ? b->m : b->n) != a->m)) 
+    cj_Blas_error(func_name, "matrices dimension aren't matched.");
+  if (side != CJ_LEFT && side != CJ_RIGHT)
+    cj_Blas_error(func_name, "side is neither left nor right.");
+}
+
+/* B:= alpha * op(A)^(-1) * B (left) or alpha * B * op(A)^(-1) (right), A is triangular, 
+ * unit diagonal if diag is CJ_UNIT, A: n*n, B: n*m (left) or m*n (right) */
+void cj_Trsm (cj_Side side, cj_Uplo uplo, cj_Trans trans, cj_Diag diag, cj_Object *alpha, cj_Object *A, cj_Object *B) {
+  cj_Triangular_check("trsm", side, alpha, A, B);
+  if (B->matrix->m == 0 || B->matrix->n == 0) return;
+
+  cj_Queue_end();
+  cj_Triangular_tiles(TRUE, side, uplo, trans, diag, alpha, A, B);
+  cj_Queue_begin();
+}
+
+/* B:= alpha * op(A) * B (left) or alpha * B * op(A) (right), A is triangular, 
+ * unit diagonal if diag is CJ_UNIT, A: n*n, B: n*m (left) or m*n (right) */
+void cj_Trmm (cj_Side side, cj_Uplo uplo, cj_Trans trans, cj_Diag diag, cj_Object *alpha, cj_Object *A, cj_Object *B) {
+  cj_Triangular_check("trmm", side, alpha, A, B);
+  if (B->matrix->m == 0 || B->matrix->n == 0) return;
+
+  cj_Queue_end();
+  cj_Triangular_tiles(FALSE, side, uplo, trans, diag, alpha, A, B);
+  cj_Queue_begin();
+}
+
+static void cj_Symmetric_check (const char *func_name, cj_Object *alpha, cj_Object *A, cj_Object *B, 
+    cj_Object *beta, cj_Object *C) {
+  if (!alpha || !A || !B || !beta || !C) 
+    cj_Blas_error(func_name, "matrices haven't been initialized yet.");
+  if (alpha->objtype != CJ_CONSTANT || beta->objtype != CJ_CONSTANT)
+    cj_Blas_error(func_name, "alpha and beta are not constants.");
+  if (A->objtype != CJ_MATRIX || B->objtype != CJ_MATRIX || C->objtype != CJ_MATRIX)
+    cj_Blas_error(func_name, "Object types are not matrix type.");
+}
+
+/* C:= alpha * A * A' + beta * C (trans is CJ_NOTRANS) or alpha * A' * A + beta * C, 
+ * C is symmetric and only its triangle uplo is referenced, op(A): n*k, C: n*n */
+void cj_Syrk (cj_Uplo uplo, cj_Trans trans, cj_Object *alpha, cj_Object *A, cj_Object *beta, cj_Object *C) {
+  cj_Matrix *a, *c;
+  int an, ak;
+  /* A rank-k update is the rank-2k one with B = A. */
+  cj_Symmetric_check("syrk", alpha, A, A, beta, C);
+  a = A->matrix;
+  c = C->matrix;
+  an = (trans == CJ_NOTRANS) ? a->m : a->n;
+  ak = (trans == CJ_NOTRANS) ? a->n : a->m;
+  if ((c->m != c->n) || (an != c->m)) 
+    cj_Blas_error("syrk", "matrices dimension aren't matched.");
+  if (c->m == 0) return;
+  if (ak == 0) {
+    if (cj_Constant_get(beta) == 1.0) return;
+    cj_Blas_error("syrk", "inner dimension is zero.");
+  }
+
+  cj_Queue_end();
+  cj_Syrk_tiles(uplo, trans, alpha, A, NULL, beta, C);
+  cj_Queue_begin();
+}
+
+/* C:= alpha * (A * B' + B * A') + beta * C (trans is CJ_NOTRANS) or alpha * (A' * B + B' * A) + beta * C, 
+ * C is symmetric and only its triangle uplo is referenced, op(A), op(B): n*k, C: n*n */
+void cj_Syr2k (cj_Uplo uplo, cj_Trans trans, cj_Object *alpha, cj_Object *A, cj_Object *B, 
+    cj_Object *beta, cj_Object *C) {
+  cj_Matrix *a, *b, *c;
+  int an, ak;
+  cj_Symmetric_check("syr2k", alpha, A, B, beta, C);
+  a = A->matrix;
+  b = B->matrix;
+  c = C->matrix;
+  an = (trans == CJ_NOTRANS) ? a->m : a->n;
+  ak = (trans == CJ_NOTRANS) ? a->n : a->m;
+  if ((c->m != c->n) || (an != c->m) || (a->m != b->m) || (a->n != b->n)) 
+    cj_Blas_error("syr2k", "matrices dimension aren't matched.");
+  if (c->m == 0) return;
+  if (ak == 0) {
+    if (cj_Constant_get(beta) == 1.0) return;
+    cj_Blas_error("syr2k", "inner dimension is zero.");
+  }
+
+  cj_Queue_end();
+  cj_Syrk_tiles(uplo, trans, alpha, A, B, beta, C);
+  cj_Queue_begin();
+}
+
+/* C:= alpha * A * B + beta * C (left) or alpha * B * A + beta * C (right), A is symmetric 
+ * and only its triangle uplo is referenced, A: m*m (left) or n*n (right), B, C: m*n */
+void cj_Symm (cj_Side side, cj_Uplo uplo, cj_Object *alpha, cj_Object *A, cj_Object *B, 
+    cj_Object *beta, cj_Object *C) {
+  cj_Matrix *a, *b, *c;
+  cj_Symmetric_check("symm", alpha, A, B, beta, C);
+  a = A->matrix;
+  b = B->matrix;
+  c = C->matrix;
+  if ((a->m != a->n) || (b->m != c->m) || (b->n != c->n) || (((side == CJ_LEFT) ? c->m : c->n) != a->m)) 
+    cj_Blas_error("symm", "matrices dimension aren't matched.");
+  if (side != CJ_LEFT && side != CJ_RIGHT)
+    cj_Blas_error("symm", "side is neither left nor right.");
+  if (c->m == 0 || c->n == 0) return;
+
+  cj_Queue_end();
+  cj_Symm_tiles(side, uplo, alpha, A, B, beta, C);
+  cj_Queue_begin();
+}
+
+/* B:= A or B:= A + B on the host, converting between precisions. */
+static void cj_Copy_host (cj_Matrix *a, char *a_ptr, int lda, cj_Matrix *b, char *b_ptr, int ldb, cj_Bool add) {
+  int i, j;
+  double value;
+
+  if (add == FALSE && a->eletype == b->eletype) {
+    cj_Device_host_memcpy2d(b_ptr, ldb*b->elelen, a_ptr, lda*a->elelen, a->m*a->elelen, a->n);
+    return;
+  }
+  for (j = 0; j < a->n; j++) {
+    for (i = 0; i < a->m; i++) {
+      if (a->eletype == CJ_SINGLE) value = ((float *) a_ptr)[i + (size_t) j*lda];
+      else value = ((double *) a_ptr)[i + (size_t) j*lda];
+      if (b->eletype == CJ_SINGLE) {
+        float *b_elem = (float *) b_ptr + i + (size_t) j*ldb;
+        *b_elem = (add == TRUE) ? *b_elem + value : value;
+      }
+      else {
+        double *b_elem = (double *) b_ptr + i + (size_t) j*ldb;
+        *b_elem = (add == TRUE) ? *b_elem + value : value;
+      }
+    }
+  }
+}
+
+static void cj_Copy_kernel (void *task_ptr, cj_Bool add) {
+  cj_Task *task = (cj_Task *) task_ptr;
+  cj_Worker *worker = task->worker;
+  cj_devType devtype = worker->devtype;
+  int device_id = worker->device_id;
+  int lda, ldb;
+
+  cj_Object *A, *B;
+  cj_Matrix *a, *b;
+  char *a_ptr, *b_ptr;
+  A = task->arg->dqueue->head;
+  B = A->next;
+  a = A->matrix;
+  b = B->matrix;
+  a_ptr = cj_Worker_get_buff(worker, a, &lda);
+  b_ptr = cj_Worker_get_buff(worker, b, &ldb);
+
+  if (device_id != -1 && devtype == CJ_DEV_CUDA) {
+#ifdef CJ_HAVE_CUDA
+    cudaSetDevice(device_id);
+    cj_Device *device = worker->cj_ptr->device[device_id];
+    cudaStream_t stream;
+    cublasGetStream(device->handle, &stream);
+    if (add == FALSE && a->eletype == b->eletype) {
+      if (cudaMemcpy2DAsync(b_ptr, ldb*b->elelen, a_ptr, lda*a->elelen, a->m*a->elelen, a->n, 
+            cudaMemcpyDeviceToDevice, stream) != cudaSuccess) {
+        cj_Blas_error("cj_Copy_kernel", "cuda failure");
+      }
+    }
+    else if (a->eletype == b->eletype) {
+      cublasStatus_t status;
+      if (a->eletype == CJ_SINGLE) {
+        float f_one = 1.0;
+        status = cublasSgeam(device->handle, CUBLAS_OP_N, CUBLAS_OP_N, b->m, b->n, &f_one, (float *) a_ptr, lda,
+            &f_one, (float *) b_ptr, ldb, (float *) b_ptr, ldb);
+      }
+      else {
+        double f_one = 1.0;
+        status = cublasDgeam(device->handle, CUBLAS_OP_N, CUBLAS_OP_N, b->m, b->n, &f_one, (double *) a_ptr, lda,
+            &f_one, (double *) b_ptr, ldb, (double *) b_ptr, ldb);
+      }
+      if (status != CUBLAS_STATUS_SUCCESS) cj_Blas_error("cj_Copy_kernel", "cublas failure");
+    }
+    else {
+      /* Tiles changing precision are converted in the pinned workspace. */
+      size_t a_len = (size_t) a->m*a->n*a->elelen;
+      char *work = cj_Device_workspace(device, a_len + (size_t) b->m*b->n*b->elelen);
+      cudaMemcpy2DAsync(work, a->m*a->elelen, a_ptr, lda*a->elelen, a->m*a->elelen, a->n, 
+          cudaMemcpyDeviceToHost, stream);
+      if (add == TRUE) {
+        cudaMemcpy2DAsync(work + a_len, b->m*b->elelen, b_ptr, ldb*b->elelen, b->m*b->elelen, b->n, 
+            cudaMemcpyDeviceToHost, stream);
+      }
+      if (cudaStreamSynchronize(stream) != cudaSuccess) cj_Blas_error("cj_Copy_kernel", "cuda failure");
+      cj_Copy_host(a, work, a->m, b, work + a_len, b->m, add);
+      cudaMemcpy2DAsync(b_ptr, ldb*b->elelen, work + a_len, b->m*b->elelen, b->m*b->elelen, b->n, 
+          cudaMemcpyHostToDevice, stream);
+      /* The workspace is reused by the next task. */
+      if (cudaStreamSynchronize(stream) != cudaSuccess) cj_Blas_error("cj_Copy_kernel", "cuda failure");
+    }
+#endif
+  }
+  else {
+    cj_Copy_host(a, a_ptr, lda, b, b_ptr, ldb, add);
+  }
+
+  fprintf(stderr, YELLOW "  Worker_execute %d (%d, %s), A(%d, %d), B(%d, %d): \n" NONE, 
+      task->worker->id, task->id, task->name,
+      a->offm/BLOCK_SIZE, a->offn/BLOCK_SIZE, 
+      b->offm/BLOCK_SIZE, b->offn/BLOCK_SIZE);  
+}
+
+void cj_Copy_task_function (void *task_ptr) {
+  cj_Copy_kernel(task_ptr, FALSE);
+}
+
+void cj_Axpy_task_function (void *task_ptr) {
+  cj_Copy_kernel(task_ptr, TRUE);
+}
+
+static void cj_Copy_task (cj_Object *A, cj_Object *B, cj_Bool add) {
+  /* Copy will read A and write B, Axpy will read A, B and write B. */
+  cj_Object *A_copy, *B_copy, *task;
+  cj_Matrix *a, *b;
+
+  A_copy = cj_Object_new(CJ_MATRIX);
+  B_copy = cj_Object_new(CJ_MATRIX);
+  cj_Matrix_duplicate(A, A_copy);
+  cj_Matrix_duplicate(B, B_copy);
+  a = A_copy->matrix; b = B_copy->matrix;
+
+  task = cj_Object_new(CJ_TASK);
+  cj_Task_set(task->task, CJ_TASK_COPY, (add == TRUE) ? &cj_Axpy_task_function : &cj_Copy_task_function);
+
+  /* Pushing arguments. */
+  cj_Object *arg_A = cj_Object_append(CJ_MATRIX, a);
+  cj_Object *arg_B = cj_Object_append(CJ_MATRIX, b);
+  arg_A->rwtype = CJ_R;
+  arg_B->rwtype = (add == TRUE) ? CJ_RW : CJ_W;
+  cj_Dqueue_push_tail(task->task->arg, arg_A);
+  cj_Dqueue_push_tail(task->task->arg, arg_B);
+
+  /* Setup task name. */
+  snprintf(task->task->name,  64, "%s%d", (add == TRUE) ? "Axpy" : "Copy", task->task->id);
+  snprintf(task->task->label, 64, "B%d%d%s=A%d%d",
+      b->offm/BLOCK_SIZE, b->offn/BLOCK_SIZE, (add == TRUE) ? "+" : "",
+      a->offm/BLOCK_SIZE, a->offn/BLOCK_SIZE);
+
+  cj_Task_dependency_analysis(task);
+}
+
+static void cj_Copy_tiles (cj_Object *A, cj_Object *B, cj_Bool add, const char *func_name) {
+  cj_Matrix *a, *b;
+  cj_Object *A_tile, *B_tile;
+  int i, j;
+  if (!A || !B) 
+    cj_Blas_error(func_name, "matrices haven't been initialized yet.");
+  if (!A->matrix || !B->matrix)
+    cj_Blas_error(func_name, "Object types are not matrix type.");
+  a = A->matrix;
+  b = B->matrix;
+  if ((a->m != b->m) || (a->n != b->n)) 
+    cj_Blas_error(func_name, "matrices dimension aren't matched.");
+  if (a->offm%BLOCK_SIZE != 0 || a->offn%BLOCK_SIZE != 0 || b->offm%BLOCK_SIZE != 0 || b->offn%BLOCK_SIZE != 0)
+    cj_Blas_error(func_name, "matrices aren't aligned to the tiles.");
+
+  A_tile = cj_Object_new(CJ_MATRIX);
+  B_tile = cj_Object_new(CJ_MATRIX);
+  cj_Matrix_duplicate(A, A_tile);
+  cj_Matrix_duplicate(B, B_tile);
+
+  cj_Queue_end();
+  for (j = 0; j < a->n; j += BLOCK_SIZE) {
+    for (i = 0; i < a->m; i += BLOCK_SIZE) {
+      A_tile->matrix->offm = a->offm + i; A_tile->matrix->offn = a->offn + j;
+      B_tile->matrix->offm = b->offm + i; B_tile->matrix->offn = b->offn + j;
+      A_tile->matrix->m = B_tile->matrix->m = min(BLOCK_SIZE, a->m - i);
+      A_tile->matrix->n = B_tile->matrix->n = min(BLOCK_SIZE, a->n - j);
+      cj_Copy_task(A_tile, B_tile, add);
+    }
+  }
+  cj_Queue_begin();
+}
+
+/* B:= A, one task per tile. A and B may be stored in different layouts or
+ * precisions, which converts between them in parallel. A: m*n, B: m*n */
+void cj_Copy (cj_Object *A, cj_Object *B) {
+  cj_Copy_tiles(A, B, FALSE, "copy");
+}
+
+/* B:= A + B, one task per tile. A may be stored in a lower precision than B. A: m*n, B: m*n */
+void cj_Axpy (cj_Object *A, cj_Object *B) {
+  cj_Copy_tiles(A, B, TRUE, "axpy");
+}
+
 
 //void cj_Chol_l_unb_var3(cj_Object *A) {
 //  cj_Object *ATL,   *ATR,      *A00,  *a01,     *A02,
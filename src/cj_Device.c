@@ -3,13 +3,16 @@
  *  Chenhan D. Yu
  *  Created: Mar 30, 2014
  *
- *  Implement the software cache for the GPU device.
+ *  Implement the software cache for the GPU device. Cache lines are backed
+ *  lazily by blocks from a slab allocator bounded by a memory budget, so a
+ *  line holds a tile of any size and precision.
  *
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
 
 #ifdef CJ_HAVE_CUDA
 #include <cuda_runtime_api.h>
@@ -32,7 +35,9 @@ void cj_Device_error (const char *func_name, char* msg_text) {
 }
 
 /**
- *  @brief  Read the target object into device cache.
+ *  @brief  Read the target object into device cache. The tile is stored 
+ *          packed, its leading dimension is kept with the line. Tiles of 
+ *          pageable matrices go through the staging buffers.
  *  @param  *device :device structure pointer
  *  @param  line_id :cache line id
  *  @param  *target :target object pointer
@@ -40,25 +45,73 @@ void cj_Device_error (const char *func_name, char* msg_text) {
 void cj_Cache_read_in (cj_Device *device, int line_id, cj_Object *target) {
   cj_Cache *cache = &device->cache;
   uintptr_t ptr_d = cache->dev_ptr[line_id];
-  //fprintf(stderr, "inside cache_read_in\n");
-  char *ptr_h;
-  if (device->devtype == CJ_DEV_CUDA) {    
-    if (target->objtype == CJ_MATRIX) {
-      //fprintf(stderr, "Cache_read_in (CJ_MATRIX) : \n");
-      cj_Matrix *base = target->matrix->base;
-      cj_Matrix *matrix = target->matrix;
-
-      ptr_h = base->buff + base->m*base->elelen*matrix->offn + matrix->offm*base->elelen;
-      cj_Device_memcpy2d_h2d(ptr_d, BLOCK_SIZE*base->elelen, ptr_h, base->m*base->elelen,
+  char *ptr_h = NULL;
+  int ld_h;
+
+  if (target->objtype == CJ_MATRIX) {
+    cj_Matrix *base = target->matrix->base;
+    cj_Matrix *matrix = target->matrix;
+
+    cj_Disk_touch(target);
+    ptr_h = cj_Matrix_addr(base, matrix->offm, matrix->offn, &ld_h);
+    cache->ld[line_id] = matrix->m;
+    if (base->pinned == TRUE) {
+      cj_Device_memcpy2d_h2d(ptr_d, cache->ld[line_id]*base->elelen, ptr_h, ld_h*base->elelen,
           matrix->m*matrix->elelen, matrix->n, device);
     }
     else {
+      cj_Device_stage_h2d(ptr_d, cache->ld[line_id]*base->elelen, ptr_h, ld_h*base->elelen,
+          matrix->m*matrix->elelen, matrix->n, device);
     }
+    cj_Stats_count(device, target, CJ_STAT_H2D, (long long) matrix->m*matrix->n*matrix->elelen);
   }
   cache->hos_ptr[line_id] = ptr_h;
   cache->status[line_id] = CJ_CACHE_CLEAN;
 }
 
+/**
+ *  @brief  Read a run of vertically adjacent tiles into cache lines sharing
+ *          one block, with a single strided copy. The tiles are stacked in 
+ *          the block with leading dimension ld, the first line owns it. Tiles
+ *          stored contiguously keep their own leading dimension, and the run
+ *          is one flat copy.
+ *  @param  *device :device structure pointer
+ *  @param  *line_id :cache line ids of the run
+ *  @param  **target :tiles of the run, from top to bottom
+ *  @param  nrun :number of tiles
+ *  @param  ld :leading dimension of the block
+ */
+void cj_Cache_read_in_run (cj_Device *device, int *line_id, cj_Object **target, int nrun, int ld) {
+  cj_Cache *cache = &device->cache;
+  cj_Matrix *base = target[0]->matrix->base;
+  cj_Matrix *first = target[0]->matrix;
+  int k, m = 0, ld_h;
+  char *ptr_h = cj_Matrix_addr(base, first->offm, first->offn, &ld_h);
+
+  for (k = 0; k < nrun; k++) {
+    cj_Matrix *matrix = target[k]->matrix;
+    cache->ld[line_id[k]] = (base->layout == CJ_LAYOUT_COLUMN) ? ld : matrix->m;
+    cache->hos_ptr[line_id[k]] = cj_Matrix_addr(base, matrix->offm, matrix->offn, NULL);
+    cache->status[line_id[k]] = CJ_CACHE_CLEAN;
+    cj_Disk_touch(target[k]);
+    cj_Stats_count(device, target[k], CJ_STAT_H2D, (long long) matrix->m*matrix->n*matrix->elelen);
+    m += matrix->m;
+  }
+  /* A run of contiguous tiles is one column of all their bytes. */
+  if (base->layout != CJ_LAYOUT_COLUMN) {
+    ld = ld_h = m*first->n;
+    m = ld;
+  }
+  if (base->pinned == TRUE) {
+    cj_Device_memcpy2d_h2d(cache->dev_ptr[line_id[0]], ld*base->elelen, ptr_h, ld_h*base->elelen,
+        m*base->elelen, (base->layout == CJ_LAYOUT_COLUMN) ? first->n : 1, device);
+  }
+  else {
+    cj_Device_stage_h2d(cache->dev_ptr[line_id[0]], ld*base->elelen, ptr_h, ld_h*base->elelen,
+        m*base->elelen, (base->layout == CJ_LAYOUT_COLUMN) ? first->n : 1, device);
+  }
+}
+
 /**
  *  @brief  Write the target object from device cache back to main memory.
  *  @param  *device :device structure pointer
@@ -70,15 +123,23 @@ void cj_Cache_write_back (cj_Device *device, int line_id, cj_Object *target) {
   uintptr_t ptr_d = cache->dev_ptr[line_id];
   char *ptr_h = cache->hos_ptr[line_id];
    
-  if (device->devtype == CJ_DEV_CUDA) {
-    if (target->objtype == CJ_MATRIX) {
-      cj_Matrix *base = target->matrix->base;
-      cj_Matrix *matrix = target->matrix;
-      cj_Device_memcpy2d_d2h(ptr_h, base->m*base->elelen, ptr_d, BLOCK_SIZE*base->elelen,
+  if (target->objtype == CJ_MATRIX) {
+    cj_Matrix *base = target->matrix->base;
+    cj_Matrix *matrix = target->matrix;
+    int ld_h;
+    cj_Matrix_addr(base, matrix->offm, matrix->offn, &ld_h);
+    cj_Cache_line_wait(device, line_id);
+    cj_Disk_touch(target);
+    if (base->pinned == TRUE) {
+      cj_Device_memcpy2d_d2h(ptr_h, ld_h*base->elelen, ptr_d, cache->ld[line_id]*base->elelen,
           matrix->m*matrix->elelen, matrix->n, device);
     }
     else {
+      cj_Device_stage_d2h(ptr_h, ld_h*base->elelen, ptr_d, cache->ld[line_id]*base->elelen,
+          matrix->m*matrix->elelen, matrix->n, device);
     }
+    cj_Stats_count(device, target, CJ_STAT_WRITE_BACK, 1);
+    cj_Stats_count(device, target, CJ_STAT_D2H, (long long) matrix->m*matrix->n*matrix->elelen);
   }
   cache->status[line_id] = CJ_CACHE_CLEAN;
 }
@@ -95,39 +156,347 @@ void cj_Cache_async_write_back (cj_Device *device, int line_id, cj_Object *targe
   uintptr_t ptr_d = cache->dev_ptr[line_id];
   char *ptr_h = cache->hos_ptr[line_id];
    
-  if (device->devtype == CJ_DEV_CUDA) {
-    if (target->objtype == CJ_MATRIX) {
-      cj_Matrix *base = target->matrix->base;
-      cj_Matrix *matrix = target->matrix;
-      cj_Device_async_memcpy2d_d2h(ptr_h, base->m*base->elelen, ptr_d, BLOCK_SIZE*base->elelen,
+  if (target->objtype == CJ_MATRIX) {
+    cj_Matrix *base = target->matrix->base;
+    cj_Matrix *matrix = target->matrix;
+    int ld_h;
+    cj_Matrix_addr(base, matrix->offm, matrix->offn, &ld_h);
+    cj_Cache_line_wait(device, line_id);
+    cj_Disk_touch(target);
+    if (base->pinned == TRUE) {
+      cj_Device_async_memcpy2d_d2h(ptr_h, ld_h*base->elelen, ptr_d, cache->ld[line_id]*base->elelen,
+          matrix->m*matrix->elelen, matrix->n, device);
+    }
+    else {
+      cj_Device_stage_d2h(ptr_h, ld_h*base->elelen, ptr_d, cache->ld[line_id]*base->elelen,
           matrix->m*matrix->elelen, matrix->n, device);
     }
+    cj_Stats_count(device, target, CJ_STAT_WRITE_BACK, 1);
+    cj_Stats_count(device, target, CJ_STAT_D2H, (long long) matrix->m*matrix->n*matrix->elelen);
   }
   //cache->status[line_id] = CJ_CACHE_CLEAN;
 }
 
 /**
- *  @brief  Fetch the target from main memory to device memory. This device cache 
- *          is implemented that can only replace clean cache line. If the cache 
- *          line is dirty, it will search for another one.
+ *  @brief  Read the target object into device cache from the copy held in a
+ *          cache line of another device. The copy is issued on the copy stream
+ *          of the destination once the source line has been written, and 
+ *          synchronized by cj_Cache_sync.
  *  @param  *device :device structure pointer
+ *  @param  line_id :cache line id
  *  @param  *target :target object pointer
- *  @return cache line id
+ *  @param  *src :source device pointer
+ *  @param  src_line :cache line id on the source device
  */
-int cj_Cache_fetch (cj_Device *device, cj_Object *target) {
+void cj_Cache_read_peer (cj_Device *device, int line_id, cj_Object *target, cj_Device *src, int src_line) {
   cj_Cache *cache = &device->cache;
-  int line_id = cache->fifo;
 
-  /* Update fifo pointer */
-  cache->fifo ++;
-  if (cache->fifo >= CACHE_LINE) cache->fifo = 0;
+  if (target->objtype == CJ_MATRIX) {
+    cj_Matrix *base = target->matrix->base;
+    cj_Matrix *matrix = target->matrix;
+
+    cache->hos_ptr[line_id] = cj_Matrix_addr(base, matrix->offm, matrix->offn, NULL);
+    cache->ld[line_id] = matrix->m;
+    cj_Cache_line_wait(src, src_line);
+    cj_Device_memcpy2d_d2d(cache->dev_ptr[line_id], cache->ld[line_id]*base->elelen, device,
+        src->cache.dev_ptr[src_line], src->cache.ld[src_line]*base->elelen, src,
+        matrix->m*matrix->elelen, matrix->n);
+    cj_Stats_count(device, target, CJ_STAT_D2D, (long long) matrix->m*matrix->n*matrix->elelen);
+  }
+  cache->status[line_id] = CJ_CACHE_CLEAN;
+}
+
+/**
+ *  @brief  Return the slab class of a block request. Class c holds blocks of
+ *          2^(CACHE_SLAB_MIN + c) bytes.
+ *  @param  len :memory length in bytes
+ *  @return slab class, or -1 if the request is too large
+ */
+int cj_Cache_slab_class (size_t len) {
+  int c = 0;
+  while (c < CACHE_SLAB_CLASS && ((size_t) 1 << (CACHE_SLAB_MIN + c)) < len) c ++;
+  if (c == CACHE_SLAB_CLASS) return -1;
+  return c;
+}
+
+/**
+ *  @brief  Return the block of a cache line to the free stack of its class.
+ *          A line placed in the block of another line gives its place up.
+ *  @param  *device :device structure pointer
+ *  @param  line_id :cache line id
+ */
+void cj_Cache_release (cj_Device *device, int line_id) {
+  cj_Cache *cache = &device->cache;
+  int c = cache->slab[line_id];
 
-  if (cache->status[line_id] == CJ_CACHE_DIRTY) {
-    line_id = cj_Cache_fetch(device, target);
+  /* A line placed in the block of another one only leaves it. */
+  if (cache->parent[line_id] != -1) {
+    cache->share[cache->parent[line_id]] --;
+    cache->parent[line_id] = -1;
+    cache->dev_ptr[line_id] = 0;
+    return;
+  }
+  if (c == -1) return;
+  if (cache->nfree[c] < CACHE_LINE) {
+    cache->free_ptr[c][cache->nfree[c] ++] = cache->dev_ptr[line_id];
   }
   else {
-    cj_Cache_read_in(device, line_id, target);
+    cj_Device_free(cache->dev_ptr[line_id], device->devtype);
+    cache->used -= (size_t) 1 << (CACHE_SLAB_MIN + c);
   }
+  cache->dev_ptr[line_id] = 0;
+  cache->slab[line_id] = -1;
+}
+
+/**
+ *  @brief  Give a cache line a block large enough for len bytes. A block of 
+ *          the same class is reused, a new one is only allocated while the 
+ *          budget allows. Free blocks of the other classes are returned to 
+ *          the device before giving up.
+ *  @param  *device :device structure pointer
+ *  @param  line_id :cache line id
+ *  @param  len :memory length in bytes
+ *  @return TRUE if the line has a block now
+ */
+cj_Bool cj_Cache_alloc (cj_Device *device, int line_id, size_t len) {
+  cj_Cache *cache = &device->cache;
+  int i, c = cj_Cache_slab_class(len);
+  size_t size;
+
+  if (c == -1) cj_Device_error("Cache_alloc", "tile is larger than the largest slab.");
+  if (cache->slab[line_id] == c) return TRUE;
+  cj_Cache_release(device, line_id);
+
+  size = (size_t) 1 << (CACHE_SLAB_MIN + c);
+  if (cache->nfree[c] == 0) {
+    for (i = 0; i < CACHE_SLAB_CLASS && cache->used + size > cache->budget; i++) {
+      while (cache->nfree[i] > 0 && cache->used + size > cache->budget) {
+        cj_Device_free(cache->free_ptr[i][-- cache->nfree[i]], device->devtype);
+        cache->used -= (size_t) 1 << (CACHE_SLAB_MIN + i);
+      }
+    }
+    if (cache->used + size > cache->budget) return FALSE;
+    cache->free_ptr[c][cache->nfree[c] ++] = cj_Device_malloc(size, device->devtype);
+    if (!cache->free_ptr[c][cache->nfree[c] - 1]) {
+      cache->nfree[c] --;
+      return FALSE;
+    }
+    cache->used += size;
+  }
+  cache->dev_ptr[line_id] = cache->free_ptr[c][-- cache->nfree[c]];
+  cache->slab[line_id] = c;
+  return TRUE;
+}
+
+/**
+ *  @brief  Return the distribution whose copy on this device lives in the
+ *          cache line. Free lines and stale lines (their copy has been 
+ *          invalidated since) have no owner.
+ *  @param  *device :device structure pointer
+ *  @param  line_id :cache line id
+ *  @return distribution pointer or NULL
+ */
+cj_Distribution *cj_Cache_get_distribution (cj_Device *device, int line_id) {
+  cj_Cache *cache = &device->cache;
+  cj_Object *target = cache->obj_ptr[line_id];
+  int dest = device->id + 1;
+
+  if (!target || target->objtype != CJ_MATRIX) return NULL;
+
+  cj_Matrix       *matrix = target->matrix;
+  cj_Distribution *dist   = matrix->base->dist[matrix->offm/BLOCK_SIZE][matrix->offn/BLOCK_SIZE];
+
+  if ((dist->avail[dest] == TRUE || dist->state[dest] == CJ_INFLIGHT) && dist->line[dest] == line_id) return dist;
+  return NULL;
+}
+
+/**
+ *  @brief  Pin a cache line. A pinned line is held by a running or a 
+ *          prefetching task and will never be chosen as a victim. Pinning
+ *          counts as a use for the LRU policy.
+ *  @param  *device :device structure pointer
+ *  @param  line_id :cache line id
+ */
+void cj_Cache_pin (cj_Device *device, int line_id) {
+  cj_Cache *cache = &device->cache;
+  if (line_id < 0 || line_id >= CACHE_LINE) cj_Device_error("Cache_pin", "invalid cache line.");
+  cache->ref_count[line_id] ++;
+  cache->clock ++;
+  cache->last_use[line_id] = cache->clock;
+}
+
+/**
+ *  @brief  Release a pin taken by cj_Cache_pin.
+ *  @param  *device :device structure pointer
+ *  @param  line_id :cache line id
+ */
+void cj_Cache_unpin (cj_Device *device, int line_id) {
+  cj_Cache *cache = &device->cache;
+  if (line_id < 0 || line_id >= CACHE_LINE) cj_Device_error("Cache_unpin", "invalid cache line.");
+  if (cache->ref_count[line_id] <= 0) cj_Device_error("Cache_unpin", "cache line is not pinned.");
+  cache->ref_count[line_id] --;
+}
+
+/**
+ *  @brief  Choose the line to be replaced. Pinned lines and lines whose block
+ *          holds other lines are skipped, free or stale lines are taken first. Otherwise the least recently used line
+ *          is chosen, where a dirty line is charged CACHE_LINE extra ticks for
+ *          its write-back. If lookahead is enabled, lines read by the next
+ *          queued tasks of the bound worker are only chosen as a last resort.
+ *  @param  *device :device structure pointer
+ *  @param  *skip :lines which must not be chosen
+ *  @return cache line id, or -1 if no line can be replaced
+ */
+int cj_Cache_victim (cj_Device *device, cj_Bool *skip) {
+  cj_Cache *cache = &device->cache;
+  int i, cost, keep, victim = -1, victim_cost = 0, victim_keep = 0;
+
+  for (i = 0; i < CACHE_LINE; i++) {
+    if (skip[i] == TRUE || cache->ref_count[i] > 0 || cache->share[i] > 0) continue;
+    if (!cj_Cache_get_distribution(device, i)) return i;
+
+    cost = cache->last_use[i];
+    if (cache->status[i] == CJ_CACHE_DIRTY) cost += CACHE_LINE;
+    keep = 0;
+    if (cache->lookahead > 0 && 
+        cj_Worker_lookahead(device->bindid, cache->obj_ptr[i], cache->lookahead) == TRUE) keep = 1;
+
+    if (victim == -1 || keep < victim_keep || (keep == victim_keep && cost < victim_cost)) {
+      victim      = i;
+      victim_cost = cost;
+      victim_keep = keep;
+    }
+  }
+  return victim;
+}
+
+/**
+ *  @brief  Evict the copy held in a cache line. The last dirty copy is 
+ *          written back to main memory first. The distribution of the evicted object is 
+ *          only tried, since the caller may hold other distribution locks. A copy 
+ *          read by a transfer in flight is never evicted.
+ *  @param  *device :device structure pointer
+ *  @param  line_id :cache line id
+ *  @return TRUE if the line is free now
+ */
+cj_Bool cj_Cache_evict (cj_Device *device, int line_id) {
+  cj_Cache *cache = &device->cache;
+  cj_Distribution *dist = cj_Cache_get_distribution(device, line_id);
+  int dest = device->id + 1;
+
+  if (dist) {
+    if (cj_Lock_try(&dist->lock) == FALSE) return FALSE;
+    /* The copy is the source or the destination of a transfer in flight. */
+    if (dist->reader[dest] > 0 || dist->state[dest] == CJ_INFLIGHT) {
+      cj_Lock_release(&dist->lock);
+      return FALSE;
+    }
+    /* The copy may have been invalidated before the lock was acquired. */
+    if (dist->avail[dest] == TRUE && dist->line[dest] == line_id) {
+      cj_Distribution_evict(dist, dest, cache->obj_ptr[line_id]);
+    }
+    cj_Lock_release(&dist->lock);
+  }
+  cache->status[line_id]  = CJ_CACHE_CLEAN;
+  cache->obj_ptr[line_id] = NULL;
+  return TRUE;
+}
+
+/**
+ *  @brief  Find a cache line for the target. The victim line is chosen by 
+ *          cj_Cache_victim and written back if it is dirty. If the budget is
+ *          exhausted, more lines are evicted and their blocks released until
+ *          the target fits. The caller fills the line.
+ *  @param  *device :device structure pointer
+ *  @param  *target :target object pointer
+ *  @return cache line id, or -1 if every line is pinned
+ */
+int cj_Cache_line (cj_Device *device, cj_Object *target) {
+  cj_Matrix *matrix = target->matrix;
+  return cj_Cache_line_size(device, target, (size_t) matrix->m*matrix->n*matrix->elelen);
+}
+
+/**
+ *  @brief  Find a cache line for the target with a block of len bytes, which
+ *          may hold the tiles below the target as well.
+ *  @param  *device :device structure pointer
+ *  @param  *target :target object pointer
+ *  @param  len :block length in bytes
+ *  @return cache line id, or -1 if every line is pinned
+ */
+int cj_Cache_line_size (cj_Device *device, cj_Object *target, size_t len) {
+  cj_Cache *cache = &device->cache;
+  cj_Bool skip[CACHE_LINE];
+  int i, line_id, other;
+
+  for (i = 0; i < CACHE_LINE; i++) skip[i] = FALSE;
+
+  while (1) {
+    line_id = cj_Cache_victim(device, skip);
+    if (line_id == -1) return -1;
+    if (cj_Cache_evict(device, line_id) == TRUE) break;
+    skip[line_id] = TRUE;
+  }
+
+  skip[line_id] = TRUE;
+  while (cj_Cache_alloc(device, line_id, len) == FALSE) {
+    other = cj_Cache_victim(device, skip);
+    if (other == -1) return -1;
+    skip[other] = TRUE;
+    if (cj_Cache_evict(device, other) == TRUE) cj_Cache_release(device, other);
+  }
+
+  cache->obj_ptr[line_id] = target;
+  cache->clock ++;
+  cache->last_use[line_id] = cache->clock;
+  return line_id;
+}
+
+/**
+ *  @brief  Find a cache line for the target placed in the block of another
+ *          line, offset bytes from its start. The other line must be pinned.
+ *  @param  *device :device structure pointer
+ *  @param  *target :target object pointer
+ *  @param  parent :line owning the block
+ *  @param  offset :offset in the block in bytes
+ *  @return cache line id, or -1 if every line is pinned
+ */
+int cj_Cache_line_share (cj_Device *device, cj_Object *target, int parent, size_t offset) {
+  cj_Cache *cache = &device->cache;
+  cj_Bool skip[CACHE_LINE];
+  int i, line_id;
+
+  for (i = 0; i < CACHE_LINE; i++) skip[i] = FALSE;
+  skip[parent] = TRUE;
+
+  while (1) {
+    line_id = cj_Cache_victim(device, skip);
+    if (line_id == -1) return -1;
+    if (cj_Cache_evict(device, line_id) == TRUE) break;
+    skip[line_id] = TRUE;
+  }
+  cj_Cache_release(device, line_id);
+
+  cache->dev_ptr[line_id] = cache->dev_ptr[parent] + offset;
+  cache->parent[line_id] = parent;
+  cache->share[parent] ++;
+  cache->obj_ptr[line_id] = target;
+  cache->clock ++;
+  cache->last_use[line_id] = cache->clock;
+  return line_id;
+}
+
+/**
+ *  @brief  Fetch the target from main memory to device memory.
+ *  @param  *device :device structure pointer
+ *  @param  *target :target object pointer
+ *  @return cache line id, or -1 if every line is pinned
+ */
+int cj_Cache_fetch (cj_Device *device, cj_Object *target) {
+  int line_id = cj_Cache_line(device, target);
+
+  if (line_id == -1) return -1;
+  cj_Cache_read_in(device, line_id, target);
   return line_id;
 }
 
@@ -143,6 +512,22 @@ void cj_Cache_sync (cj_Device *device) {
   }
 }
 
+/**
+ *  @brief  Wait until the last kernel writing a cache line has finished. Used
+ *          before the line is copied out of the device.
+ *  @param  *device :device structure pointer
+ *  @param  line_id :cache line id
+ * */
+void cj_Cache_line_wait (cj_Device *device, int line_id) {
+  if (device->devtype == CJ_DEV_CUDA) {
+#ifdef CJ_HAVE_CUDA
+    cudaEventSynchronize(device->line_event[line_id]);
+#else
+    (void) line_id;
+#endif
+  }
+}
+
 /**
  *  @brief  Synchronous barrier implemented by CUDA streams.
  *  @param  *device :device structure pointer
@@ -150,7 +535,120 @@ void cj_Cache_sync (cj_Device *device) {
 void cj_Device_sync (cj_Device *device) {
   if (device->devtype == CJ_DEV_CUDA) {
 #ifdef CJ_HAVE_CUDA
-    cudaStreamSynchronize(device->stream[1]);
+    int s;
+    for (s = 1; s <= STREAM_NUM; s++) cudaStreamSynchronize(device->stream[s]);
+#endif
+  }
+}
+
+/**
+ *  @brief  Retire the task in flight on a compute stream. The host waits for
+ *          the stream and the cache lines held by the task are unpinned.
+ *  @param  *device :device structure pointer
+ *  @param  s :stream id
+ * */
+void cj_Device_stream_retire (cj_Device *device, int s) {
+  int i;
+
+  if (device->nstream_line[s] == 0) return;
+  if (device->devtype == CJ_DEV_CUDA) {
+#ifdef CJ_HAVE_CUDA
+    cudaEventSynchronize(device->stream_event[s]);
+#endif
+  }
+  for (i = 0; i < device->nstream_line[s]; i++) {
+    cj_Cache_unpin(device, device->stream_line[s][i]);
+  }
+  device->nstream_line[s] = 0;
+}
+
+/**
+ *  @brief  Retire every task in flight on the device. Called when no cache
+ *          line can be replaced and before the bound worker exits.
+ *  @param  *device :device structure pointer
+ * */
+void cj_Device_drain (cj_Device *device) {
+  int s;
+  for (s = 1; s <= STREAM_NUM; s++) cj_Device_stream_retire(device, s);
+}
+
+/**
+ *  @brief  Choose the compute stream of the next task. Streams are used round
+ *          robin, so the task which ran on the stream STREAM_NUM tasks ago is
+ *          retired first. Kernels called through the device handle are issued
+ *          on the stream.
+ *  @param  *device :device structure pointer
+ *  @return stream id
+ * */
+int cj_Device_stream_begin (cj_Device *device) {
+  int s = device->stream_next + 1, t;
+
+  device->stream_next = (device->stream_next + 1)%STREAM_NUM;
+  cj_Device_stream_retire(device, s);
+  /* Count the task if others are still in flight next to it. */
+  for (t = 1; t <= STREAM_NUM; t++) if (t != s && device->nstream_line[t] > 0) break;
+  if (t <= STREAM_NUM) cj_Stats_count(device, NULL, CJ_STAT_OVERLAP, 1);
+  if (device->devtype == CJ_DEV_CUDA) {
+#ifdef CJ_HAVE_CUDA
+    cublasSetStream(device->handle, device->stream[s]);
+#endif
+  }
+  return s;
+}
+
+/**
+ *  @brief  Declare a cache line used by the task of a stream. The stream waits
+ *          for the tasks in flight on other streams which write the line, or 
+ *          which read it if the task writes it. The line is pinned until the 
+ *          stream is retired.
+ *  @param  *device :device structure pointer
+ *  @param  s :stream id
+ *  @param  line_id :cache line id
+ *  @param  write :TRUE if the task writes the line
+ * */
+void cj_Device_stream_use (cj_Device *device, int s, int line_id, cj_Bool write) {
+  int t, i;
+
+  for (t = 1; t <= STREAM_NUM; t++) {
+    if (t == s) continue;
+    for (i = 0; i < device->nstream_line[t]; i++) {
+      if (device->stream_line[t][i] == line_id && 
+          (write == TRUE || device->stream_write[t][i] == TRUE)) {
+        cj_Stats_count(device, NULL, CJ_STAT_STREAM_WAIT, 1);
+        if (device->devtype == CJ_DEV_CUDA) {
+#ifdef CJ_HAVE_CUDA
+          cudaStreamWaitEvent(device->stream[s], device->stream_event[t], 0);
+#endif
+        }
+        break;
+      }
+    }
+  }
+  if (device->nstream_line[s] == CACHE_LINE) cj_Device_error("Device_stream_use", "too many cache lines.");
+  cj_Cache_pin(device, line_id);
+  device->stream_line[s][device->nstream_line[s]]  = line_id;
+  device->stream_write[s][device->nstream_line[s]] = write;
+  device->nstream_line[s] ++;
+}
+
+/**
+ *  @brief  Mark the end of the task issued on a stream. The lines it writes
+ *          can be waited for by cj_Cache_line_wait from now on.
+ *  @param  *device :device structure pointer
+ *  @param  s :stream id
+ * */
+void cj_Device_stream_end (cj_Device *device, int s) {
+  if (device->devtype == CJ_DEV_CUDA) {
+#ifdef CJ_HAVE_CUDA
+    int i;
+    cudaEventRecord(device->stream_event[s], device->stream[s]);
+    for (i = 0; i < device->nstream_line[s]; i++) {
+      if (device->stream_write[s][i] == TRUE) {
+        cudaEventRecord(device->line_event[device->stream_line[s][i]], device->stream[s]);
+      }
+    }
+#else
+    (void) s;
 #endif
   }
 }
@@ -158,25 +656,31 @@ void cj_Device_sync (cj_Device *device) {
 /**
  *  @brief  Allocate device memory for device cache or other usage.
  *  @param  len :memory length in bytes
- *  @param  devtype :can be CUDA or MIC
- *  @return device memory pointer
+ *  @param  devtype :can be CUDA, MIC or HOST
+ *  @return device memory pointer, 0 if the allocation failed
  * */
 uintptr_t cj_Device_malloc (size_t len, cj_devType devtype) {
-  char *ptr;
+  char *ptr = NULL;
   if (devtype == CJ_DEV_CUDA) {
 #ifdef CJ_HAVE_CUDA
     cudaError_t error; 
     error = cudaMalloc((void**)&ptr, len);
-    if (error != cudaSuccess) fprintf(stderr, "%s\n", cudaGetErrorString(error));
+    if (error != cudaSuccess) {
+      fprintf(stderr, "%s\n", cudaGetErrorString(error));
+      ptr = NULL;
+    }
 #endif
   } 
+  else if (devtype == CJ_DEV_HOST) {
+    ptr = (char *) malloc(len);
+  }
   return (uintptr_t) ptr;
 }
 
 /**
  *  @brief  Free the target device memory.
  *  @param  ptr :device memory pointer represented in unsigned long long.
- *  @param  devtype :can be CUDA or MIC
+ *  @param  devtype :can be CUDA, MIC or HOST
  * */
 void cj_Device_free (uintptr_t ptr, cj_devType devtype) {
   if (devtype == CJ_DEV_CUDA) {
@@ -186,6 +690,193 @@ void cj_Device_free (uintptr_t ptr, cj_devType devtype) {
     if (error != cudaSuccess) fprintf(stderr, "%s\n", cudaGetErrorString(error));
 #endif
   }
+  else if (devtype == CJ_DEV_HOST) {
+    free((char *) ptr);
+  }
+}
+
+/**
+ *  @brief  Allocate page-locked main memory, which devices copy from and to
+ *          asynchronously.
+ *  @param  len :memory length in bytes
+ *  @param  devtype :can be CUDA, MIC or HOST
+ *  @return memory pointer, NULL if the allocation failed
+ * */
+char *cj_Device_malloc_host (size_t len, cj_devType devtype) {
+  char *ptr = NULL;
+  if (devtype == CJ_DEV_CUDA) {
+#ifdef CJ_HAVE_CUDA
+    if (cudaMallocHost((void**)&ptr, len) != cudaSuccess) ptr = NULL;
+#endif
+  }
+  else if (devtype == CJ_DEV_HOST) {
+    ptr = (char *) malloc(len);
+  }
+  return ptr;
+}
+
+/**
+ *  @brief  Free memory allocated by cj_Device_malloc_host.
+ *  @param  *ptr :memory pointer
+ *  @param  devtype :can be CUDA, MIC or HOST
+ * */
+void cj_Device_free_host (char *ptr, cj_devType devtype) {
+  if (!ptr) return;
+  if (devtype == CJ_DEV_CUDA) {
+#ifdef CJ_HAVE_CUDA
+    cudaFreeHost(ptr);
+#endif
+  }
+  else if (devtype == CJ_DEV_HOST) {
+    free(ptr);
+  }
+}
+
+/**
+ *  @brief  Lend the pinned workspace of the device to a kernel. The workspace
+ *          only grows, so kernels do not allocate page-locked memory per call.
+ *          Only the bound worker may call it.
+ *  @param  *device :device structure pointer
+ *  @param  len :memory length in bytes
+ *  @return workspace pointer
+ * */
+char *cj_Device_workspace (cj_Device *device, size_t len) {
+  if (len > device->work_size) {
+    cj_Device_free_host(device->work, device->devtype);
+    device->work = cj_Device_malloc_host(len, device->devtype);
+    if (!device->work) cj_Device_error("Device_workspace", "memory allocation failed.");
+    device->work_size = len;
+  }
+  return device->work;
+}
+
+/* Wait until the copy reading or filling a staging buffer has finished. */
+static void cj_Device_stage_wait (cj_Device *device, int b) {
+  if (device->devtype == CJ_DEV_CUDA) {
+#ifdef CJ_HAVE_CUDA
+    cudaEventSynchronize(device->stage_event[b]);
+#else
+    (void) b;
+#endif
+  }
+}
+
+/* Mark the end of the copies issued on a staging buffer. */
+static void cj_Device_stage_record (cj_Device *device, int b) {
+  if (device->devtype == CJ_DEV_CUDA) {
+#ifdef CJ_HAVE_CUDA
+    cudaEventRecord(device->stage_event[b], device->stream[0]);
+#else
+    (void) b;
+#endif
+  }
+}
+
+/* Allocate the staging buffers on first use. Call it with stage_lock held. */
+static cj_Bool cj_Device_stage_init (cj_Device *device) {
+  int b;
+  for (b = 0; b < STAGE_NUM; b++) {
+    if (!device->stage[b]) device->stage[b] = cj_Device_malloc_host(STAGE_SIZE, device->devtype);
+    if (!device->stage[b]) return FALSE;
+  }
+  return TRUE;
+}
+
+/**
+ *  @brief  Copy the object (matrix) from pageable main memory to device memory.
+ *          The columns are packed into the pinned staging buffers in chunks of 
+ *          STAGE_SIZE bytes, one chunk is packed while the previous one is on
+ *          its way. The last copies are synchronized by cj_Cache_sync.
+ *  @param  ptr_d :device memory pointer represented in unsigned long long
+ *  @param  pitch_d :device pitch in bytes
+ *  @param  *ptr_h :the corresponding main memory pointer
+ *  @param  pitch_h :main memory pitch in bytes
+ *  @param  mbytes :column length in bytes
+ *  @param  n :number of columns
+ *  @param  *device :device structure pointer
+ * */
+void cj_Device_stage_h2d (uintptr_t ptr_d, size_t pitch_d, char *ptr_h, size_t pitch_h, 
+    size_t mbytes, size_t n, cj_Device *device) {
+  size_t j, nc, chunk = (mbytes > 0) ? STAGE_SIZE/mbytes : 0;
+  int b = 0;
+
+  cj_Lock_acquire(&device->stage_lock);
+  if (chunk == 0 || cj_Device_stage_init(device) == FALSE) {
+    cj_Lock_release(&device->stage_lock);
+    cj_Device_memcpy2d_h2d(ptr_d, pitch_d, ptr_h, pitch_h, mbytes, n, device);
+    return;
+  }
+  for (j = 0; j < n; j += nc, b = (b + 1)%STAGE_NUM) {
+    nc = (n - j < chunk) ? n - j : chunk;
+    cj_Device_stage_wait(device, b);
+    cj_Device_host_memcpy2d(device->stage[b], mbytes, ptr_h + j*pitch_h, pitch_h, mbytes, nc);
+    cj_Device_memcpy2d_h2d(ptr_d + j*pitch_d, pitch_d, device->stage[b], mbytes, mbytes, nc, device);
+    cj_Device_stage_record(device, b);
+  }
+  cj_Lock_release(&device->stage_lock);
+}
+
+/**
+ *  @brief  Copy the object (matrix) from device memory to pageable main memory
+ *          through the pinned staging buffers. A chunk is unpacked while the 
+ *          next one is on its way. Returns when the copy is complete.
+ *  @param  *ptr_h :the corresponding main memory pointer
+ *  @param  pitch_h :main memory pitch in bytes
+ *  @param  ptr_d :device memory pointer represented in unsigned long long
+ *  @param  pitch_d :device pitch in bytes
+ *  @param  mbytes :column length in bytes
+ *  @param  n :number of columns
+ *  @param  *device :device structure pointer
+ * */
+void cj_Device_stage_d2h (char *ptr_h, size_t pitch_h, uintptr_t ptr_d, size_t pitch_d, 
+    size_t mbytes, size_t n, cj_Device *device) {
+  size_t j, nc, prev = 0, nprev = 0, chunk = (mbytes > 0) ? STAGE_SIZE/mbytes : 0;
+  int b = 0;
+
+  cj_Lock_acquire(&device->stage_lock);
+  if (chunk == 0 || cj_Device_stage_init(device) == FALSE) {
+    cj_Lock_release(&device->stage_lock);
+    cj_Device_memcpy2d_d2h(ptr_h, pitch_h, ptr_d, pitch_d, mbytes, n, device);
+    return;
+  }
+  for (j = 0; j <= n; j += nc, b = (b + 1)%STAGE_NUM) {
+    nc = (n - j < chunk) ? n - j : chunk;
+    cj_Device_stage_wait(device, b);
+    if (nc > 0) {
+      cj_Device_async_memcpy2d_d2h(device->stage[b], mbytes, ptr_d + j*pitch_d, pitch_d, mbytes, nc, device);
+      cj_Device_stage_record(device, b);
+    }
+    /* Unpack the previous chunk meanwhile. */
+    if (nprev > 0) {
+      int p = (b + STAGE_NUM - 1)%STAGE_NUM;
+      cj_Device_stage_wait(device, p);
+      cj_Device_host_memcpy2d(ptr_h + prev*pitch_h, pitch_h, device->stage[p], mbytes, mbytes, nprev);
+    }
+    prev  = j;
+    nprev = nc;
+    if (nc == 0) break;
+  }
+  cj_Lock_release(&device->stage_lock);
+}
+
+/**
+ *  @brief  Copy n columns of mbytes between two host buffers. Used by the
+ *          host-memory device, which stands in for a GPU in tests.
+ *          Contiguous columns are copied at once.
+ *  @param  *dst :destination pointer
+ *  @param  dpitch :destination pitch in bytes
+ *  @param  *src :source pointer
+ *  @param  spitch :source pitch in bytes
+ *  @param  mbytes :column length in bytes
+ *  @param  n :number of columns
+ * */
+void cj_Device_host_memcpy2d (char *dst, size_t dpitch, char *src, size_t spitch, size_t mbytes, size_t n) {
+  size_t j;
+  if (dpitch == mbytes && spitch == mbytes) {
+    memcpy(dst, src, mbytes*n);
+    return;
+  }
+  for (j = 0; j < n; j++) memcpy(dst + j*dpitch, src + j*spitch, mbytes);
 }
 
 /**
@@ -205,6 +896,9 @@ void cj_Device_memcpy_d2h (char *ptr_h, uintptr_t ptr_d, size_t len, cj_Device *
     if (error != cudaSuccess) fprintf(stderr, "%s\n", cudaGetErrorString(error));
 #endif
   }
+  else if (device->devtype == CJ_DEV_HOST) {
+    memcpy(ptr_h, (char *) ptr_d, len);
+  }
 }
 
 /**
@@ -227,10 +921,16 @@ void cj_Device_memcpy2d_d2h (char *ptr_h, size_t pitch_h, uintptr_t ptr_d, size_
     fprintf(stderr, "memcpy2d_d2h : pitch_d:%d, pitch_h:%d, mbytes:%d, n:%d\n", 
         (int) pitch_d, (int) pitch_h, (int) mbytes, (int) n);
         */
-    error = cudaMemcpy2D(ptr_h, pitch_h, (char *) ptr_d, pitch_d, mbytes, n, cudaMemcpyDeviceToHost);
+    if (pitch_h == mbytes && pitch_d == mbytes) 
+      error = cudaMemcpy(ptr_h, (char *) ptr_d, mbytes*n, cudaMemcpyDeviceToHost);
+    else 
+      error = cudaMemcpy2D(ptr_h, pitch_h, (char *) ptr_d, pitch_d, mbytes, n, cudaMemcpyDeviceToHost);
     if (error != cudaSuccess) fprintf(stderr, "%s\n", cudaGetErrorString(error));
 #endif
   }
+  else if (device->devtype == CJ_DEV_HOST) {
+    cj_Device_host_memcpy2d(ptr_h, pitch_h, (char *) ptr_d, pitch_d, mbytes, n);
+  }
 }
 
 /**
@@ -253,10 +953,16 @@ void cj_Device_async_memcpy2d_d2h (char *ptr_h, size_t pitch_h, uintptr_t ptr_d,
     fprintf(stderr, "memcpy2d_d2h : pitch_d:%d, pitch_h:%d, mbytes:%d, n:%d\n", 
         (int) pitch_d, (int) pitch_h, (int) mbytes, (int) n);
         */
-    error = cudaMemcpy2DAsync(ptr_h, pitch_h, (char *) ptr_d, pitch_d, mbytes, n, cudaMemcpyDeviceToHost, device->stream[0]);
+    if (pitch_h == mbytes && pitch_d == mbytes) 
+      error = cudaMemcpyAsync(ptr_h, (char *) ptr_d, mbytes*n, cudaMemcpyDeviceToHost, device->stream[0]);
+    else 
+      error = cudaMemcpy2DAsync(ptr_h, pitch_h, (char *) ptr_d, pitch_d, mbytes, n, cudaMemcpyDeviceToHost, device->stream[0]);
     if (error != cudaSuccess) fprintf(stderr, "%s\n", cudaGetErrorString(error));
 #endif
   }
+  else if (device->devtype == CJ_DEV_HOST) {
+    cj_Device_host_memcpy2d(ptr_h, pitch_h, (char *) ptr_d, pitch_d, mbytes, n);
+  }
 }
 
 /**
@@ -276,6 +982,9 @@ void cj_Device_memcpy_h2d (uintptr_t ptr_d, char *ptr_h, size_t len, cj_Device *
     if (error != cudaSuccess) fprintf(stderr, "%s\n", cudaGetErrorString(error));
 #endif
   }
+  else if (device->devtype == CJ_DEV_HOST) {
+    memcpy((char *) ptr_d, ptr_h, len);
+  }
 }
 
 void cj_Device_memcpy2d_h2d (uintptr_t ptr_d, size_t pitch_d, char *ptr_h, size_t pitch_h, 
@@ -289,10 +998,50 @@ void cj_Device_memcpy2d_h2d (uintptr_t ptr_d, size_t pitch_d, char *ptr_h, size_
         (int) pitch_d, (int) pitch_h, (int) mbytes, (int) n);
         */
     //error = cudaMemcpy2D((char *) ptr_d, pitch_d, ptr_h, pitch_h, mbytes, n, cudaMemcpyHostToDevice);
-    error = cudaMemcpy2DAsync((char *) ptr_d, pitch_d, ptr_h, pitch_h, mbytes, n, cudaMemcpyHostToDevice, device->stream[0]);
+    if (pitch_h == mbytes && pitch_d == mbytes) 
+      error = cudaMemcpyAsync((char *) ptr_d, ptr_h, mbytes*n, cudaMemcpyHostToDevice, device->stream[0]);
+    else 
+      error = cudaMemcpy2DAsync((char *) ptr_d, pitch_d, ptr_h, pitch_h, mbytes, n, cudaMemcpyHostToDevice, device->stream[0]);
     if (error != cudaSuccess) fprintf(stderr, "%s\n", cudaGetErrorString(error));
 #endif
   }
+  else if (device->devtype == CJ_DEV_HOST) {
+    cj_Device_host_memcpy2d((char *) ptr_d, pitch_d, ptr_h, pitch_h, mbytes, n);
+  }
+}
+
+/**
+ *  @brief  Copy the object (matrix) between the memory of two devices. CUDA
+ *          devices need peer access enabled by cj_Device_link.
+ *  @param  ptr_dst :destination device memory pointer
+ *  @param  pitch_dst :destination pitch in bytes
+ *  @param  *dst :destination device pointer
+ *  @param  ptr_src :source device memory pointer
+ *  @param  pitch_src :source pitch in bytes
+ *  @param  *src :source device pointer
+ *  @param  mbytes :column length in bytes
+ *  @param  n :number of columns
+ * */
+void cj_Device_memcpy2d_d2d (uintptr_t ptr_dst, size_t pitch_dst, cj_Device *dst, 
+    uintptr_t ptr_src, size_t pitch_src, cj_Device *src, size_t mbytes, size_t n) {
+  if (dst->devtype == CJ_DEV_CUDA && src->devtype == CJ_DEV_CUDA) {
+#ifdef CJ_HAVE_CUDA
+    cudaError_t error; 
+    cudaSetDevice(dst->id);
+    if (pitch_dst == mbytes && pitch_src == mbytes) 
+      error = cudaMemcpyAsync((char *) ptr_dst, (char *) ptr_src, mbytes*n, cudaMemcpyDefault, dst->stream[0]);
+    else 
+      error = cudaMemcpy2DAsync((char *) ptr_dst, pitch_dst, (char *) ptr_src, pitch_src, mbytes, n, 
+          cudaMemcpyDefault, dst->stream[0]);
+    if (error != cudaSuccess) fprintf(stderr, "%s\n", cudaGetErrorString(error));
+#endif
+  }
+  else if (dst->devtype == CJ_DEV_HOST && src->devtype == CJ_DEV_HOST) {
+    cj_Device_host_memcpy2d((char *) ptr_dst, pitch_dst, (char *) ptr_src, pitch_src, mbytes, n);
+  }
+  else {
+    cj_Device_error("Device_memcpy2d_d2d", "no direct link between the devices.");
+  }
 }
 
 void cj_Device_report(cj_Device *device) {
@@ -304,8 +1053,43 @@ void cj_Device_bind(cj_Worker *worker, cj_Device *device) {
   device->bindid = worker->id;
 }
 
+/**
+ *  @brief  Model the link from a peer to the device. CUDA peers get a direct
+ *          link if peer access can be enabled, devices emulated in host 
+ *          memory always have one. Other pairs stage through the host.
+ *  @param  *device :device structure pointer
+ *  @param  *peer :peer device pointer
+ * */
+void cj_Device_link(cj_Device *device, cj_Device *peer) {
+  device->link[peer->id + 1] = 0.0;
+  if (device == peer) return;
+
+  if (device->devtype == CJ_DEV_CUDA && peer->devtype == CJ_DEV_CUDA) {
+#ifdef CJ_HAVE_CUDA
+    int access = 0;
+    cudaDeviceCanAccessPeer(&access, device->id, peer->id);
+    if (access) {
+      cudaSetDevice(device->id);
+      cudaDeviceEnablePeerAccess(peer->id, 0);
+      device->link[peer->id + 1] = LINK_PEER;
+    }
+#endif
+  }
+  else if (device->devtype == CJ_DEV_HOST && peer->devtype == CJ_DEV_HOST) {
+    device->link[peer->id + 1] = LINK_HOST;
+  }
+}
+
+/**
+ *  @brief  Create a device and its cache. No device memory is allocated here,
+ *          cache lines get their blocks on the first fetch.
+ *  @param  devtype :can be CUDA, MIC or HOST
+ *  @param  device_id :device id
+ *  @return device structure pointer
+ * */
 cj_Device *cj_Device_new(cj_devType devtype, int device_id) {
   int i;
+  size_t memory = 0;
 
   cj_Device *device = (cj_Device*) malloc(sizeof(cj_Device));
   if (!device) cj_Device_error("Device_new", "memory allocation failed.");
@@ -317,30 +1101,69 @@ cj_Device *cj_Device_new(cj_devType devtype, int device_id) {
 #ifdef CJ_HAVE_CUDA
     cudaError_t error;
 	  struct cudaDeviceProp prop;
+    size_t free_memory, total_memory;
     cudaSetDevice(device_id);
     cudaDeviceReset();
     error = cudaGetDeviceProperties(&prop, gpu_counter);
-    cudaStreamCreate(&(device->stream[0]));
-    cudaStreamCreate(&(device->stream[1]));
+    for (i = 0; i < STREAM_NUM + 1; i++) {
+      cudaStreamCreate(&(device->stream[i]));
+      cudaEventCreateWithFlags(&(device->stream_event[i]), cudaEventDisableTiming);
+    }
+    for (i = 0; i < CACHE_LINE; i++) {
+      cudaEventCreateWithFlags(&(device->line_event[i]), cudaEventDisableTiming);
+    }
+    for (i = 0; i < STAGE_NUM; i++) {
+      cudaEventCreateWithFlags(&(device->stage_event[i]), cudaEventDisableTiming);
+    }
     cublasCreate(&(device->handle));
     cublasSetStream(device->handle, device->stream[1]);
+    cudaMemGetInfo(&free_memory, &total_memory);
+    memory = free_memory;
 	  gpu_counter ++;
 
-	  /* Setup device cache */
-	  device->cache.line_size = BLOCK_SIZE*BLOCK_SIZE*sizeof(double);
-    for (i = 0; i < CACHE_LINE; i++) {
-      device->cache.status[i] = CJ_CACHE_CLEAN;
-      device->cache.last_use[i] = 0;
-      device->cache.fifo = 0;
-      device->cache.dev_ptr[i] = cj_Device_malloc(device->cache.line_size, CJ_DEV_CUDA);
-      device->cache.hos_ptr[i] = NULL;
-    }
-
     fprintf(stderr, "  Name         : %s (%d.%d)\n", prop.name, prop.major, prop.minor);
     fprintf(stderr, "  Device Id    : %d \n", device_id);
     fprintf(stderr, "  Device Memory: %d Mbytes\n", (unsigned int) (prop.totalGlobalMem/1024)/1024);
 #endif
   }
+  else if (devtype == CJ_DEV_HOST) {
+    memory = HOST_DEV_MEMORY;
+    fprintf(stderr, "  Name         : host memory\n");
+    fprintf(stderr, "  Device Id    : %d \n", device_id);
+    fprintf(stderr, "  Device Memory: %d Mbytes\n", (unsigned int) (memory/1024)/1024);
+  }
+
+  for (i = 0; i < MAX_DEV + 1; i++) device->link[i] = 0.0;
+  if (devtype == CJ_DEV_CUDA) device->link[0] = LINK_PCI;
+  if (devtype == CJ_DEV_HOST) device->link[0] = LINK_HOST;
+
+  for (i = 0; i < CJ_STAT_NUM; i++) device->stats.count[i] = 0;
+  device->stream_next = 0;
+  for (i = 0; i < STREAM_NUM + 1; i++) device->nstream_line[i] = 0;
+  cj_Lock_new(&device->stage_lock);
+  for (i = 0; i < STAGE_NUM; i++) device->stage[i] = NULL;
+  device->work = NULL;
+  device->work_size = 0;
+
+  /* Setup device cache */
+  device->cache.clock = 0;
+  device->cache.lookahead = CACHE_LOOKAHEAD;
+  device->cache.budget = (size_t) (memory*CACHE_BUDGET);
+  device->cache.used = 0;
+  for (i = 0; i < CACHE_LINE; i++) {
+    device->cache.status[i] = CJ_CACHE_CLEAN;
+    device->cache.last_use[i] = 0;
+    device->cache.ref_count[i] = 0;
+    device->cache.obj_ptr[i] = NULL;
+    device->cache.dev_ptr[i] = 0;
+    device->cache.slab[i] = -1;
+    device->cache.parent[i] = -1;
+    device->cache.share[i] = 0;
+    device->cache.ld[i] = 0;
+    device->cache.hos_ptr[i] = NULL;
+  }
+  for (i = 0; i < CACHE_SLAB_CLASS; i++) device->cache.nfree[i] = 0;
+  fprintf(stderr, "  Cache Budget : %d Mbytes\n", (unsigned int) (device->cache.budget/1024)/1024);
 
   return device;
 }
@@ -0,0 +1,417 @@
+/*
+ * cj_File.c
+ * Tiled matrix files for CJ
+ * A file starts with a header (dimensions, element type, tile size, layout)
+ * and the offsets of its tiles, followed by the data. Tiles are loaded and
+ * stored by runtime tasks, one per tile, so that the workers read and write
+ * the file in parallel.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <sys/stat.h>
+
+#include <cj.h>
+
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+/* files with tasks in flight, and the signal of their last task */
+static cj_Lock file_lock = {PTHREAD_MUTEX_INITIALIZER};
+static pthread_cond_t file_done = PTHREAD_COND_INITIALIZER;
+static cj_File *file_busy = NULL;
+
+void cj_File_error (const char *func_name, char* msg_text) {
+  fprintf(stderr, "CJ_FILE_ERROR: %s(): %s\n", func_name, msg_text);
+  abort();
+  exit(0);
+}
+
+/**
+ * @brief  Wait until the tasks loading or storing a file are done. Files are
+ *         told apart by the name they were opened with.
+ * @param  *filename matrix file
+ */
+void cj_File_wait (const char *filename) {
+  cj_File *file;
+
+  cj_Lock_acquire(&file_lock);
+  file = file_busy;
+  while (file) {
+    if (strcmp(file->name, filename) == 0) {
+      pthread_cond_wait(&file_done, &file_lock.lock);
+      file = file_busy;
+    }
+    else file = file->next;
+  }
+  cj_Lock_release(&file_lock);
+}
+
+/* Round up to the alignment of the file data. */
+static int64_t cj_File_align (int64_t off, int64_t align) {
+  return ((off + align - 1)/align)*align;
+}
+
+/* Leading dimension of the tiles of row i in the file. */
+static int64_t cj_File_ld (cj_File *file, int i) {
+  cj_FileHeader *header = &file->header;
+  if (header->layout == CJ_LAYOUT_COLUMN) return header->m;
+  return min(header->tile, header->m - i*header->tile);
+}
+
+/* Move the pieces gathered in iov, contiguous in the file from off. Short
+ * transfers are resumed where they stopped. */
+static void cj_File_flush (cj_File *file, struct iovec *iov, int niov, int64_t off, cj_Bool store) {
+  ssize_t done;
+
+  while (niov > 0) {
+    done = (store == TRUE) ? pwritev(file->fd, iov, niov, off) : preadv(file->fd, iov, niov, off);
+    if (done <= 0) cj_File_error("File_flush", (store == TRUE) ? "Could not write the file." : "The file is truncated.");
+    off += done;
+    while (niov > 0 && (size_t) done >= iov->iov_len) {
+      done -= iov->iov_len;
+      iov ++;
+      niov --;
+    }
+    if (niov > 0) {
+      iov->iov_base = (char *) iov->iov_base + done;
+      iov->iov_len -= done;
+    }
+  }
+}
+
+/* Read or write a tile through buff with leading dimension ld. The tile is
+ * cut along the tiles of the file, and pieces following each other in the
+ * file go through one call. */
+static void cj_File_tile_io (cj_File *file, cj_Matrix *tile, char *buff, int ld, cj_Bool store) {
+  cj_FileHeader *header = &file->header;
+  size_t elelen = header->elelen;
+  struct iovec iov[IOV_MAX];
+  int64_t off = 0, next = -1, t = header->tile;
+  int64_t r, rend, c, fi, fj, fld, at;
+  size_t len;
+  char *p;
+  int j, niov = 0;
+
+  for (j = 0; j < tile->n; j++) {
+    c  = tile->offn + j - file->offn;
+    fj = c/t;
+    for (r = tile->offm - file->offm; r < tile->offm - file->offm + tile->m; r = rend) {
+      fi   = r/t;
+      rend = min((fi + 1)*t, tile->offm - file->offm + tile->m);
+      fld  = cj_File_ld(file, fi);
+      at   = file->offset[fj*file->mb + fi] + ((c - fj*t)*fld + (r - fi*t))*elelen;
+      if (niov == IOV_MAX || (niov > 0 && at != next)) {
+        cj_File_flush(file, iov, niov, off, store);
+        niov = 0;
+      }
+      if (niov == 0) off = at;
+      p   = buff + ((size_t) j*ld + (r + file->offm - tile->offm))*elelen;
+      len = (rend - r)*elelen;
+      next = at + len;
+      /* Pieces contiguous in memory as well are one. */
+      if (niov > 0 && (char *) iov[niov - 1].iov_base + iov[niov - 1].iov_len == p) {
+        iov[niov - 1].iov_len += len;
+        continue;
+      }
+      iov[niov].iov_base = p;
+      iov[niov].iov_len  = len;
+      niov ++;
+    }
+  }
+  cj_File_flush(file, iov, niov, off, store);
+}
+
+/* Release the memory of a file, once it is closed. */
+static void cj_File_delete (cj_File *file) {
+  free(file->name);
+  free(file->offset);
+  free(file);
+}
+
+/* The last task done with a file closes it and wakes up its waiters. */
+static void cj_File_done (cj_File *file) {
+  cj_File **prev;
+  int remaining;
+
+  cj_Lock_acquire(&file_lock);
+  remaining = -- file->remaining;
+  cj_Lock_release(&file_lock);
+  if (remaining > 0) return;
+
+  if (file->store == TRUE && fsync(file->fd) == -1) {
+    cj_File_error("File_done", "Could not write the file.");
+  }
+  close(file->fd);
+
+  cj_Lock_acquire(&file_lock);
+  for (prev = &file_busy; *prev != file; prev = &(*prev)->next);
+  *prev = file->next;
+  pthread_cond_broadcast(&file_done);
+  cj_Lock_release(&file_lock);
+  cj_File_delete(file);
+}
+
+/* Move a tile between the file and the worker. Device workers go through a
+ * main memory buffer. */
+static void cj_File_task_io (cj_Task *task, cj_Bool store) {
+  cj_Worker *worker = task->worker;
+  cj_Object *A = task->arg->dqueue->head;
+  cj_File *file = A->next->file;
+  cj_Matrix *a = A->matrix;
+  char *a_ptr;
+  int lda;
+
+  a_ptr = cj_Worker_get_buff(worker, a, &lda);
+
+  if (worker->device_id != -1) {
+    cj_Device *device = worker->cj_ptr->device[worker->device_id];
+    cj_Distribution *dist = a->base->dist[a->offm/BLOCK_SIZE][a->offn/BLOCK_SIZE];
+    size_t mbytes = (size_t) a->m*a->elelen;
+    char *buff = (char *) malloc(mbytes*a->n);
+
+    if (!buff) cj_File_error("File_task_io", "memory allocation failed.");
+    if (store == TRUE) {
+      cj_Cache_line_wait(device, dist->line[worker->device_id + 1]);
+      cj_Device_stage_d2h(buff, mbytes, (uintptr_t) a_ptr, lda*a->elelen, mbytes, a->n, device);
+      cj_File_tile_io(file, a, buff, a->m, TRUE);
+    }
+    else {
+      cj_File_tile_io(file, a, buff, a->m, FALSE);
+      cj_Device_stage_h2d((uintptr_t) a_ptr, lda*a->elelen, buff, mbytes, mbytes, a->n, device);
+    }
+    free(buff);
+  }
+  else {
+    cj_File_tile_io(file, a, a_ptr, lda, store);
+  }
+  cj_File_done(file);
+
+  fprintf(stderr, YELLOW "  Worker_execute %d (%d, %s), A(%d, %d): \n" NONE,
+      task->worker->id, task->id, task->name,
+      a->offm/BLOCK_SIZE, a->offn/BLOCK_SIZE);
+}
+
+void cj_File_load_task_function (void *task_ptr) {
+  cj_File_task_io((cj_Task *) task_ptr, FALSE);
+}
+
+void cj_File_store_task_function (void *task_ptr) {
+  cj_File_task_io((cj_Task *) task_ptr, TRUE);
+}
+
+/* Submit one task per tile of A moving the tile between the file and A. */
+static void cj_File_task (cj_Object *A, cj_File *file, cj_Bool store) {
+  cj_Matrix *matrix = A->matrix;
+  int i, j, mb = (matrix->m - 1)/BLOCK_SIZE + 1, nb = (matrix->n - 1)/BLOCK_SIZE + 1;
+
+  file->store     = store;
+  file->remaining = mb*nb;
+  cj_Lock_acquire(&file_lock);
+  file->next = file_busy;
+  file_busy  = file;
+  cj_Lock_release(&file_lock);
+
+  cj_Queue_end();
+  for (j = 0; j < nb; j++) {
+    for (i = 0; i < mb; i++) {
+      cj_Object *A_copy = cj_Object_new(CJ_MATRIX);
+      cj_Object *task;
+      cj_Matrix *a;
+
+      cj_Matrix_duplicate(A, A_copy);
+      a = A_copy->matrix;
+      a->offm = matrix->offm + i*BLOCK_SIZE;
+      a->offn = matrix->offn + j*BLOCK_SIZE;
+      a->m    = min(BLOCK_SIZE, matrix->m - i*BLOCK_SIZE);
+      a->n    = min(BLOCK_SIZE, matrix->n - j*BLOCK_SIZE);
+
+      task = cj_Object_new(CJ_TASK);
+      cj_Task_set(task->task, (store == TRUE) ? CJ_TASK_STORE : CJ_TASK_LOAD,
+          (store == TRUE) ? &cj_File_store_task_function : &cj_File_load_task_function);
+
+      /* Pushing arguments. */
+      cj_Object *arg_A = cj_Object_append(CJ_MATRIX, a);
+      cj_Object *arg_F = cj_Object_append(CJ_FILE, file);
+      arg_A->rwtype = (store == TRUE) ? CJ_R : CJ_W;
+      arg_F->rwtype = CJ_R;
+      cj_Dqueue_push_tail(task->task->arg, arg_A);
+      cj_Dqueue_push_tail(task->task->arg, arg_F);
+
+      /* Setup task name. */
+      snprintf(task->task->name,  64, "%s%d", (store == TRUE) ? "Store" : "Load", task->task->id);
+      snprintf(task->task->label, 64, "%s A%d%d", (store == TRUE) ? "Store" : "Load",
+          a->offm/BLOCK_SIZE, a->offn/BLOCK_SIZE);
+
+      cj_Task_dependency_analysis(task);
+    }
+  }
+  cj_Queue_begin();
+}
+
+/* Open a matrix file and read its header and tile offsets. */
+static cj_File *cj_File_open (const char *filename, int flags) {
+  cj_File *file = (cj_File *) malloc(sizeof(cj_File));
+  cj_FileHeader *header;
+  size_t len;
+
+  if (!file) cj_File_error("File_open", "memory allocation failed.");
+  header = &file->header;
+
+  cj_File_wait(filename);
+  file->name = strdup(filename);
+  file->fd   = open(filename, flags);
+  if (file->fd == -1) cj_File_error("File_open", "Could not open the file.");
+  if (pread(file->fd, header, sizeof(cj_FileHeader), 0) != sizeof(cj_FileHeader) ||
+      memcmp(header->magic, CJ_FILE_MAGIC, sizeof(header->magic)) != 0) {
+    cj_File_error("File_open", "The file is not a matrix file.");
+  }
+  if (header->version != CJ_FILE_VERSION || header->m <= 0 || header->n <= 0 ||
+      header->m > INT_MAX || header->n > INT_MAX || header->tile <= 0 ||
+      (header->eletype != CJ_DOUBLE && header->eletype != CJ_SINGLE) ||
+      (header->layout != CJ_LAYOUT_COLUMN && header->layout != CJ_LAYOUT_TILE && header->layout != CJ_LAYOUT_MORTON)) {
+    cj_File_error("File_open", "The file header is not supported.");
+  }
+
+  file->mb     = (header->m - 1)/header->tile + 1;
+  file->nb     = (header->n - 1)/header->tile + 1;
+  file->offm   = 0;
+  file->offn   = 0;
+  len          = (size_t) file->mb*file->nb*sizeof(int64_t);
+  file->offset = (int64_t *) malloc(len);
+  if (!file->offset) cj_File_error("File_open", "memory allocation failed.");
+  if (pread(file->fd, file->offset, len, sizeof(cj_FileHeader)) != (ssize_t) len) {
+    cj_File_error("File_open", "The file is truncated.");
+  }
+  return file;
+}
+
+/**
+ * @brief  Store a matrix in a tiled matrix file, replacing the file. The tiles
+ *         are written by runtime tasks, after the tasks writing them.
+ * @param  *object matrix object, possibly a view aligned to the tiles
+ * @param  *filename matrix file
+ * @param  layout layout of the file, placed like a matrix stored in this layout,
+ *         so that cj_Matrix_map can open the file as such a matrix
+ */
+void cj_Matrix_store (cj_Object *object, const char *filename, cj_layoutType layout) {
+  if (object->objtype != CJ_MATRIX) {
+    cj_File_error("Matrix_store", "The object is not a matrix.");
+  }
+  cj_Matrix *matrix = object->matrix;
+  cj_File *file = (cj_File *) malloc(sizeof(cj_File));
+  cj_FileHeader *header;
+  size_t len, size, *off;
+  int k;
+
+  if (!file) cj_File_error("Matrix_store", "memory allocation failed.");
+  if (matrix->offm%BLOCK_SIZE != 0 || matrix->offn%BLOCK_SIZE != 0) {
+    cj_File_error("Matrix_store", "The matrix is not aligned to the tiles.");
+  }
+  header = &file->header;
+  memset(header, 0, sizeof(cj_FileHeader));
+  memcpy(header->magic, CJ_FILE_MAGIC, sizeof(header->magic));
+  header->version = CJ_FILE_VERSION;
+  header->eletype = matrix->eletype;
+  header->elelen  = matrix->elelen;
+  header->layout  = layout;
+  header->m       = matrix->m;
+  header->n       = matrix->n;
+  header->tile    = BLOCK_SIZE;
+
+  file->mb     = (matrix->m - 1)/BLOCK_SIZE + 1;
+  file->nb     = (matrix->n - 1)/BLOCK_SIZE + 1;
+  file->offm   = matrix->offm;
+  file->offn   = matrix->offn;
+  len          = (size_t) file->mb*file->nb*sizeof(int64_t);
+  file->offset = (int64_t *) malloc(len);
+  off          = (size_t *) malloc((size_t) file->mb*file->nb*sizeof(size_t));
+  if (!file->offset || !off) cj_File_error("Matrix_store", "memory allocation failed.");
+
+  /* The data start on a page of their own, so that they can be mapped. */
+  header->data = cj_File_align(sizeof(cj_FileHeader) + len, CJ_FILE_ALIGN);
+  size = header->data + cj_Matrix_tile_offsets(matrix->m, matrix->n, matrix->elelen, layout, off);
+  for (k = 0; k < file->mb*file->nb; k++) file->offset[k] = header->data + off[k];
+  free(off);
+
+  cj_File_wait(filename);
+  file->name = strdup(filename);
+  file->fd   = open(filename, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (file->fd == -1) cj_File_error("Matrix_store", "Could not open the file.");
+  if (ftruncate(file->fd, size) == -1 ||
+      pwrite(file->fd, header, sizeof(cj_FileHeader), 0) != sizeof(cj_FileHeader) ||
+      pwrite(file->fd, file->offset, len, sizeof(cj_FileHeader)) != (ssize_t) len) {
+    cj_File_error("Matrix_store", "Could not write the file.");
+  }
+
+  cj_File_task(object, file, TRUE);
+}
+
+/**
+ * @brief  Set up a matrix from a tiled matrix file, in the layout chosen for
+ *         the matrix whatever the layout of the file. The tiles are read by
+ *         runtime tasks, and the tasks reading the matrix afterwards wait
+ *         for them. The tile size of the file may differ from BLOCK_SIZE.
+ * @param  *object matrix object
+ * @param  *filename matrix file
+ */
+void cj_Matrix_load (cj_Object *object, const char *filename) {
+  if (object->objtype != CJ_MATRIX) {
+    cj_File_error("Matrix_load", "The object is not a matrix.");
+  }
+  cj_File *file = cj_File_open(filename, O_RDONLY);
+
+  object->matrix->eletype = file->header.eletype;
+  object->matrix->elelen  = file->header.elelen;
+  cj_Matrix_set(object, file->header.m, file->header.n);
+
+  cj_File_task(object, file, FALSE);
+}
+
+/**
+ * @brief  Open a matrix file without copying it: the matrix is disk-backed by
+ *         the data of the file, which are read as the tiles are used, and it
+ *         takes the layout of the file. Files in a tile layout must have been
+ *         stored with the tile size BLOCK_SIZE.
+ * @param  *object matrix object
+ * @param  *filename matrix file
+ * @param  writable TRUE if the updates of the matrix go to the file, FALSE to
+ *         open the file read-only
+ */
+void cj_Matrix_map (cj_Object *object, const char *filename, cj_Bool writable) {
+  if (object->objtype != CJ_MATRIX) {
+    cj_File_error("Matrix_map", "The object is not a matrix.");
+  }
+  cj_File *file = cj_File_open(filename, (writable == TRUE) ? O_RDWR : O_RDONLY);
+  cj_FileHeader *header = &file->header;
+  size_t *off = (size_t *) malloc((size_t) file->mb*file->nb*sizeof(size_t));
+  int k;
+
+  if (!off) cj_File_error("Matrix_map", "memory allocation failed.");
+  if (header->data%sysconf(_SC_PAGESIZE) != 0) {
+    cj_File_error("Matrix_map", "The data of the file are not page-aligned.");
+  }
+  if (header->layout != CJ_LAYOUT_COLUMN) {
+    if (header->tile != BLOCK_SIZE) cj_File_error("Matrix_map", "The tile size of the file is not BLOCK_SIZE.");
+    cj_Matrix_tile_offsets(header->m, header->n, header->elelen, header->layout, off);
+    for (k = 0; k < file->mb*file->nb; k++) {
+      if (file->offset[k] != header->data + (int64_t) off[k]) {
+        cj_File_error("Matrix_map", "The tiles of the file are not placed as in memory.");
+      }
+    }
+  }
+  free(off);
+
+  object->matrix->eletype = header->eletype;
+  object->matrix->elelen  = header->elelen;
+  object->matrix->layout  = header->layout;
+  cj_Disk_map(object, header->m, header->n, file->fd, header->data, writable);
+  cj_File_delete(file);
+}
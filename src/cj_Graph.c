@@ -22,9 +22,19 @@ void cj_Vertex_set (cj_Object *object, cj_Object *target) {
   object->vertex->task  = target->task;
   cj_Color color;
   if (target->task->tasktype == CJ_TASK_GEMM) color = CJ_ORANGE;
-  else if (target->task->tasktype == CJ_TASK_TRSM) color = CJ_RED;
-  else if (target->task->tasktype == CJ_TASK_SYRK) color = CJ_BLUE;
-  else if (target->task->tasktype == CJ_TASK_POTRF) color = CJ_GREEN;
+  else if (target->task->tasktype == CJ_TASK_TRSM || target->task->tasktype == CJ_TASK_TRMM) color = CJ_RED;
+  else if (target->task->tasktype == CJ_TASK_SYRK || target->task->tasktype == CJ_TASK_SYR2K) color = CJ_BLUE;
+  else if (target->task->tasktype == CJ_TASK_SYMM) color = CJ_PURPLE;
+  else if (target->task->tasktype == CJ_TASK_POTRF || target->task->tasktype == CJ_TASK_GETRF || 
+      target->task->tasktype == CJ_TASK_TSTRF || target->task->tasktype == CJ_TASK_SYTRF ||
+      target->task->tasktype == CJ_TASK_TRTRI || target->task->tasktype == CJ_TASK_LAUUM ||
+      target->task->tasktype == CJ_TASK_ROTG) color = CJ_GREEN;
+  else if (target->task->tasktype == CJ_TASK_GESSM || target->task->tasktype == CJ_TASK_TRSMD) color = CJ_RED;
+  else if (target->task->tasktype == CJ_TASK_SSSSM || target->task->tasktype == CJ_TASK_TPMQRT ||
+      target->task->tasktype == CJ_TASK_GEMDM || target->task->tasktype == CJ_TASK_ROT) color = CJ_ORANGE;
+  else if (target->task->tasktype == CJ_TASK_GEQRT || target->task->tasktype == CJ_TASK_TPQRT ||
+      target->task->tasktype == CJ_TASK_SBTRD) color = CJ_YELLOW;
+  else if (target->task->tasktype == CJ_TASK_GEMQRT) color = CJ_RED;
   else color = CJ_BLACK;
   object->vertex->color = color;
 }
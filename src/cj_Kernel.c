@@ -0,0 +1,1898 @@
+/*
+ * cj_Kernel.c
+ * Built-in BLAS kernels for the CPU tiles: GEMM on packed panels with register
+ * blocked micro-kernels, SYR2K and SYMM through it, and recursive SYRK, TRSM,
+ * TRMM, POTRF, TRTRI, LAUUM, GETRF and the compact WY QR (GEQRT, TPQRT) on top
+ * of it, plus the tile pair kernels of the pairwise pivoted LU and the unpivoted
+ * LDL'. The recursion bottoms out on KERNEL_TB sized blocks, with the Cholesky
+ * of the common block sizes compiled for their order.
+ * The micro-kernels are picked at run time from the instructions the CPU
+ * reports (AVX-512, AVX2 with FMA, or portable C); the environment variable
+ * CJ_KERNEL=avx512|avx2|generic overrides the choice. With -DCJ_EXTERNAL_BLAS
+ * the entry points call the linked BLAS instead.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#include <math.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CJ_KERNEL_X86
+#include <immintrin.h>
+#endif
+
+#include <cj.h>
+
+void cj_Kernel_error (const char *func_name, char* msg_text) {
+  fprintf(stderr, "CJ_KERNEL_ERROR: %s(): %s\n", func_name, msg_text);
+  abort();
+  exit(0);
+}
+
+/* Packing buffers of the calling thread, kept across calls since the recursive
+ * factorizations issue many small GEMMs. Slots 0 and 1 pack GEMM operands, 2 to 4
+ * hold the scratch blocks of the kernels built on GEMM. */
+static __thread char *kernel_buff[5];
+static __thread size_t kernel_buff_size[5];
+
+static char *cj_Kernel_buff (int id, size_t size) {
+  if (size > kernel_buff_size[id]) {
+    free(kernel_buff[id]);
+    if (posix_memalign((void **) &kernel_buff[id], 64, size)) {
+      cj_Kernel_error("buff", "memory allocation failed.");
+    }
+    kernel_buff_size[id] = size;
+  }
+  return kernel_buff[id];
+}
+
+#ifndef CJ_EXTERNAL_BLAS
+
+/* ab = a*b, a: packed mr x k panel, b: packed k x nr panel, ab: mr x nr column major. */
+typedef void (*cj_Kernel_micro) (int, const void*, const void*, void*);
+
+/* Micro-kernels of an instruction set, [0] for double and [1] for single precision. */
+typedef struct {
+  const char *name;
+  int mr[2], nr[2];
+  cj_Kernel_micro micro[2];
+} cj_Kernel_arch;
+
+static void cj_Kernel_dmicro_c (int k, const void *a_ptr, const void *b_ptr, void *ab_ptr) {
+  const double *a = (const double *) a_ptr, *b = (const double *) b_ptr;
+  double c[16] = {0.0};
+  int i, j, p;
+
+  for (p = 0; p < k; p++) {
+    for (j = 0; j < 4; j++) {
+      for (i = 0; i < 4; i++) c[i + j*4] += a[i]*b[j];
+    }
+    a += 4; b += 4;
+  }
+  memcpy(ab_ptr, c, sizeof(c));
+}
+
+static void cj_Kernel_smicro_c (int k, const void *a_ptr, const void *b_ptr, void *ab_ptr) {
+  const float *a = (const float *) a_ptr, *b = (const float *) b_ptr;
+  float c[16] = {0.0};
+  int i, j, p;
+
+  for (p = 0; p < k; p++) {
+    for (j = 0; j < 4; j++) {
+      for (i = 0; i < 4; i++) c[i + j*4] += a[i]*b[j];
+    }
+    a += 4; b += 4;
+  }
+  memcpy(ab_ptr, c, sizeof(c));
+}
+
+#ifdef CJ_KERNEL_X86
+/* 8 x 6 doubles in 12 ymm accumulators. */
+__attribute__((target("avx2,fma")))
+static void cj_Kernel_dmicro_avx2 (int k, const void *a_ptr, const void *b_ptr, void *ab_ptr) {
+  const double *a = (const double *) a_ptr, *b = (const double *) b_ptr;
+  double *ab = (double *) ab_ptr;
+  __m256d c00 = _mm256_setzero_pd(), c10 = _mm256_setzero_pd(), c01 = _mm256_setzero_pd(), c11 = _mm256_setzero_pd();
+  __m256d c02 = _mm256_setzero_pd(), c12 = _mm256_setzero_pd(), c03 = _mm256_setzero_pd(), c13 = _mm256_setzero_pd();
+  __m256d c04 = _mm256_setzero_pd(), c14 = _mm256_setzero_pd(), c05 = _mm256_setzero_pd(), c15 = _mm256_setzero_pd();
+  __m256d a0, a1, bj;
+  int p;
+
+  for (p = 0; p < k; p++) {
+    a0 = _mm256_loadu_pd(a); a1 = _mm256_loadu_pd(a + 4);
+    bj = _mm256_broadcast_sd(b);     c00 = _mm256_fmadd_pd(a0, bj, c00); c10 = _mm256_fmadd_pd(a1, bj, c10);
+    bj = _mm256_broadcast_sd(b + 1); c01 = _mm256_fmadd_pd(a0, bj, c01); c11 = _mm256_fmadd_pd(a1, bj, c11);
+    bj = _mm256_broadcast_sd(b + 2); c02 = _mm256_fmadd_pd(a0, bj, c02); c12 = _mm256_fmadd_pd(a1, bj, c12);
+    bj = _mm256_broadcast_sd(b + 3); c03 = _mm256_fmadd_pd(a0, bj, c03); c13 = _mm256_fmadd_pd(a1, bj, c13);
+    bj = _mm256_broadcast_sd(b + 4); c04 = _mm256_fmadd_pd(a0, bj, c04); c14 = _mm256_fmadd_pd(a1, bj, c14);
+    bj = _mm256_broadcast_sd(b + 5); c05 = _mm256_fmadd_pd(a0, bj, c05); c15 = _mm256_fmadd_pd(a1, bj, c15);
+    a += 8; b += 6;
+  }
+  _mm256_storeu_pd(ab,      c00); _mm256_storeu_pd(ab +  4, c10);
+  _mm256_storeu_pd(ab +  8, c01); _mm256_storeu_pd(ab + 12, c11);
+  _mm256_storeu_pd(ab + 16, c02); _mm256_storeu_pd(ab + 20, c12);
+  _mm256_storeu_pd(ab + 24, c03); _mm256_storeu_pd(ab + 28, c13);
+  _mm256_storeu_pd(ab + 32, c04); _mm256_storeu_pd(ab + 36, c14);
+  _mm256_storeu_pd(ab + 40, c05); _mm256_storeu_pd(ab + 44, c15);
+}
+
+/* 16 x 6 floats in 12 ymm accumulators. */
+__attribute__((target("avx2,fma")))
+static void cj_Kernel_smicro_avx2 (int k, const void *a_ptr, const void *b_ptr, void *ab_ptr) {
+  const float *a = (const float *) a_ptr, *b = (const float *) b_ptr;
+  float *ab = (float *) ab_ptr;
+  __m256 c00 = _mm256_setzero_ps(), c10 = _mm256_setzero_ps(), c01 = _mm256_setzero_ps(), c11 = _mm256_setzero_ps();
+  __m256 c02 = _mm256_setzero_ps(), c12 = _mm256_setzero_ps(), c03 = _mm256_setzero_ps(), c13 = _mm256_setzero_ps();
+  __m256 c04 = _mm256_setzero_ps(), c14 = _mm256_setzero_ps(), c05 = _mm256_setzero_ps(), c15 = _mm256_setzero_ps();
+  __m256 a0, a1, bj;
+  int p;
+
+  for (p = 0; p < k; p++) {
+    a0 = _mm256_loadu_ps(a); a1 = _mm256_loadu_ps(a + 8);
+    bj = _mm256_broadcast_ss(b);     c00 = _mm256_fmadd_ps(a0, bj, c00); c10 = _mm256_fmadd_ps(a1, bj, c10);
+    bj = _mm256_broadcast_ss(b + 1); c01 = _mm256_fmadd_ps(a0, bj, c01); c11 = _mm256_fmadd_ps(a1, bj, c11);
+    bj = _mm256_broadcast_ss(b + 2); c02 = _mm256_fmadd_ps(a0, bj, c02); c12 = _mm256_fmadd_ps(a1, bj, c12);
+    bj = _mm256_broadcast_ss(b + 3); c03 = _mm256_fmadd_ps(a0, bj, c03); c13 = _mm256_fmadd_ps(a1, bj, c13);
+    bj = _mm256_broadcast_ss(b + 4); c04 = _mm256_fmadd_ps(a0, bj, c04); c14 = _mm256_fmadd_ps(a1, bj, c14);
+    bj = _mm256_broadcast_ss(b + 5); c05 = _mm256_fmadd_ps(a0, bj, c05); c15 = _mm256_fmadd_ps(a1, bj, c15);
+    a += 16; b += 6;
+  }
+  _mm256_storeu_ps(ab,      c00); _mm256_storeu_ps(ab +  8, c10);
+  _mm256_storeu_ps(ab + 16, c01); _mm256_storeu_ps(ab + 24, c11);
+  _mm256_storeu_ps(ab + 32, c02); _mm256_storeu_ps(ab + 40, c12);
+  _mm256_storeu_ps(ab + 48, c03); _mm256_storeu_ps(ab + 56, c13);
+  _mm256_storeu_ps(ab + 64, c04); _mm256_storeu_ps(ab + 72, c14);
+  _mm256_storeu_ps(ab + 80, c05); _mm256_storeu_ps(ab + 88, c15);
+}
+
+/* 16 x 8 doubles in 16 zmm accumulators. */
+__attribute__((target("avx512f")))
+static void cj_Kernel_dmicro_avx512 (int k, const void *a_ptr, const void *b_ptr, void *ab_ptr) {
+  const double *a = (const double *) a_ptr, *b = (const double *) b_ptr;
+  double *ab = (double *) ab_ptr;
+  __m512d c00 = _mm512_setzero_pd(), c10 = _mm512_setzero_pd(), c01 = _mm512_setzero_pd(), c11 = _mm512_setzero_pd();
+  __m512d c02 = _mm512_setzero_pd(), c12 = _mm512_setzero_pd(), c03 = _mm512_setzero_pd(), c13 = _mm512_setzero_pd();
+  __m512d c04 = _mm512_setzero_pd(), c14 = _mm512_setzero_pd(), c05 = _mm512_setzero_pd(), c15 = _mm512_setzero_pd();
+  __m512d c06 = _mm512_setzero_pd(), c16 = _mm512_setzero_pd(), c07 = _mm512_setzero_pd(), c17 = _mm512_setzero_pd();
+  __m512d a0, a1, bj;
+  int p;
+
+  for (p = 0; p < k; p++) {
+    a0 = _mm512_loadu_pd(a); a1 = _mm512_loadu_pd(a + 8);
+    bj = _mm512_set1_pd(b[0]); c00 = _mm512_fmadd_pd(a0, bj, c00); c10 = _mm512_fmadd_pd(a1, bj, c10);
+    bj = _mm512_set1_pd(b[1]); c01 = _mm512_fmadd_pd(a0, bj, c01); c11 = _mm512_fmadd_pd(a1, bj, c11);
+    bj = _mm512_set1_pd(b[2]); c02 = _mm512_fmadd_pd(a0, bj, c02); c12 = _mm512_fmadd_pd(a1, bj, c12);
+    bj = _mm512_set1_pd(b[3]); c03 = _mm512_fmadd_pd(a0, bj, c03); c13 = _mm512_fmadd_pd(a1, bj, c13);
+    bj = _mm512_set1_pd(b[4]); c04 = _mm512_fmadd_pd(a0, bj, c04); c14 = _mm512_fmadd_pd(a1, bj, c14);
+    bj = _mm512_set1_pd(b[5]); c05 = _mm512_fmadd_pd(a0, bj, c05); c15 = _mm512_fmadd_pd(a1, bj, c15);
+    bj = _mm512_set1_pd(b[6]); c06 = _mm512_fmadd_pd(a0, bj, c06); c16 = _mm512_fmadd_pd(a1, bj, c16);
+    bj = _mm512_set1_pd(b[7]); c07 = _mm512_fmadd_pd(a0, bj, c07); c17 = _mm512_fmadd_pd(a1, bj, c17);
+    a += 16; b += 8;
+  }
+  _mm512_storeu_pd(ab,       c00); _mm512_storeu_pd(ab +   8, c10);
+  _mm512_storeu_pd(ab +  16, c01); _mm512_storeu_pd(ab +  24, c11);
+  _mm512_storeu_pd(ab +  32, c02); _mm512_storeu_pd(ab +  40, c12);
+  _mm512_storeu_pd(ab +  48, c03); _mm512_storeu_pd(ab +  56, c13);
+  _mm512_storeu_pd(ab +  64, c04); _mm512_storeu_pd(ab +  72, c14);
+  _mm512_storeu_pd(ab +  80, c05); _mm512_storeu_pd(ab +  88, c15);
+  _mm512_storeu_pd(ab +  96, c06); _mm512_storeu_pd(ab + 104, c16);
+  _mm512_storeu_pd(ab + 112, c07); _mm512_storeu_pd(ab + 120, c17);
+}
+
+/* 32 x 8 floats in 16 zmm accumulators. */
+__attribute__((target("avx512f")))
+static void cj_Kernel_smicro_avx512 (int k, const void *a_ptr, const void *b_ptr, void *ab_ptr) {
+  const float *a = (const float *) a_ptr, *b = (const float *) b_ptr;
+  float *ab = (float *) ab_ptr;
+  __m512 c00 = _mm512_setzero_ps(), c10 = _mm512_setzero_ps(), c01 = _mm512_setzero_ps(), c11 = _mm512_setzero_ps();
+  __m512 c02 = _mm512_setzero_ps(), c12 = _mm512_setzero_ps(), c03 = _mm512_setzero_ps(), c13 = _mm512_setzero_ps();
+  __m512 c04 = _mm512_setzero_ps(), c14 = _mm512_setzero_ps(), c05 = _mm512_setzero_ps(), c15 = _mm512_setzero_ps();
+  __m512 c06 = _mm512_setzero_ps(), c16 = _mm512_setzero_ps(), c07 = _mm512_setzero_ps(), c17 = _mm512_setzero_ps();
+  __m512 a0, a1, bj;
+  int p;
+
+  for (p = 0; p < k; p++) {
+    a0 = _mm512_loadu_ps(a); a1 = _mm512_loadu_ps(a + 16);
+    bj = _mm512_set1_ps(b[0]); c00 = _mm512_fmadd_ps(a0, bj, c00); c10 = _mm512_fmadd_ps(a1, bj, c10);
+    bj = _mm512_set1_ps(b[1]); c01 = _mm512_fmadd_ps(a0, bj, c01); c11 = _mm512_fmadd_ps(a1, bj, c11);
+    bj = _mm512_set1_ps(b[2]); c02 = _mm512_fmadd_ps(a0, bj, c02); c12 = _mm512_fmadd_ps(a1, bj, c12);
+    bj = _mm512_set1_ps(b[3]); c03 = _mm512_fmadd_ps(a0, bj, c03); c13 = _mm512_fmadd_ps(a1, bj, c13);
+    bj = _mm512_set1_ps(b[4]); c04 = _mm512_fmadd_ps(a0, bj, c04); c14 = _mm512_fmadd_ps(a1, bj, c14);
+    bj = _mm512_set1_ps(b[5]); c05 = _mm512_fmadd_ps(a0, bj, c05); c15 = _mm512_fmadd_ps(a1, bj, c15);
+    bj = _mm512_set1_ps(b[6]); c06 = _mm512_fmadd_ps(a0, bj, c06); c16 = _mm512_fmadd_ps(a1, bj, c16);
+    bj = _mm512_set1_ps(b[7]); c07 = _mm512_fmadd_ps(a0, bj, c07); c17 = _mm512_fmadd_ps(a1, bj, c17);
+    a += 32; b += 8;
+  }
+  _mm512_storeu_ps(ab,       c00); _mm512_storeu_ps(ab +  16, c10);
+  _mm512_storeu_ps(ab +  32, c01); _mm512_storeu_ps(ab +  48, c11);
+  _mm512_storeu_ps(ab +  64, c02); _mm512_storeu_ps(ab +  80, c12);
+  _mm512_storeu_ps(ab +  96, c03); _mm512_storeu_ps(ab + 112, c13);
+  _mm512_storeu_ps(ab + 128, c04); _mm512_storeu_ps(ab + 144, c14);
+  _mm512_storeu_ps(ab + 160, c05); _mm512_storeu_ps(ab + 176, c15);
+  _mm512_storeu_ps(ab + 192, c06); _mm512_storeu_ps(ab + 208, c16);
+  _mm512_storeu_ps(ab + 224, c07); _mm512_storeu_ps(ab + 240, c17);
+}
+#endif
+
+static const cj_Kernel_arch kernel_generic = {"generic", {4, 4}, {4, 4}, {cj_Kernel_dmicro_c, cj_Kernel_smicro_c}};
+#ifdef CJ_KERNEL_X86
+static const cj_Kernel_arch kernel_avx2 = {"avx2", {8, 16}, {6, 6}, {cj_Kernel_dmicro_avx2, cj_Kernel_smicro_avx2}};
+static const cj_Kernel_arch kernel_avx512 = {"avx512", {16, 32}, {8, 8}, {cj_Kernel_dmicro_avx512, cj_Kernel_smicro_avx512}};
+#endif
+
+static const cj_Kernel_arch *kernel_arch = &kernel_generic;
+static pthread_once_t kernel_once = PTHREAD_ONCE_INIT;
+
+/* Pick the widest micro-kernels the CPU supports. */
+static void cj_Kernel_init () {
+  const char *name = getenv("CJ_KERNEL");
+
+#ifdef CJ_KERNEL_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f") && (!name || !strcmp(name, "avx512"))) {
+    kernel_arch = &kernel_avx512;
+  }
+  else if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") &&
+      (!name || !strcmp(name, "avx512") || !strcmp(name, "avx2"))) {
+    kernel_arch = &kernel_avx2;
+  }
+#endif
+  fprintf(stderr, "  Kernel : %s\n", kernel_arch->name);
+}
+
+static const cj_Kernel_arch *cj_Kernel_arch_get () {
+  pthread_once(&kernel_once, cj_Kernel_init);
+  return kernel_arch;
+}
+
+/* C:= beta * C on the part of C selected by uplo ('L', 'U' or 'F' for full). */
+static void cj_Kernel_scale (cj_eleType type, char uplo, int m, int n, double beta, char *C, int ldc) {
+  int i, j, i0, i1;
+
+  if (beta == 1.0) return;
+  for (j = 0; j < n; j++) {
+    i0 = (uplo == 'L') ? min(j, m) : 0;
+    i1 = (uplo == 'U') ? min(j + 1, m) : m;
+    for (i = i0; i < i1; i++) {
+      /* A zero beta clears C, NaNs included. */
+      if (type == CJ_SINGLE) {
+        float *c = (float *) C + i + (size_t) j*ldc;
+        *c = (beta == 0.0) ? 0.0 : (*c)*beta;
+      }
+      else {
+        double *c = (double *) C + i + (size_t) j*ldc;
+        *c = (beta == 0.0) ? 0.0 : (*c)*beta;
+      }
+    }
+  }
+}
+
+/* Pack an mc x kc block of op(A) into panels of mr rows, each stored k major. */
+static void cj_Kernel_pack_a (cj_eleType type, int mr, char trans, int mc, int kc, const char *A, int lda, char *buff) {
+  int i, p, ir, mb;
+
+  for (ir = 0; ir < mc; ir += mr) {
+    mb = min(mr, mc - ir);
+    if (type == CJ_SINGLE) {
+      const float *a = (const float *) A;
+      float *w = (float *) buff + (size_t) ir*kc;
+      for (p = 0; p < kc; p++, w += mr) {
+        for (i = 0; i < mb; i++) w[i] = (trans == 'N') ? a[ir + i + (size_t) p*lda] : a[p + (size_t) (ir + i)*lda];
+        for (; i < mr; i++) w[i] = 0.0;
+      }
+    }
+    else {
+      const double *a = (const double *) A;
+      double *w = (double *) buff + (size_t) ir*kc;
+      for (p = 0; p < kc; p++, w += mr) {
+        for (i = 0; i < mb; i++) w[i] = (trans == 'N') ? a[ir + i + (size_t) p*lda] : a[p + (size_t) (ir + i)*lda];
+        for (; i < mr; i++) w[i] = 0.0;
+      }
+    }
+  }
+}
+
+/* Pack a kc x nc block of op(B) into panels of nr columns, each stored k major. */
+static void cj_Kernel_pack_b (cj_eleType type, int nr, char trans, int kc, int nc, const char *B, int ldb, char *buff) {
+  int j, p, jr, nb;
+
+  for (jr = 0; jr < nc; jr += nr) {
+    nb = min(nr, nc - jr);
+    if (type == CJ_SINGLE) {
+      const float *b = (const float *) B;
+      float *w = (float *) buff + (size_t) jr*kc;
+      for (p = 0; p < kc; p++, w += nr) {
+        for (j = 0; j < nb; j++) w[j] = (trans == 'N') ? b[p + (size_t) (jr + j)*ldb] : b[jr + j + (size_t) p*ldb];
+        for (; j < nr; j++) w[j] = 0.0;
+      }
+    }
+    else {
+      const double *b = (const double *) B;
+      double *w = (double *) buff + (size_t) jr*kc;
+      for (p = 0; p < kc; p++, w += nr) {
+        for (j = 0; j < nb; j++) w[j] = (trans == 'N') ? b[p + (size_t) (jr + j)*ldb] : b[jr + j + (size_t) p*ldb];
+        for (; j < nr; j++) w[j] = 0.0;
+      }
+    }
+  }
+}
+
+/* C(i0:, j0:) += alpha * ab on the mb x nb corner, within the triangle selected by uplo. */
+static void cj_Kernel_update (cj_eleType type, char uplo, int mb, int nb, int i0, int j0, double alpha,
+    const void *ab, int mr, char *C, int ldc) {
+  int i, j, i1, i2;
+
+  for (j = 0; j < nb; j++) {
+    i1 = (uplo == 'L') ? max(0, j0 + j - i0) : 0;
+    i2 = (uplo == 'U') ? min(mb, j0 + j - i0 + 1) : mb;
+    if (type == CJ_SINGLE) {
+      float *c = (float *) C + (size_t) j*ldc;
+      const float *w = (const float *) ab + j*mr;
+      for (i = i1; i < i2; i++) c[i] += (float) alpha*w[i];
+    }
+    else {
+      double *c = (double *) C + (size_t) j*ldc;
+      const double *w = (const double *) ab + j*mr;
+      for (i = i1; i < i2; i++) c[i] += alpha*w[i];
+    }
+  }
+}
+
+/* C:= alpha * op(A) * op(B) + beta * C, only the triangle of C selected by uplo is touched. */
+static void cj_Kernel_gemm (cj_eleType type, char uplo, char transa, char transb, int m, int n, int k,
+    double alpha, const char *A, int lda, const char *B, int ldb, double beta, char *C, int ldc) {
+  const cj_Kernel_arch *arch = cj_Kernel_arch_get();
+  int t = (type == CJ_SINGLE), mr = arch->mr[t], nr = arch->nr[t];
+  size_t len = (type == CJ_SINGLE) ? sizeof(float) : sizeof(double);
+  int ic, jc, pc, ir, jr, mc, nc, kc, i0, j0, mb, nb;
+  double ab[256] __attribute__((aligned(64)));
+  char *a_buff, *b_buff;
+
+  if (m <= 0 || n <= 0) return;
+  cj_Kernel_scale(type, uplo, m, n, beta, C, ldc);
+  if (k <= 0 || alpha == 0.0) return;
+
+  a_buff = cj_Kernel_buff(0, (size_t) ((KERNEL_MC + mr - 1)/mr)*mr*KERNEL_KC*len);
+  b_buff = cj_Kernel_buff(1, (size_t) ((min(n, KERNEL_NC) + nr - 1)/nr)*nr*KERNEL_KC*len);
+
+  for (jc = 0; jc < n; jc += KERNEL_NC) {
+    nc = min(KERNEL_NC, n - jc);
+    for (pc = 0; pc < k; pc += KERNEL_KC) {
+      kc = min(KERNEL_KC, k - pc);
+      cj_Kernel_pack_b(type, nr, transb, kc, nc,
+          B + ((transb == 'N') ? pc + (size_t) jc*ldb : jc + (size_t) pc*ldb)*len, ldb, b_buff);
+      for (ic = 0; ic < m; ic += KERNEL_MC) {
+        mc = min(KERNEL_MC, m - ic);
+        if (uplo == 'L' && ic + mc <= jc) continue;
+        if (uplo == 'U' && ic >= jc + nc) continue;
+        cj_Kernel_pack_a(type, mr, transa, mc, kc,
+            A + ((transa == 'N') ? ic + (size_t) pc*lda : pc + (size_t) ic*lda)*len, lda, a_buff);
+        for (jr = 0; jr < nc; jr += nr) {
+          for (ir = 0; ir < mc; ir += mr) {
+            i0 = ic + ir; j0 = jc + jr;
+            mb = min(mr, mc - ir); nb = min(nr, nc - jr);
+            if (uplo == 'L' && i0 + mb <= j0) continue;
+            if (uplo == 'U' && i0 >= j0 + nb) continue;
+            arch->micro[t](kc, a_buff + (size_t) ir*kc*len, b_buff + (size_t) jr*kc*len, ab);
+            cj_Kernel_update(type, uplo, mb, nb, i0, j0, alpha, ab, mr, C + (i0 + (size_t) j0*ldc)*len, ldc);
+          }
+        }
+      }
+    }
+  }
+}
+
+/* Size of the leading half in the recursive kernels, a multiple of KERNEL_TB/4
+ * so that power-of-two tiles end on the specialized sizes. */
+static int cj_Kernel_split (int n) {
+  int q = KERNEL_TB/4;
+  return (n/2 > q) ? (n/2 + q/2)/q*q : n/2;
+}
+
+/* Address of op(A)(i, j) as the GEMM above reads op(A). */
+static const char *cj_Kernel_op_addr (const char *A, int lda, char trans, int i, int j, size_t len) {
+  return A + ((trans == 'N') ? i + (size_t) j*lda : j + (size_t) i*lda)*len;
+}
+
+/* Solve X op(D) = B (side 'R') or op(D) X = B (side 'L') for a small diagonal block D in place. */
+static void cj_Kernel_trsm_unb (cj_eleType type, char side, cj_Bool lower, char trans, char diag,
+    int m, int n, const char *D, int ldd, char *B, int ldb) {
+  int nd = (side == 'R') ? n : m;
+  int s, c, q, r, i;
+  double coef;
+
+  for (s = 0; s < nd; s++) {
+    /* Unknowns that only depend on solved ones come first. */
+    c = ((side == 'R') == (lower == TRUE)) ? nd - 1 - s : s;
+    for (q = 0; q < nd; q++) {
+      if (q == c || (((side == 'R') == (lower == TRUE)) ? q < c : q > c)) continue;
+      /* Coefficient coupling unknown c to the solved unknown q. */
+      r = (side == 'R') ? q : c;
+      i = (side == 'R') ? c : q;
+      if (type == CJ_SINGLE) {
+        coef = *(const float *) cj_Kernel_op_addr(D, ldd, trans, r, i, sizeof(float));
+        if (coef == 0.0) continue;
+        if (side == 'R') {
+          float *bc = (float *) B + (size_t) c*ldb, *bq = (float *) B + (size_t) q*ldb;
+          for (r = 0; r < m; r++) bc[r] -= (float) coef*bq[r];
+        }
+        else {
+          float *b = (float *) B;
+          for (r = 0; r < n; r++) b[c + (size_t) r*ldb] -= (float) coef*b[q + (size_t) r*ldb];
+        }
+      }
+      else {
+        coef = *(const double *) cj_Kernel_op_addr(D, ldd, trans, r, i, sizeof(double));
+        if (coef == 0.0) continue;
+        if (side == 'R') {
+          double *bc = (double *) B + (size_t) c*ldb, *bq = (double *) B + (size_t) q*ldb;
+          for (r = 0; r < m; r++) bc[r] -= coef*bq[r];
+        }
+        else {
+          double *b = (double *) B;
+          for (r = 0; r < n; r++) b[c + (size_t) r*ldb] -= coef*b[q + (size_t) r*ldb];
+        }
+      }
+    }
+    if (diag == 'U') continue;
+    if (type == CJ_SINGLE) {
+      float inv = 1.0/(*(const float *) cj_Kernel_op_addr(D, ldd, trans, c, c, sizeof(float)));
+      if (side == 'R') for (r = 0; r < m; r++) ((float *) B)[r + (size_t) c*ldb] *= inv;
+      else for (r = 0; r < n; r++) ((float *) B)[c + (size_t) r*ldb] *= inv;
+    }
+    else {
+      double inv = 1.0/(*(const double *) cj_Kernel_op_addr(D, ldd, trans, c, c, sizeof(double)));
+      if (side == 'R') for (r = 0; r < m; r++) ((double *) B)[r + (size_t) c*ldb] *= inv;
+      else for (r = 0; r < n; r++) ((double *) B)[c + (size_t) r*ldb] *= inv;
+    }
+  }
+}
+
+/* Solve with the triangular dimension halved until it fits KERNEL_TB; the block
+ * solved second is updated by GEMM with the block solved first. */
+static void cj_Kernel_trsm_rec (cj_eleType type, char side, cj_Bool lower, char trans, char diag, int m, int n,
+    const char *A, int lda, char *B, int ldb) {
+  size_t len = (type == CJ_SINGLE) ? sizeof(float) : sizeof(double);
+  int na = (side == 'R') ? n : m;
+  int n1, f0, fn, s0, sn;
+
+  if (na <= KERNEL_TB) {
+    cj_Kernel_trsm_unb(type, side, lower, trans, diag, m, n, A, lda, B, ldb);
+    return;
+  }
+  n1 = cj_Kernel_split(na);
+  /* X op(A) = B with op(A) lower, or op(A) X = B with op(A) upper, starts from the end. */
+  f0 = ((side == 'R') == (lower == TRUE)) ? n1 : 0;
+  fn = f0 ? na - n1 : n1;
+  s0 = f0 ? 0 : n1;
+  sn = na - fn;
+
+  if (side == 'R') {
+    cj_Kernel_trsm_rec(type, side, lower, trans, diag, m, fn, A + (f0 + (size_t) f0*lda)*len, lda,
+        B + (size_t) f0*ldb*len, ldb);
+    cj_Kernel_gemm(type, 'F', 'N', trans, m, sn, fn, -1.0, B + (size_t) f0*ldb*len, ldb,
+        cj_Kernel_op_addr(A, lda, trans, f0, s0, len), lda, 1.0, B + (size_t) s0*ldb*len, ldb);
+    cj_Kernel_trsm_rec(type, side, lower, trans, diag, m, sn, A + (s0 + (size_t) s0*lda)*len, lda,
+        B + (size_t) s0*ldb*len, ldb);
+  }
+  else {
+    cj_Kernel_trsm_rec(type, side, lower, trans, diag, fn, n, A + (f0 + (size_t) f0*lda)*len, lda,
+        B + f0*len, ldb);
+    cj_Kernel_gemm(type, 'F', trans, 'N', sn, n, fn, -1.0, cj_Kernel_op_addr(A, lda, trans, s0, f0, len), lda,
+        B + f0*len, ldb, 1.0, B + s0*len, ldb);
+    cj_Kernel_trsm_rec(type, side, lower, trans, diag, sn, n, A + (s0 + (size_t) s0*lda)*len, lda,
+        B + s0*len, ldb);
+  }
+}
+
+/* B:= alpha * B * op(A)^(-1) (side 'R') or alpha * op(A)^(-1) * B (side 'L'). */
+static void cj_Kernel_trsm (cj_eleType type, char side, char uplo, char trans, char diag, int m, int n,
+    double alpha, const char *A, int lda, char *B, int ldb) {
+  /* op(A) is lower triangular if A is stored lower and not transposed, or upper and transposed. */
+  cj_Bool lower = ((uplo == 'L') == (trans == 'N')) ? TRUE : FALSE;
+
+  if (m <= 0 || n <= 0) return;
+  cj_Kernel_scale(type, 'F', m, n, alpha, B, ldb);
+  if (alpha == 0.0) return;
+  cj_Kernel_trsm_rec(type, side, lower, trans, diag, m, n, A, lda, B, ldb);
+}
+
+/* B:= op(D) * B (side 'L') or B * op(D) (side 'R') for a small diagonal block D in place. */
+static void cj_Kernel_trmm_unb (cj_eleType type, char side, cj_Bool lower, char trans, char diag,
+    int m, int n, const char *D, int ldd, char *B, int ldb) {
+  int nd = (side == 'R') ? n : m;
+  int s, c, q, r, i;
+  double coef;
+
+  for (s = 0; s < nd; s++) {
+    /* Each result takes its own unknown and the others still holding their input. */
+    c = ((side == 'L') == (lower == TRUE)) ? nd - 1 - s : s;
+    if (diag != 'U') {
+      if (type == CJ_SINGLE) {
+        float d = *(const float *) cj_Kernel_op_addr(D, ldd, trans, c, c, sizeof(float));
+        if (side == 'R') for (r = 0; r < m; r++) ((float *) B)[r + (size_t) c*ldb] *= d;
+        else for (r = 0; r < n; r++) ((float *) B)[c + (size_t) r*ldb] *= d;
+      }
+      else {
+        double d = *(const double *) cj_Kernel_op_addr(D, ldd, trans, c, c, sizeof(double));
+        if (side == 'R') for (r = 0; r < m; r++) ((double *) B)[r + (size_t) c*ldb] *= d;
+        else for (r = 0; r < n; r++) ((double *) B)[c + (size_t) r*ldb] *= d;
+      }
+    }
+    for (q = 0; q < nd; q++) {
+      if (q == c || (((side == 'L') == (lower == TRUE)) ? q > c : q < c)) continue;
+      /* Coefficient of the input q in the result c. */
+      r = (side == 'R') ? q : c;
+      i = (side == 'R') ? c : q;
+      if (type == CJ_SINGLE) {
+        coef = *(const float *) cj_Kernel_op_addr(D, ldd, trans, r, i, sizeof(float));
+        if (coef == 0.0) continue;
+        if (side == 'R') {
+          float *bc = (float *) B + (size_t) c*ldb, *bq = (float *) B + (size_t) q*ldb;
+          for (r = 0; r < m; r++) bc[r] += (float) coef*bq[r];
+        }
+        else {
+          float *b = (float *) B;
+          for (r = 0; r < n; r++) b[c + (size_t) r*ldb] += (float) coef*b[q + (size_t) r*ldb];
+        }
+      }
+      else {
+        coef = *(const double *) cj_Kernel_op_addr(D, ldd, trans, r, i, sizeof(double));
+        if (coef == 0.0) continue;
+        if (side == 'R') {
+          double *bc = (double *) B + (size_t) c*ldb, *bq = (double *) B + (size_t) q*ldb;
+          for (r = 0; r < m; r++) bc[r] += coef*bq[r];
+        }
+        else {
+          double *b = (double *) B;
+          for (r = 0; r < n; r++) b[c + (size_t) r*ldb] += coef*b[q + (size_t) r*ldb];
+        }
+      }
+    }
+  }
+}
+
+/* B:= op(D) * B (side 'L') or B * op(D) (side 'R') for a diagonal block D of at most
+ * KERNEL_TB. op(D) is expanded to a square with its zeros and B is multiplied by
+ * GEMM through a copy, in panels of KERNEL_TB, which beats the scalar loops above
+ * once B has a few panels. */
+static void cj_Kernel_trmm_blk (cj_eleType type, char side, cj_Bool lower, char trans, char diag,
+    int m, int n, const char *D, int ldd, char *B, int ldb) {
+  size_t len = (type == CJ_SINGLE) ? sizeof(float) : sizeof(double);
+  int nd = (side == 'R') ? n : m, nb = (side == 'R') ? m : n;
+  int i, j, p, pb;
+  char *E, *W;
+
+  if (nb < KERNEL_TB) {
+    cj_Kernel_trmm_unb(type, side, lower, trans, diag, m, n, D, ldd, B, ldb);
+    return;
+  }
+  E = cj_Kernel_buff(4, (size_t) (nd + KERNEL_TB)*nd*len);
+  W = E + (size_t) nd*nd*len;
+  memset(E, 0, (size_t) nd*nd*len);
+  for (j = 0; j < nd; j++) {
+    for (i = (lower == TRUE) ? j : 0; i < ((lower == TRUE) ? nd : j + 1); i++) {
+      memcpy(E + (i + (size_t) j*nd)*len, cj_Kernel_op_addr(D, ldd, trans, i, j, len), len);
+    }
+    if (diag == 'U') {
+      if (type == CJ_SINGLE) ((float *) E)[j + (size_t) j*nd] = 1.0;
+      else ((double *) E)[j + (size_t) j*nd] = 1.0;
+    }
+  }
+
+  for (p = 0; p < nb; p += KERNEL_TB) {
+    pb = min(KERNEL_TB, nb - p);
+    if (side == 'R') {
+      for (j = 0; j < nd; j++) 
+        memcpy(W + (size_t) j*pb*len, B + (p + (size_t) j*ldb)*len, (size_t) pb*len);
+      cj_Kernel_gemm(type, 'F', 'N', 'N', pb, nd, nd, 1.0, W, pb, E, nd, 0.0, B + p*len, ldb);
+    }
+    else {
+      for (j = 0; j < pb; j++) 
+        memcpy(W + (size_t) j*nd*len, B + (size_t) (p + j)*ldb*len, (size_t) nd*len);
+      cj_Kernel_gemm(type, 'F', 'N', 'N', nd, pb, nd, 1.0, E, nd, W, nd, 0.0, B + (size_t) p*ldb*len, ldb);
+    }
+  }
+}
+
+/* Multiply with the triangular dimension halved until it fits KERNEL_TB. The half
+ * whose result needs the input of the other is done first, then the GEMM with that
+ * input, then the other half. */
+static void cj_Kernel_trmm_rec (cj_eleType type, char side, cj_Bool lower, char trans, char diag, int m, int n,
+    const char *A, int lda, char *B, int ldb) {
+  size_t len = (type == CJ_SINGLE) ? sizeof(float) : sizeof(double);
+  int na = (side == 'R') ? n : m;
+  int n1, f0, fn, s0, sn;
+
+  if (na <= KERNEL_TB) {
+    cj_Kernel_trmm_blk(type, side, lower, trans, diag, m, n, A, lda, B, ldb);
+    return;
+  }
+  n1 = cj_Kernel_split(na);
+  f0 = ((side == 'L') == (lower == TRUE)) ? n1 : 0;
+  fn = f0 ? na - n1 : n1;
+  s0 = f0 ? 0 : n1;
+  sn = na - fn;
+
+  if (side == 'R') {
+    cj_Kernel_trmm_rec(type, side, lower, trans, diag, m, fn, A + (f0 + (size_t) f0*lda)*len, lda,
+        B + (size_t) f0*ldb*len, ldb);
+    cj_Kernel_gemm(type, 'F', 'N', trans, m, fn, sn, 1.0, B + (size_t) s0*ldb*len, ldb,
+        cj_Kernel_op_addr(A, lda, trans, s0, f0, len), lda, 1.0, B + (size_t) f0*ldb*len, ldb);
+    cj_Kernel_trmm_rec(type, side, lower, trans, diag, m, sn, A + (s0 + (size_t) s0*lda)*len, lda,
+        B + (size_t) s0*ldb*len, ldb);
+  }
+  else {
+    cj_Kernel_trmm_rec(type, side, lower, trans, diag, fn, n, A + (f0 + (size_t) f0*lda)*len, lda,
+        B + f0*len, ldb);
+    cj_Kernel_gemm(type, 'F', trans, 'N', fn, n, sn, 1.0, cj_Kernel_op_addr(A, lda, trans, f0, s0, len), lda,
+        B + s0*len, ldb, 1.0, B + f0*len, ldb);
+    cj_Kernel_trmm_rec(type, side, lower, trans, diag, sn, n, A + (s0 + (size_t) s0*lda)*len, lda,
+        B + s0*len, ldb);
+  }
+}
+
+/* B:= alpha * op(A) * B (side 'L') or alpha * B * op(A) (side 'R'). */
+static void cj_Kernel_trmm (cj_eleType type, char side, char uplo, char trans, char diag, int m, int n,
+    double alpha, const char *A, int lda, char *B, int ldb) {
+  cj_Bool lower = ((uplo == 'L') == (trans == 'N')) ? TRUE : FALSE;
+
+  if (m <= 0 || n <= 0) return;
+  cj_Kernel_scale(type, 'F', m, n, alpha, B, ldb);
+  if (alpha == 0.0) return;
+  cj_Kernel_trmm_rec(type, side, lower, trans, diag, m, n, A, lda, B, ldb);
+}
+
+/* C:= alpha * op(A) * op(A)' + beta * C on the triangle uplo of C. The diagonal blocks
+ * recurse and the off-diagonal block is a plain GEMM. */
+static void cj_Kernel_syrk (cj_eleType type, char uplo, char trans, int n, int k, double alpha,
+    const char *A, int lda, double beta, char *C, int ldc) {
+  size_t len = (type == CJ_SINGLE) ? sizeof(float) : sizeof(double);
+  char transb = (trans == 'N') ? 'T' : 'N';
+  const char *A2;
+  int n1;
+
+  if (n <= KERNEL_TB) {
+    cj_Kernel_gemm(type, uplo, trans, transb, n, n, k, alpha, A, lda, A, lda, beta, C, ldc);
+    return;
+  }
+  n1 = cj_Kernel_split(n);
+  /* Rows n1: of op(A). */
+  A2 = A + ((trans == 'N') ? (size_t) n1 : (size_t) n1*lda)*len;
+
+  cj_Kernel_syrk(type, uplo, trans, n1, k, alpha, A, lda, beta, C, ldc);
+  if (uplo == 'L') {
+    cj_Kernel_gemm(type, 'F', trans, transb, n - n1, n1, k, alpha, A2, lda, A, lda, beta,
+        C + n1*len, ldc);
+  }
+  else {
+    cj_Kernel_gemm(type, 'F', trans, transb, n1, n - n1, k, alpha, A, lda, A2, lda, beta,
+        C + (size_t) n1*ldc*len, ldc);
+  }
+  cj_Kernel_syrk(type, uplo, trans, n - n1, k, alpha, A2, lda, beta, C + (n1 + (size_t) n1*ldc)*len, ldc);
+}
+
+/* C:= alpha * (op(A) * op(B)' + op(B) * op(A)') + beta * C on the triangle uplo of C. */
+static void cj_Kernel_syr2k (cj_eleType type, char uplo, char trans, int n, int k, double alpha,
+    const char *A, int lda, const char *B, int ldb, double beta, char *C, int ldc) {
+  char transb = (trans == 'N') ? 'T' : 'N';
+
+  cj_Kernel_gemm(type, uplo, trans, transb, n, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+  cj_Kernel_gemm(type, uplo, trans, transb, n, n, k, alpha, B, ldb, A, lda, 1.0, C, ldc);
+}
+
+/* C:= alpha * A * B + beta * C (side 'L') or alpha * B * A + beta * C (side 'R'), A is
+ * symmetric and only its triangle uplo is read. A is expanded into a scratch copy,
+ * which costs one pass over A against the m*n*na flops of the product. */
+static void cj_Kernel_symm (cj_eleType type, char side, char uplo, int m, int n, double alpha,
+    const char *A, int lda, const char *B, int ldb, double beta, char *C, int ldc) {
+  int na = (side == 'L') ? m : n, i, j, si, sj;
+  size_t len = (type == CJ_SINGLE) ? sizeof(float) : sizeof(double);
+  char *S;
+
+  if (m <= 0 || n <= 0) return;
+  S = cj_Kernel_buff(2, (size_t) na*na*len);
+  for (j = 0; j < na; j++) {
+    for (i = 0; i < na; i++) {
+      /* Entries outside the stored triangle come from their mirror. */
+      if ((uplo == 'L') == (i >= j)) { si = i; sj = j; }
+      else { si = j; sj = i; }
+      memcpy(S + (i + (size_t) j*na)*len, A + (si + (size_t) sj*lda)*len, len);
+    }
+  }
+  if (side == 'L') cj_Kernel_gemm(type, 'F', 'N', 'N', m, n, m, alpha, S, na, B, ldb, beta, C, ldc);
+  else cj_Kernel_gemm(type, 'F', 'N', 'N', m, n, n, alpha, B, ldb, S, na, beta, C, ldc);
+}
+
+/* Unblocked left-looking Cholesky of a lower tile. Column j is updated by the
+ * columns left of it and then scaled, so the inner loops run down contiguous
+ * columns. N fixes the order at compile time (0 for any order), which lets the
+ * compiler unroll and vectorize the common tile sizes. */
+#define CJ_KERNEL_POTRF_UNB(name, type, N)                                  \
+static int name (int n_arg, type *a, int lda) {                             \
+  const int n = (N) ? (N) : n_arg;                                          \
+  int i, j, p;                                                              \
+  type d;                                                                   \
+                                                                            \
+  for (j = 0; j < n; j++) {                                                 \
+    type *aj = a + (size_t) j*lda;                                          \
+    for (p = 0; p < j; p++) {                                               \
+      const type *ap = a + (size_t) p*lda;                                  \
+      const type s = ap[j];                                                 \
+      for (i = j; i < n; i++) aj[i] -= ap[i]*s;                             \
+    }                                                                       \
+    d = aj[j];                                                              \
+    if (!(d > 0.0)) return j + 1;                                           \
+    d = sqrt(d);                                                            \
+    aj[j] = d;                                                              \
+    d = 1.0/d;                                                              \
+    for (i = j + 1; i < n; i++) aj[i] *= d;                                 \
+  }                                                                         \
+  return 0;                                                                 \
+}
+
+CJ_KERNEL_POTRF_UNB(cj_Kernel_dpotrf_unb, double, 0)
+CJ_KERNEL_POTRF_UNB(cj_Kernel_dpotrf_unb16, double, 16)
+CJ_KERNEL_POTRF_UNB(cj_Kernel_dpotrf_unb32, double, 32)
+CJ_KERNEL_POTRF_UNB(cj_Kernel_dpotrf_unb64, double, 64)
+CJ_KERNEL_POTRF_UNB(cj_Kernel_spotrf_unb, float, 0)
+CJ_KERNEL_POTRF_UNB(cj_Kernel_spotrf_unb16, float, 16)
+CJ_KERNEL_POTRF_UNB(cj_Kernel_spotrf_unb32, float, 32)
+CJ_KERNEL_POTRF_UNB(cj_Kernel_spotrf_unb64, float, 64)
+
+static int cj_Kernel_potrf_unb (cj_eleType type, int n, char *A, int lda) {
+  if (type == CJ_SINGLE) {
+    float *a = (float *) A;
+    switch (n) {
+      case 16: return cj_Kernel_spotrf_unb16(n, a, lda);
+      case 32: return cj_Kernel_spotrf_unb32(n, a, lda);
+      case 64: return cj_Kernel_spotrf_unb64(n, a, lda);
+      default: return cj_Kernel_spotrf_unb(n, a, lda);
+    }
+  }
+  else {
+    double *a = (double *) A;
+    switch (n) {
+      case 16: return cj_Kernel_dpotrf_unb16(n, a, lda);
+      case 32: return cj_Kernel_dpotrf_unb32(n, a, lda);
+      case 64: return cj_Kernel_dpotrf_unb64(n, a, lda);
+      default: return cj_Kernel_dpotrf_unb(n, a, lda);
+    }
+  }
+}
+
+/* Recursive Cholesky, A = L * L' (uplo 'L') or A = U' * U (uplo 'U'). Returns the
+ * LAPACK info: 0, or the order of the first leading minor that is not positive. */
+static int cj_Kernel_potrf (cj_eleType type, char uplo, int n, char *A, int lda) {
+  size_t len = (type == CJ_SINGLE) ? sizeof(float) : sizeof(double);
+  char *A12, *A21, *A22;
+  int n1, info;
+
+  if (n <= 0) return 0;
+  if (n <= KERNEL_TB && uplo == 'L') return cj_Kernel_potrf_unb(type, n, A, lda);
+  if (n == 1) {
+    /* The upper factor recurses down to scalars. */
+    double d = (type == CJ_SINGLE) ? *(float *) A : *(double *) A;
+    if (!(d > 0.0)) return 1;
+    if (type == CJ_SINGLE) *(float *) A = sqrt(d);
+    else *(double *) A = sqrt(d);
+    return 0;
+  }
+  n1 = cj_Kernel_split(n);
+  A12 = A + (size_t) n1*lda*len;
+  A21 = A + n1*len;
+  A22 = A + (n1 + (size_t) n1*lda)*len;
+
+  if ((info = cj_Kernel_potrf(type, uplo, n1, A, lda))) return info;
+  if (uplo == 'L') {
+    cj_Kernel_trsm_rec(type, 'R', FALSE, 'T', 'N', n - n1, n1, A, lda, A21, lda);
+    cj_Kernel_syrk(type, 'L', 'N', n - n1, n1, -1.0, A21, lda, 1.0, A22, lda);
+  }
+  else {
+    cj_Kernel_trsm_rec(type, 'L', TRUE, 'T', 'N', n1, n - n1, A, lda, A12, lda);
+    cj_Kernel_syrk(type, 'U', 'T', n - n1, n1, -1.0, A12, lda, 1.0, A22, lda);
+  }
+  if ((info = cj_Kernel_potrf(type, uplo, n - n1, A22, lda))) return info + n1;
+  return 0;
+}
+
+/* Swap rows i and ipiv[i] - 1 of the n columns of A for k1 <= i < k2, as LAPACK laswp. */
+static void cj_Kernel_laswp (cj_eleType type, int n, char *A, int lda, int k1, int k2, const int *ipiv) {
+  int i, j, p;
+
+  for (i = k1; i < k2; i++) {
+    p = ipiv[i] - 1;
+    if (p == i) continue;
+    for (j = 0; j < n; j++) {
+      if (type == CJ_SINGLE) {
+        float *a = (float *) A + (size_t) j*lda, t = a[i];
+        a[i] = a[p]; a[p] = t;
+      }
+      else {
+        double *a = (double *) A + (size_t) j*lda, t = a[i];
+        a[i] = a[p]; a[p] = t;
+      }
+    }
+  }
+}
+
+/* Unblocked right-looking LU with partial pivoting of a narrow m x n panel,
+ * pivots and info as LAPACK getrf. A zero pivot leaves its column as it is. */
+#define CJ_KERNEL_GETRF_UNB(name, type)                                     \
+static int name (int m, int n, type *a, int lda, int *ipiv) {               \
+  int i, j, c, p, info = 0;                                                 \
+  type d, s;                                                                \
+                                                                            \
+  for (j = 0; j < min(m, n); j++) {                                         \
+    type *aj = a + (size_t) j*lda;                                          \
+    p = j;                                                                  \
+    for (i = j + 1; i < m; i++) if (fabs(aj[i]) > fabs(aj[p])) p = i;       \
+    ipiv[j] = p + 1;                                                        \
+    if (p != j) {                                                           \
+      for (c = 0; c < n; c++) {                                             \
+        type *ac = a + (size_t) c*lda;                                      \
+        s = ac[j]; ac[j] = ac[p]; ac[p] = s;                                \
+      }                                                                     \
+    }                                                                       \
+    if (aj[j] == 0.0) {                                                     \
+      if (!info) info = j + 1;                                              \
+      continue;                                                             \
+    }                                                                       \
+    d = 1.0/aj[j];                                                          \
+    for (i = j + 1; i < m; i++) aj[i] *= d;                                 \
+    for (c = j + 1; c < n; c++) {                                           \
+      type *ac = a + (size_t) c*lda;                                        \
+      s = ac[j];                                                            \
+      for (i = j + 1; i < m; i++) ac[i] -= aj[i]*s;                         \
+    }                                                                       \
+  }                                                                         \
+  return info;                                                              \
+}
+
+CJ_KERNEL_GETRF_UNB(cj_Kernel_dgetrf_unb, double)
+CJ_KERNEL_GETRF_UNB(cj_Kernel_sgetrf_unb, float)
+
+/* Recursive LU with partial pivoting, A = P * L * U. The left half is factored,
+ * its pivots and its L applied to the right half, and the trailing block recurses;
+ * everything but the narrow panels runs in TRSM and GEMM. */
+static int cj_Kernel_getrf (cj_eleType type, int m, int n, char *A, int lda, int *ipiv) {
+  size_t len = (type == CJ_SINGLE) ? sizeof(float) : sizeof(double);
+  int mn = min(m, n), n1, i, info, info2;
+  char *A12, *A21, *A22;
+
+  if (mn <= 0) return 0;
+  if (mn <= KERNEL_TB/4) {
+    if (type == CJ_SINGLE) return cj_Kernel_sgetrf_unb(m, n, (float *) A, lda, ipiv);
+    return cj_Kernel_dgetrf_unb(m, n, (double *) A, lda, ipiv);
+  }
+  n1 = cj_Kernel_split(mn);
+  A12 = A + (size_t) n1*lda*len;
+  A21 = A + n1*len;
+  A22 = A + (n1 + (size_t) n1*lda)*len;
+
+  info = cj_Kernel_getrf(type, m, n1, A, lda, ipiv);
+  cj_Kernel_laswp(type, n - n1, A12, lda, 0, n1, ipiv);
+  cj_Kernel_trsm_rec(type, 'L', TRUE, 'N', 'U', n1, n - n1, A, lda, A12, lda);
+  cj_Kernel_gemm(type, 'F', 'N', 'N', m - n1, n - n1, n1, -1.0, A21, lda, A12, lda, 1.0, A22, lda);
+  info2 = cj_Kernel_getrf(type, m - n1, n - n1, A22, lda, ipiv + n1);
+  if (!info && info2) info = info2 + n1;
+  for (i = n1; i < mn; i++) ipiv[i] += n1;
+  cj_Kernel_laswp(type, n1, A, lda, n1, mn, ipiv);
+  return info;
+}
+
+/* A:= L^(-1) * P' * A with the pivots and the unit lower L of an m x m getrf tile. */
+static void cj_Kernel_gessm (cj_eleType type, int m, int n, const int *ipiv, const char *L, int ldl,
+    char *A, int lda) {
+  cj_Kernel_laswp(type, n, A, lda, 0, m, ipiv);
+  cj_Kernel_trsm_rec(type, 'L', TRUE, 'N', 'U', m, n, L, ldl, A, lda);
+}
+
+/* Householder reflector of LAPACK larfg: H' * [alpha; x] = [beta; 0] for
+ * H = I - tau * [1; v] * [1; v]'. v overwrites x, beta overwrites alpha and tau
+ * is returned, 0 when x is already zero. */
+#define CJ_KERNEL_LARFG(name, type)                                         \
+static type name (int n, type *alpha, type *x) {                            \
+  type scale = 0.0, ssq = 0.0, beta, d;                                     \
+  int i;                                                                    \
+                                                                            \
+  for (i = 0; i < n; i++) if (fabs(x[i]) > scale) scale = fabs(x[i]);       \
+  if (scale == 0.0) return 0.0;                                             \
+  for (i = 0; i < n; i++) { d = x[i]/scale; ssq += d*d; }                   \
+  beta = -copysign(hypot(*alpha, scale*sqrt(ssq)), *alpha);                 \
+  d = 1.0/(*alpha - beta);                                                  \
+  for (i = 0; i < n; i++) x[i] *= d;                                        \
+  d = (beta - *alpha)/beta;                                                 \
+  *alpha = beta;                                                            \
+  return d;                                                                 \
+}
+
+/* Unblocked QR of a narrow m x n panel, LAPACK geqrt2: R in the upper triangle,
+ * the unit lower V below it and the upper T of Q = I - V * T * V'. */
+#define CJ_KERNEL_GEQRT_UNB(name, larfg, type)                              \
+static void name (int m, int n, type *a, int lda, type *t, int ldt) {       \
+  int i, j, c, k = min(m, n);                                               \
+  type tau, w;                                                              \
+                                                                            \
+  for (j = 0; j < k; j++) {                                                 \
+    type *aj = a + (size_t) j*lda, *tj = t + (size_t) j*ldt;                \
+    tau = larfg(m - j - 1, aj + j, aj + j + 1);                             \
+    for (c = j + 1; tau != 0.0 && c < n; c++) {                             \
+      type *ac = a + (size_t) c*lda;                                        \
+      w = ac[j];                                                            \
+      for (i = j + 1; i < m; i++) w += aj[i]*ac[i];                         \
+      w *= tau;                                                             \
+      ac[j] -= w;                                                           \
+      for (i = j + 1; i < m; i++) ac[i] -= aj[i]*w;                         \
+    }                                                                       \
+    /* T(0:j, j) = -tau * T(0:j, 0:j) * V(:, 0:j)' * v */                   \
+    for (c = 0; c < j; c++) {                                               \
+      const type *ac = a + (size_t) c*lda;                                  \
+      w = ac[j];                                                            \
+      for (i = j + 1; i < m; i++) w += ac[i]*aj[i];                         \
+      tj[c] = -tau*w;                                                       \
+    }                                                                       \
+    for (c = 0; c < j; c++) {                                               \
+      w = 0.0;                                                              \
+      for (i = c; i < j; i++) w += t[c + (size_t) i*ldt]*tj[i];             \
+      tj[c] = w;                                                            \
+    }                                                                       \
+    tj[j] = tau;                                                            \
+  }                                                                         \
+}
+
+/* Unblocked QR of the n x n upper A stacked on the full m x n B, LAPACK tpqrt2
+ * with l = 0: R over A, V = [I; B] over B and the T of Q = I - V * T * V'. */
+#define CJ_KERNEL_TPQRT_UNB(name, larfg, type)                              \
+static void name (int m, int n, type *a, int lda, type *b, int ldb, type *t, int ldt) { \
+  int i, j, c;                                                              \
+  type tau, w;                                                              \
+                                                                            \
+  for (j = 0; j < n; j++) {                                                 \
+    type *bj = b + (size_t) j*ldb, *tj = t + (size_t) j*ldt;                \
+    tau = larfg(m, a + j + (size_t) j*lda, bj);                             \
+    for (c = j + 1; tau != 0.0 && c < n; c++) {                             \
+      type *bc = b + (size_t) c*ldb;                                        \
+      w = a[j + (size_t) c*lda];                                            \
+      for (i = 0; i < m; i++) w += bj[i]*bc[i];                             \
+      w *= tau;                                                             \
+      a[j + (size_t) c*lda] -= w;                                           \
+      for (i = 0; i < m; i++) bc[i] -= bj[i]*w;                             \
+    }                                                                       \
+    for (c = 0; c < j; c++) {                                               \
+      const type *bc = b + (size_t) c*ldb;                                  \
+      w = 0.0;                                                              \
+      for (i = 0; i < m; i++) w += bc[i]*bj[i];                             \
+      tj[c] = -tau*w;                                                       \
+    }                                                                       \
+    for (c = 0; c < j; c++) {                                               \
+      w = 0.0;                                                              \
+      for (i = c; i < j; i++) w += t[c + (size_t) i*ldt]*tj[i];             \
+      tj[c] = w;                                                            \
+    }                                                                       \
+    tj[j] = tau;                                                            \
+  }                                                                         \
+}
+
+CJ_KERNEL_LARFG(cj_Kernel_dlarfg, double)
+CJ_KERNEL_LARFG(cj_Kernel_slarfg, float)
+CJ_KERNEL_GEQRT_UNB(cj_Kernel_dgeqrt_unb, cj_Kernel_dlarfg, double)
+CJ_KERNEL_GEQRT_UNB(cj_Kernel_sgeqrt_unb, cj_Kernel_slarfg, float)
+CJ_KERNEL_TPQRT_UNB(cj_Kernel_dtpqrt_unb, cj_Kernel_dlarfg, double)
+CJ_KERNEL_TPQRT_UNB(cj_Kernel_stpqrt_unb, cj_Kernel_slarfg, float)
+
+/* Y:= Y - X for m x n blocks. */
+static void cj_Kernel_sub (cj_eleType type, int m, int n, const char *X, int ldx, char *Y, int ldy) {
+  int i, j;
+
+  for (j = 0; j < n; j++) {
+    for (i = 0; i < m; i++) {
+      if (type == CJ_SINGLE) ((float *) Y)[i + (size_t) j*ldy] -= ((const float *) X)[i + (size_t) j*ldx];
+      else ((double *) Y)[i + (size_t) j*ldy] -= ((const double *) X)[i + (size_t) j*ldx];
+    }
+  }
+}
+
+/* C:= op(Q) * C for Q = I - V * T * V' of a geqrt: V unit lower m x k, T upper
+ * k x k and C m x n; trans 'T' applies Q'. */
+static void cj_Kernel_larfb (cj_eleType type, char trans, int m, int n, int k, const char *V, int ldv,
+    const char *T, int ldt, char *C, int ldc) {
+  size_t len = (type == CJ_SINGLE) ? sizeof(float) : sizeof(double);
+  char *W;
+  int j;
+
+  if (m <= 0 || n <= 0 || k <= 0) return;
+  W = cj_Kernel_buff(3, (size_t) k*n*len);
+
+  /* W = op(T) * V' * C */
+  for (j = 0; j < n; j++) memcpy(W + (size_t) j*k*len, C + (size_t) j*ldc*len, (size_t) k*len);
+  cj_Kernel_trmm(type, 'L', 'L', 'T', 'U', k, n, 1.0, V, ldv, W, k);
+  cj_Kernel_gemm(type, 'F', 'T', 'N', k, n, m - k, 1.0, V + k*len, ldv, C + k*len, ldc, 1.0, W, k);
+  cj_Kernel_trmm(type, 'L', 'U', trans, 'N', k, n, 1.0, T, ldt, W, k);
+
+  /* C:= C - V * W */
+  cj_Kernel_gemm(type, 'F', 'N', 'N', m - k, n, k, -1.0, V + k*len, ldv, W, k, 1.0, C + k*len, ldc);
+  cj_Kernel_trmm(type, 'L', 'L', 'N', 'U', k, n, 1.0, V, ldv, W, k);
+  cj_Kernel_sub(type, k, n, W, k, C, ldc);
+}
+
+/* Recursive QR, A = Q * R with Q = I - V * T * V' (LAPACK geqrt with one block).
+ * The left half is factored and applied to the right half, the trailing block
+ * recurses, and the two T blocks are joined by T12 = -T11 * V1' * V2 * T22. */
+static void cj_Kernel_geqrt (cj_eleType type, int m, int n, char *A, int lda, char *T, int ldt) {
+  size_t len = (type == CJ_SINGLE) ? sizeof(float) : sizeof(double);
+  int k = min(m, n), n1, n2, i, j;
+  char *A22, *T12, *T22;
+
+  if (k <= 0) return;
+  if (n > k) {
+    cj_Kernel_geqrt(type, m, k, A, lda, T, ldt);
+    cj_Kernel_larfb(type, 'T', m, n - k, k, A, lda, T, ldt, A + (size_t) k*lda*len, lda);
+    return;
+  }
+  if (k <= KERNEL_TB/4) {
+    if (type == CJ_SINGLE) cj_Kernel_sgeqrt_unb(m, n, (float *) A, lda, (float *) T, ldt);
+    else cj_Kernel_dgeqrt_unb(m, n, (double *) A, lda, (double *) T, ldt);
+    return;
+  }
+  n1 = cj_Kernel_split(k);
+  n2 = k - n1;
+  A22 = A + (n1 + (size_t) n1*lda)*len;
+  T12 = T + (size_t) n1*ldt*len;
+  T22 = T + (n1 + (size_t) n1*ldt)*len;
+
+  cj_Kernel_geqrt(type, m, n1, A, lda, T, ldt);
+  cj_Kernel_larfb(type, 'T', m, n2, n1, A, lda, T, ldt, A + (size_t) n1*lda*len, lda);
+  cj_Kernel_geqrt(type, m - n1, n2, A22, lda, T22, ldt);
+
+  /* V2 is unit lower from row n1 on. */
+  for (j = 0; j < n2; j++) {
+    for (i = 0; i < n1; i++) memcpy(T12 + (i + (size_t) j*ldt)*len, A + (n1 + j + (size_t) i*lda)*len, len);
+  }
+  cj_Kernel_trmm(type, 'R', 'L', 'N', 'U', n1, n2, 1.0, A22, lda, T12, ldt);
+  cj_Kernel_gemm(type, 'F', 'T', 'N', n1, n2, m - k, 1.0, A + k*len, lda, A22 + n2*len, lda, 1.0, T12, ldt);
+  cj_Kernel_trmm(type, 'L', 'U', 'N', 'N', n1, n2, -1.0, T, ldt, T12, ldt);
+  cj_Kernel_trmm(type, 'R', 'U', 'N', 'N', n1, n2, 1.0, T22, ldt, T12, ldt);
+}
+
+/* [A; B]:= op(Q) * [A; B] for Q = I - V * T * V' of a tpqrt with l = 0: V = [I; V2],
+ * V2 full m x k, A the top k x n rows and B m x n. */
+static void cj_Kernel_tpmqrt_ts (cj_eleType type, char trans, int m, int n, int k, const char *V, int ldv,
+    const char *T, int ldt, char *A, int lda, char *B, int ldb) {
+  size_t len = (type == CJ_SINGLE) ? sizeof(float) : sizeof(double);
+  char *W;
+  int j;
+
+  if (n <= 0 || k <= 0) return;
+  W = cj_Kernel_buff(3, (size_t) k*n*len);
+
+  /* W = op(T) * (A + V2' * B) */
+  for (j = 0; j < n; j++) memcpy(W + (size_t) j*k*len, A + (size_t) j*lda*len, (size_t) k*len);
+  cj_Kernel_gemm(type, 'F', 'T', 'N', k, n, m, 1.0, V, ldv, B, ldb, 1.0, W, k);
+  cj_Kernel_trmm(type, 'L', 'U', trans, 'N', k, n, 1.0, T, ldt, W, k);
+
+  cj_Kernel_sub(type, k, n, W, k, A, lda);
+  cj_Kernel_gemm(type, 'F', 'N', 'N', m, n, k, -1.0, V, ldv, W, k, 1.0, B, ldb);
+}
+
+/* Recursive QR of the n x n upper A stacked on the full m x n B, as cj_Kernel_geqrt. */
+static void cj_Kernel_tpqrt_ts (cj_eleType type, int m, int n, char *A, int lda, char *B, int ldb,
+    char *T, int ldt) {
+  size_t len = (type == CJ_SINGLE) ? sizeof(float) : sizeof(double);
+  int n1, n2;
+  char *B2, *T12, *T22;
+
+  if (n <= 0) return;
+  if (n <= KERNEL_TB/4) {
+    if (type == CJ_SINGLE) cj_Kernel_stpqrt_unb(m, n, (float *) A, lda, (float *) B, ldb, (float *) T, ldt);
+    else cj_Kernel_dtpqrt_unb(m, n, (double *) A, lda, (double *) B, ldb, (double *) T, ldt);
+    return;
+  }
+  n1 = cj_Kernel_split(n);
+  n2 = n - n1;
+  B2 = B + (size_t) n1*ldb*len;
+  T12 = T + (size_t) n1*ldt*len;
+  T22 = T + (n1 + (size_t) n1*ldt)*len;
+
+  cj_Kernel_tpqrt_ts(type, m, n1, A, lda, B, ldb, T, ldt);
+  cj_Kernel_tpmqrt_ts(type, 'T', m, n2, n1, B, ldb, T, ldt, A + (size_t) n1*lda*len, lda, B2, ldb);
+  cj_Kernel_tpqrt_ts(type, m, n2, A + (n1 + (size_t) n1*lda)*len, lda, B2, ldb, T22, ldt);
+
+  /* The identity parts of V1 and V2 do not overlap. */
+  cj_Kernel_gemm(type, 'F', 'T', 'N', n1, n2, m, 1.0, B, ldb, B2, ldb, 0.0, T12, ldt);
+  cj_Kernel_trmm(type, 'L', 'U', 'N', 'N', n1, n2, -1.0, T, ldt, T12, ldt);
+  cj_Kernel_trmm(type, 'R', 'U', 'N', 'N', n1, n2, 1.0, T22, ldt, T12, ldt);
+}
+
+/* Copy the pentagon of an m x n block whose last l rows are upper trapezoidal,
+ * from X to Y; the entries under it are zeroed in Y when zero is TRUE and left
+ * alone otherwise. */
+static void cj_Kernel_pentagon (cj_eleType type, int m, int n, int l, const char *X, int ldx,
+    char *Y, int ldy, cj_Bool zero) {
+  size_t len = (type == CJ_SINGLE) ? sizeof(float) : sizeof(double);
+  int j, h;
+
+  for (j = 0; j < n; j++) {
+    h = min(m, m - l + j + 1);
+    memcpy(Y + (size_t) j*ldy*len, X + (size_t) j*ldx*len, (size_t) h*len);
+    if (zero == TRUE) memset(Y + (h + (size_t) j*ldy)*len, 0, (size_t) (m - h)*len);
+  }
+}
+
+/* QR of the n x n upper A stacked on the m x n B whose last l rows are upper
+ * trapezoidal, LAPACK tpqrt with one block. The entries of B under the pentagon
+ * are neither read nor written, the pentagon is factored on a zero filled copy. */
+static void cj_Kernel_tpqrt (cj_eleType type, int m, int n, int l, char *A, int lda, char *B, int ldb,
+    char *T, int ldt) {
+  size_t len = (type == CJ_SINGLE) ? sizeof(float) : sizeof(double);
+  char *P;
+
+  if (l == 0) {
+    cj_Kernel_tpqrt_ts(type, m, n, A, lda, B, ldb, T, ldt);
+    return;
+  }
+  if (m <= 0 || n <= 0) return;
+  P = cj_Kernel_buff(2, (size_t) m*n*len);
+  cj_Kernel_pentagon(type, m, n, l, B, ldb, P, m, TRUE);
+  cj_Kernel_tpqrt_ts(type, m, n, A, lda, P, m, T, ldt);
+  cj_Kernel_pentagon(type, m, n, l, P, m, B, ldb, FALSE);
+}
+
+/* [A; B]:= op(Q) * [A; B] with the pentagonal m x k V and the T of a tpqrt,
+ * A: k x n, B: m x n. */
+static void cj_Kernel_tpmqrt (cj_eleType type, char trans, int m, int n, int k, int l, const char *V,
+    int ldv, const char *T, int ldt, char *A, int lda, char *B, int ldb) {
+  size_t len = (type == CJ_SINGLE) ? sizeof(float) : sizeof(double);
+  char *P;
+
+  if (l == 0) {
+    cj_Kernel_tpmqrt_ts(type, trans, m, n, k, V, ldv, T, ldt, A, lda, B, ldb);
+    return;
+  }
+  if (m <= 0 || k <= 0) return;
+  P = cj_Kernel_buff(2, (size_t) m*k*len);
+  cj_Kernel_pentagon(type, m, k, l, V, ldv, P, m, TRUE);
+  cj_Kernel_tpmqrt_ts(type, trans, m, n, k, P, m, T, ldt, A, lda, B, ldb);
+}
+
+/* Unblocked inverse of a lower triangular tile in place, as LAPACK trti2: from the
+ * last column back, column j is multiplied by the inverse already formed below and
+ * right of it, then scaled by minus its inverted diagonal entry. */
+#define CJ_KERNEL_TRTRI_UNB(name, type)                                     \
+static void name (char diag, int n, type *a, int lda) {                     \
+  int i, j, p;                                                              \
+  type d, s;                                                                \
+                                                                            \
+  for (j = n - 1; j >= 0; j--) {                                            \
+    type *aj = a + (size_t) j*lda;                                          \
+    d = (diag == 'U') ? 1.0 : (aj[j] = 1.0/aj[j]);                          \
+    for (p = n - 1; p > j; p--) {                                           \
+      const type *ap = a + (size_t) p*lda;                                  \
+      s = aj[p];                                                            \
+      if (diag != 'U') aj[p] = ap[p]*s;                                     \
+      for (i = p + 1; i < n; i++) aj[i] += ap[i]*s;                         \
+    }                                                                       \
+    for (i = j + 1; i < n; i++) aj[i] *= -d;                                \
+  }                                                                         \
+}
+
+CJ_KERNEL_TRTRI_UNB(cj_Kernel_dtrtri_unb, double)
+CJ_KERNEL_TRTRI_UNB(cj_Kernel_strtri_unb, float)
+
+/* Recursive inverse of a lower triangular A in place: A21:= -A22^(-1) * A21 * A11^(-1)
+ * with the triangles still as given, then both triangles are inverted. */
+static void cj_Kernel_trtri_rec (cj_eleType type, char diag, int n, char *A, int lda) {
+  size_t len = (type == CJ_SINGLE) ? sizeof(float) : sizeof(double);
+  char *A21, *A22;
+  int n1;
+
+  if (n <= KERNEL_TB) {
+    if (type == CJ_SINGLE) cj_Kernel_strtri_unb(diag, n, (float *) A, lda);
+    else cj_Kernel_dtrtri_unb(diag, n, (double *) A, lda);
+    return;
+  }
+  n1 = cj_Kernel_split(n);
+  A21 = A + n1*len;
+  A22 = A + (n1 + (size_t) n1*lda)*len;
+
+  cj_Kernel_trsm(type, 'R', 'L', 'N', diag, n - n1, n1, -1.0, A, lda, A21, lda);
+  cj_Kernel_trsm(type, 'L', 'L', 'N', diag, n - n1, n1, 1.0, A22, lda, A21, lda);
+  cj_Kernel_trtri_rec(type, diag, n1, A, lda);
+  cj_Kernel_trtri_rec(type, diag, n - n1, A22, lda);
+}
+
+/* L^(-1) of the lower triangle of A in place. Returns the LAPACK info: 0, or the
+ * index plus one of the first zero on a non-unit diagonal, A being left alone. */
+static int cj_Kernel_trtri (cj_eleType type, char diag, int n, char *A, int lda) {
+  size_t len = (type == CJ_SINGLE) ? sizeof(float) : sizeof(double);
+  double d;
+  int j;
+
+  for (j = 0; diag != 'U' && j < n; j++) {
+    d = (type == CJ_SINGLE) ? *(float *) (A + j*(lda + (size_t) 1)*len) : *(double *) (A + j*(lda + (size_t) 1)*len);
+    if (d == 0.0) return j + 1;
+  }
+  cj_Kernel_trtri_rec(type, diag, n, A, lda);
+  return 0;
+}
+
+/* Unblocked L' * L on the lower triangle of A in place, as LAPACK lauu2: row i of the
+ * product only needs the rows of L from i on, so the rows are overwritten in order. */
+#define CJ_KERNEL_LAUUM_UNB(name, type)                                     \
+static void name (int n, type *a, int lda) {                                \
+  int i, j, p;                                                              \
+  type d, s;                                                                \
+                                                                            \
+  for (i = 0; i < n; i++) {                                                 \
+    type *ai = a + (size_t) i*lda;                                          \
+    d = ai[i];                                                              \
+    for (j = 0; j < i; j++) {                                               \
+      type *aj = a + (size_t) j*lda;                                        \
+      for (s = d*aj[i], p = i + 1; p < n; p++) s += ai[p]*aj[p];            \
+      aj[i] = s;                                                            \
+    }                                                                       \
+    for (s = 0.0, p = i; p < n; p++) s += ai[p]*ai[p];                      \
+    ai[i] = s;                                                              \
+  }                                                                         \
+}
+
+CJ_KERNEL_LAUUM_UNB(cj_Kernel_dlauum_unb, double)
+CJ_KERNEL_LAUUM_UNB(cj_Kernel_slauum_unb, float)
+
+/* Recursive L' * L in place on the lower triangle: A11:= L11' * L11 + L21' * L21,
+ * A21:= L22' * L21 and A22:= L22' * L22. */
+static void cj_Kernel_lauum (cj_eleType type, int n, char *A, int lda) {
+  size_t len = (type == CJ_SINGLE) ? sizeof(float) : sizeof(double);
+  char *A21, *A22;
+  int n1;
+
+  if (n <= 0) return;
+  if (n <= KERNEL_TB) {
+    if (type == CJ_SINGLE) cj_Kernel_slauum_unb(n, (float *) A, lda);
+    else cj_Kernel_dlauum_unb(n, (double *) A, lda);
+    return;
+  }
+  n1 = cj_Kernel_split(n);
+  A21 = A + n1*len;
+  A22 = A + (n1 + (size_t) n1*lda)*len;
+
+  cj_Kernel_lauum(type, n1, A, lda);
+  cj_Kernel_syrk(type, 'L', 'T', n1, n - n1, 1.0, A21, lda, 1.0, A, lda);
+  cj_Kernel_trmm(type, 'L', 'L', 'T', 'N', n - n1, n1, 1.0, A22, lda, A21, lda);
+  cj_Kernel_lauum(type, n - n1, A22, lda);
+}
+
+/* BLAS accepts both cases and 'C' for the transpose of a real matrix. */
+static char cj_Kernel_trans (const char *trans) {
+  return (*trans == 'N' || *trans == 'n') ? 'N' : 'T';
+}
+
+static char cj_Kernel_upper (const char *flag) {
+  return (*flag >= 'a' && *flag <= 'z') ? *flag - 'a' + 'A' : *flag;
+}
+
+#endif
+
+/* LU of a pair of tiles with pairwise pivoting, after PLASMA's tstrf: the n x n upper
+ * triangle of U sits on top of the m x n tile A. Column j picks its pivot among U(j, j)
+ * and A(:, j), swaps the tails of the two rows from column j on, and eliminates A(:, j),
+ * whose multipliers overwrite it. ipiv[j] is the row of A swapped with row j of U plus
+ * one, or 0. The strict lower part of U is never touched, so U keeps the L of its getrf.
+ * Returns the index plus one of the first zero pivot, or 0. */
+#define CJ_KERNEL_TSTRF(name, type)                                         \
+static int name (int m, int n, type *u, int ldu, type *a, int lda, int *ipiv) { \
+  int i, j, c, p, info = 0;                                                 \
+  type d, s;                                                                \
+                                                                            \
+  for (j = 0; j < n; j++) {                                                 \
+    type *aj = a + (size_t) j*lda;                                          \
+    p = -1; d = fabs(u[j + (size_t) j*ldu]);                                \
+    for (i = 0; i < m; i++) if (fabs(aj[i]) > d) { p = i; d = fabs(aj[i]); } \
+    ipiv[j] = p + 1;                                                        \
+    if (p >= 0) {                                                           \
+      for (c = j; c < n; c++) {                                             \
+        s = u[j + (size_t) c*ldu];                                          \
+        u[j + (size_t) c*ldu] = a[p + (size_t) c*lda];                      \
+        a[p + (size_t) c*lda] = s;                                          \
+      }                                                                     \
+    }                                                                       \
+    if (u[j + (size_t) j*ldu] == 0.0) {                                     \
+      if (!info) info = j + 1;                                              \
+      continue;                                                             \
+    }                                                                       \
+    d = 1.0/u[j + (size_t) j*ldu];                                          \
+    for (i = 0; i < m; i++) aj[i] *= d;                                     \
+    for (c = j + 1; c < n; c++) {                                           \
+      type *ac = a + (size_t) c*lda;                                        \
+      s = u[j + (size_t) c*ldu];                                            \
+      for (i = 0; i < m; i++) ac[i] -= aj[i]*s;                             \
+    }                                                                       \
+  }                                                                         \
+  return info;                                                              \
+}
+
+CJ_KERNEL_TSTRF(cj_Kernel_dtstrf_pair, double)
+CJ_KERNEL_TSTRF(cj_Kernel_ststrf_pair, float)
+
+/* Apply the transformations of a tstrf to a pair of tiles on its right: the top
+ * rows 0:k of A1 and the m x n tile A2 below, with the m x k multipliers L.
+ * Replaying the k swaps and rank-1 updates one by one runs at vector speed, so
+ * the replay is folded into BLAS-3. Row p of A2 gets updates from the steps since
+ * it last changed content: those before a swap at step j feed the final row j
+ * of A1 and go to the unit lower M(j, :), the rest stay in W(p, :). With rows
+ * gathered from where their final content started, A1:= M^(-1) * A1 and then
+ * A2:= A2 - W * A1. */
+static void cj_Kernel_ssssm (cj_eleType type, int m, int n, int k, char *A1, int lda1,
+    char *A2, int lda2, const char *L, int ldl, const int *ipiv) {
+  size_t len = (type == CJ_DOUBLE) ? sizeof(double) : sizeof(float);
+  char *M, *W, *T, *buff;
+  int *src, *cur, *seg;
+  int i, j, p, q;
+
+  if (m <= 0 || n <= 0 || k <= 0) return;
+  buff = cj_Kernel_buff(2, ((size_t) k*k + (size_t) m*k + (size_t) k*n)*len +
+      (size_t) (k + 2*m)*sizeof(int));
+  M = buff;
+  W = M + (size_t) k*k*len;
+  T = W + (size_t) m*k*len;
+  src = (int *) (T + (size_t) k*n*len);
+  cur = src + k;
+  seg = cur + m;
+
+  /* Rows 0:k-1 of the source are those of A1, rows k:k+m-1 those of A2. */
+  memset(M, 0, (size_t) k*k*len);
+  for (p = 0; p < m; p++) { cur[p] = k + p; seg[p] = 0; }
+  for (j = 0; j < k; j++) {
+    p = ipiv[j] - 1;
+    if (p < 0) { src[j] = j; continue; }
+    src[j] = cur[p];
+    for (q = seg[p]; q < j; q++) {
+      memcpy(M + (j + (size_t) q*k)*len, L + (p + (size_t) q*ldl)*len, len);
+    }
+    cur[p] = j;
+    seg[p] = j;
+  }
+  for (q = 0; q < k; q++) {
+    for (p = 0; p < m; p++) {
+      if (q >= seg[p]) memcpy(W + (p + (size_t) q*m)*len, L + (p + (size_t) q*ldl)*len, len);
+      else memset(W + (p + (size_t) q*m)*len, 0, len);
+    }
+  }
+
+  /* Gather T before A2 is overwritten, and A2 before A1 is. */
+  for (i = 0; i < n; i++) {
+    for (j = 0; j < k; j++) {
+      memcpy(T + (j + (size_t) i*k)*len, (src[j] < k) ? A1 + (src[j] + (size_t) i*lda1)*len :
+          A2 + (src[j] - k + (size_t) i*lda2)*len, len);
+    }
+    for (p = 0; p < m; p++) {
+      if (cur[p] < k) memcpy(A2 + (p + (size_t) i*lda2)*len, A1 + (cur[p] + (size_t) i*lda1)*len, len);
+    }
+  }
+
+  if (type == CJ_DOUBLE) {
+    double d_one = 1.0, d_mone = -1.0;
+    cj_Kernel_dtrsm("L", "L", "N", "U", &k, &n, &d_one, (double *) M, &k, (double *) T, &k);
+    cj_Kernel_dgemm("N", "N", &m, &n, &k, &d_mone, (double *) W, &m, (double *) T, &k,
+        &d_one, (double *) A2, &lda2);
+  }
+  else {
+    float f_one = 1.0, f_mone = -1.0;
+    cj_Kernel_strsm("L", "L", "N", "U", &k, &n, &f_one, (float *) M, &k, (float *) T, &k);
+    cj_Kernel_sgemm("N", "N", &m, &n, &k, &f_mone, (float *) W, &m, (float *) T, &k,
+        &f_one, (float *) A2, &lda2);
+  }
+  for (i = 0; i < n; i++) {
+    memcpy(A1 + (size_t) i*lda1*len, T + (size_t) i*k*len, (size_t) k*len);
+  }
+}
+
+/* A = L * D * L' without pivoting on the lower triangle of A, L unit lower below the
+ * diagonal and D on it. A zero pivot leaves its column alone. Returns the index plus
+ * one of the first zero pivot, or 0. */
+#define CJ_KERNEL_SYTRF_UNB(name, type)                                     \
+static int name (int n, type *a, int lda) {                                 \
+  int i, j, c, info = 0;                                                    \
+  type d, s;                                                                \
+                                                                            \
+  for (j = 0; j < n; j++) {                                                 \
+    type *aj = a + (size_t) j*lda;                                          \
+    if (aj[j] == 0.0) {                                                     \
+      if (!info) info = j + 1;                                              \
+      continue;                                                             \
+    }                                                                       \
+    d = 1.0/aj[j];                                                          \
+    for (c = j + 1; c < n; c++) {                                           \
+      type *ac = a + (size_t) c*lda;                                        \
+      s = aj[c]*d;                                                          \
+      for (i = c; i < n; i++) ac[i] -= aj[i]*s;                             \
+    }                                                                       \
+    for (i = j + 1; i < n; i++) aj[i] *= d;                                 \
+  }                                                                         \
+  return info;                                                              \
+}
+
+CJ_KERNEL_SYTRF_UNB(cj_Kernel_dsytrf_unb, double)
+CJ_KERNEL_SYTRF_UNB(cj_Kernel_ssytrf_unb, float)
+
+/* Columns of the m x n A divided by the diagonal of D, skipping zeros. */
+static void cj_Kernel_diag_div (cj_eleType type, int m, int n, const char *D, int incd, char *A, int lda) {
+  int i, j;
+  for (j = 0; j < n; j++) {
+    if (type == CJ_DOUBLE) {
+      double d = ((const double *) D)[(size_t) j*incd], *aj = (double *) A + (size_t) j*lda;
+      if (d != 0.0) for (i = 0; i < m; i++) aj[i] /= d;
+    }
+    else {
+      float d = ((const float *) D)[(size_t) j*incd], *aj = (float *) A + (size_t) j*lda;
+      if (d != 0.0) for (i = 0; i < m; i++) aj[i] /= d;
+    }
+  }
+}
+
+/* C:= C - A * W' for the m x k A and the n x k W = B * D. With uplo 'L', W = A * D and
+ * only the lower triangle of the square C is updated, by a SYR2K with half of both
+ * products since A * W' is symmetric. */
+static void cj_Kernel_ldlt_update (cj_eleType type, char uplo, int m, int n, int k, char *A, int lda,
+    char *W, int ldw, char *C, int ldc) {
+  if (m <= 0 || n <= 0 || k <= 0) return;
+  if (type == CJ_DOUBLE) {
+    double d_one = 1.0, d_mone = -1.0, d_mhalf = -0.5;
+    if (uplo == 'L') cj_Kernel_dsyr2k("L", "N", &n, &k, &d_mhalf, (double *) A, &lda, (double *) W, &ldw,
+        &d_one, (double *) C, &ldc);
+    else cj_Kernel_dgemm("N", "T", &m, &n, &k, &d_mone, (double *) A, &lda, (double *) W, &ldw,
+        &d_one, (double *) C, &ldc);
+  }
+  else {
+    float f_one = 1.0, f_mone = -1.0, f_mhalf = -0.5;
+    if (uplo == 'L') cj_Kernel_ssyr2k("L", "N", &n, &k, &f_mhalf, (float *) A, &lda, (float *) W, &ldw,
+        &f_one, (float *) C, &ldc);
+    else cj_Kernel_sgemm("N", "T", &m, &n, &k, &f_mone, (float *) A, &lda, (float *) W, &ldw,
+        &f_one, (float *) C, &ldc);
+  }
+}
+
+/* Recursive LDL' without pivoting: factor A11, A21:= A21 * L11^(-T) gives L21 * D1,
+ * which is kept for the update of A22 before its columns are divided by D1. */
+static int cj_Kernel_sytrf_nopiv (cj_eleType type, int n, char *A, int lda) {
+  size_t len = (type == CJ_DOUBLE) ? sizeof(double) : sizeof(float);
+  int n1 = n/2, n2 = n - n1, info, info2;
+  char *A21 = A + n1*len, *A22 = A + (n1 + (size_t) n1*lda)*len, *W;
+  int j;
+
+  if (n <= KERNEL_TB) {
+    return (type == CJ_DOUBLE) ? cj_Kernel_dsytrf_unb(n, (double *) A, lda) : 
+      cj_Kernel_ssytrf_unb(n, (float *) A, lda);
+  }
+  info = cj_Kernel_sytrf_nopiv(type, n1, A, lda);
+  if (type == CJ_DOUBLE) {
+    double d_one = 1.0;
+    cj_Kernel_dtrsm("R", "L", "T", "U", &n2, &n1, &d_one, (double *) A, &lda, (double *) A21, &lda);
+  }
+  else {
+    float f_one = 1.0;
+    cj_Kernel_strsm("R", "L", "T", "U", &n2, &n1, &f_one, (float *) A, &lda, (float *) A21, &lda);
+  }
+  W = cj_Kernel_buff(2, (size_t) n2*n1*len);
+  for (j = 0; j < n1; j++) memcpy(W + (size_t) j*n2*len, A21 + (size_t) j*lda*len, (size_t) n2*len);
+  cj_Kernel_diag_div(type, n2, n1, A, lda + 1, A21, lda);
+  cj_Kernel_ldlt_update(type, 'L', n2, n2, n1, A21, lda, W, n2, A22, lda);
+  info2 = cj_Kernel_sytrf_nopiv(type, n2, A22, lda);
+  return (info || !info2) ? info : n1 + info2;
+}
+
+/* A:= A * L^(-T) * D^(-1) with the unit lower L and diagonal D of a tile LDL'. */
+static void cj_Kernel_trsmd (cj_eleType type, int m, int n, const char *L, int ldl, char *A, int lda) {
+  if (type == CJ_DOUBLE) {
+    double d_one = 1.0;
+    cj_Kernel_dtrsm("R", "L", "T", "U", &m, &n, &d_one, (double *) L, &ldl, (double *) A, &lda);
+  }
+  else {
+    float f_one = 1.0;
+    cj_Kernel_strsm("R", "L", "T", "U", &m, &n, &f_one, (float *) L, &ldl, (float *) A, &lda);
+  }
+  cj_Kernel_diag_div(type, m, n, L, ldl + 1, A, lda);
+}
+
+/* C:= C - A * D * B' with the diagonal D at stride incd, lower triangle only with
+ * uplo 'L' (then B = A). */
+static void cj_Kernel_gemdm (cj_eleType type, char uplo, int m, int n, int k, char *A, int lda,
+    const char *D, int incd, const char *B, int ldb, char *C, int ldc) {
+  size_t len = (type == CJ_DOUBLE) ? sizeof(double) : sizeof(float);
+  char *W;
+  int i, j;
+
+  if (m <= 0 || n <= 0 || k <= 0) return;
+  W = cj_Kernel_buff(2, (size_t) n*k*len);
+  for (j = 0; j < k; j++) {
+    if (type == CJ_DOUBLE) {
+      double d = ((const double *) D)[(size_t) j*incd], *wj = (double *) W + (size_t) j*n;
+      const double *bj = (const double *) B + (size_t) j*ldb;
+      for (i = 0; i < n; i++) wj[i] = bj[i]*d;
+    }
+    else {
+      float d = ((const float *) D)[(size_t) j*incd], *wj = (float *) W + (size_t) j*n;
+      const float *bj = (const float *) B + (size_t) j*ldb;
+      for (i = 0; i < n; i++) wj[i] = bj[i]*d;
+    }
+  }
+  cj_Kernel_ldlt_update(type, uplo, m, n, k, A, lda, W, n, C, ldc);
+}
+
+/* The entry points take their arguments like the Fortran BLAS they replace. */
+
+void cj_Kernel_sgemm (char *transa, char *transb, int *m, int *n, int *k, float *alpha, float *A, int *lda,
+    float *B, int *ldb, float *beta, float *C, int *ldc) {
+#ifdef CJ_EXTERNAL_BLAS
+  sgemm_(transa, transb, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+#else
+  cj_Kernel_gemm(CJ_SINGLE, 'F', cj_Kernel_trans(transa), cj_Kernel_trans(transb), *m, *n, *k,
+      *alpha, (char *) A, *lda, (char *) B, *ldb, *beta, (char *) C, *ldc);
+#endif
+}
+
+void cj_Kernel_dgemm (char *transa, char *transb, int *m, int *n, int *k, double *alpha, double *A, int *lda,
+    double *B, int *ldb, double *beta, double *C, int *ldc) {
+#ifdef CJ_EXTERNAL_BLAS
+  dgemm_(transa, transb, m, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+#else
+  cj_Kernel_gemm(CJ_DOUBLE, 'F', cj_Kernel_trans(transa), cj_Kernel_trans(transb), *m, *n, *k,
+      *alpha, (char *) A, *lda, (char *) B, *ldb, *beta, (char *) C, *ldc);
+#endif
+}
+
+/* C:= alpha * A * A' + beta * C or alpha * A' * A + beta * C, on the triangle uplo of C. */
+void cj_Kernel_ssyrk (char *uplo, char *trans, int *n, int *k, float *alpha, float *A, int *lda,
+    float *beta, float *C, int *ldc) {
+#ifdef CJ_EXTERNAL_BLAS
+  ssyrk_(uplo, trans, n, k, alpha, A, lda, beta, C, ldc);
+#else
+  char t = cj_Kernel_trans(trans);
+  cj_Kernel_gemm(CJ_SINGLE, cj_Kernel_upper(uplo), t, (t == 'N') ? 'T' : 'N', *n, *n, *k,
+      *alpha, (char *) A, *lda, (char *) A, *lda, *beta, (char *) C, *ldc);
+#endif
+}
+
+void cj_Kernel_dsyrk (char *uplo, char *trans, int *n, int *k, double *alpha, double *A, int *lda,
+    double *beta, double *C, int *ldc) {
+#ifdef CJ_EXTERNAL_BLAS
+  dsyrk_(uplo, trans, n, k, alpha, A, lda, beta, C, ldc);
+#else
+  char t = cj_Kernel_trans(trans);
+  cj_Kernel_gemm(CJ_DOUBLE, cj_Kernel_upper(uplo), t, (t == 'N') ? 'T' : 'N', *n, *n, *k,
+      *alpha, (char *) A, *lda, (char *) A, *lda, *beta, (char *) C, *ldc);
+#endif
+}
+
+/* C:= alpha * (A * B' + B * A') + beta * C or alpha * (A' * B + B' * A) + beta * C, on the triangle uplo of C. */
+void cj_Kernel_ssyr2k (char *uplo, char *trans, int *n, int *k, float *alpha, float *A, int *lda,
+    float *B, int *ldb, float *beta, float *C, int *ldc) {
+#ifdef CJ_EXTERNAL_BLAS
+  ssyr2k_(uplo, trans, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+#else
+  cj_Kernel_syr2k(CJ_SINGLE, cj_Kernel_upper(uplo), cj_Kernel_trans(trans), *n, *k,
+      *alpha, (char *) A, *lda, (char *) B, *ldb, *beta, (char *) C, *ldc);
+#endif
+}
+
+void cj_Kernel_dsyr2k (char *uplo, char *trans, int *n, int *k, double *alpha, double *A, int *lda,
+    double *B, int *ldb, double *beta, double *C, int *ldc) {
+#ifdef CJ_EXTERNAL_BLAS
+  dsyr2k_(uplo, trans, n, k, alpha, A, lda, B, ldb, beta, C, ldc);
+#else
+  cj_Kernel_syr2k(CJ_DOUBLE, cj_Kernel_upper(uplo), cj_Kernel_trans(trans), *n, *k,
+      *alpha, (char *) A, *lda, (char *) B, *ldb, *beta, (char *) C, *ldc);
+#endif
+}
+
+/* C:= alpha * A * B + beta * C or alpha * B * A + beta * C, A is symmetric in its triangle uplo. */
+void cj_Kernel_ssymm (char *side, char *uplo, int *m, int *n, float *alpha, float *A, int *lda,
+    float *B, int *ldb, float *beta, float *C, int *ldc) {
+#ifdef CJ_EXTERNAL_BLAS
+  ssymm_(side, uplo, m, n, alpha, A, lda, B, ldb, beta, C, ldc);
+#else
+  cj_Kernel_symm(CJ_SINGLE, cj_Kernel_upper(side), cj_Kernel_upper(uplo), *m, *n,
+      *alpha, (char *) A, *lda, (char *) B, *ldb, *beta, (char *) C, *ldc);
+#endif
+}
+
+void cj_Kernel_dsymm (char *side, char *uplo, int *m, int *n, double *alpha, double *A, int *lda,
+    double *B, int *ldb, double *beta, double *C, int *ldc) {
+#ifdef CJ_EXTERNAL_BLAS
+  dsymm_(side, uplo, m, n, alpha, A, lda, B, ldb, beta, C, ldc);
+#else
+  cj_Kernel_symm(CJ_DOUBLE, cj_Kernel_upper(side), cj_Kernel_upper(uplo), *m, *n,
+      *alpha, (char *) A, *lda, (char *) B, *ldb, *beta, (char *) C, *ldc);
+#endif
+}
+
+void cj_Kernel_strsm (char *side, char *uplo, char *transa, char *diag, int *m, int *n, float *alpha,
+    float *A, int *lda, float *B, int *ldb) {
+#ifdef CJ_EXTERNAL_BLAS
+  strsm_(side, uplo, transa, diag, m, n, alpha, A, lda, B, ldb);
+#else
+  cj_Kernel_trsm(CJ_SINGLE, cj_Kernel_upper(side), cj_Kernel_upper(uplo), cj_Kernel_trans(transa),
+      cj_Kernel_upper(diag), *m, *n, *alpha, (char *) A, *lda, (char *) B, *ldb);
+#endif
+}
+
+void cj_Kernel_dtrsm (char *side, char *uplo, char *transa, char *diag, int *m, int *n, double *alpha,
+    double *A, int *lda, double *B, int *ldb) {
+#ifdef CJ_EXTERNAL_BLAS
+  dtrsm_(side, uplo, transa, diag, m, n, alpha, A, lda, B, ldb);
+#else
+  cj_Kernel_trsm(CJ_DOUBLE, cj_Kernel_upper(side), cj_Kernel_upper(uplo), cj_Kernel_trans(transa),
+      cj_Kernel_upper(diag), *m, *n, *alpha, (char *) A, *lda, (char *) B, *ldb);
+#endif
+}
+
+void cj_Kernel_strmm (char *side, char *uplo, char *transa, char *diag, int *m, int *n, float *alpha,
+    float *A, int *lda, float *B, int *ldb) {
+#ifdef CJ_EXTERNAL_BLAS
+  strmm_(side, uplo, transa, diag, m, n, alpha, A, lda, B, ldb);
+#else
+  cj_Kernel_trmm(CJ_SINGLE, cj_Kernel_upper(side), cj_Kernel_upper(uplo), cj_Kernel_trans(transa),
+      cj_Kernel_upper(diag), *m, *n, *alpha, (char *) A, *lda, (char *) B, *ldb);
+#endif
+}
+
+void cj_Kernel_dtrmm (char *side, char *uplo, char *transa, char *diag, int *m, int *n, double *alpha,
+    double *A, int *lda, double *B, int *ldb) {
+#ifdef CJ_EXTERNAL_BLAS
+  dtrmm_(side, uplo, transa, diag, m, n, alpha, A, lda, B, ldb);
+#else
+  cj_Kernel_trmm(CJ_DOUBLE, cj_Kernel_upper(side), cj_Kernel_upper(uplo), cj_Kernel_trans(transa),
+      cj_Kernel_upper(diag), *m, *n, *alpha, (char *) A, *lda, (char *) B, *ldb);
+#endif
+}
+
+void cj_Kernel_spotrf (char *uplo, int *n, float *A, int *lda, int *info) {
+#ifdef CJ_EXTERNAL_BLAS
+  spotrf_(uplo, n, A, lda, info);
+#else
+  *info = cj_Kernel_potrf(CJ_SINGLE, cj_Kernel_upper(uplo), *n, (char *) A, *lda);
+#endif
+}
+
+void cj_Kernel_dpotrf (char *uplo, int *n, double *A, int *lda, int *info) {
+#ifdef CJ_EXTERNAL_BLAS
+  dpotrf_(uplo, n, A, lda, info);
+#else
+  *info = cj_Kernel_potrf(CJ_DOUBLE, cj_Kernel_upper(uplo), *n, (char *) A, *lda);
+#endif
+}
+
+/* L^(-1) in place for the lower triangle of A, as LAPACK trtri; the built-in kernel
+ * only takes uplo "L". */
+void cj_Kernel_strtri (char *uplo, char *diag, int *n, float *A, int *lda, int *info) {
+#ifdef CJ_EXTERNAL_BLAS
+  strtri_(uplo, diag, n, A, lda, info);
+#else
+  if (cj_Kernel_upper(uplo) != 'L') cj_Kernel_error("strtri", "only the lower triangle is supported.");
+  *info = cj_Kernel_trtri(CJ_SINGLE, cj_Kernel_upper(diag), *n, (char *) A, *lda);
+#endif
+}
+
+void cj_Kernel_dtrtri (char *uplo, char *diag, int *n, double *A, int *lda, int *info) {
+#ifdef CJ_EXTERNAL_BLAS
+  dtrtri_(uplo, diag, n, A, lda, info);
+#else
+  if (cj_Kernel_upper(uplo) != 'L') cj_Kernel_error("dtrtri", "only the lower triangle is supported.");
+  *info = cj_Kernel_trtri(CJ_DOUBLE, cj_Kernel_upper(diag), *n, (char *) A, *lda);
+#endif
+}
+
+/* A:= L' * L in place on the lower triangle of A, as LAPACK lauum with uplo "L". */
+void cj_Kernel_slauum (char *uplo, int *n, float *A, int *lda, int *info) {
+#ifdef CJ_EXTERNAL_BLAS
+  slauum_(uplo, n, A, lda, info);
+#else
+  if (cj_Kernel_upper(uplo) != 'L') cj_Kernel_error("slauum", "only the lower triangle is supported.");
+  cj_Kernel_lauum(CJ_SINGLE, *n, (char *) A, *lda);
+  *info = 0;
+#endif
+}
+
+void cj_Kernel_dlauum (char *uplo, int *n, double *A, int *lda, int *info) {
+#ifdef CJ_EXTERNAL_BLAS
+  dlauum_(uplo, n, A, lda, info);
+#else
+  if (cj_Kernel_upper(uplo) != 'L') cj_Kernel_error("dlauum", "only the lower triangle is supported.");
+  cj_Kernel_lauum(CJ_DOUBLE, *n, (char *) A, *lda);
+  *info = 0;
+#endif
+}
+
+/* A = P * L * U with partial pivoting, as LAPACK getrf. */
+void cj_Kernel_sgetrf (int *m, int *n, float *A, int *lda, int *ipiv, int *info) {
+#ifdef CJ_EXTERNAL_BLAS
+  sgetrf_(m, n, A, lda, ipiv, info);
+#else
+  *info = cj_Kernel_getrf(CJ_SINGLE, *m, *n, (char *) A, *lda, ipiv);
+#endif
+}
+
+void cj_Kernel_dgetrf (int *m, int *n, double *A, int *lda, int *ipiv, int *info) {
+#ifdef CJ_EXTERNAL_BLAS
+  dgetrf_(m, n, A, lda, ipiv, info);
+#else
+  *info = cj_Kernel_getrf(CJ_DOUBLE, *m, *n, (char *) A, *lda, ipiv);
+#endif
+}
+
+/* A:= L^(-1) * P' * A, L and ipiv from the getrf of an m x m tile, A: m x n. */
+void cj_Kernel_sgessm (int *m, int *n, int *ipiv, float *L, int *ldl, float *A, int *lda) {
+#ifdef CJ_EXTERNAL_BLAS
+  int one = 1;
+  float f_one = 1.0;
+  slaswp_(n, A, lda, &one, m, ipiv, &one);
+  strsm_("L", "L", "N", "U", m, n, &f_one, L, ldl, A, lda);
+#else
+  cj_Kernel_gessm(CJ_SINGLE, *m, *n, ipiv, (char *) L, *ldl, (char *) A, *lda);
+#endif
+}
+
+void cj_Kernel_dgessm (int *m, int *n, int *ipiv, double *L, int *ldl, double *A, int *lda) {
+#ifdef CJ_EXTERNAL_BLAS
+  int one = 1;
+  double d_one = 1.0;
+  dlaswp_(n, A, lda, &one, m, ipiv, &one);
+  dtrsm_("L", "L", "N", "U", m, n, &d_one, L, ldl, A, lda);
+#else
+  cj_Kernel_gessm(CJ_DOUBLE, *m, *n, ipiv, (char *) L, *ldl, (char *) A, *lda);
+#endif
+}
+
+/* Pairwise pivoted LU of the n x n upper U over the m x n A, see CJ_KERNEL_TSTRF. */
+void cj_Kernel_ststrf (int *m, int *n, float *U, int *ldu, float *A, int *lda, int *ipiv, int *info) {
+  *info = cj_Kernel_ststrf_pair(*m, *n, U, *ldu, A, *lda, ipiv);
+}
+
+void cj_Kernel_dtstrf (int *m, int *n, double *U, int *ldu, double *A, int *lda, int *ipiv, int *info) {
+  *info = cj_Kernel_dtstrf_pair(*m, *n, U, *ldu, A, *lda, ipiv);
+}
+
+/* Rows 0:k of A1 (k x n) and A2 (m x n) by the tstrf that left L (m x k) and ipiv. */
+void cj_Kernel_sssssm (int *m, int *n, int *k, float *A1, int *lda1, float *A2, int *lda2,
+    float *L, int *ldl, int *ipiv) {
+  cj_Kernel_ssssm(CJ_SINGLE, *m, *n, *k, (char *) A1, *lda1, (char *) A2, *lda2, (char *) L, *ldl, ipiv);
+}
+
+void cj_Kernel_dssssm (int *m, int *n, int *k, double *A1, int *lda1, double *A2, int *lda2,
+    double *L, int *ldl, int *ipiv) {
+  cj_Kernel_ssssm(CJ_DOUBLE, *m, *n, *k, (char *) A1, *lda1, (char *) A2, *lda2, (char *) L, *ldl, ipiv);
+}
+
+/* A = Q * R, Q = I - V * T * V' with V unit lower under R and T upper min(m, n)
+ * square, as LAPACK geqrt with one block. */
+void cj_Kernel_sgeqrt (int *m, int *n, float *A, int *lda, float *T, int *ldt) {
+#ifdef CJ_EXTERNAL_BLAS
+  int k = min(*m, *n), info;
+  if (k <= 0) return;
+  sgeqrt_(m, n, &k, A, lda, T, ldt, (float *) cj_Kernel_buff(2, (size_t) k*(*n)*sizeof(float)), &info);
+#else
+  cj_Kernel_geqrt(CJ_SINGLE, *m, *n, (char *) A, *lda, (char *) T, *ldt);
+#endif
+}
+
+void cj_Kernel_dgeqrt (int *m, int *n, double *A, int *lda, double *T, int *ldt) {
+#ifdef CJ_EXTERNAL_BLAS
+  int k = min(*m, *n), info;
+  if (k <= 0) return;
+  dgeqrt_(m, n, &k, A, lda, T, ldt, (double *) cj_Kernel_buff(2, (size_t) k*(*n)*sizeof(double)), &info);
+#else
+  cj_Kernel_geqrt(CJ_DOUBLE, *m, *n, (char *) A, *lda, (char *) T, *ldt);
+#endif
+}
+
+/* C:= Q * C or Q' * C with the k reflectors of a geqrt in V and T, C: m x n. */
+void cj_Kernel_sgemqrt (char *trans, int *m, int *n, int *k, float *V, int *ldv, float *T, int *ldt,
+    float *C, int *ldc) {
+#ifdef CJ_EXTERNAL_BLAS
+  int info;
+  if (*k <= 0) return;
+  sgemqrt_("L", trans, m, n, k, k, V, ldv, T, ldt, C, ldc,
+      (float *) cj_Kernel_buff(2, (size_t) (*k)*(*n)*sizeof(float)), &info);
+#else
+  cj_Kernel_larfb(CJ_SINGLE, cj_Kernel_trans(trans), *m, *n, *k, (char *) V, *ldv, (char *) T, *ldt,
+      (char *) C, *ldc);
+#endif
+}
+
+void cj_Kernel_dgemqrt (char *trans, int *m, int *n, int *k, double *V, int *ldv, double *T, int *ldt,
+    double *C, int *ldc) {
+#ifdef CJ_EXTERNAL_BLAS
+  int info;
+  if (*k <= 0) return;
+  dgemqrt_("L", trans, m, n, k, k, V, ldv, T, ldt, C, ldc,
+      (double *) cj_Kernel_buff(2, (size_t) (*k)*(*n)*sizeof(double)), &info);
+#else
+  cj_Kernel_larfb(CJ_DOUBLE, cj_Kernel_trans(trans), *m, *n, *k, (char *) V, *ldv, (char *) T, *ldt,
+      (char *) C, *ldc);
+#endif
+}
+
+/* QR of the n x n upper A over the m x n B whose last l rows are upper trapezoidal,
+ * as LAPACK tpqrt with one block: R over A, V over the pentagon of B. */
+void cj_Kernel_stpqrt (int *m, int *n, int *l, float *A, int *lda, float *B, int *ldb, float *T, int *ldt) {
+#ifdef CJ_EXTERNAL_BLAS
+  int info;
+  if (*n <= 0) return;
+  stpqrt_(m, n, l, n, A, lda, B, ldb, T, ldt, (float *) cj_Kernel_buff(2, (size_t) (*n)*(*n)*sizeof(float)), &info);
+#else
+  cj_Kernel_tpqrt(CJ_SINGLE, *m, *n, *l, (char *) A, *lda, (char *) B, *ldb, (char *) T, *ldt);
+#endif
+}
+
+void cj_Kernel_dtpqrt (int *m, int *n, int *l, double *A, int *lda, double *B, int *ldb, double *T, int *ldt) {
+#ifdef CJ_EXTERNAL_BLAS
+  int info;
+  if (*n <= 0) return;
+  dtpqrt_(m, n, l, n, A, lda, B, ldb, T, ldt, (double *) cj_Kernel_buff(2, (size_t) (*n)*(*n)*sizeof(double)), &info);
+#else
+  cj_Kernel_tpqrt(CJ_DOUBLE, *m, *n, *l, (char *) A, *lda, (char *) B, *ldb, (char *) T, *ldt);
+#endif
+}
+
+/* [A; B]:= Q * [A; B] or Q' * [A; B] with the k reflectors of a tpqrt in V (m x k)
+ * and T, A: k x n, B: m x n. */
+void cj_Kernel_stpmqrt (char *trans, int *m, int *n, int *k, int *l, float *V, int *ldv, float *T, int *ldt,
+    float *A, int *lda, float *B, int *ldb) {
+#ifdef CJ_EXTERNAL_BLAS
+  int info;
+  if (*k <= 0) return;
+  stpmqrt_("L", trans, m, n, k, l, k, V, ldv, T, ldt, A, lda, B, ldb,
+      (float *) cj_Kernel_buff(2, (size_t) (*k)*(*n)*sizeof(float)), &info);
+#else
+  cj_Kernel_tpmqrt(CJ_SINGLE, cj_Kernel_trans(trans), *m, *n, *k, *l, (char *) V, *ldv, (char *) T, *ldt,
+      (char *) A, *lda, (char *) B, *ldb);
+#endif
+}
+
+void cj_Kernel_dtpmqrt (char *trans, int *m, int *n, int *k, int *l, double *V, int *ldv, double *T, int *ldt,
+    double *A, int *lda, double *B, int *ldb) {
+#ifdef CJ_EXTERNAL_BLAS
+  int info;
+  if (*k <= 0) return;
+  dtpmqrt_("L", trans, m, n, k, l, k, V, ldv, T, ldt, A, lda, B, ldb,
+      (double *) cj_Kernel_buff(2, (size_t) (*k)*(*n)*sizeof(double)), &info);
+#else
+  cj_Kernel_tpmqrt(CJ_DOUBLE, cj_Kernel_trans(trans), *m, *n, *k, *l, (char *) V, *ldv, (char *) T, *ldt,
+      (char *) A, *lda, (char *) B, *ldb);
+#endif
+}
+
+/* A = L * D * L' without pivoting on the lower triangle, see CJ_KERNEL_SYTRF_UNB. */
+void cj_Kernel_ssytrf_nopiv (int *n, float *A, int *lda, int *info) {
+  *info = cj_Kernel_sytrf_nopiv(CJ_SINGLE, *n, (char *) A, *lda);
+}
+
+void cj_Kernel_dsytrf_nopiv (int *n, double *A, int *lda, int *info) {
+  *info = cj_Kernel_sytrf_nopiv(CJ_DOUBLE, *n, (char *) A, *lda);
+}
+
+/* A:= A * L^(-T) * D^(-1) for the m x n A and the n x n factors of a sytrf_nopiv in L. */
+void cj_Kernel_strsmd (int *m, int *n, float *L, int *ldl, float *A, int *lda) {
+  cj_Kernel_trsmd(CJ_SINGLE, *m, *n, (char *) L, *ldl, (char *) A, *lda);
+}
+
+void cj_Kernel_dtrsmd (int *m, int *n, double *L, int *ldl, double *A, int *lda) {
+  cj_Kernel_trsmd(CJ_DOUBLE, *m, *n, (char *) L, *ldl, (char *) A, *lda);
+}
+
+/* C:= C - A * D * B', A m x k, B n x k, D k entries incd apart. With uplo "L" C is
+ * square, B = A and only the lower triangle of C is updated. */
+void cj_Kernel_sgemdm (char *uplo, int *m, int *n, int *k, float *A, int *lda, float *D, int *incd,
+    float *B, int *ldb, float *C, int *ldc) {
+  cj_Kernel_gemdm(CJ_SINGLE, (*uplo == 'L' || *uplo == 'l') ? 'L' : 'F', *m, *n, *k, (char *) A, *lda,
+      (char *) D, *incd, (char *) B, *ldb, (char *) C, *ldc);
+}
+
+void cj_Kernel_dgemdm (char *uplo, int *m, int *n, int *k, double *A, int *lda, double *D, int *incd,
+    double *B, int *ldb, double *C, int *ldc) {
+  cj_Kernel_gemdm(CJ_DOUBLE, (*uplo == 'L' || *uplo == 'l') ? 'L' : 'F', *m, *n, *k, (char *) A, *lda,
+      (char *) D, *incd, (char *) B, *ldb, (char *) C, *ldc);
+}
@@ -5,6 +5,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <math.h>
+#include <float.h>
 
 #ifdef CJ_HAVE_CUDA
 #include <cuda_runtime_api.h>
@@ -28,25 +30,35 @@ int get_dpotrf_nb (int n) {
 }
 
 #ifdef CJ_HAVE_CUDA
-void hybrid_dpotrf (cublasHandle_t *handle, int n, double *dA, int ldda, int *info) {
+/* Bytes of pinned workspace needed by hybrid_dpotrf for an n x n matrix. */
+size_t hybrid_dpotrf_lwork (int n) {
+  int nb = get_dpotrf_nb(n);
+  if (nb > n) nb = n;
+  return (size_t) nb*nb*sizeof(double);
+}
+
+/* work is pinned host memory of hybrid_dpotrf_lwork(n) bytes. */
+void hybrid_dpotrf (cublasHandle_t *handle, int n, double *dA, int ldda, double *work, int *info) {
   int	   j, jb, nb;
   double f_one  = 1.0, f_mone = -1.0;
-  double *work;
 
   cublasStatus_t status;
 
   *info = 0;
 
-  cudaStream_t stream[2];
-  cudaStreamCreate(&stream[0]);
-  cudaStreamCreate(&stream[1]);
+  /* Copies go on the stream of the task, behind the kernels issued there. 
+   * The host only waits for the panel copy, the trailing GEMM issued after
+   * it runs meanwhile. */
+  cudaStream_t stream;
+  cudaEvent_t  panel;
+  cublasGetStream(*handle, &stream);
+  cudaEventCreateWithFlags(&panel, cudaEventDisableTiming);
 
   nb = get_dpotrf_nb(n);
-  cudaMallocHost((void**)&work, nb*nb*sizeof(double));
 
   if ((nb <= 1) || (nb >= n)) {
     cublasGetMatrix(n, n, sizeof(double), dA, ldda, work, n);
-    dpotrf("L", &n, work, &n, info);
+    cj_Kernel_dpotrf("L", &n, work, &n, info);
     cublasSetMatrix(n, n, sizeof(double), work, n, dA, ldda);
   } 
   else {
@@ -56,32 +68,31 @@ void hybrid_dpotrf (cublasHandle_t *handle, int n, double *dA, int ldda, int *in
       status = cublasDsyrk(*handle, CUBLAS_FILL_MODE_LOWER, CUBLAS_OP_N, 
           jb, j, &f_mone, dA(j,0), ldda, &f_one, dA(j,j), ldda);
       cudaMemcpy2DAsync(work, jb*sizeof(double), dA(j,j), ldda*sizeof(double),
-          sizeof(double)*jb, jb, cudaMemcpyDeviceToHost, stream[1]);
+          sizeof(double)*jb, jb, cudaMemcpyDeviceToHost, stream);
+      cudaEventRecord(panel, stream);
 
       if ((j + jb) < n) {
 			  status = cublasDgemm(*handle, CUBLAS_OP_N, CUBLAS_OP_T, 
             (n - j - jb), jb, j, &f_mone, dA(j+jb,0), ldda, 
 						dA(j,0), ldda, &f_one, dA(j+jb,j), ldda);
       }
-      cudaStreamSynchronize(stream[1]);
-      dpotrf("L", &jb, work, &jb, info);
+      cudaEventSynchronize(panel);
+      cj_Kernel_dpotrf("L", &jb, work, &jb, info);
       if (*info != 0) {
         *info = *info + j;
         break;
       }
       cudaMemcpy2DAsync(dA(j,j), ldda*sizeof(double), work, jb*sizeof(double),
-          sizeof(double)*jb, jb, cudaMemcpyHostToDevice, stream[0]);
+          sizeof(double)*jb, jb, cudaMemcpyHostToDevice, stream);
 
       if ( (j + jb) < n) {
         status = cublasDtrsm(*handle, CUBLAS_SIDE_RIGHT, CUBLAS_FILL_MODE_LOWER, CUBLAS_OP_T, CUBLAS_DIAG_NON_UNIT, 
             (n - j - jb), jb, &f_one, dA(j,j), ldda, dA(j+jb,j), ldda); 
       }
     }
-  }
-  cudaStreamDestroy(stream[0]);
-  cudaStreamDestroy(stream[1]);
-
-  cudaFreeHost(work);
+  }  /* The workspace is reused by the next call. */
+  cudaStreamSynchronize(stream);
+  cudaEventDestroy(panel);
 };
 #endif
 
@@ -90,49 +101,51 @@ void cj_Chol_l_task_function (void *task_ptr) {
   cj_Worker *worker = task->worker;
   cj_devType devtype = worker->devtype;
   int device_id = worker->device_id;
-  int dest = device_id + 1;
+  int lda;
 
   cj_Object *A;
   cj_Matrix *a;
+  char *a_ptr;
   A = task->arg->dqueue->head;
   a = A->matrix;
+  a_ptr = cj_Worker_get_buff(worker, a, &lda);
 
   if (device_id != -1 && devtype == CJ_DEV_CUDA) {
 #ifdef CJ_HAVE_CUDA
     cudaSetDevice(device_id);
     cj_Device *device = worker->cj_ptr->device[device_id];
-    cj_Cache *cache = &(device->cache);
-    cublasHandle_t *handle = &(device->handle);
-    cj_Distribution *dist_a = a->base->dist[a->offm/BLOCK_SIZE][a->offn/BLOCK_SIZE];
-    if (dist_a->avail[dest] != TRUE) {
-      cj_Blas_error("cj_Chol_l_task_function", "No propriate distribution.");
-    }
 
     if (a->eletype == CJ_SINGLE) { 
-      float f_one = 1.0, f_mone = -1.0;
-      float *a_buff = (float *) cache->dev_ptr[dist_a->line[dest]];
+      int info;
+      float *a_buff = (float *) a_ptr;
+      /* The tile is factored on the host, behind the kernels of the task stream. */
+      cudaStream_t stream;
+      cublasGetStream(device->handle, &stream);
+      cudaStreamSynchronize(stream);
+      float *work = (float *) cj_Device_workspace(device, (size_t) a->m*a->m*sizeof(float));
+      cublasGetMatrix(a->m, a->m, sizeof(float), a_buff, lda, work, a->m);
+      cj_Kernel_spotrf("L", &(a->m), work, &(a->m), &info);
+      cublasSetMatrix(a->m, a->m, sizeof(float), work, a->m, a_buff, lda);
     }
     else {
-      double f_one = 1.0, f_mone = -1.0;
       int info;
-      double *a_buff = (double *) cache->dev_ptr[dist_a->line[dest]];
+      double *a_buff = (double *) a_ptr;
       cudaSetDevice(device->id);
-      hybrid_dpotrf (&device->handle, a->m, a_buff, BLOCK_SIZE, &info);
+      double *work = (double *) cj_Device_workspace(device, hybrid_dpotrf_lwork(a->m));
+      hybrid_dpotrf (&device->handle, a->m, a_buff, lda, work, &info);
     }
 #endif
   }
   else {
     if (a->eletype == CJ_SINGLE) {
-      float f_one = 1.0, f_mone = -1.0;
       int info = 0;
-      float *a_buff = (float *) (a->base->buff) + (a->base->m)*(a->offn) + a->offm;
-      spotrf_("L", &(a->m), a_buff, &(a->base->m), &info);
+      float *a_buff = (float *) a_ptr;
+      cj_Kernel_spotrf("L", &(a->m), a_buff, &lda, &info);
     }
     else {
-      double f_one = 1.0, f_mone = -1.0;
       int info = 0;
-      double *a_buff = (double *) (a->base->buff) + (a->base->m)*(a->offn) + a->offm;
-      dpotrf_("L", &(a->m), a_buff, &(a->base->m), &info);
+      double *a_buff = (double *) a_ptr;
+      cj_Kernel_dpotrf("L", &(a->m), a_buff, &lda, &info);
     }
   }
 
@@ -234,7 +247,9 @@ void cj_Chol_l_task(cj_Object *A) {
 //}
 
 
-void cj_Chol_l_blk_var3(cj_Object *A )
+/* A11 -> L11 * L11' for the leading k columns of A, with A21:= A21 * L11^(-T) and
+ * A22:= A22 - A21 * A21', the Schur complement; k = n factors all of A. */
+void cj_Chol_l_blk_var3(cj_Object *A, int k)
 {
   cj_Object *ATL,   *ATR,      *A00, *A01, *A02, 
             *ABL,   *ABR,      *A10, *A11, *A12,
@@ -256,9 +271,9 @@ void cj_Chol_l_blk_var3(cj_Object *A )
   cj_Matrix_part_2x2( A,    ATL, ATR,
                             ABL, ABR,     0, 0, CJ_TL );
 
-  while ( ATL->matrix->m  < A->matrix->m ){
+  while ( ATL->matrix->m  < k ){
 
-	b = min(ABR->matrix->m, BLOCK_SIZE);
+	b = min(k - ATL->matrix->m, BLOCK_SIZE);
 
     cj_Matrix_repart_2x2_to_3x3( ATL, /**/ ATR,       A00, /**/ A01, A02,
                               /* ************* */   /* ******************** */
@@ -309,9 +324,1952 @@ void cj_Chol_l (cj_Object *A) {
     cj_Lapack_error("chol", "matrice is not a square matrix.");
 
   cj_Queue_end();
-  cj_Chol_l_blk_var3(A);
+  cj_Chol_l_blk_var3(A, a->m);
+  cj_Queue_begin();
+}
+
+/**
+ * @brief  Partial Cholesky of the leading k columns of A = [A11, A21'; A21, A22]:
+ *         A11 -> L11 * L11', A21:= A21 * L11^(-T) = L21 and the Schur complement
+ *         A22:= A22 - L21 * L21' left in place, as the first k columns of
+ *         cj_Chol_l. A22 is updated by tile tasks, so work submitted on it,
+ *         for instance cj_Chol_l on a view of A22, starts on each tile as its
+ *         update is done. Only the lower triangle of A is referenced.
+ * @param  *A symmetric matrix or view starting on a tile, n x n
+ * @param  k columns to factor, a multiple of BLOCK_SIZE or n, so that A22
+ *         starts on a tile
+ */
+void cj_Chol_l_partial (cj_Object *A, int k) {
+  cj_Matrix *a;
+  if (!A) 
+    cj_Lapack_error("chol_partial", "matrice hasn't been initialized yet.");
+  if (!A->matrix)
+    cj_Lapack_error("chol_partial", "Object types are not matrix type.");
+  a = A->matrix;
+  if ((a->m != a->n)) 
+    cj_Lapack_error("chol_partial", "matrice is not a square matrix.");
+  if (k < 0 || k > a->m || (k % BLOCK_SIZE && k != a->m))
+    cj_Lapack_error("chol_partial", "k is not a multiple of BLOCK_SIZE within A.");
+  if (a->offm % BLOCK_SIZE || a->offn % BLOCK_SIZE)
+    cj_Lapack_error("chol_partial", "A does not start on a tile.");
+
+  cj_Queue_end();
+  cj_Chol_l_blk_var3(A, k);
+  cj_Queue_begin();
+}
+
+/* Run an LU tile kernel on host copies of its arguments, leading dimensions in ldx. */
+static void cj_Lu_host (cj_Task *task, cj_Matrix **x, char **x_ptr, int *ldx) {
+  int info, *ipiv = (int *) task->t;
+
+  if (x[0]->eletype == CJ_SINGLE) {
+    if (task->tasktype == CJ_TASK_GETRF)
+      cj_Kernel_sgetrf(&(x[0]->m), &(x[0]->n), (float *) x_ptr[0], &ldx[0], ipiv, &info);
+    else if (task->tasktype == CJ_TASK_GESSM)
+      cj_Kernel_sgessm(&(x[1]->m), &(x[1]->n), ipiv, (float *) x_ptr[0], &ldx[0], (float *) x_ptr[1], &ldx[1]);
+    else if (task->tasktype == CJ_TASK_TSTRF)
+      cj_Kernel_ststrf(&(x[1]->m), &(x[1]->n), (float *) x_ptr[0], &ldx[0], (float *) x_ptr[1], &ldx[1], ipiv, &info);
+    else
+      cj_Kernel_sssssm(&(x[2]->m), &(x[2]->n), &(x[0]->n), (float *) x_ptr[1], &ldx[1], (float *) x_ptr[2], &ldx[2], 
+          (float *) x_ptr[0], &ldx[0], ipiv);
+  }
+  else {
+    if (task->tasktype == CJ_TASK_GETRF)
+      cj_Kernel_dgetrf(&(x[0]->m), &(x[0]->n), (double *) x_ptr[0], &ldx[0], ipiv, &info);
+    else if (task->tasktype == CJ_TASK_GESSM)
+      cj_Kernel_dgessm(&(x[1]->m), &(x[1]->n), ipiv, (double *) x_ptr[0], &ldx[0], (double *) x_ptr[1], &ldx[1]);
+    else if (task->tasktype == CJ_TASK_TSTRF)
+      cj_Kernel_dtstrf(&(x[1]->m), &(x[1]->n), (double *) x_ptr[0], &ldx[0], (double *) x_ptr[1], &ldx[1], ipiv, &info);
+    else
+      cj_Kernel_dssssm(&(x[2]->m), &(x[2]->n), &(x[0]->n), (double *) x_ptr[1], &ldx[1], (double *) x_ptr[2], &ldx[2], 
+          (double *) x_ptr[0], &ldx[0], ipiv);
+  }
+}
+
+/* Run the kernel of a task on host copies of its tile arguments, through host
+ * with the leading dimensions in ldx. cuBLAS has no pivoted LU nor compact WY QR,
+ * so on a CUDA worker the tiles are staged through the device workspace behind
+ * the kernels of the task stream, and the RW ones are copied back. */
+static void cj_Lapack_host_kernel (cj_Task *task, void (*host)(cj_Task*, cj_Matrix**, char**, int*)) {
+  cj_Worker *worker = task->worker;
+  cj_devType devtype = worker->devtype;
+  int device_id = worker->device_id;
+  int ldx[4], narg = 0;
+
+  cj_Object *X;
+  cj_Matrix *x[4];
+  char *x_ptr[4];
+  for (X = task->arg->dqueue->head; X; X = X->next) {
+    x[narg] = X->matrix;
+    x_ptr[narg] = cj_Worker_get_buff(worker, x[narg], &ldx[narg]);
+    narg ++;
+  }
+
+  if (device_id != -1 && devtype == CJ_DEV_CUDA) {
+#ifdef CJ_HAVE_CUDA
+    cudaSetDevice(device_id);
+    cj_Device *device = worker->cj_ptr->device[device_id];
+    size_t tile = (size_t) BLOCK_SIZE*BLOCK_SIZE*x[0]->elelen;
+    char *dev_ptr[4], *work;
+    int dev_ld[4], i;
+    cudaStream_t stream;
+    cublasGetStream(device->handle, &stream);
+    cudaStreamSynchronize(stream);
+    work = cj_Device_workspace(device, narg*tile);
+    for (i = 0; i < narg; i++) {
+      dev_ptr[i] = x_ptr[i]; dev_ld[i] = ldx[i];
+      x_ptr[i] = work + i*tile; ldx[i] = x[i]->m;
+      cublasGetMatrix(x[i]->m, x[i]->n, x[i]->elelen, dev_ptr[i], dev_ld[i], x_ptr[i], ldx[i]);
+    }
+    (*host)(task, x, x_ptr, ldx);
+    for (i = 0, X = task->arg->dqueue->head; i < narg; i++, X = X->next) {
+      if (X->rwtype == CJ_RW)
+        cublasSetMatrix(x[i]->m, x[i]->n, x[i]->elelen, x_ptr[i], ldx[i], dev_ptr[i], dev_ld[i]);
+    }
+#endif
+  }
+  else {
+    (*host)(task, x, x_ptr, ldx);
+  }
+
+  fprintf(stderr, YELLOW "  Worker_execute %d (%d, %s), A(%d, %d), B(%d, %d): \n" NONE, 
+      task->worker->id, task->id, task->name,
+      x[0]->offm/BLOCK_SIZE, x[0]->offn/BLOCK_SIZE,
+      x[narg - 1]->offm/BLOCK_SIZE, x[narg - 1]->offn/BLOCK_SIZE);
+}
+
+/* The task function of all the tile tasks run by cj_Lapack_host_kernel, with the
+ * host function of the task. */
+void cj_Lapack_task_function (void *task_ptr) {
+  cj_Task *task = (cj_Task *) task_ptr;
+  cj_Lapack_host_kernel(task, task->host);
+}
+
+/* One tile task running host on the narg tiles X (at most 4), those of the bits
+ * set in rw written and the others read, with the integer arguments iarg (4 of
+ * them, or NULL) and t, ldt as in cj_Task. When t is written by a task and read
+ * by later ones, the tiles they share order them. */
+static void cj_Lapack_task (cj_taskType tasktype, void (*host)(cj_Task*, cj_Matrix**, char**, int*), const char *name,
+    const int *iarg, char *t, int ldt, cj_Object **X, int rw, int narg) {
+  cj_Object *copy, *arg, *task;
+  int i;
+
+  task = cj_Object_new(CJ_TASK);
+  cj_Task_set(task->task, tasktype, &cj_Lapack_task_function);
+  task->task->host = host;
+  for (i = 0; i < 4; i++) task->task->iarg[i] = iarg ? iarg[i] : 0;
+  task->task->t = t;
+  task->task->ldt = ldt;
+
+  for (i = 0; i < narg; i++) {
+    copy = cj_Object_new(CJ_MATRIX);
+    cj_Matrix_duplicate(X[i], copy);
+    arg = cj_Object_append(CJ_MATRIX, copy->matrix);
+    arg->rwtype = (rw & (1 << i)) ? CJ_RW : CJ_R;
+    cj_Dqueue_push_tail(task->task->arg, arg);
+  }
+
+  /* Setup task name. */
+  snprintf(task->task->name,  64, "%s%d", name, task->task->id);
+  snprintf(task->task->label, 64, "%s(A%d%d,A%d%d)", name,
+      X[0]->matrix->offm/BLOCK_SIZE, X[0]->matrix->offn/BLOCK_SIZE,
+      X[narg - 1]->matrix->offm/BLOCK_SIZE, X[narg - 1]->matrix->offn/BLOCK_SIZE);
+
+  cj_Task_dependency_analysis(task);
+}
+
+/* One task of the tiled LU on the tiles A, B and C (B and C may be NULL), chosen
+ * by the task type, with the pivots ipiv:
+ *   GETRF: A11 = P * L * U
+ *   GESSM: A12:= L11^(-1) * P' * A12, with the L11 and pivots of a GETRF
+ *   TSTRF: [U11; A21] = P * [L; L21] * U11, pairwise pivoting, L21 over A21
+ *   SSSSM: [A12; A22]:= the transformations of a TSTRF, with its L21
+ * The pivots are written by GETRF and TSTRF with their RW tile and read by GESSM
+ * and SSSSM with that tile, so the tile dependencies order them too. */
+static void cj_Lu_task (cj_taskType tasktype, int *ipiv, cj_Object *A, cj_Object *B, cj_Object *C) {
+  cj_Object *X[3] = {A, B, C};
+  const char *name;
+  int narg = C ? 3 : (B ? 2 : 1);
+
+  if (tasktype == CJ_TASK_GETRF) name = "Getrf";
+  else if (tasktype == CJ_TASK_GESSM) name = "Gessm";
+  else if (tasktype == CJ_TASK_TSTRF) name = "Tstrf";
+  else name = "Ssssm";
+
+  /* The L of GESSM and SSSSM is only read. */
+  cj_Lapack_task(tasktype, &cj_Lu_host, name, NULL, (char *) ipiv, 0, X,
+      (tasktype == CJ_TASK_GESSM || tasktype == CJ_TASK_SSSSM) ? 6 : 7, narg);
+}
+
+/* Tiled LU with incremental (pairwise) pivoting. Step k factors the diagonal tile,
+ * applies it to the tile row, then eliminates the tiles below it one by one against
+ * the updated diagonal tile, each elimination updating its tile row. The tasks of a
+ * step on different tile columns are independent. */
+static void cj_Lu_tiles (cj_Object *A, int *ipiv) {
+  cj_Matrix *a = A->matrix;
+  cj_Object *Akk, *Akj, *Aik, *Aij;
+  int i, j, k, n = a->n;
+
+  Akk = cj_Object_new(CJ_MATRIX); Akj = cj_Object_new(CJ_MATRIX);
+  Aik = cj_Object_new(CJ_MATRIX); Aij = cj_Object_new(CJ_MATRIX);
+  cj_Matrix_duplicate(A, Akk); cj_Matrix_duplicate(A, Akj);
+  cj_Matrix_duplicate(A, Aik); cj_Matrix_duplicate(A, Aij);
+
+  for (k = 0; k < n; k += BLOCK_SIZE) {
+    cj_Matrix_tile(A, Akk, k, k);
+    cj_Lu_task(CJ_TASK_GETRF, ipiv + (size_t) k/BLOCK_SIZE*n + k, Akk, NULL, NULL);
+    for (j = k + BLOCK_SIZE; j < n; j += BLOCK_SIZE) {
+      cj_Matrix_tile(A, Akj, k, j);
+      cj_Lu_task(CJ_TASK_GESSM, ipiv + (size_t) k/BLOCK_SIZE*n + k, Akk, Akj, NULL);
+    }
+    for (i = k + BLOCK_SIZE; i < n; i += BLOCK_SIZE) {
+      cj_Matrix_tile(A, Aik, i, k);
+      cj_Lu_task(CJ_TASK_TSTRF, ipiv + (size_t) i/BLOCK_SIZE*n + k, Akk, Aik, NULL);
+      for (j = k + BLOCK_SIZE; j < n; j += BLOCK_SIZE) {
+        cj_Matrix_tile(A, Akj, k, j);
+        cj_Matrix_tile(A, Aij, i, j);
+        cj_Lu_task(CJ_TASK_SSSSM, ipiv + (size_t) i/BLOCK_SIZE*n + k, Aik, Akj, Aij);
+      }
+    }
+  }
+}
+
+static void cj_Lu_check (const char *func_name, cj_Object *A, int *ipiv) {
+  if (!A || !ipiv) 
+    cj_Lapack_error(func_name, "matrice or pivots haven't been initialized yet.");
+  if (A->objtype != CJ_MATRIX)
+    cj_Lapack_error(func_name, "Object types are not matrix type.");
+  if (A->matrix->m != A->matrix->n) 
+    cj_Lapack_error(func_name, "matrice is not a square matrix.");
+}
+
+/**
+ * @brief  A -> L U with incremental pivoting on tiles. The diagonal tiles are
+ *         factored with partial pivoting and every tile below the diagonal is
+ *         eliminated against its diagonal tile with pivoting between the two,
+ *         so the tasks of a step are as parallel as the Cholesky ones. U is
+ *         left in the upper triangle of A, the multipliers below it. The
+ *         factors are only meant for cj_Lu_solve: L is not a single
+ *         triangular matrix and the pivots are not one permutation.
+ * @param  *A square matrix, n x n, overwritten by the factors
+ * @param  *ipiv pivots, ceil(n/BLOCK_SIZE)*n integers
+ */
+void cj_Lu (cj_Object *A, int *ipiv) {
+  cj_Lu_check("lu", A, ipiv);
+  if (A->matrix->m == 0) return;
+
+  cj_Queue_end();
+  cj_Lu_tiles(A, ipiv);
+  cj_Queue_begin();
+}
+
+/**
+ * @brief  Solve A X = B with the factors of cj_Lu: the transformations of the
+ *         factorization are replayed on every tile column of B in the order
+ *         they were made, then B is solved with U by cj_Trsm.
+ * @param  *A factors from cj_Lu, n x n
+ * @param  *ipiv pivots from cj_Lu
+ * @param  *B right-hand sides, n x k, overwritten by X
+ */
+void cj_Lu_solve (cj_Object *A, int *ipiv, cj_Object *B) {
+  cj_Object *Akk, *Aik, *Bkj, *Bij, *one;
+  int i, j, k, n;
+
+  cj_Lu_check("lu_solve", A, ipiv);
+  if (!B || B->objtype != CJ_MATRIX)
+    cj_Lapack_error("lu_solve", "right-hand sides are not a matrix.");
+  if (B->matrix->m != A->matrix->m) 
+    cj_Lapack_error("lu_solve", "matrices dimension aren't matched.");
+  n = A->matrix->n;
+  if (n == 0 || B->matrix->n == 0) return;
+
+  Akk = cj_Object_new(CJ_MATRIX); Aik = cj_Object_new(CJ_MATRIX);
+  Bkj = cj_Object_new(CJ_MATRIX); Bij = cj_Object_new(CJ_MATRIX);
+  cj_Matrix_duplicate(A, Akk); cj_Matrix_duplicate(A, Aik);
+  cj_Matrix_duplicate(B, Bkj); cj_Matrix_duplicate(B, Bij);
+
+  cj_Queue_end();
+  for (k = 0; k < n; k += BLOCK_SIZE) {
+    cj_Matrix_tile(A, Akk, k, k);
+    for (j = 0; j < B->matrix->n; j += BLOCK_SIZE) {
+      cj_Matrix_tile(B, Bkj, k, j);
+      cj_Lu_task(CJ_TASK_GESSM, ipiv + (size_t) k/BLOCK_SIZE*n + k, Akk, Bkj, NULL);
+      for (i = k + BLOCK_SIZE; i < n; i += BLOCK_SIZE) {
+        cj_Matrix_tile(A, Aik, i, k);
+        cj_Matrix_tile(B, Bij, i, j);
+        cj_Lu_task(CJ_TASK_SSSSM, ipiv + (size_t) i/BLOCK_SIZE*n + k, Aik, Bkj, Bij);
+      }
+    }
+  }
+  cj_Queue_begin();
+
+  /* B = U^(-1) * B */
+  one = cj_Object_new(CJ_CONSTANT);
+  cj_Constant_set(one, 1.0);
+  cj_Trsm(CJ_LEFT, CJ_UPPER, CJ_NOTRANS, CJ_NONUNIT, one, A, B);
+}
+
+/* Run a QR tile kernel on host copies of its arguments, ordered as cj_Qr_task
+ * pushes them. iarg[0] is 1 for the TT kernels, whose V is the upper trapezoid
+ * of a tile already reduced by a GEQRT. */
+static void cj_Qr_host (cj_Task *task, cj_Matrix **x, char **x_ptr, int *ldx) {
+  int k = min(x[0]->m, x[0]->n), m = x[0]->m, l = 0;
+  char *trans = task->iarg[1] ? "N" : "T";
+
+  if (task->tasktype == CJ_TASK_TPQRT || task->tasktype == CJ_TASK_TPMQRT) {
+    k = x[0]->n;
+    if (task->iarg[0]) m = l = min(x[0]->m, k);
+  }
+  if (x[0]->eletype == CJ_SINGLE) {
+    float *t = (float *) task->t;
+    if (task->tasktype == CJ_TASK_GEQRT)
+      cj_Kernel_sgeqrt(&(x[0]->m), &(x[0]->n), (float *) x_ptr[0], &ldx[0], t, &(task->ldt));
+    else if (task->tasktype == CJ_TASK_GEMQRT)
+      cj_Kernel_sgemqrt(trans, &(x[1]->m), &(x[1]->n), &k, (float *) x_ptr[0], &ldx[0], t, &(task->ldt),
+          (float *) x_ptr[1], &ldx[1]);
+    else if (task->tasktype == CJ_TASK_TPQRT)
+      cj_Kernel_stpqrt(&m, &k, &l, (float *) x_ptr[1], &ldx[1], (float *) x_ptr[0], &ldx[0], t, &(task->ldt));
+    else
+      cj_Kernel_stpmqrt(trans, &m, &(x[2]->n), &k, &l, (float *) x_ptr[0], &ldx[0], t, &(task->ldt),
+          (float *) x_ptr[1], &ldx[1], (float *) x_ptr[2], &ldx[2]);
+  }
+  else {
+    double *t = (double *) task->t;
+    if (task->tasktype == CJ_TASK_GEQRT)
+      cj_Kernel_dgeqrt(&(x[0]->m), &(x[0]->n), (double *) x_ptr[0], &ldx[0], t, &(task->ldt));
+    else if (task->tasktype == CJ_TASK_GEMQRT)
+      cj_Kernel_dgemqrt(trans, &(x[1]->m), &(x[1]->n), &k, (double *) x_ptr[0], &ldx[0], t, &(task->ldt),
+          (double *) x_ptr[1], &ldx[1]);
+    else if (task->tasktype == CJ_TASK_TPQRT)
+      cj_Kernel_dtpqrt(&m, &k, &l, (double *) x_ptr[1], &ldx[1], (double *) x_ptr[0], &ldx[0], t, &(task->ldt));
+    else
+      cj_Kernel_dtpmqrt(trans, &m, &(x[2]->n), &k, &l, (double *) x_ptr[0], &ldx[0], t, &(task->ldt),
+          (double *) x_ptr[1], &ldx[1], (double *) x_ptr[2], &ldx[2]);
+  }
+}
+
+/* One task of the tiled QR, chosen by the task type, T in t:
+ *   GEQRT:  A11 = Q * R, V and T of Q
+ *   GEMQRT: A12:= Q' * A12, with the V and T of a GEQRT
+ *   TPQRT:  [R11; A21] = Q * R11, V over A21, TS or TT
+ *   TPMQRT: [A12; A22]:= Q' * [A12; A22], with the V and T of a TPQRT
+ * The reflectors are held by the tile V, followed by the tiles the task updates, B
+ * and C (may be NULL): the R of a TPQRT is B, the tiles of a GEMQRT or TPMQRT are
+ * B and C. The T is written by GEQRT and TPQRT with their RW V and read by GEMQRT
+ * and TPMQRT with that tile, so the tile dependencies order it too. trans = 'N'
+ * has GEMQRT and TPMQRT apply Q rather than Q'. */
+static void cj_Qr_task (cj_taskType tasktype, int tt, char trans, char *t, int ldt, cj_Object *V, cj_Object *B, cj_Object *C) {
+  cj_Object *X[3] = {V, B, C};
+  int iarg[4] = {tt, trans == 'N', 0, 0}, narg = C ? 3 : (B ? 2 : 1);
+  const char *name;
+
+  if (tasktype == CJ_TASK_GEQRT) name = "Geqrt";
+  else if (tasktype == CJ_TASK_GEMQRT) name = "Gemqrt";
+  else if (tasktype == CJ_TASK_TPQRT) name = tt ? "Ttqrt" : "Tsqrt";
+  else name = tt ? "Ttmqrt" : "Tsmqrt";
+
+  /* The V of GEMQRT and TPMQRT is only read. */
+  cj_Lapack_task(tasktype, &cj_Qr_host, name, iarg, t, ldt, X,
+      (tasktype == CJ_TASK_GEMQRT || tasktype == CJ_TASK_TPMQRT) ? 6 : 7, narg);
+}
+
+/* T of the reflectors of tile (i, k) of A, from a GEQRT or TS kernel (tt = 0) or
+ * a TT kernel (tt = 1), with its leading dimension. */
+static char *cj_Qr_t (cj_Object *A, cj_Object *T, int i, int k, int tt, int *ldt) {
+  cj_Matrix *a = A->matrix, *t = T->matrix;
+  return cj_Matrix_addr(t->base, t->offm, t->offn + (2*(i/BLOCK_SIZE) + tt)*a->n + k, ldt);
+}
+
+/* Step k of the tiled QR on the tile rows k, k + BLOCK_SIZE, ... of A. The rows
+ * are cut into domains of h tiles, each domain is reduced to its first tile by a
+ * flat chain of TS kernels and the domain heads by a binary tree of TT kernels.
+ * With C = A the step factors tile column k and updates the columns on its right,
+ * otherwise it applies the Q' of the step to all of C. */
+static void cj_Qr_step (cj_Object *A, cj_Object *T, int k, int h, cj_Object *C) {
+  cj_Object *V, *R, *C1, *C2;
+  cj_Bool factor = (C == A) ? TRUE : FALSE;
+  int m = A->matrix->m, j0 = (factor == TRUE) ? k + BLOCK_SIZE : 0, d, i, j, s, ldt;
+  char *t;
+
+  V = cj_Object_new(CJ_MATRIX); R = cj_Object_new(CJ_MATRIX);
+  C1 = cj_Object_new(CJ_MATRIX); C2 = cj_Object_new(CJ_MATRIX);
+  cj_Matrix_duplicate(A, V); cj_Matrix_duplicate(A, R);
+  cj_Matrix_duplicate(C, C1); cj_Matrix_duplicate(C, C2);
+
+  for (d = k; d < m; d += h*BLOCK_SIZE) {
+    cj_Matrix_tile(A, V, d, k);
+    t = cj_Qr_t(A, T, d, k, 0, &ldt);
+    if (factor == TRUE) cj_Qr_task(CJ_TASK_GEQRT, 0, 'T', t, ldt, V, NULL, NULL);
+    for (j = j0; j < C->matrix->n; j += BLOCK_SIZE) {
+      cj_Matrix_tile(C, C1, d, j);
+      cj_Qr_task(CJ_TASK_GEMQRT, 0, 'T', t, ldt, V, C1, NULL);
+    }
+    cj_Matrix_tile(A, R, d, k);
+    for (i = d + BLOCK_SIZE; i < min(m, d + h*BLOCK_SIZE); i += BLOCK_SIZE) {
+      cj_Matrix_tile(A, V, i, k);
+      t = cj_Qr_t(A, T, i, k, 0, &ldt);
+      if (factor == TRUE) cj_Qr_task(CJ_TASK_TPQRT, 0, 'T', t, ldt, V, R, NULL);
+      for (j = j0; j < C->matrix->n; j += BLOCK_SIZE) {
+        cj_Matrix_tile(C, C1, d, j);
+        cj_Matrix_tile(C, C2, i, j);
+        cj_Qr_task(CJ_TASK_TPMQRT, 0, 'T', t, ldt, V, C1, C2);
+      }
+    }
+  }
+
+  for (s = h*BLOCK_SIZE; k + s < m; s *= 2) {
+    for (d = k; d + s < m; d += 2*s) {
+      cj_Matrix_tile(A, R, d, k);
+      cj_Matrix_tile(A, V, d + s, k);
+      t = cj_Qr_t(A, T, d + s, k, 1, &ldt);
+      if (factor == TRUE) cj_Qr_task(CJ_TASK_TPQRT, 1, 'T', t, ldt, V, R, NULL);
+      for (j = j0; j < C->matrix->n; j += BLOCK_SIZE) {
+        cj_Matrix_tile(C, C1, d, j);
+        cj_Matrix_tile(C, C2, d + s, j);
+        cj_Qr_task(CJ_TASK_TPMQRT, 1, 'T', t, ldt, V, C1, C2);
+      }
+    }
+  }
+}
+
+/* Domains are as many tiles high as A is wide: a square A is a single domain
+ * with a flat tree, a tall and skinny one is reduced in parallel. */
+static int cj_Qr_domain (cj_Object *A) {
+  return (A->matrix->n - 1)/BLOCK_SIZE + 1;
+}
+
+static void cj_Qr_check (const char *func_name, cj_Object *A, cj_Object *T) {
+  if (!A || !T) 
+    cj_Lapack_error(func_name, "matrices haven't been initialized yet.");
+  if (A->objtype != CJ_MATRIX || T->objtype != CJ_MATRIX)
+    cj_Lapack_error(func_name, "Object types are not matrix type.");
+  if (A->matrix->m < A->matrix->n) 
+    cj_Lapack_error(func_name, "matrice has more columns than rows.");
+}
+
+/**
+ * @brief  A -> Q R with Householder reflectors on tiles. Each tile column is
+ *         reduced by a GEQRT on the first tile of every domain of tile rows,
+ *         TS kernels eliminating the other tiles of a domain against its
+ *         first one, and TT kernels eliminating the first tiles of the
+ *         domains in a binary tree. Domains are as many tiles high as A is
+ *         wide, so a square A is reduced by a flat tree like the LU, while a
+ *         tall and skinny one gets a tree of parallel reductions. R is left
+ *         in the upper triangle of A, the reflectors below it and their T
+ *         factors in T, both only meant for cj_Qr_solve.
+ * @param  *A matrix, m x n with m >= n, overwritten by the factors
+ * @param  *T a new matrix object, set up here to min(BLOCK_SIZE, n) x
+ *         2*ceil(m/BLOCK_SIZE)*n, or such a matrix in column major order
+ */
+void cj_Qr (cj_Object *A, cj_Object *T) {
+  cj_Matrix *a, *t;
+  int k, h;
+
+  cj_Qr_check("qr", A, T);
+  a = A->matrix; t = T->matrix;
+  if (a->n == 0) return;
+  if (!t->buff) {
+    cj_Matrix_set_eletype(T, a->eletype);
+    cj_Matrix_set(T, min(BLOCK_SIZE, a->n), 2*((a->m - 1)/BLOCK_SIZE + 1)*a->n);
+  }
+  if (t->eletype != a->eletype || t->layout != CJ_LAYOUT_COLUMN || t->m < min(BLOCK_SIZE, a->n) || 
+      t->n < 2*((a->m - 1)/BLOCK_SIZE + 1)*a->n)
+    cj_Lapack_error("qr", "T does not fit the block reflectors of A.");
+
+  h = cj_Qr_domain(A);
+  cj_Queue_end();
+  for (k = 0; k < a->n; k += BLOCK_SIZE) cj_Qr_step(A, T, k, h, A);
+  cj_Queue_begin();
+}
+
+/**
+ * @brief  Solve the least squares problem min || A X - B || with the factors
+ *         of cj_Qr: the reflectors are applied to B in the order they were
+ *         made, giving Q' B, then the first n rows of Q' B are solved with R
+ *         by cj_Trsm. The rows of B below them are left with the residual
+ *         in the basis of Q.
+ * @param  *A factors from cj_Qr, m x n
+ * @param  *T block reflectors from cj_Qr
+ * @param  *B right-hand sides, m x k, overwritten by X in the first n rows
+ */
+void cj_Qr_solve (cj_Object *A, cj_Object *T, cj_Object *B) {
+  cj_Object *ATL, *ATR, *ABL, *ABR, *BT, *BB, *one;
+  int k, h;
+
+  cj_Qr_check("qr_solve", A, T);
+  if (!B || B->objtype != CJ_MATRIX)
+    cj_Lapack_error("qr_solve", "right-hand sides are not a matrix.");
+  if (B->matrix->m != A->matrix->m) 
+    cj_Lapack_error("qr_solve", "matrices dimension aren't matched.");
+  if (A->matrix->n == 0 || B->matrix->n == 0) return;
+
+  /* B = Q' * B */
+  h = cj_Qr_domain(A);
+  cj_Queue_end();
+  for (k = 0; k < A->matrix->n; k += BLOCK_SIZE) cj_Qr_step(A, T, k, h, B);
+  cj_Queue_begin();
+
+  /* BT = R^(-1) * BT */
+  ATL = cj_Object_new(CJ_MATRIX); ATR = cj_Object_new(CJ_MATRIX);
+  ABL = cj_Object_new(CJ_MATRIX); ABR = cj_Object_new(CJ_MATRIX);
+  BT = cj_Object_new(CJ_MATRIX); BB = cj_Object_new(CJ_MATRIX);
+  cj_Matrix_duplicate(A, ATL); cj_Matrix_duplicate(B, BT);
+  cj_Matrix_part_2x2(A, ATL, ATR,
+                        ABL, ABR,     A->matrix->n, A->matrix->n, CJ_TL);
+  cj_Matrix_part_2x1(B, BT,
+                        BB,     A->matrix->n, CJ_TOP);
+  one = cj_Object_new(CJ_CONSTANT);
+  cj_Constant_set(one, 1.0);
+  cj_Trsm(CJ_LEFT, CJ_UPPER, CJ_NOTRANS, CJ_NONUNIT, one, ATL, BT);
+}
+
+/* Element (i, j) of a single or double precision tile, read and written as a double. */
+static double cj_Lapack_get (cj_eleType type, const char *x, int ldx, int i, int j) {
+  if (type == CJ_DOUBLE) return ((const double *) x)[i + (size_t) j*ldx];
+  return ((const float *) x)[i + (size_t) j*ldx];
+}
+
+static void cj_Lapack_put (cj_eleType type, char *x, int ldx, int i, int j, double value) {
+  if (type == CJ_DOUBLE) ((double *) x)[i + (size_t) j*ldx] = value;
+  else ((float *) x)[i + (size_t) j*ldx] = (float) value;
+}
+
+/* Rows of the butterfly led by row r of tile t, of an n x n matrix. Tile t goes with
+ * tile t2 > t row by row, and the rows left over (all of them if t2 = t) go with those
+ * half of them further down in t, an odd one staying alone. Returns the number of rows,
+ * 1 or 2, with their indices in g and the weights M(i, x) of row i in row x: column x
+ * of M is (u_p, u_p)/sqrt(2) for the first row p and (u_q, -u_q)/sqrt(2) for the second
+ * row q, or just u_p alone. Returns 0 if r is the second row of its pair. With t2 = -1
+ * the rows of t are left alone, M = 1. */
+static int cj_Ldlt_butterfly (cj_eleType type, const char *u, int n, int t, int t2, int r,
+    int *g, double M[2][2]) {
+  int mt = min(BLOCK_SIZE, n - t*BLOCK_SIZE), m2 = (t2 > t) ? min(BLOCK_SIZE, n - t2*BLOCK_SIZE) : 0;
+  int h = (mt - m2)/2;
+  double up, uq;
+
+  g[0] = t*BLOCK_SIZE + r;
+  if (t2 == -1) {
+    M[0][0] = 1.0;
+    return 1;
+  }
+  if (r < m2) g[1] = t2*BLOCK_SIZE + r;
+  else if (r < m2 + h) g[1] = g[0] + h;
+  else if (r == m2 + 2*h) g[1] = -1;
+  else return 0;
+
+  up = cj_Lapack_get(type, u, 0, g[0], 0);
+  if (g[1] == -1) {
+    M[0][0] = up;
+    return 1;
+  }
+  uq = cj_Lapack_get(type, u, 0, g[1], 0);
+  M[0][0] = M[1][0] = up*M_SQRT1_2;
+  M[0][1] = uq*M_SQRT1_2;
+  M[1][1] = -uq*M_SQRT1_2;
+  return 2;
+}
+
+/* The tile of x holding element (i, j) of the lower triangle of A, whose tile (0, 0)
+ * is at (offm, offn), with (i, j) turned into the element of that tile. */
+static int cj_Ldlt_find (cj_Matrix **x, int narg, int offm, int offn, int *i, int *j) {
+  int k, s;
+
+  if (*i < *j) { s = *i; *i = *j; *j = s; }
+  for (k = 0; k < narg - 1; k++) {
+    if (x[k]->offm - offm == *i - *i%BLOCK_SIZE && x[k]->offn - offn == *j - *j%BLOCK_SIZE) break;
+  }
+  *i %= BLOCK_SIZE; *j %= BLOCK_SIZE;
+  return k;
+}
+
+/* SYRBT: A:= U' * A * U on the tiles of the row pair (t, t2) and column pair (b, b2)
+ * of A, held by their lower tiles, the first being that of (t, b). Each 2 x 2 quad of
+ * elements is done at once, and a diagonal pair, t = b, does only the quads on or
+ * below the diagonal. A side with t2 or b2 = -1 is left alone, so a pair of tiles
+ * off the diagonal is done one side at a time.
+ * GERBT: B:= U' * B, or B:= U * B if iarg[2] is 'N', on the tiles t and t2 of a tile
+ * column of B. The weights of U are task->t, of length task->ldt. */
+static void cj_Ldlt_rbt (cj_Task *task, cj_Matrix **x, char **x_ptr, int *ldx, int narg) {
+  cj_eleType type = x[0]->eletype;
+  int n = task->ldt, t = task->iarg[0], t2 = task->iarg[1], b = task->iarg[2], b2 = task->iarg[3];
+  int offm, offn, np, nq, r, c, i, j, k, l, g[2], h[2], at[2][2], ri[2][2], ci[2][2];
+  double M[2][2], N[2][2], v[2][2], w;
+
+  if (task->tasktype == CJ_TASK_GERBT) {
+    for (r = 0; r < x[0]->m; r++) {
+      if (!(np = cj_Ldlt_butterfly(type, task->t, n, t, t2, r, g, M))) continue;
+      for (i = 0; i < np; i++) {
+        at[i][0] = (g[i]/BLOCK_SIZE == t) ? 0 : 1;
+        ri[i][0] = g[i]%BLOCK_SIZE;
+      }
+      for (c = 0; c < x[0]->n; c++) {
+        for (i = 0; i < np; i++) v[i][0] = cj_Lapack_get(type, x_ptr[at[i][0]], ldx[at[i][0]], ri[i][0], c);
+        for (i = 0; i < np; i++) {
+          for (w = 0.0, k = 0; k < np; k++) w += ((b == 'N') ? M[i][k] : M[k][i])*v[k][0];
+          cj_Lapack_put(type, x_ptr[at[i][0]], ldx[at[i][0]], ri[i][0], c, w);
+        }
+      }
+    }
+    return;
+  }
+
+  offm = x[0]->offm - max(t, b)*BLOCK_SIZE;
+  offn = x[0]->offn - min(t, b)*BLOCK_SIZE;
+  for (r = 0; r < min(BLOCK_SIZE, n - t*BLOCK_SIZE); r++) {
+    if (!(np = cj_Ldlt_butterfly(type, task->t, n, t, t2, r, g, M))) continue;
+    for (c = 0; c < min(BLOCK_SIZE, n - b*BLOCK_SIZE); c++) {
+      if (!(nq = cj_Ldlt_butterfly(type, task->t, n, b, b2, c, h, N))) continue;
+      if (t == b && g[0] < h[0]) continue;
+      for (i = 0; i < np; i++) {
+        for (j = 0; j < nq; j++) {
+          ri[i][j] = g[i]; ci[i][j] = h[j];
+          at[i][j] = cj_Ldlt_find(x, narg, offm, offn, &ri[i][j], &ci[i][j]);
+          v[i][j] = cj_Lapack_get(type, x_ptr[at[i][j]], ldx[at[i][j]], ri[i][j], ci[i][j]);
+        }
+      }
+      for (i = 0; i < np; i++) {
+        for (j = 0; j < nq; j++) {
+          for (w = 0.0, k = 0; k < np; k++) for (l = 0; l < nq; l++) w += M[k][i]*v[k][l]*N[l][j];
+          cj_Lapack_put(type, x_ptr[at[i][j]], ldx[at[i][j]], ri[i][j], ci[i][j], w);
+        }
+      }
+    }
+  }
+}
+
+/* Run an LDL' tile kernel on host copies of its arguments, ordered as cj_Ldlt_task
+ * pushes them. The D of a tile is on the diagonal of its factored diagonal tile,
+ * and SYTRF leaves a copy in task->t for the GEMDM of the step. */
+static void cj_Ldlt_host (cj_Task *task, cj_Matrix **x, char **x_ptr, int *ldx) {
+  int narg = cj_Dqueue_get_size(task->arg), one = 1, info, i, j;
+  char *uplo = (narg == 2) ? "L" : "F";
+
+  if (task->tasktype == CJ_TASK_SYRBT || task->tasktype == CJ_TASK_GERBT) {
+    cj_Ldlt_rbt(task, x, x_ptr, ldx, narg);
+  }
+  else if (task->tasktype == CJ_TASK_DIAG) {
+    for (j = 0; j < x[1]->n; j++) {
+      for (i = 0; i < x[1]->m; i++) {
+        cj_Lapack_put(x[1]->eletype, x_ptr[1], ldx[1], i, j, cj_Lapack_get(x[1]->eletype, x_ptr[1], ldx[1], i, j)/
+            cj_Lapack_get(x[0]->eletype, x_ptr[0], ldx[0], i, i));
+      }
+    }
+  }
+  else if (x[0]->eletype == CJ_SINGLE) {
+    if (task->tasktype == CJ_TASK_SYTRF)
+      cj_Kernel_ssytrf_nopiv(&(x[0]->m), (float *) x_ptr[0], &ldx[0], &info);
+    else if (task->tasktype == CJ_TASK_TRSMD)
+      cj_Kernel_strsmd(&(x[1]->m), &(x[1]->n), (float *) x_ptr[0], &ldx[0], (float *) x_ptr[1], &ldx[1]);
+    else
+      cj_Kernel_sgemdm(uplo, &(x[narg - 1]->m), &(x[narg - 1]->n), &(x[0]->n), (float *) x_ptr[0], &ldx[0],
+          (float *) task->t, &one, (float *) x_ptr[narg - 2], &ldx[narg - 2], (float *) x_ptr[narg - 1], &ldx[narg - 1]);
+  }
+  else {
+    if (task->tasktype == CJ_TASK_SYTRF)
+      cj_Kernel_dsytrf_nopiv(&(x[0]->m), (double *) x_ptr[0], &ldx[0], &info);
+    else if (task->tasktype == CJ_TASK_TRSMD)
+      cj_Kernel_dtrsmd(&(x[1]->m), &(x[1]->n), (double *) x_ptr[0], &ldx[0], (double *) x_ptr[1], &ldx[1]);
+    else
+      cj_Kernel_dgemdm(uplo, &(x[narg - 1]->m), &(x[narg - 1]->n), &(x[0]->n), (double *) x_ptr[0], &ldx[0],
+          (double *) task->t, &one, (double *) x_ptr[narg - 2], &ldx[narg - 2], (double *) x_ptr[narg - 1], &ldx[narg - 1]);
+  }
+  if (task->tasktype == CJ_TASK_SYTRF) {
+    for (i = 0; i < x[0]->m; i++)
+      cj_Lapack_put(x[0]->eletype, task->t, 0, i, 0, cj_Lapack_get(x[0]->eletype, x_ptr[0], ldx[0], i, i));
+  }
+}
+
+/* One task of the tiled LDL' on the narg tiles X, chosen by the task type, with
+ * the integer arguments iarg and the butterfly weights u of length n:
+ *   SYTRF: A11 = L * D * L' without pivoting, D copied to u
+ *   TRSMD: A21:= A21 * L11^(-T) * D^(-1), with the L11 and D of a SYTRF
+ *   GEMDM: A32:= A32 - A31 * D * A21', D in u and only the lower triangle for a
+ *          diagonal tile, A31 = A21
+ *   DIAG:  B1:= D^(-1) * B1
+ *   SYRBT, GERBT: the random butterflies, see cj_Ldlt_rbt
+ * The last tile is written and the others read, except for the butterflies,
+ * which write all of their tiles. */
+static void cj_Ldlt_task (cj_taskType tasktype, const int *iarg, char *u, int n, cj_Object **X, int narg) {
+  const char *name;
+
+  if (tasktype == CJ_TASK_SYTRF) name = "Sytrf";
+  else if (tasktype == CJ_TASK_TRSMD) name = "Trsmd";
+  else if (tasktype == CJ_TASK_GEMDM) name = "Gemdm";
+  else if (tasktype == CJ_TASK_DIAG) name = "Diag";
+  else if (tasktype == CJ_TASK_SYRBT) name = "Syrbt";
+  else name = "Gerbt";
+
+  cj_Lapack_task(tasktype, &cj_Ldlt_host, name, iarg, u, n, X,
+      (tasktype == CJ_TASK_SYRBT || tasktype == CJ_TASK_GERBT) ? (1 << narg) - 1 : 1 << (narg - 1), narg);
+}
+
+/* Tile pairs of butterfly level l on nt tiles: level 0 pairs the top half of the
+ * tiles with the bottom half, level l + 1 does so within each half of level l. In
+ * a group of odd size the last tile pairs its own rows. pair[t] is the tile going
+ * with t, t itself for such a tile, or -1 for the second tile of a pair. */
+static void cj_Ldlt_pairs (int nt, int level, int *pair) {
+  int start[1 << RBT_DEPTH], size[1 << RBT_DEPTH], ng = 1, g, h, s, i, t;
+
+  start[0] = 0; size[0] = nt;
+  for (; level > 0; level--, ng *= 2) {
+    for (i = ng - 1; i >= 0; i--) {
+      s = start[i]; g = size[i]; h = g/2;
+      start[2*i] = s; size[2*i] = h;
+      start[2*i + 1] = s + h; size[2*i + 1] = g - h;
+    }
+  }
+  for (i = 0; i < ng; i++) {
+    h = size[i]/2;
+    for (t = start[i]; t < start[i] + h; t++) {
+      pair[t] = t + h;
+      pair[t + h] = -1;
+    }
+    if (size[i]%2) pair[start[i] + 2*h] = start[i] + 2*h;
+  }
+}
+
+/* A SYRBT task on the tiles of the rows iarg[0], iarg[1] and columns iarg[2], iarg[3]
+ * of A, the lower one of a tile and its transpose standing for both. */
+static void cj_Ldlt_syrbt (cj_Object *A, const int *iarg, char *w, cj_Object **X) {
+  cj_Matrix *a = A->matrix;
+  int narg = 0, i, j, k, r, c;
+
+  for (i = 0; i < 2; i++) {
+    for (j = 2; j < 4; j++) {
+      if (iarg[i] == -1 || iarg[j] == -1) continue;
+      r = max(iarg[i], iarg[j])*BLOCK_SIZE; c = min(iarg[i], iarg[j])*BLOCK_SIZE;
+      for (k = 0; k < narg; k++) {
+        if (X[k]->matrix->offm == a->offm + r && X[k]->matrix->offn == a->offn + c) break;
+      }
+      if (k == narg) cj_Matrix_tile(A, X[narg ++], r, c);
+    }
+  }
+  cj_Ldlt_task(CJ_TASK_SYRBT, iarg, w, a->m, X, narg);
+}
+
+/* Level l of the butterfly on the symmetric A, or on the rows of B. A diagonal pair
+ * of tiles is done by one task. A pair off the diagonal holds four tiles, more than
+ * a task takes, so it is done from the right by a task on each tile row, then from
+ * the left by one on each tile column. */
+static void cj_Ldlt_level (cj_Object *A, cj_Object *U, int l, cj_Object *B, char trans) {
+  cj_Matrix *u = U->matrix;
+  cj_Object *X[3];
+  int n = A->matrix->m, nt = (n - 1)/BLOCK_SIZE + 1, *pair, iarg[4], i, j, t, b;
+  char *w = cj_Matrix_addr(u->base, u->offm, u->offn + l, NULL);
+
+  pair = (int *) malloc(nt*sizeof(int));
+  if (!pair) cj_Lapack_error("ldlt", "memory allocation failed.");
+  cj_Ldlt_pairs(nt, l, pair);
+  for (i = 0; i < 3; i++) {
+    X[i] = cj_Object_new(CJ_MATRIX);
+    cj_Matrix_duplicate(B ? B : A, X[i]);
+  }
+
+  for (t = 0; t < nt; t++) {
+    if (pair[t] == -1) continue;
+    if (B) {
+      iarg[0] = t; iarg[1] = pair[t]; iarg[2] = trans;
+      for (j = 0; j < B->matrix->n; j += BLOCK_SIZE) {
+        cj_Matrix_tile(B, X[0], t*BLOCK_SIZE, j);
+        cj_Matrix_tile(B, X[1], pair[t]*BLOCK_SIZE, j);
+        cj_Ldlt_task(CJ_TASK_GERBT, iarg, w, n, X, (pair[t] != t) ? 2 : 1);
+      }
+      continue;
+    }
+    for (b = 0; b <= t; b++) {
+      if (pair[b] == -1) continue;
+      if (b == t) {
+        iarg[0] = iarg[2] = t; iarg[1] = iarg[3] = pair[t];
+        cj_Ldlt_syrbt(A, iarg, w, X);
+        continue;
+      }
+      iarg[1] = -1; iarg[2] = b; iarg[3] = pair[b];
+      for (i = 0; i < 2; i++) {
+        iarg[0] = i ? pair[t] : t;
+        if (i == 0 || pair[t] != t) cj_Ldlt_syrbt(A, iarg, w, X);
+      }
+      iarg[0] = t; iarg[1] = pair[t]; iarg[3] = -1;
+      for (i = 0; i < 2; i++) {
+        iarg[2] = i ? pair[b] : b;
+        if (i == 0 || pair[b] != b) cj_Ldlt_syrbt(A, iarg, w, X);
+      }
+    }
+  }
+  free(pair);
+}
+
+/* Tiled LDL' without pivoting, right looking like the Cholesky: each step factors
+ * the diagonal tile, solves the tiles below it and updates the lower triangle of
+ * the trailing matrix. D is copied to the last column of u for the updates. */
+static void cj_Ldlt_tiles (cj_Object *A, cj_Matrix *u) {
+  cj_Object *X[3];
+  char *dk;
+  int i, j, k, n = A->matrix->n;
+
+  for (i = 0; i < 3; i++) {
+    X[i] = cj_Object_new(CJ_MATRIX);
+    cj_Matrix_duplicate(A, X[i]);
+  }
+  for (k = 0; k < n; k += BLOCK_SIZE) {
+    dk = cj_Matrix_addr(u->base, u->offm + k, u->offn + RBT_DEPTH, NULL);
+    cj_Matrix_tile(A, X[0], k, k);
+    cj_Ldlt_task(CJ_TASK_SYTRF, NULL, dk, 0, X, 1);
+    for (i = k + BLOCK_SIZE; i < n; i += BLOCK_SIZE) {
+      cj_Matrix_tile(A, X[1], i, k);
+      cj_Ldlt_task(CJ_TASK_TRSMD, NULL, NULL, 0, X, 2);
+    }
+    for (j = k + BLOCK_SIZE; j < n; j += BLOCK_SIZE) {
+      cj_Matrix_tile(A, X[0], j, k);
+      cj_Matrix_tile(A, X[1], j, j);
+      cj_Ldlt_task(CJ_TASK_GEMDM, NULL, dk, 0, X, 2);
+      for (i = j + BLOCK_SIZE; i < n; i += BLOCK_SIZE) {
+        cj_Matrix_tile(A, X[0], i, k);
+        cj_Matrix_tile(A, X[1], j, k);
+        cj_Matrix_tile(A, X[2], i, j);
+        cj_Ldlt_task(CJ_TASK_GEMDM, NULL, dk, 0, X, 3);
+      }
+    }
+  }
+}
+
+static void cj_Ldlt_check (const char *func_name, cj_Object *A, cj_Object *U) {
+  if (!A || !U) 
+    cj_Lapack_error(func_name, "matrices haven't been initialized yet.");
+  if (A->objtype != CJ_MATRIX || U->objtype != CJ_MATRIX)
+    cj_Lapack_error(func_name, "Object types are not matrix type.");
+  if (A->matrix->m != A->matrix->n) 
+    cj_Lapack_error(func_name, "matrice is not a square matrix.");
+}
+
+/**
+ * @brief  A -> U' A U = L D L' for a symmetric, possibly indefinite, A. U is a
+ *         random butterfly of RBT_DEPTH levels, paired on tiles so that each
+ *         level is a set of independent tasks, after which L D L' needs no
+ *         pivoting with high probability. The factorization then has the
+ *         tasks and parallelism of the Cholesky. Only the lower triangle of
+ *         A is read and written: L is left below the diagonal, D on it. U' A U
+ *         is congruent to A, so D has the inertia of A (cj_Ldlt_inertia).
+ * @param  *A symmetric matrix, n x n, overwritten by the factors
+ * @param  *U a new matrix object, set up here to n x (RBT_DEPTH + 1) with the
+ *         random weights of the butterfly and a copy of D for the updates, or
+ *         such a matrix in column major order to use its weights
+ */
+void cj_Ldlt (cj_Object *A, cj_Object *U) {
+  cj_Matrix *a, *u;
+  unsigned int seed = 1;
+  int i, l;
+
+  cj_Ldlt_check("ldlt", A, U);
+  a = A->matrix; u = U->matrix;
+  if (a->m == 0) return;
+  if (!u->buff) {
+    cj_Matrix_set_eletype(U, a->eletype);
+    cj_Matrix_set(U, a->m, RBT_DEPTH + 1);
+    /* Weights exp(r/20), r uniform in [-1, 1], as in Parker's butterflies. */
+    for (l = 0; l < RBT_DEPTH; l++) {
+      for (i = 0; i < a->m; i++) {
+        double r = exp((2.0*rand_r(&seed)/RAND_MAX - 1.0)/20.0);
+        if (a->eletype == CJ_DOUBLE) cj_Matrix_elem(u, double, i, l) = r;
+        else cj_Matrix_elem(u, float, i, l) = (float) r;
+      }
+    }
+  }
+  if (u->eletype != a->eletype || u->base->layout != CJ_LAYOUT_COLUMN || u->m < a->m || u->n < RBT_DEPTH + 1)
+    cj_Lapack_error("ldlt", "U does not fit the butterfly of A.");
+
+  cj_Queue_end();
+  for (l = 0; l < RBT_DEPTH; l++) cj_Ldlt_level(A, U, l, NULL, 'T');
+  cj_Ldlt_tiles(A, u);
+  cj_Queue_begin();
+}
+
+/**
+ * @brief  Solve A X = B with the factors of cj_Ldlt: B:= U' B, then L and D are
+ *         solved with cj_Trsm and the DIAG tasks, and X = U B.
+ * @param  *A factors from cj_Ldlt, n x n
+ * @param  *U butterfly from cj_Ldlt
+ * @param  *B right-hand sides, n x k, overwritten by X
+ */
+void cj_Ldlt_solve (cj_Object *A, cj_Object *U, cj_Object *B) {
+  cj_Object *X[2], *one;
+  int j, k, l, n;
+
+  cj_Ldlt_check("ldlt_solve", A, U);
+  if (!B || B->objtype != CJ_MATRIX)
+    cj_Lapack_error("ldlt_solve", "right-hand sides are not a matrix.");
+  if (B->matrix->m != A->matrix->m) 
+    cj_Lapack_error("ldlt_solve", "matrices dimension aren't matched.");
+  n = A->matrix->n;
+  if (n == 0 || B->matrix->n == 0) return;
+
+  /* B = U' * B, with U = U_0 * U_1 * ... */
+  cj_Queue_end();
+  for (l = 0; l < RBT_DEPTH; l++) cj_Ldlt_level(A, U, l, B, 'T');
+  cj_Queue_begin();
+
+  /* B = D^(-1) * L^(-1) * B */
+  one = cj_Object_new(CJ_CONSTANT);
+  cj_Constant_set(one, 1.0);
+  cj_Trsm(CJ_LEFT, CJ_LOWER, CJ_NOTRANS, CJ_UNIT, one, A, B);
+  X[0] = cj_Object_new(CJ_MATRIX); X[1] = cj_Object_new(CJ_MATRIX);
+  cj_Matrix_duplicate(A, X[0]); cj_Matrix_duplicate(B, X[1]);
+  cj_Queue_end();
+  for (k = 0; k < n; k += BLOCK_SIZE) {
+    cj_Matrix_tile(A, X[0], k, k);
+    for (j = 0; j < B->matrix->n; j += BLOCK_SIZE) {
+      cj_Matrix_tile(B, X[1], k, j);
+      cj_Ldlt_task(CJ_TASK_DIAG, NULL, NULL, 0, X, 2);
+    }
+  }
+  cj_Queue_begin();
+
+  /* X = U * L^(-T) * B */
+  cj_Trsm(CJ_LEFT, CJ_LOWER, CJ_TRANS, CJ_UNIT, one, A, B);
+  cj_Queue_end();
+  for (l = RBT_DEPTH - 1; l >= 0; l--) cj_Ldlt_level(A, U, l, B, 'N');
   cj_Queue_begin();
 }
 
+/**
+ * @brief  Inertia of the matrix factored by cj_Ldlt, from the signs of D: the
+ *         number of positive, negative and zero eigenvalues. Waits for the
+ *         factorization.
+ * @param  *A factors from cj_Ldlt, n x n
+ * @param  *inertia three integers, set to the numbers of positive, negative
+ *         and zero entries of D
+ */
+void cj_Ldlt_inertia (cj_Object *A, int *inertia) {
+  cj_Object *Akk;
+  cj_Matrix *a;
+  double d;
+  int k;
+
+  if (!A || A->objtype != CJ_MATRIX || !inertia)
+    cj_Lapack_error("ldlt_inertia", "matrice or inertia haven't been initialized yet.");
+  a = A->matrix;
+  inertia[0] = inertia[1] = inertia[2] = 0;
+
+  cj_Sync();
+  Akk = cj_Object_new(CJ_MATRIX);
+  cj_Matrix_duplicate(A, Akk);
+  for (k = 0; k < a->n; k += BLOCK_SIZE) {
+    cj_Matrix_tile(A, Akk, k, k);
+    cj_Object_acquire(Akk);
+  }
+  for (k = 0; k < a->n; k++) {
+    d = (a->base->eletype == CJ_DOUBLE) ? cj_Matrix_elem(a->base, double, a->offm + k, a->offn + k) :
+      cj_Matrix_elem(a->base, float, a->offm + k, a->offn + k);
+    if (d > 0.0) inertia[0] ++;
+    else if (d < 0.0) inertia[1] ++;
+    else inertia[2] ++;
+  }
+}
+
+/* Rows r and below of column c of l and column p of x by the rotation of tangent
+ * t: with s = 1 for a Givens rotation and -1 for a hyperbolic one, and a =
+ * 1/sqrt(1 + s*t^2), l:= a*(l + s*t*x) and x:= a*(x - t*l). These keep l*l' +
+ * s*x*x', and zero x against l for t = x/l. */
+static void cj_Chol_rot (cj_Matrix *l, char *l_ptr, int ldl, int c, cj_Matrix *x, char *x_ptr, int ldx, int p,
+    int r, double t, int down) {
+  double s = down ? -1.0 : 1.0, a = 1.0/sqrt(1.0 + s*t*t), li, xi;
+  int i;
+
+  for (i = r; i < l->m; i++) {
+    li = cj_Lapack_get(l->eletype, l_ptr, ldl, i, c);
+    xi = cj_Lapack_get(x->eletype, x_ptr, ldx, i, p);
+    cj_Lapack_put(l->eletype, l_ptr, ldl, i, c, a*(li + s*t*xi));
+    cj_Lapack_put(x->eletype, x_ptr, ldx, i, p, a*(xi - t*li));
+  }
+}
 
+/* Run a Cholesky tile kernel on host copies of its arguments:
+ *   TRTRI:  A11:= L11^(-1)
+ *   LAUUM:  A11:= L11' * L11, lower triangle
+ *   LOGDET: W(0):= 2 * sum(log(diag(L11))) on (L11, W) with iarg[0] = 0, or
+ *           W(0):= W(0) + V(0) on (V, W) with iarg[0] = 1; the sum is also
+ *           stored to task->t as a double, if set
+ *   ROTG:   [L11, X1]:= [L11, X1] * G, G the rotations that zero X1 against L11
+ *           column by column, with their tangents left in X1
+ *   ROT:    [L21, X2]:= [L21, X2] * G, with the tangents of a ROTG in X1
+ * The rotations are hyperbolic, for L * L' - X * X', with iarg[0] = 1. */
+static void cj_Chol_host (cj_Task *task, cj_Matrix **x, char **x_ptr, int *ldx) {
+  int info, i, c, p;
+  double sum, t;
 
+  if (task->tasktype == CJ_TASK_TRTRI) {
+    if (x[0]->eletype == CJ_SINGLE)
+      cj_Kernel_strtri("L", "N", &(x[0]->m), (float *) x_ptr[0], &ldx[0], &info);
+    else
+      cj_Kernel_dtrtri("L", "N", &(x[0]->m), (double *) x_ptr[0], &ldx[0], &info);
+  }
+  else if (task->tasktype == CJ_TASK_LAUUM) {
+    if (x[0]->eletype == CJ_SINGLE)
+      cj_Kernel_slauum("L", &(x[0]->m), (float *) x_ptr[0], &ldx[0], &info);
+    else
+      cj_Kernel_dlauum("L", &(x[0]->m), (double *) x_ptr[0], &ldx[0], &info);
+  }
+  else if (task->tasktype == CJ_TASK_ROTG) {
+    for (c = 0; c < x[0]->n; c++) {
+      for (p = 0; p < x[1]->n; p++) {
+        t = cj_Lapack_get(x[1]->eletype, x_ptr[1], ldx[1], c, p)/cj_Lapack_get(x[0]->eletype, x_ptr[0], ldx[0], c, c);
+        cj_Chol_rot(x[0], x_ptr[0], ldx[0], c, x[1], x_ptr[1], ldx[1], p, c, t, task->iarg[0]);
+        cj_Lapack_put(x[1]->eletype, x_ptr[1], ldx[1], c, p, t);
+      }
+    }
+  }
+  else if (task->tasktype == CJ_TASK_ROT) {
+    for (c = 0; c < x[1]->n; c++) {
+      for (p = 0; p < x[2]->n; p++) {
+        t = cj_Lapack_get(x[0]->eletype, x_ptr[0], ldx[0], c, p);
+        cj_Chol_rot(x[1], x_ptr[1], ldx[1], c, x[2], x_ptr[2], ldx[2], p, 0, t, task->iarg[0]);
+      }
+    }
+  }
+  else {
+    if (task->iarg[0] == 0) {
+      sum = 0.0;
+      for (i = 0; i < x[0]->m; i++) sum += log(cj_Lapack_get(x[0]->eletype, x_ptr[0], ldx[0], i, i));
+      sum *= 2.0;
+    }
+    else sum = *(double *) x_ptr[1] + *(double *) x_ptr[0];
+    *(double *) x_ptr[1] = sum;
+    if (task->t) *(double *) task->t = sum;
+  }
+}
+
+/* One task of the tiled Cholesky inverse, log-determinant or rank-k updates on A,
+ * and B and C if set, with iarg[0] and t, see cj_Chol_host. The first of several
+ * tiles is only read, except by ROTG, and the others written. */
+static void cj_Chol_task (cj_taskType tasktype, int iarg, char *t, cj_Object *A, cj_Object *B, cj_Object *C) {
+  cj_Object *X[3] = {A, B, C};
+  int iargs[4] = {iarg, 0, 0, 0}, narg = C ? 3 : (B ? 2 : 1);
+  const char *name;
+
+  if (tasktype == CJ_TASK_TRTRI) name = "Trtri";
+  else if (tasktype == CJ_TASK_LAUUM) name = "Lauum";
+  else if (tasktype == CJ_TASK_LOGDET) name = "Logdet";
+  else if (tasktype == CJ_TASK_ROTG) name = "Rotg";
+  else name = "Rot";
+
+  cj_Lapack_task(tasktype, &cj_Chol_host, name, iargs, t, 0, X,
+      (narg == 1 || tasktype == CJ_TASK_ROTG) ? (1 << narg) - 1 : (1 << narg) - 2, narg);
+}
+
+/* A:= L^(-1) on the lower triangle, by blocks of rows as LAPACK trtri: with
+ * L00^(-1) in place, L10:= -L11^(-1) * L10 * L00^(-1) needs L10 and L11 only. */
+static void cj_Chol_trtri_blk (cj_Object *A) {
+  cj_Object *ATL,   *ATR,      *A00, *A01, *A02, 
+            *ABL,   *ABR,      *A10, *A11, *A12,
+                               *A20, *A21, *A22;
+  cj_Object *one, *minus_one;
+  int b;
+
+  ATL = cj_Object_new(CJ_MATRIX); ATR = cj_Object_new(CJ_MATRIX); 
+  A00 = cj_Object_new(CJ_MATRIX); A01 = cj_Object_new(CJ_MATRIX); A02 = cj_Object_new(CJ_MATRIX);
+
+  ABL = cj_Object_new(CJ_MATRIX); ABR = cj_Object_new(CJ_MATRIX);
+  A10 = cj_Object_new(CJ_MATRIX); A11 = cj_Object_new(CJ_MATRIX); A12 = cj_Object_new(CJ_MATRIX);
+  A20 = cj_Object_new(CJ_MATRIX); A21 = cj_Object_new(CJ_MATRIX); A22 = cj_Object_new(CJ_MATRIX);
+
+  one = cj_Object_new(CJ_CONSTANT); minus_one = cj_Object_new(CJ_CONSTANT);
+  cj_Constant_set(one, 1.0); cj_Constant_set(minus_one, -1.0);
+
+  cj_Matrix_part_2x2( A,    ATL, ATR,
+                            ABL, ABR,     0, 0, CJ_TL );
+
+  while ( ATL->matrix->m  < A->matrix->m ){
+
+    b = min(ABR->matrix->m, BLOCK_SIZE);
+
+    cj_Matrix_repart_2x2_to_3x3( ATL, /**/ ATR,       A00, /**/ A01, A02,
+                              /* ************* */   /* ******************** */
+                                                      A10, /**/ A11, A12,
+                                 ABL, /**/ ABR,       A20, /**/ A21, A22,
+                                 b, b, CJ_BR );
+    /*------------------------------------------------------------*/
+
+    // A10 = -inv( A11 ) * A10 * A00, A00 already inverted
+    cj_Trmm(CJ_RIGHT, CJ_LOWER, CJ_NOTRANS, CJ_NONUNIT, one, A00, A10);
+    cj_Trsm(CJ_LEFT, CJ_LOWER, CJ_NOTRANS, CJ_NONUNIT, minus_one, A11, A10);
+
+    // A11 = inv( A11 )
+    cj_Chol_task(CJ_TASK_TRTRI, 0, NULL, A11, NULL, NULL);
+
+    /*------------------------------------------------------------*/
+
+    cj_Matrix_cont_with_3x3_to_2x2( ATL, /**/ ATR,       A00, A01, /**/ A02,
+                                                     A10, A11, /**/ A12,
+                            /* ************** */  /* ****************** */
+                              ABL, /**/ ABR,       A20, A21, /**/ A22,
+                              CJ_TL );
+  }
+}
+
+/* A:= L' * L on the lower triangle, by blocks of rows as LAPACK lauum. */
+static void cj_Chol_lauum_blk (cj_Object *A) {
+  cj_Object *ATL,   *ATR,      *A00, *A01, *A02, 
+            *ABL,   *ABR,      *A10, *A11, *A12,
+                               *A20, *A21, *A22;
+  cj_Object *one;
+  int b;
+
+  ATL = cj_Object_new(CJ_MATRIX); ATR = cj_Object_new(CJ_MATRIX); 
+  A00 = cj_Object_new(CJ_MATRIX); A01 = cj_Object_new(CJ_MATRIX); A02 = cj_Object_new(CJ_MATRIX);
+
+  ABL = cj_Object_new(CJ_MATRIX); ABR = cj_Object_new(CJ_MATRIX);
+  A10 = cj_Object_new(CJ_MATRIX); A11 = cj_Object_new(CJ_MATRIX); A12 = cj_Object_new(CJ_MATRIX);
+  A20 = cj_Object_new(CJ_MATRIX); A21 = cj_Object_new(CJ_MATRIX); A22 = cj_Object_new(CJ_MATRIX);
+
+  one = cj_Object_new(CJ_CONSTANT);
+  cj_Constant_set(one, 1.0);
+
+  cj_Matrix_part_2x2( A,    ATL, ATR,
+                            ABL, ABR,     0, 0, CJ_TL );
+
+  while ( ATL->matrix->m  < A->matrix->m ){
+
+    b = min(ABR->matrix->m, BLOCK_SIZE);
+
+    cj_Matrix_repart_2x2_to_3x3( ATL, /**/ ATR,       A00, /**/ A01, A02,
+                              /* ************* */   /* ******************** */
+                                                      A10, /**/ A11, A12,
+                                 ABL, /**/ ABR,       A20, /**/ A21, A22,
+                                 b, b, CJ_BR );
+    /*------------------------------------------------------------*/
+
+    // A00 = A00 + A10' * A10
+    cj_Syrk(CJ_LOWER, CJ_TRANS, one, A10, one, A00);
+
+    // A10 = A11' * A10
+    cj_Trmm(CJ_LEFT, CJ_LOWER, CJ_TRANS, CJ_NONUNIT, one, A11, A10);
+
+    // A11 = A11' * A11
+    cj_Chol_task(CJ_TASK_LAUUM, 0, NULL, A11, NULL, NULL);
+
+    /*------------------------------------------------------------*/
+
+    cj_Matrix_cont_with_3x3_to_2x2( ATL, /**/ ATR,       A00, A01, /**/ A02,
+                                                     A10, A11, /**/ A12,
+                            /* ************** */  /* ****************** */
+                              ABL, /**/ ABR,       A20, A21, /**/ A22,
+                              CJ_TL );
+  }
+}
+
+static void cj_Chol_check (const char *func_name, cj_Object *A) {
+  if (!A) 
+    cj_Lapack_error(func_name, "matrice hasn't been initialized yet.");
+  if (A->objtype != CJ_MATRIX)
+    cj_Lapack_error(func_name, "Object types are not matrix type.");
+  if (A->matrix->m != A->matrix->n) 
+    cj_Lapack_error(func_name, "matrice is not a square matrix.");
+}
+
+/**
+ * @brief  Solve A X = B with the factor of cj_Chol_l, as LAPACK potrs: B:=
+ *         L^(-T) * L^(-1) * B by two cj_Trsm. Nothing waits for the factor,
+ *         so the solve may follow cj_Chol_l in the same graph and its tasks
+ *         start on the tiles of L as they are done.
+ * @param  *A factor from cj_Chol_l, n x n
+ * @param  *B right-hand sides, n x k, overwritten by X
+ */
+void cj_Chol_solve (cj_Object *A, cj_Object *B) {
+  cj_Object *one;
+
+  cj_Chol_check("chol_solve", A);
+  if (!B || B->objtype != CJ_MATRIX)
+    cj_Lapack_error("chol_solve", "right-hand sides are not a matrix.");
+  if (B->matrix->m != A->matrix->m) 
+    cj_Lapack_error("chol_solve", "matrices dimension aren't matched.");
+
+  one = cj_Object_new(CJ_CONSTANT);
+  cj_Constant_set(one, 1.0);
+  cj_Trsm(CJ_LEFT, CJ_LOWER, CJ_NOTRANS, CJ_NONUNIT, one, A, B);
+  cj_Trsm(CJ_LEFT, CJ_LOWER, CJ_TRANS, CJ_NONUNIT, one, A, B);
+}
+
+/**
+ * @brief  A^(-1) from the factor of cj_Chol_l, as LAPACK potri: L is inverted
+ *         in place and L^(-T) * L^(-1) formed over it, both by tile tasks with
+ *         the TRTRI and LAUUM kernels on the diagonal. Only the lower triangle
+ *         of A is written. Does not wait for the factor.
+ * @param  *A factor from cj_Chol_l, n x n, overwritten by the inverse
+ */
+void cj_Chol_inverse (cj_Object *A) {
+  cj_Chol_check("chol_inverse", A);
+
+  cj_Queue_end();
+  cj_Chol_trtri_blk(A);
+  cj_Chol_lauum_blk(A);
+  cj_Queue_begin();
+}
+
+/**
+ * @brief  log(det(A)) = 2 * sum(log(L_ii)) from the factor of cj_Chol_l, as a
+ *         reduction over the diagonal tiles: a task per tile, then pairwise
+ *         sums in log2 of their number levels. The last task stores the value,
+ *         so it may be read after cj_Sync; nothing else waits for it. NaN if
+ *         A was not positive definite.
+ * @param  *A factor from cj_Chol_l, n x n
+ * @param  *logdet where to store the log-determinant
+ */
+void cj_Chol_logdet (cj_Object *A, double *logdet) {
+  cj_Object *Akk, *W, *Wk, *Ws;
+  int nt, k, s;
+
+  cj_Chol_check("chol_logdet", A);
+  if (!logdet)
+    cj_Lapack_error("chol_logdet", "logdet hasn't been initialized yet.");
+  nt = (A->matrix->n + BLOCK_SIZE - 1)/BLOCK_SIZE;
+  *logdet = 0.0;
+  if (nt == 0) return;
+
+  /* A partial sum per diagonal tile, in the first element of tile k of W. */
+  W = cj_Object_new(CJ_MATRIX);
+  cj_Matrix_set(W, nt*BLOCK_SIZE, 1);
+  Akk = cj_Object_new(CJ_MATRIX); Wk = cj_Object_new(CJ_MATRIX); Ws = cj_Object_new(CJ_MATRIX);
+  cj_Matrix_duplicate(A, Akk); cj_Matrix_duplicate(W, Wk); cj_Matrix_duplicate(W, Ws);
+
+  cj_Queue_end();
+  for (k = 0; k < nt; k++) {
+    cj_Matrix_tile(A, Akk, k*BLOCK_SIZE, k*BLOCK_SIZE);
+    cj_Matrix_tile(W, Wk, k*BLOCK_SIZE, 0);
+    cj_Chol_task(CJ_TASK_LOGDET, 0, (nt == 1) ? (char *) logdet : NULL, Akk, Wk, NULL);
+  }
+  for (s = 1; s < nt; s *= 2) {
+    for (k = 0; k + s < nt; k += 2*s) {
+      cj_Matrix_tile(W, Wk, k*BLOCK_SIZE, 0);
+      cj_Matrix_tile(W, Ws, (k + s)*BLOCK_SIZE, 0);
+      cj_Chol_task(CJ_TASK_LOGDET, 1, (2*s >= nt) ? (char *) logdet : NULL, Ws, Wk, NULL);
+    }
+  }
+  cj_Queue_begin();
+}
+
+/* L * L' + s * X * X' -> L * L', s = 1 or -1 (down), a tile column of X at a time:
+ * the diagonal tile of column j zeroes the rows of X next to it, and the rows
+ * below are rotated alike. Tile column j + 1 starts on its diagonal as soon as
+ * the rotations of column j have reached it. */
+static void cj_Chol_rank (const char *func_name, cj_Object *A, cj_Object *X, int down) {
+  cj_Object *Ljj, *Lij, *Xjp, *Xip;
+  int n, k, i, j, p;
+
+  cj_Chol_check(func_name, A);
+  if (!X || X->objtype != CJ_MATRIX)
+    cj_Lapack_error(func_name, "X is not a matrix.");
+  if (X->matrix->m != A->matrix->m) 
+    cj_Lapack_error(func_name, "matrices dimension aren't matched.");
+  if (X->matrix->eletype != A->matrix->eletype)
+    cj_Lapack_error(func_name, "matrices are not of the same precision.");
+  n = A->matrix->n; k = X->matrix->n;
+
+  Ljj = cj_Object_new(CJ_MATRIX); Lij = cj_Object_new(CJ_MATRIX);
+  Xjp = cj_Object_new(CJ_MATRIX); Xip = cj_Object_new(CJ_MATRIX);
+  cj_Matrix_duplicate(A, Ljj); cj_Matrix_duplicate(A, Lij);
+  cj_Matrix_duplicate(X, Xjp); cj_Matrix_duplicate(X, Xip);
+
+  cj_Queue_end();
+  for (p = 0; p < k; p += BLOCK_SIZE) {
+    for (j = 0; j < n; j += BLOCK_SIZE) {
+      cj_Matrix_tile(A, Ljj, j, j);
+      cj_Matrix_tile(X, Xjp, j, p);
+      cj_Chol_task(CJ_TASK_ROTG, down, NULL, Ljj, Xjp, NULL);
+      for (i = j + BLOCK_SIZE; i < n; i += BLOCK_SIZE) {
+        cj_Matrix_tile(A, Lij, i, j);
+        cj_Matrix_tile(X, Xip, i, p);
+        cj_Chol_task(CJ_TASK_ROT, down, NULL, Xjp, Lij, Xip);
+      }
+    }
+  }
+  cj_Queue_begin();
+}
+
+/**
+ * @brief  Rank-k update of the factor of cj_Chol_l: L * L' + X * X' -> L * L',
+ *         in place, by Givens rotations as LINPACK chud. The rotations of a
+ *         diagonal tile are tasks on its tile column, so the update takes
+ *         O(n^2 k) flops in parallel instead of a new factorization. Does not
+ *         wait for the factor.
+ * @param  *A factor from cj_Chol_l, n x n, overwritten by the new factor
+ * @param  *X n x k, of the precision of A, overwritten by the tangents of the
+ *         rotations
+ */
+void cj_Chol_update (cj_Object *A, cj_Object *X) {
+  cj_Chol_rank("chol_update", A, X, 0);
+}
+
+/**
+ * @brief  Rank-k downdate of the factor of cj_Chol_l: L * L' - X * X' -> L * L',
+ *         in place, by hyperbolic rotations as LINPACK chdd, with the tasks
+ *         of cj_Chol_update. The factor gets NaNs if L * L' - X * X' is not
+ *         positive definite.
+ * @param  *A factor from cj_Chol_l, n x n, overwritten by the new factor
+ * @param  *X n x k, of the precision of A, overwritten by the tangents of the
+ *         rotations
+ */
+void cj_Chol_downdate (cj_Object *A, cj_Object *X) {
+  cj_Chol_rank("chol_downdate", A, X, 1);
+}
+
+/* Row norms of a double precision matrix on the host: the largest magnitude of
+ * each row, or the sum of the magnitudes. NaNs are kept. */
+static void cj_Lapack_row_norms (cj_Object *A, double *row, cj_Bool sum) {
+  cj_Matrix *a = A->matrix;
+  int i, j;
+  double value;
+
+  cj_Object_acquire(A);
+  for (i = 0; i < a->m; i++) row[i] = 0.0;
+  for (j = 0; j < a->n; j++) {
+    for (i = 0; i < a->m; i++) {
+      value = fabs(cj_Matrix_elem(a->base, double, a->offm + i, a->offn + j));
+      if (sum == TRUE) row[i] += value;
+      else if (value > row[i] || isnan(value)) row[i] = value;
+    }
+  }
+}
+
+/**
+ * @brief  Solve X A = B for a symmetric positive definite A with a single
+ *         precision Cholesky factor and double precision iterative refinement.
+ *         The right-hand sides are the rows of B, as for cj_Trsm_rlt. A single
+ *         precision copy of A is factored by cj_Chol_l, then every step takes
+ *         the residual B - X A with tiled double GEMMs and solves for the
+ *         correction with the single precision factor. When the residual of a
+ *         row stops shrinking, or after REFINE_ITERMAX steps, A is factored
+ *         in double precision instead. A must hold both triangles and is left
+ *         unchanged. Returns when the solution is in X.
+ * @param  *A symmetric positive definite matrix, n x n, double precision
+ * @param  *B right-hand sides, k x n, double precision
+ * @param  *X solution, k x n, double precision
+ * @return number of refinement steps, or -(steps + 1) when the system was
+ *         solved in double precision after that many steps
+ */
+int cj_Chol_solve_mixed (cj_Object *A, cj_Object *B, cj_Object *X) {
+  cj_Matrix *a, *b, *x;
+  cj_Object *As, *Rs, *R, *Ad;
+  double *rnrm, *xnrm, *prev, anrm, cte;
+  int i, n, k, iter = 0;
+  cj_Bool done, stalled;
+
+  if (!A || !B || !X) 
+    cj_Lapack_error("chol_solve_mixed", "matrices haven't been initialized yet.");
+  if (!A->matrix || !B->matrix || !X->matrix)
+    cj_Lapack_error("chol_solve_mixed", "Object types are not matrix type.");
+  a = A->matrix; b = B->matrix; x = X->matrix;
+  if ((a->m != a->n) || (b->n != a->m) || (x->m != b->m) || (x->n != b->n)) 
+    cj_Lapack_error("chol_solve_mixed", "matrices dimension aren't matched.");
+  if (a->base->eletype != CJ_DOUBLE || b->base->eletype != CJ_DOUBLE || x->base->eletype != CJ_DOUBLE)
+    cj_Lapack_error("chol_solve_mixed", "matrices are not double precision.");
+
+  n = a->m; k = b->m;
+  rnrm = (double *) malloc(max(n, 3*k)*sizeof(double));
+  if (!rnrm) cj_Lapack_error("chol_solve_mixed", "memory allocation failed.");
+  xnrm = rnrm + k; prev = xnrm + k;
+
+  /* Stop when every residual row is as small as the rounding errors of X A. */
+  cj_Sync();
+  cj_Lapack_row_norms(A, rnrm, TRUE);
+  anrm = 0.0;
+  for (i = 0; i < n; i++) if (rnrm[i] > anrm || isnan(rnrm[i])) anrm = rnrm[i];
+  cte = anrm*0.5*DBL_EPSILON*sqrt((double) n);
+
+  /* A does not fit in single precision. */
+  if (!(anrm <= FLT_MAX)) goto fallback;
+
+  As = cj_Object_new(CJ_MATRIX); Rs = cj_Object_new(CJ_MATRIX); R = cj_Object_new(CJ_MATRIX);
+  cj_Matrix_set_eletype(As, CJ_SINGLE); cj_Matrix_set(As, n, n);
+  cj_Matrix_set_eletype(Rs, CJ_SINGLE); cj_Matrix_set(Rs, k, n);
+  cj_Matrix_set(R, k, n);
+
+  cj_Copy(A, As);
+  cj_Chol_l(As);
+  cj_Copy(B, Rs);
+  cj_Trsm_rlt(As, Rs);
+  cj_Trsm_rln(As, Rs);
+  cj_Copy(Rs, X);
+  for (i = 0; i < k; i++) prev[i] = HUGE_VAL;
+
+  while (1) {
+    /* R = B - X A */
+    cj_Copy(B, R);
+    cj_Gemm_nt(X, A, R);
+    cj_Sync();
+    cj_Lapack_row_norms(R, rnrm, FALSE);
+    cj_Lapack_row_norms(X, xnrm, FALSE);
+
+    done = TRUE; stalled = FALSE;
+    for (i = 0; i < k; i++) {
+      if (rnrm[i] <= xnrm[i]*cte) continue;
+      done = FALSE;
+      if (!(rnrm[i] < prev[i])) stalled = TRUE;
+      prev[i] = rnrm[i];
+    }
+    if (done == TRUE) {
+      free(rnrm);
+      return iter;
+    }
+    if (stalled == TRUE || iter == REFINE_ITERMAX) break;
+
+    /* X = X + R A^(-1) */
+    cj_Copy(R, Rs);
+    cj_Trsm_rlt(As, Rs);
+    cj_Trsm_rln(As, Rs);
+    cj_Axpy(Rs, X);
+    iter ++;
+  }
+
+fallback:
+  Ad = cj_Object_new(CJ_MATRIX);
+  cj_Matrix_set(Ad, n, n);
+  cj_Copy(A, Ad);
+  cj_Chol_l(Ad);
+  cj_Copy(B, X);
+  cj_Trsm_rlt(Ad, X);
+  cj_Trsm_rln(Ad, X);
+  cj_Sync();
+  free(rnrm);
+  return -(iter + 1);
+}
+
+
+/* The host side of cj_Eig, shared by its tasks through task->t: the band of
+ * bandwidth b in lower band storage, ldab x n with room for the bulges, the
+ * reflectors of the bulge chasing, nq of length b to a sweep, the tridiagonal
+ * d, e with its norm and Gershgorin bounds, the eigenvalues w and, if asked
+ * for, the eigenvectors z, n x n. */
+typedef struct {
+  int n, b, ldab, nq;
+  double *ab, *v, *tau, *d, *e, *w, *z;
+  double tnrm, gl, gu, pivmin;
+} cj_Eig_work;
+
+/* Element (r, c) of the symmetric band. */
+static double *cj_Eig_ab (cj_Eig_work *work, int r, int c) {
+  if (r < c) { int s = r; r = c; c = s; }
+  return work->ab + (r - c) + (size_t) c*work->ldab;
+}
+
+/* Reflector H = I - tau * v * v', v(0) = 1, with H * x = (beta, 0, ...)', as
+ * LAPACK larfg. x is overwritten by H * x. Returns tau. */
+static double cj_Eig_larfg (int len, double *x, double *v) {
+  double alpha = x[0], xnorm = 0.0, beta, scale;
+  int i;
+
+  for (i = 1; i < len; i++) xnorm = hypot(xnorm, x[i]);
+  v[0] = 1.0;
+  if (xnorm == 0.0) {
+    for (i = 1; i < len; i++) v[i] = 0.0;
+    return 0.0;
+  }
+  beta = -copysign(hypot(alpha, xnorm), alpha);
+  scale = 1.0/(alpha - beta);
+  for (i = 1; i < len; i++) { v[i] = x[i]*scale; x[i] = 0.0; }
+  x[0] = beta;
+  return (beta - alpha)/beta;
+}
+
+/* B(s:s+len, s:s+len):= H * B(s:s+len, s:s+len) * H, y of length len. */
+static void cj_Eig_syr2 (cj_Eig_work *work, int s, int len, const double *v, double tau, double *y) {
+  double alpha = 0.0;
+  int i, j;
+
+  if (tau == 0.0) return;
+  for (i = 0; i < len; i++) {
+    y[i] = 0.0;
+    for (j = 0; j < len; j++) y[i] += *cj_Eig_ab(work, s + i, s + j)*v[j];
+    y[i] *= tau;
+    alpha += y[i]*v[i];
+  }
+  alpha *= -0.5*tau;
+  for (i = 0; i < len; i++) y[i] += alpha*v[i];
+  for (j = 0; j < len; j++) {
+    for (i = j; i < len; i++) *cj_Eig_ab(work, s + i, s + j) -= v[i]*y[j] + y[i]*v[j];
+  }
+}
+
+/* B(r:r+m, c:c+len):= B(r:r+m, c:c+len) * H for right, H * B(r:r+len, c:c+m)
+ * otherwise, below the diagonal. */
+static void cj_Eig_larf (cj_Eig_work *work, cj_Bool right, int r, int c, int m, int len, const double *v, double tau) {
+  double s;
+  int i, j;
+
+  if (tau == 0.0) return;
+  for (i = 0; i < m; i++) {
+    s = 0.0;
+    for (j = 0; j < len; j++) s += v[j]*((right == TRUE) ? *cj_Eig_ab(work, r + i, c + j) : *cj_Eig_ab(work, r + j, c + i));
+    s *= tau;
+    for (j = 0; j < len; j++) {
+      if (right == TRUE) *cj_Eig_ab(work, r + i, c + j) -= s*v[j];
+      else *cj_Eig_ab(work, r + j, c + i) -= s*v[j];
+    }
+  }
+}
+
+/* Rows st to ed of block q of sweep i of the bulge chasing, each b long but the last. */
+static void cj_Eig_block (cj_Eig_work *work, int i, int q, int *st, int *ed) {
+  *st = i + 1 + q*work->b;
+  *ed = min(*st + work->b - 1, work->n - 1);
+}
+
+/* Block q of sweep i of the band to tridiagonal reduction. Block 0 zeroes column
+ * i below its subdiagonal and applies its reflector to the diagonal block on its
+ * right. Block q > 0 applies the reflector of block q - 1 to the rows below it,
+ * which makes a bulge, zeroes the first column of the bulge and applies its
+ * reflector to its rows and to the next diagonal block. */
+static void cj_Eig_sbtrd (cj_Eig_work *work, int i, int q, double *y) {
+  double *v = work->v + ((size_t) i*work->nq + q)*work->b, *tau = work->tau + (size_t) i*work->nq + q;
+  int st, ed, pst, ped;
+
+  cj_Eig_block(work, i, q, &st, &ed);
+  if (q == 0) {
+    *tau = cj_Eig_larfg(ed - st + 1, cj_Eig_ab(work, st, i), v);
+  }
+  else {
+    cj_Eig_block(work, i, q - 1, &pst, &ped);
+    cj_Eig_larf(work, TRUE, st, pst, ed - st + 1, ped - pst + 1, v - work->b, *(tau - 1));
+    *tau = cj_Eig_larfg(ed - st + 1, cj_Eig_ab(work, st, pst), v);
+    cj_Eig_larf(work, FALSE, st, pst + 1, ped - pst, ed - st + 1, v, *tau);
+  }
+  cj_Eig_syr2(work, st, ed - st + 1, v, *tau, y);
+}
+
+/* Number of eigenvalues of the tridiagonal below x, by a Sturm sequence. */
+static int cj_Eig_count (cj_Eig_work *work, double x) {
+  double q = work->d[0] - x;
+  int i, count = 0;
+
+  if (fabs(q) < work->pivmin) q = -work->pivmin;
+  if (q < 0.0) count ++;
+  for (i = 1; i < work->n; i++) {
+    q = work->d[i] - x - work->e[i - 1]*work->e[i - 1]/q;
+    if (fabs(q) < work->pivmin) q = -work->pivmin;
+    if (q < 0.0) count ++;
+  }
+  return count;
+}
+
+/* Eigenvalues l to u - 1 of the tridiagonal, ascending, by bisection as LAPACK stebz. */
+static void cj_Eig_stebz (cj_Eig_work *work, int l, int u) {
+  double lo, hi, mid;
+  int j, iter;
+
+  for (j = l; j < u; j++) {
+    lo = work->gl; hi = work->gu;
+    for (iter = 0; iter < 256 && hi - lo > 2.0*DBL_EPSILON*fmax(fabs(lo), fabs(hi)) + 2.0*work->pivmin; iter++) {
+      mid = 0.5*(lo + hi);
+      if (cj_Eig_count(work, mid) > j) hi = mid;
+      else lo = mid;
+    }
+    work->w[j] = 0.5*(lo + hi);
+  }
+}
+
+/* Eigenvectors l to u - 1 of the tridiagonal by inverse iteration as LAPACK stein:
+ * T - w(j) * I is factored with partial pivoting, tiny pivots raised to eps * |T|,
+ * and three steps are taken from a random vector. Close eigenvalues, within
+ * 1e-3 * |T|, make a cluster, whose shifts are kept apart and whose vectors are
+ * orthogonalized against each other; l starts a cluster and u ends one. */
+static void cj_Eig_stein (cj_Eig_work *work, int l, int u) {
+  int n = work->n, i, j, p, c0 = l, iter, *ipiv;
+  double *dl, *dd, *du, *du2, *x, *z, sigma = 0.0, fact, temp, s;
+  double ortol = 1e-3*work->tnrm, tol = (work->tnrm > 0.0) ? DBL_EPSILON*work->tnrm : DBL_MIN;
+  unsigned int seed = l + 1;
+
+  dl = (double *) malloc(5*(size_t) n*sizeof(double));
+  ipiv = (int *) malloc(n*sizeof(int));
+  if (!dl || !ipiv) cj_Lapack_error("eig", "memory allocation failed.");
+  dd = dl + n; du = dd + n; du2 = du + n; x = du2 + n;
+
+  for (j = l; j < u; j++) {
+    if (j > l && work->w[j] - work->w[j - 1] > ortol) c0 = j;
+    if (j > c0 && work->w[j] - sigma < 10.0*DBL_EPSILON*fabs(sigma)) sigma += 10.0*DBL_EPSILON*fabs(sigma);
+    else sigma = work->w[j];
+
+    /* T - sigma * I = P * L * U, as LAPACK gttrf. */
+    for (i = 0; i < n; i++) {
+      dd[i] = work->d[i] - sigma;
+      if (i < n - 1) dl[i] = du[i] = work->e[i];
+      du2[i] = 0.0;
+    }
+    for (i = 0; i < n - 1; i++) {
+      if (fabs(dd[i]) >= fabs(dl[i])) {
+        ipiv[i] = i;
+        if (dd[i] != 0.0) {
+          fact = dl[i]/dd[i];
+          dl[i] = fact;
+          dd[i + 1] -= fact*du[i];
+        }
+      }
+      else {
+        ipiv[i] = i + 1;
+        fact = dd[i]/dl[i];
+        dd[i] = dl[i];
+        dl[i] = fact;
+        temp = du[i];
+        du[i] = dd[i + 1];
+        dd[i + 1] = temp - fact*dd[i + 1];
+        if (i < n - 2) {
+          du2[i] = du[i + 1];
+          du[i + 1] = -fact*du[i + 1];
+        }
+      }
+    }
+    for (i = 0; i < n; i++) if (fabs(dd[i]) < tol) dd[i] = (dd[i] < 0.0) ? -tol : tol;
+
+    for (i = 0; i < n; i++) x[i] = 2.0*rand_r(&seed)/RAND_MAX - 1.0;
+    for (iter = 0; iter < 3; iter++) {
+      for (i = 0; i < n - 1; i++) {
+        if (ipiv[i] == i) x[i + 1] -= dl[i]*x[i];
+        else { temp = x[i]; x[i] = x[i + 1]; x[i + 1] = temp - dl[i]*x[i]; }
+      }
+      x[n - 1] /= dd[n - 1];
+      if (n > 1) x[n - 2] = (x[n - 2] - du[n - 2]*x[n - 1])/dd[n - 2];
+      for (i = n - 3; i >= 0; i--) x[i] = (x[i] - du[i]*x[i + 1] - du2[i]*x[i + 2])/dd[i];
+
+      for (p = c0; p < j; p++) {
+        z = work->z + (size_t) p*n;
+        for (s = 0.0, i = 0; i < n; i++) s += z[i]*x[i];
+        for (i = 0; i < n; i++) x[i] -= s*z[i];
+      }
+      for (s = 0.0, i = 0; i < n; i++) s = hypot(s, x[i]);
+      for (i = 0; i < n; i++) x[i] /= s;
+    }
+    z = work->z + (size_t) j*n;
+    for (i = 0; i < n; i++) z[i] = x[i];
+  }
+  free(dl); free(ipiv);
+}
+
+/* Columns c0 to c1 - 1 of z:= Q2 * z, Q2 the reflectors of the bulge chasing in
+ * the order they were made. The columns go by groups of 32, which stay in cache
+ * while all the reflectors are applied to them. */
+static void cj_Eig_ormtr (cj_Eig_work *work, int c0, int c1) {
+  int n = work->n, i, q, c, g, r, st, ed;
+  double *v, tau, s, *z;
+
+  for (g = c0; g < c1; g += 32) {
+    for (i = n - 3; i >= 0; i--) {
+      for (q = (n - 2 - i)/work->b; q >= 0; q--) {
+        cj_Eig_block(work, i, q, &st, &ed);
+        v = work->v + ((size_t) i*work->nq + q)*work->b;
+        tau = work->tau[(size_t) i*work->nq + q];
+        if (tau == 0.0) continue;
+        for (c = g; c < min(c1, g + 32); c++) {
+          z = work->z + (size_t) c*n + st;
+          for (s = 0.0, r = 0; r <= ed - st; r++) s += v[r]*z[r];
+          s *= tau;
+          for (r = 0; r <= ed - st; r++) z[r] -= s*v[r];
+        }
+      }
+    }
+  }
+}
+
+/* Run a cj_Eig tile kernel on host copies of its arguments, the work in task->t:
+ *   TRANS: A21:= A11' (iarg[0] = 0, or the lower triangle of A11 mirrored) or
+ *          A11 and A21 swapped and transposed (iarg[0] = 1, or A11 transposed)
+ *   SBTRD: the band of columns iarg[1] to iarg[1] + b - 1 out of the blocks
+ *          of A from their diagonal on (iarg[0] = -1), or block iarg[1] of
+ *          sweep iarg[0]
+ *   STEBZ: eigenvalues iarg[1] to iarg[2] - 1
+ *   STEIN: eigenvectors iarg[1] to iarg[2] - 1
+ *   ORMTR: columns iarg[1] to iarg[2] - 1 of the eigenvectors by Q2
+ *          (iarg[0] = 0), or into the tile of Z at (iarg[1], iarg[2])
+ * The last three and the bulge chasing only take a tile of cj_Eig's token
+ * matrix, which orders them by the columns they work on. */
+static void cj_Eig_host (cj_Task *task, cj_Matrix **x, char **x_ptr, int *ldx) {
+  cj_Eig_work *work = (cj_Eig_work *) task->t;
+  int narg = cj_Dqueue_get_size(task->arg), *iarg = task->iarg, i, j, k, r;
+  double value, *y;
+
+  if (task->tasktype == CJ_TASK_TRANS) {
+    cj_eleType type = x[0]->eletype;
+    for (j = 0; j < x[0]->n; j++) {
+      for (i = (narg == 1) ? j + 1 : 0; i < x[0]->m; i++) {
+        value = cj_Lapack_get(type, x_ptr[0], ldx[0], i, j);
+        if (iarg[0] == 1) cj_Lapack_put(type, x_ptr[0], ldx[0], i, j, cj_Lapack_get(type, x_ptr[narg - 1], ldx[narg - 1], j, i));
+        cj_Lapack_put(type, x_ptr[narg - 1], ldx[narg - 1], j, i, value);
+      }
+    }
+  }
+  else if (task->tasktype == CJ_TASK_SBTRD && iarg[0] < 0) {
+    k = iarg[1];
+    for (j = 0; j < x[0]->n; j++) {
+      for (r = 0; r <= work->b; r++) {
+        i = j + r;
+        value = 0.0;
+        if (i < x[0]->m) value = cj_Lapack_get(x[0]->eletype, x_ptr[0], ldx[0], i, j);
+        else if (narg == 3 && i - x[0]->m < x[1]->m)
+          value = cj_Lapack_get(x[1]->eletype, x_ptr[1], ldx[1], i - x[0]->m, j);
+        if (k + i < work->n) *cj_Eig_ab(work, k + i, k + j) = value;
+      }
+    }
+  }
+  else if (task->tasktype == CJ_TASK_SBTRD) {
+    y = (double *) malloc(work->b*sizeof(double));
+    if (!y) cj_Lapack_error("eig", "memory allocation failed.");
+    cj_Eig_sbtrd(work, iarg[0], iarg[1], y);
+    free(y);
+  }
+  else if (task->tasktype == CJ_TASK_STEBZ) cj_Eig_stebz(work, iarg[1], iarg[2]);
+  else if (task->tasktype == CJ_TASK_STEIN) cj_Eig_stein(work, iarg[1], iarg[2]);
+  else if (iarg[0] == 0) cj_Eig_ormtr(work, iarg[1], iarg[2]);
+  else {
+    for (j = 0; j < x[1]->n; j++) {
+      for (i = 0; i < x[1]->m; i++)
+        cj_Lapack_put(x[1]->eletype, x_ptr[1], ldx[1], i, j, work->z[iarg[1] + i + (size_t) (iarg[2] + j)*work->n]);
+    }
+  }
+}
+
+/* One task of cj_Eig on the narg tiles X with the integer arguments iarg, see
+ * cj_Eig_host. The last tile is written and the others read, except for the
+ * swaps of TRANS and the sweeps of SBTRD, which write all of their tiles. */
+static void cj_Eig_task (cj_taskType tasktype, int iarg0, int iarg1, int iarg2, cj_Eig_work *work, cj_Object **X, int narg) {
+  int iarg[4] = {iarg0, iarg1, iarg2, 0};
+  const char *name;
+
+  if (tasktype == CJ_TASK_TRANS) name = "Trans";
+  else if (tasktype == CJ_TASK_SBTRD) name = "Sbtrd";
+  else if (tasktype == CJ_TASK_STEBZ) name = "Stebz";
+  else if (tasktype == CJ_TASK_STEIN) name = "Stein";
+  else name = "Ormtr";
+
+  cj_Lapack_task(tasktype, &cj_Eig_host, name, iarg, (char *) work, 0, X,
+      ((tasktype == CJ_TASK_TRANS && iarg0 == 1) || (tasktype == CJ_TASK_SBTRD && iarg0 >= 0)) ?
+      (1 << narg) - 1 : 1 << (narg - 1), narg);
+}
+
+/* X:= the block of A at (i, j), at most m x n and cut at the edges of A and of
+ * the tile of its first element, X a duplicate of A. */
+static void cj_Eig_view (cj_Object *A, cj_Object *X, int i, int j, int m, int n) {
+  cj_Matrix *a = A->matrix, *x = X->matrix;
+  x->offm = a->offm + i;
+  x->offn = a->offn + j;
+  x->m = min(min(m, a->m - i), BLOCK_SIZE - x->offm%BLOCK_SIZE);
+  x->n = min(min(n, a->n - j), BLOCK_SIZE - x->offn%BLOCK_SIZE);
+}
+
+/* T of the reflectors of panel k of A on the tile row of i, b x b, in the
+ * workspace T of cj_Eig. */
+static char *cj_Eig_t (char *T, cj_Object *A, int b, int i, int k) {
+  int nt = (A->matrix->m - 1)/BLOCK_SIZE + 1;
+  return T + ((size_t) (k/b)*nt + i/BLOCK_SIZE)*b*b*A->matrix->elelen;
+}
+
+/* Panel k of the reduction to band, columns k to k + b - 1 of A: its rows from
+ * p = k + b on are reduced to their first b, if factor, by a GEQRT of the rows
+ * of the tile of p and a flat chain of TS kernels on the tiles below, and the
+ * Q' (trans = 'T') or Q ('N') of the panel is applied to the same rows of C
+ * from column j0 on. */
+static void cj_Eig_qr (cj_Object *A, char *T, int b, int k, cj_Bool factor, char trans, cj_Object *C, int j0) {
+  cj_Object *V, *R, *C1, *C2;
+  int m = A->matrix->m, p = k + b, i0 = p - p%BLOCK_SIZE, nt = (m - i0 - 1)/BLOCK_SIZE + 1, s, i, j;
+  char *t;
+
+  V = cj_Object_new(CJ_MATRIX); R = cj_Object_new(CJ_MATRIX);
+  C1 = cj_Object_new(CJ_MATRIX); C2 = cj_Object_new(CJ_MATRIX);
+  cj_Matrix_duplicate(A, V); cj_Matrix_duplicate(A, R);
+  cj_Matrix_duplicate(C, C1); cj_Matrix_duplicate(C, C2);
+  cj_Eig_view(A, R, p, k, b, b);
+
+  for (s = 0; s < nt; s++) {
+    i = i0 + ((trans == 'T') ? s : nt - 1 - s)*BLOCK_SIZE;
+    if (i < p) i = p;
+    cj_Eig_view(A, V, i, k, m, b);
+    t = cj_Eig_t(T, A, b, i, k);
+    if (factor == TRUE) cj_Qr_task((i == p) ? CJ_TASK_GEQRT : CJ_TASK_TPQRT, 0, trans, t, b, V, (i == p) ? NULL : R, NULL);
+    for (j = j0; j < C->matrix->n; j += C1->matrix->n) {
+      cj_Eig_view(C, C1, p, j, (i == p) ? m : b, C->matrix->n);
+      cj_Eig_view(C, C2, i, j, m, C->matrix->n);
+      if (i == p) cj_Qr_task(CJ_TASK_GEMQRT, 0, trans, t, b, V, C1, NULL);
+      else cj_Qr_task(CJ_TASK_TPMQRT, 0, trans, t, b, V, C1, C2);
+    }
+  }
+}
+
+/* The trailing matrix of A from (p, p) on transposed, or with swap = 0 all of
+ * A made symmetric from its lower triangle, by blocks cut at the tile edges. */
+static void cj_Eig_trans (cj_Object *A, int p, int swap) {
+  cj_Object *X[2];
+  int i, j, nj, n = A->matrix->n;
+
+  X[0] = cj_Object_new(CJ_MATRIX); X[1] = cj_Object_new(CJ_MATRIX);
+  cj_Matrix_duplicate(A, X[0]); cj_Matrix_duplicate(A, X[1]);
+  for (j = p; j < n; j += nj) {
+    cj_Eig_view(A, X[0], j, j, n, n);
+    nj = X[0]->matrix->n;
+    cj_Eig_task(CJ_TASK_TRANS, swap, 0, 0, NULL, X, 1);
+    for (i = j + nj; i < n; i += X[0]->matrix->m) {
+      cj_Eig_view(A, X[0], i, j, n, n);
+      cj_Eig_view(A, X[1], j, i, n, n);
+      cj_Eig_task(CJ_TASK_TRANS, swap, 0, 0, NULL, X, 2);
+    }
+  }
+}
+
+/* The tiles of the token matrix S over columns c0 to c1 of the band, one tile
+ * to every b columns. */
+static int cj_Eig_tokens (cj_Object *S, int b, int c0, int c1, cj_Object **X) {
+  int narg = 0, g;
+  for (g = c0/b; g <= c1/b; g++) cj_Matrix_tile(S, X[narg++], 0, g*BLOCK_SIZE);
+  return narg;
+}
+
+/**
+ * @brief  Eigenvalues, and eigenvectors if Z is set, of a symmetric A, by a two
+ *         stage reduction to tridiagonal form. A is first reduced to a band
+ *         of b = EIG_NB subdiagonals (BLOCK_SIZE if EIG_NB does not divide
+ *         it) by tasks on blocks inside the tiles: a QR of each panel of b
+ *         columns below the band with the TS kernels of cj_Qr, whose Q is
+ *         applied to the trailing matrix from the left, then, across a
+ *         transposition of its blocks, from the right. The band is then
+ *         reduced to tridiagonal form by bulge chasing, a task to each block
+ *         of a sweep, pipelined behind the sweeps before it by a token to
+ *         every b columns. The eigenvalues come from
+ *         bisection and the eigenvectors from inverse iteration, each task on
+ *         a range of them, and the eigenvectors are taken back by the
+ *         reflectors of both stages, those of the first by tile tasks on Z.
+ *         Returns when all is done.
+ * @param  *A symmetric matrix, n x n, of which the lower triangle is read;
+ *         overwritten by the reflectors of the first stage
+ * @param  *w n doubles, set to the eigenvalues in ascending order
+ * @param  *Z NULL, or n x n of the precision of A, set to the eigenvectors,
+ *         the j-th of them in column j
+ */
+void cj_Eig (cj_Object *A, double *w, cj_Object *Z) {
+  cj_Object *S, *X[3], *Zij;
+  cj_Eig_work work;
+  cj_Matrix *a;
+  int n, nt, ntok, b, i, j, k, q, l, u, narg, st, ed, pst, ped;
+  double ortol, r, emax = 0.0;
+  char *T, *token;
+
+  if (!A || A->objtype != CJ_MATRIX || !w)
+    cj_Lapack_error("eig", "matrice or w haven't been initialized yet.");
+  a = A->matrix;
+  if (a->m != a->n) 
+    cj_Lapack_error("eig", "matrice is not a square matrix.");
+  if (Z && (Z->objtype != CJ_MATRIX || Z->matrix->m != a->m || Z->matrix->n != a->n || Z->matrix->eletype != a->eletype))
+    cj_Lapack_error("eig", "Z does not fit the eigenvectors of A.");
+  n = a->n;
+  if (n == 0) return;
+  nt = (n - 1)/BLOCK_SIZE + 1;
+
+  /* The panels of b columns must not cross the tiles. */
+  b = (BLOCK_SIZE%EIG_NB == 0) ? EIG_NB : BLOCK_SIZE;
+  b = max(1, min(b, n - 1));
+  ntok = (n - 1)/b + 1;
+
+  work.n = n;
+  work.b = b;
+  work.ldab = 2*b + 1;
+  work.nq = (n - 2)/b + 1;
+  work.ab = (double *) calloc((size_t) work.ldab*n + (size_t) (work.nq + 1)*n*(b + 1) + 2*n, sizeof(double));
+  work.z = Z ? (double *) malloc((size_t) n*n*sizeof(double)) : NULL;
+  T = (char *) malloc((size_t) ntok*nt*b*b*a->elelen);
+  token = (char *) malloc((size_t) ntok*BLOCK_SIZE*sizeof(double));
+  if (!work.ab || (Z && !work.z) || !T || !token) cj_Lapack_error("eig", "memory allocation failed.");
+  work.v = work.ab + (size_t) work.ldab*n;
+  work.tau = work.v + (size_t) n*work.nq*b;
+  work.d = work.tau + (size_t) n*work.nq;
+  work.e = work.d + n;
+  work.w = w;
+
+  S = cj_Object_new(CJ_MATRIX);
+  cj_Matrix_attach(S, 1, ntok*BLOCK_SIZE, token);
+  for (i = 0; i < 3; i++) { X[i] = cj_Object_new(CJ_MATRIX); cj_Matrix_duplicate(A, X[i]); }
+
+  /* A = Q1 * B * Q1', B of bandwidth b, then B = Q2 * T * Q2' */
+  cj_Queue_end();
+  cj_Eig_trans(A, 0, 0);
+  for (k = 0; k + b < n; k += b) {
+    cj_Eig_qr(A, T, b, k, TRUE, 'T', A, k + b);
+    cj_Eig_trans(A, k + b, 1);
+    cj_Eig_qr(A, T, b, k, FALSE, 'T', A, k + b);
+  }
+  for (k = 0; k < n; k += b) {
+    narg = 2;
+    cj_Matrix_duplicate(A, X[0]); cj_Matrix_duplicate(A, X[1]);
+    cj_Eig_view(A, X[0], k, k, 2*b, b);
+    if (X[0]->matrix->m < min(2*b, n - k)) {
+      cj_Eig_view(A, X[1], k + X[0]->matrix->m, k, 2*b - X[0]->matrix->m, b);
+      narg = 3;
+    }
+    cj_Matrix_duplicate(S, X[narg - 1]);
+    cj_Matrix_tile(S, X[narg - 1], 0, k/b*BLOCK_SIZE);
+    cj_Eig_task(CJ_TASK_SBTRD, -1, k, 0, &work, X, narg);
+  }
+  for (i = 0; i < 3; i++) cj_Matrix_duplicate(S, X[i]);
+  for (i = 0; i + 2 < n; i++) {
+    for (q = 0; q <= (n - 2 - i)/b; q++) {
+      cj_Eig_block(&work, i, q, &st, &ed);
+      if (q == 0) pst = i;
+      else cj_Eig_block(&work, i, q - 1, &pst, &ped);
+      narg = cj_Eig_tokens(S, b, pst, ed, X);
+      cj_Eig_task(CJ_TASK_SBTRD, i, q, 0, &work, X, narg);
+    }
+  }
+  cj_Queue_begin();
+  cj_Sync();
+
+  /* The tridiagonal T, its norm and Gershgorin bounds. */
+  for (i = 0; i < n; i++) {
+    work.d[i] = *cj_Eig_ab(&work, i, i);
+    work.e[i] = (i < n - 1) ? *cj_Eig_ab(&work, i + 1, i) : 0.0;
+    emax = fmax(emax, work.e[i]*work.e[i]);
+  }
+  work.tnrm = 0.0; work.gl = HUGE_VAL; work.gu = -HUGE_VAL;
+  for (i = 0; i < n; i++) {
+    r = fabs(work.e[i]) + ((i > 0) ? fabs(work.e[i - 1]) : 0.0);
+    work.tnrm = fmax(work.tnrm, fabs(work.d[i]) + r);
+    work.gl = fmin(work.gl, work.d[i] - r);
+    work.gu = fmax(work.gu, work.d[i] + r);
+  }
+  work.pivmin = DBL_MIN*fmax(1.0, emax);
+  work.gl -= 2.0*DBL_EPSILON*work.tnrm + 2.0*work.pivmin;
+  work.gu += 2.0*DBL_EPSILON*work.tnrm + 2.0*work.pivmin;
+
+  cj_Queue_end();
+  for (j = 0; j < n; j += BLOCK_SIZE) {
+    cj_Matrix_tile(S, X[0], 0, j);
+    cj_Eig_task(CJ_TASK_STEBZ, 0, j, min(n, j + BLOCK_SIZE), &work, X, 1);
+  }
+  cj_Queue_begin();
+  cj_Sync();
+
+  if (Z) {
+    /* Ranges of eigenvectors of a tile or more, ending with their clusters. */
+    ortol = 1e-3*work.tnrm;
+    cj_Queue_end();
+    for (l = 0; l < n; l = u) {
+      for (u = min(n, l + BLOCK_SIZE); u < n && w[u] - w[u - 1] <= ortol; u++);
+      cj_Matrix_tile(S, X[0], 0, l - l%BLOCK_SIZE);
+      cj_Eig_task(CJ_TASK_STEIN, 0, l, u, &work, X, 1);
+    }
+    cj_Queue_begin();
+    cj_Sync();
+
+    /* Z = Q1 * Q2 * Z */
+    Zij = cj_Object_new(CJ_MATRIX);
+    cj_Matrix_duplicate(Z, Zij);
+    cj_Queue_end();
+    for (j = 0; j < n; j += BLOCK_SIZE) {
+      cj_Matrix_tile(S, X[0], 0, j);
+      cj_Eig_task(CJ_TASK_ORMTR, 0, j, min(n, j + BLOCK_SIZE), &work, X, 1);
+      for (i = 0; i < n; i += BLOCK_SIZE) {
+        cj_Matrix_tile(Z, Zij, i, j);
+        X[1] = Zij;
+        cj_Eig_task(CJ_TASK_ORMTR, 1, i, j, &work, X, 2);
+      }
+    }
+    for (k = ((n - 1)/b - 1)*b; k >= 0; k -= b) cj_Eig_qr(A, T, b, k, FALSE, 'N', Z, 0);
+    cj_Queue_begin();
+    cj_Sync();
+    free(work.z);
+  }
+  cj_Matrix_detach(S);
+  free(token); free(T);
+  free(work.ab);
+}
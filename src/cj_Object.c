@@ -9,6 +9,10 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include <cj.h>
 
@@ -143,6 +147,22 @@ void cj_Dqueue_push_tail (cj_Object *object, cj_Object *target) {
   dqueue->size ++;
 }
 
+/* Unlink a member of the dqueue. */
+void cj_Dqueue_remove (cj_Object *object, cj_Object *target) {
+  if (object->objtype != CJ_DQUEUE) {
+    cj_Object_error("Dqueue_remove", "The object is not a dqueue.");
+  }
+  cj_Dqueue *dqueue = object->dqueue;
+
+  if (target->prev) target->prev->next = target->next;
+  else dqueue->head = target->next;
+  if (target->next) target->next->prev = target->prev;
+  else dqueue->tail = target->prev;
+  target->prev = NULL;
+  target->next = NULL;
+  dqueue->size --;
+}
+
 cj_Object *cj_Dqueue_get_head (cj_Object *object) {
   if (object->objtype != CJ_DQUEUE) {
     cj_Object_error("Dqueue_get_head", "The object is not a dqueue.");
@@ -177,8 +197,9 @@ void cj_Matrix_duplicate (cj_Object *object, cj_Object *target) {
   cj_Matrix *base = object->matrix;
   cj_Matrix *copy = target->matrix;
 
-  copy->eletype = base->eletype;
-  copy->elelen  = base->elelen;
+  /* Partitions only track the shape; the precision is the one of the base. */
+  copy->eletype = base->base ? base->base->eletype : base->eletype;
+  copy->elelen  = base->base ? base->base->elelen : base->elelen;
   copy->m       = base->m;
   copy->n       = base->n;
   copy->mb      = base->mb;
@@ -186,19 +207,150 @@ void cj_Matrix_duplicate (cj_Object *object, cj_Object *target) {
   copy->offm    = base->offm;
   copy->offn    = base->offn;
   copy->base    = base->base;
+  copy->layout  = base->layout;
+  copy->tile_off = base->tile_off;
   //copy->buff    = base->buff;
 }
 
-void cj_Matrix_set (cj_Object *object, int m, int n) {
+/* Point T, a duplicate of X, at the tile of X starting at element (i, j) of X. */
+void cj_Matrix_tile (cj_Object *X, cj_Object *T, int i, int j) {
+  cj_Matrix *x = X->matrix, *t = T->matrix;
+  t->offm = x->offm + i;
+  t->offn = x->offn + j;
+  t->m = min(BLOCK_SIZE, x->m - i);
+  t->n = min(BLOCK_SIZE, x->n - j);
+}
+
+/* Interleave the bits of a tile index, row bits in the even positions. */
+static uint64_t cj_Matrix_morton (uint32_t i, uint32_t j) {
+  uint64_t key = 0;
+  int b;
+  for (b = 0; b < 32; b++) {
+    key |= (uint64_t) ((i >> b) & 1) << (2*b);
+    key |= (uint64_t) ((j >> b) & 1) << (2*b + 1);
+  }
+  return key;
+}
+
+static int cj_Matrix_morton_order (const void *a, const void *b) {
+  uint64_t ka = ((const uint64_t *) a)[0], kb = ((const uint64_t *) b)[0];
+  return (ka < kb) ? -1 : (ka > kb);
+}
+
+/**
+ * @brief  Compute where the tiles of an m x n matrix lie in a layout. In the
+ *         tile layouts each tile is stored column major with leading dimension
+ *         its own height, and starts on a page of its own, or on a cache line
+ *         of its own if it is smaller than a page.
+ * @param  m number of rows
+ * @param  n number of columns
+ * @param  elelen element length in bytes
+ * @param  layout the layout
+ * @param  *off return the byte offset of tile (i, j) at i + j*mb, may be NULL
+ * @return length of the matrix in bytes
+ */
+size_t cj_Matrix_tile_offsets (int m, int n, size_t elelen, cj_layoutType layout, size_t *off) {
+  int mb = (m - 1)/BLOCK_SIZE + 1, nb = (n - 1)/BLOCK_SIZE + 1;
+  int i, j, k;
+  size_t len = 0;
+
+  if (layout == CJ_LAYOUT_COLUMN) {
+    if (off) {
+      for (j = 0; j < nb; j++) {
+        for (i = 0; i < mb; i++) off[i + j*mb] = ((size_t) m*j*BLOCK_SIZE + i*BLOCK_SIZE)*elelen;
+      }
+    }
+    return (size_t) m*n*elelen;
+  }
+
+  uint64_t (*order)[2] = malloc((size_t) mb*nb*sizeof(uint64_t[2]));
+  if (!order) cj_Object_error("Matrix_tile_offsets", "memory allocation failed.");
+  for (j = 0; j < nb; j++) {
+    for (i = 0; i < mb; i++) {
+      order[i + j*mb][0] = (layout == CJ_LAYOUT_MORTON) ? cj_Matrix_morton(i, j) : (uint64_t) (i + j*mb);
+      order[i + j*mb][1] = i + j*mb;
+    }
+  }
+  if (layout == CJ_LAYOUT_MORTON) qsort(order, (size_t) mb*nb, sizeof(uint64_t[2]), cj_Matrix_morton_order);
+
+  for (k = 0; k < mb*nb; k++) {
+    i = order[k][1]%mb;
+    j = order[k][1]/mb;
+    size_t tile = (size_t) min(BLOCK_SIZE, m - i*BLOCK_SIZE)*min(BLOCK_SIZE, n - j*BLOCK_SIZE)*elelen;
+    size_t align = (tile >= TILE_ALIGN_PAGE) ? TILE_ALIGN_PAGE : TILE_ALIGN_LINE;
+    len = ((len + align - 1)/align)*align;
+    if (off) off[order[k][1]] = len;
+    len += tile;
+  }
+  free(order);
+  return len;
+}
+
+/**
+ * @brief  Address of element (i, j) of a base matrix, in any layout.
+ * @param  *base the base matrix
+ * @param  i row index
+ * @param  j column index
+ * @param  *ld return the leading dimension around the element, may be NULL
+ * @return the address in main memory
+ */
+char *cj_Matrix_addr (cj_Matrix *base, int i, int j, int *ld) {
+  int ti, tj, ldt;
+
+  if (base->layout == CJ_LAYOUT_COLUMN) {
+    if (ld) *ld = base->m;
+    return base->buff + ((size_t) base->m*j + i)*base->elelen;
+  }
+  ti  = i/BLOCK_SIZE;
+  tj  = j/BLOCK_SIZE;
+  ldt = min(BLOCK_SIZE, base->m - ti*BLOCK_SIZE);
+  if (ld) *ld = ldt;
+  return base->buff + base->tile_off[ti + tj*base->mb] + 
+    ((size_t) ldt*(j - tj*BLOCK_SIZE) + i - ti*BLOCK_SIZE)*base->elelen;
+}
+
+/**
+ * @brief  Choose the layout of a matrix before it is set up. Tile kernels on 
+ *         a matrix stored in a tile layout get the leading dimension of the 
+ *         tile, and its device transfers are flat copies. cj_Copy converts
+ *         between matrices of different layouts.
+ * @param  *object matrix object
+ * @param  layout the layout
+ */
+void cj_Matrix_set_layout (cj_Object *object, cj_layoutType layout) {
   if (object->objtype != CJ_MATRIX) {
-    cj_Object_error("Matrix_set", "The object is not a matrix.");
+    cj_Object_error("Matrix_set_layout", "The object is not a matrix.");
   }
-  if (m <= 0 && n <= 0) {
-    cj_Object_error("Matrix_set", "m and n should at least be 1.");
+  if (object->matrix->buff) {
+    cj_Object_error("Matrix_set_layout", "The matrix has been set up already.");
   }
+  object->matrix->layout = layout;
+}
+
+/**
+ * @brief  Choose the precision of a matrix before it is set up. Matrices are
+ *         double precision by default; cj_Copy converts between precisions.
+ * @param  *object matrix object
+ * @param  eletype CJ_SINGLE or CJ_DOUBLE
+ */
+void cj_Matrix_set_eletype (cj_Object *object, cj_eleType eletype) {
+  if (object->objtype != CJ_MATRIX) {
+    cj_Object_error("Matrix_set_eletype", "The object is not a matrix.");
+  }
+  if (object->matrix->buff) {
+    cj_Object_error("Matrix_set_eletype", "The matrix has been set up already.");
+  }
+  if (eletype == CJ_SINGLE) object->matrix->elelen = sizeof(float);
+  else if (eletype == CJ_DOUBLE) object->matrix->elelen = sizeof(double);
+  else cj_Object_error("Matrix_set_eletype", "Only single and double precision are supported.");
+  object->matrix->eletype = eletype;
+}
+
+/* Set up the tiles of a matrix whose memory is in place. */
+static void cj_Matrix_set_tiles (cj_Object *object, int m, int n) {
   cj_Matrix *matrix = object->matrix;
+  cj_Object *tile;
   int i, j;
-  size_t elelen = matrix->elelen;
 
   matrix->m     = m;
   matrix->n     = n;
@@ -207,15 +359,7 @@ void cj_Matrix_set (cj_Object *object, int m, int n) {
   matrix->offm  = 0;
   matrix->offn  = 0;
   matrix->base  = object->matrix;
-#ifdef CJ_HAVE_CUDA
-  cudaMallocHost((void**)&(matrix->buff), m*n*elelen);
-#else
-  matrix->buff  = (char *) malloc(m*n*elelen);
-#endif
 
-  if (!matrix->buff) {
-    cj_Object_error("Matrix_set", "memory allocation failed.");
-  }
   matrix->rset = (cj_Object ***) malloc((matrix->mb)*sizeof(cj_Object**));
   matrix->wset = (cj_Object ***) malloc((matrix->mb)*sizeof(cj_Object**));
   matrix->dist = (cj_Distribution ***) malloc((matrix->mb)*sizeof(cj_Distribution**));
@@ -224,6 +368,12 @@ void cj_Matrix_set (cj_Object *object, int m, int n) {
     cj_Object_error("Matrix_set", "memory allocation failed.");
   }
 
+  if (matrix->layout != CJ_LAYOUT_COLUMN) {
+    matrix->tile_off = (size_t *) malloc((size_t) matrix->mb*matrix->nb*sizeof(size_t));
+    if (!matrix->tile_off) cj_Object_error("Matrix_set", "memory allocation failed.");
+    cj_Matrix_tile_offsets(m, n, matrix->elelen, matrix->layout, matrix->tile_off);
+  }
+
   for (i = 0; i < matrix->mb; i++) {
     matrix->rset[i] = (cj_Object **) malloc(matrix->nb*sizeof(cj_Object*));
     matrix->wset[i] = (cj_Object **) malloc(matrix->nb*sizeof(cj_Object*));
@@ -242,12 +392,303 @@ void cj_Matrix_set (cj_Object *object, int m, int n) {
         cj_Object_error("Matrix_set", "memory allocation failed.");
       }
 
+      /* Copies always move the whole tile, even for a task on a partition
+       * cutting through it. */
+      tile = cj_Object_new(CJ_MATRIX);
+      cj_Matrix_duplicate(object, tile);
+      tile->matrix->m    = min(BLOCK_SIZE, m - i*BLOCK_SIZE);
+      tile->matrix->n    = min(BLOCK_SIZE, n - j*BLOCK_SIZE);
+      tile->matrix->offm = i*BLOCK_SIZE;
+      tile->matrix->offn = j*BLOCK_SIZE;
+      matrix->dist[i][j]->tile = tile;
+
       //cj_Lock_new(&(matrix->dist[i][j]->lock));
     }
   }
 }
 
+void cj_Matrix_set (cj_Object *object, int m, int n) {
+  if (object->objtype != CJ_MATRIX) {
+    cj_Object_error("Matrix_set", "The object is not a matrix.");
+  }
+  if (m <= 0 && n <= 0) {
+    cj_Object_error("Matrix_set", "m and n should at least be 1.");
+  }
+  cj_Matrix *matrix = object->matrix;
+  size_t len = cj_Matrix_tile_offsets(m, n, matrix->elelen, matrix->layout, NULL);
+
+#ifdef CJ_HAVE_CUDA
+  cudaMallocHost((void**)&(matrix->buff), len);
+#else
+  matrix->buff  = (char *) malloc(len);
+#endif
+
+  if (!matrix->buff) {
+    cj_Object_error("Matrix_set", "memory allocation failed.");
+  }
+  matrix->pinned = TRUE;
+  cj_Matrix_set_tiles(object, m, n);
+}
+
+/**
+ * @brief  Set up a matrix on memory owned by the caller, stored in the layout
+ *         of the matrix (column major with leading dimension m by default). 
+ *         The memory is pageable, so device copies go through the pinned 
+ *         staging buffers of the device.
+ * @param  *object matrix object
+ * @param  m number of rows
+ * @param  n number of columns
+ * @param  *buff the caller's memory, kept until cj_Matrix_detach
+ */
+void cj_Matrix_attach (cj_Object *object, int m, int n, char *buff) {
+  if (object->objtype != CJ_MATRIX) {
+    cj_Object_error("Matrix_attach", "The object is not a matrix.");
+  }
+  if (m <= 0 && n <= 0) {
+    cj_Object_error("Matrix_attach", "m and n should at least be 1.");
+  }
+  if (!buff) {
+    cj_Object_error("Matrix_attach", "no memory to attach.");
+  }
+  object->matrix->buff   = buff;
+  object->matrix->pinned = FALSE;
+  cj_Matrix_set_tiles(object, m, n);
+}
+
+/**
+ * @brief  Give back the memory of a matrix set by cj_Matrix_attach, once the
+ *         tasks on it are done. The copies of its tiles on the devices are
+ *         dropped without being written back, so the caller may free the
+ *         memory afterwards; the content of the matrix is lost.
+ * @param  *object matrix object
+ */
+void cj_Matrix_detach (cj_Object *object) {
+  if (object->objtype != CJ_MATRIX) {
+    cj_Object_error("Matrix_detach", "The object is not a matrix.");
+  }
+  cj_Matrix *matrix = object->matrix;
+  cj_Distribution *dist;
+  int i, j;
+
+  for (i = 0; i < matrix->mb; i++) {
+    for (j = 0; j < matrix->nb; j++) {
+      dist = matrix->dist[i][j];
+      cj_Lock_acquire(&dist->lock);
+      cj_Distribution_write(dist, 0);
+      cj_Lock_release(&dist->lock);
+    }
+  }
+  matrix->buff = NULL;
+}
+
+/* ---------------------------------------------------------------------
+ * cj_Disk
+ * ---------------------------------------------------------------------
+ * The tiles of a disk-backed matrix live in a file mapped at buff. The main
+ * memory holds a bounded set of them, replaced least recently used first:
+ * an evicted tile is written to the file and its pages are dropped, so the
+ * next access reads it back. 
+ * */
+
+#define CJ_DISK_PREFETCH 0
+#define CJ_DISK_EVICT 1
+
+static cj_Lock disk_lock;
+static cj_Object *disk_lru = NULL;
+static size_t disk_used = 0, disk_budget = DISK_CACHE;
+
+/* Apply op to the pages holding a tile, column pieces sharing pages merged. */
+static void cj_Disk_pages (cj_Matrix *matrix, int op) {
+  cj_Matrix *base = matrix->base;
+  uintptr_t start = (uintptr_t) base->buff, lo = 0, hi = 0, l = 0, h = 0;
+  size_t page = (size_t) sysconf(_SC_PAGESIZE);
+  int j;
+
+  for (j = 0; j <= matrix->n; j++) {
+    if (j < matrix->n) {
+      l = (uintptr_t) cj_Matrix_addr(base, matrix->offm, matrix->offn + j, NULL) - start;
+      h = l + matrix->m*base->elelen;
+      l = start + (l/page)*page;
+      h = start + ((h + page - 1)/page)*page;
+      if (j > 0 && l <= hi) {
+        hi = max(hi, h);
+        continue;
+      }
+    }
+    if (j > 0) {
+      if (hi > start + base->map_len) hi = start + base->map_len;
+      if (op == CJ_DISK_PREFETCH) {
+        madvise((void *) lo, hi - lo, MADV_WILLNEED);
+      }
+      else {
+        msync((void *) lo, hi - lo, MS_SYNC);
+        madvise((void *) lo, hi - lo, MADV_DONTNEED);
+        posix_fadvise(base->fd, base->map_off + (lo - start), hi - lo, POSIX_FADV_DONTNEED);
+      }
+    }
+    lo = l;
+    hi = h;
+  }
+}
+
+/**
+ * @brief  Set the main memory the disk tier may fill, in bytes.
+ * @param  len memory length in bytes
+ */
+void cj_Disk_budget (size_t len) {
+  disk_budget = len;
+}
+
+/**
+ * @brief  Record a use of a tile in main memory. Tiles of disk-backed matrices
+ *         become the most recently used, and the least recently used ones are
+ *         written back and dropped while the tier is over its budget.
+ * @param  *target the tile
+ */
+void cj_Disk_touch (cj_Object *target) {
+  cj_Matrix *matrix = target->matrix;
+  cj_Matrix *base = matrix->base;
+  cj_Object *victim[CACHE_LINE];
+  cj_Distribution *dist;
+  int i, nvictim = 0;
+
+  if (base->fd == -1) return;
+  dist = base->dist[matrix->offm/BLOCK_SIZE][matrix->offn/BLOCK_SIZE];
+
+  cj_Lock_acquire(&disk_lock);
+  {
+    if (dist->resident == TRUE) {
+      cj_Dqueue_remove(disk_lru, dist->lru);
+    }
+    else {
+      dist->resident = TRUE;
+      disk_used += (size_t) dist->tile->matrix->m*dist->tile->matrix->n*base->elelen;
+    }
+    cj_Dqueue_push_tail(disk_lru, dist->lru);
+
+    while (disk_used > disk_budget && nvictim < CACHE_LINE && disk_lru->dqueue->head != dist->lru) {
+      cj_Distribution *old = cj_Dqueue_pop_head(disk_lru)->distribution;
+      old->resident = FALSE;
+      disk_used -= (size_t) old->tile->matrix->m*old->tile->matrix->n*old->tile->matrix->base->elelen;
+      victim[nvictim ++] = old->tile;
+    }
+  }
+  cj_Lock_release(&disk_lock);
+
+  /* The file keeps the data, so a tile used meanwhile is only read again. */
+  for (i = 0; i < nvictim; i++) cj_Disk_pages(victim[i]->matrix, CJ_DISK_EVICT);
+}
+
+/**
+ * @brief  Start reading a tile of a disk-backed matrix into main memory, 
+ *         without waiting for it.
+ * @param  *target the tile
+ */
+void cj_Disk_prefetch (cj_Object *target) {
+  if (cj_Disk_resident(target) == TRUE) return;
+  cj_Disk_touch(target);
+  cj_Disk_pages(target->matrix, CJ_DISK_PREFETCH);
+}
+
+/**
+ * @brief  Whether a tile is held in main memory. Tiles of matrices which are
+ *         not disk-backed always are.
+ * @param  *target the tile
+ * @return TRUE if the tile is resident
+ */
+cj_Bool cj_Disk_resident (cj_Object *target) {
+  cj_Matrix *matrix = target->matrix;
+  cj_Matrix *base = matrix->base;
+
+  if (base->fd == -1) return TRUE;
+  return base->dist[matrix->offm/BLOCK_SIZE][matrix->offn/BLOCK_SIZE]->resident;
+}
+
+/**
+ * @brief  Set up a disk-backed matrix on an open file, whose data, in the
+ *         layout of the matrix, start at a page-aligned offset.
+ * @param  *object matrix object
+ * @param  m number of rows
+ * @param  n number of columns
+ * @param  fd file descriptor, kept open by the matrix
+ * @param  off offset of the data in the file
+ * @param  writable FALSE to map the file read-only
+ */
+void cj_Disk_map (cj_Object *object, int m, int n, int fd, size_t off, cj_Bool writable) {
+  cj_Matrix *matrix = object->matrix;
+  size_t len = cj_Matrix_tile_offsets(m, n, matrix->elelen, matrix->layout, NULL);
+  char *buff;
+  int i, j;
+
+  buff = (char *) mmap(NULL, len, (writable == TRUE) ? PROT_READ | PROT_WRITE : PROT_READ, 
+      MAP_SHARED, fd, off);
+  if (buff == MAP_FAILED) cj_Object_error("Disk_map", "Could not map the file.");
+
+  matrix->buff    = buff;
+  matrix->pinned  = FALSE;
+  matrix->fd      = fd;
+  matrix->map_off = off;
+  matrix->map_len = len;
+  cj_Matrix_set_tiles(object, m, n);
+
+  if (!disk_lru) {
+    cj_Lock_new(&disk_lock);
+    disk_lru = cj_Object_new(CJ_DQUEUE);
+  }
+  for (i = 0; i < matrix->mb; i++) {
+    for (j = 0; j < matrix->nb; j++) {
+      cj_Distribution *dist = matrix->dist[i][j];
+      dist->lru = cj_Object_append(CJ_DISTRIBUTION, (void *) dist);
+    }
+  }
+}
+
+/**
+ * @brief  Set up a matrix whose tiles live in a file, stored in the layout of
+ *         the matrix. The file is created or extended as needed, and its
+ *         content is kept. Main memory holds the tiles in use only.
+ * @param  *object matrix object
+ * @param  m number of rows
+ * @param  n number of columns
+ * @param  *filename backing file
+ */
+void cj_Matrix_set_disk (cj_Object *object, int m, int n, const char *filename) {
+  if (object->objtype != CJ_MATRIX) {
+    cj_Object_error("Matrix_set_disk", "The object is not a matrix.");
+  }
+  if (m <= 0 && n <= 0) {
+    cj_Object_error("Matrix_set_disk", "m and n should at least be 1.");
+  }
+  size_t len = cj_Matrix_tile_offsets(m, n, object->matrix->elelen, object->matrix->layout, NULL);
+  struct stat st;
+  int fd;
+
+  fd = open(filename, O_RDWR | O_CREAT, 0644);
+  if (fd == -1) cj_Object_error("Matrix_set_disk", "Could not open the file.");
+  if (fstat(fd, &st) == -1 || ((size_t) st.st_size < len && ftruncate(fd, len) == -1)) {
+    cj_Object_error("Matrix_set_disk", "Could not size the file.");
+  }
+  cj_Disk_map(object, m, n, fd, 0, TRUE);
+}
+
+/**
+ * @brief  Write every tile of a disk-backed matrix held in main memory to its
+ *         file. Call it once the tasks using the matrix are done.
+ * @param  *object matrix object
+ */
+void cj_Matrix_flush_disk (cj_Object *object) {
+  if (object->objtype != CJ_MATRIX) {
+    cj_Object_error("Matrix_flush_disk", "The object is not a matrix.");
+  }
+  cj_Matrix *base = object->matrix->base;
+  if (base->fd == -1) return;
+  if (msync(base->buff, base->map_len, MS_SYNC) == -1) {
+    cj_Object_error("Matrix_flush_disk", "Could not write the file.");
+  }
+}
+
 cj_Matrix *cj_Matrix_new () {
+  int i;
   cj_Matrix *matrix = (cj_Matrix *) malloc(sizeof(cj_Matrix));
   if (!matrix) cj_Object_error("Matrix_new", "memory allocation failed.");
 
@@ -265,6 +706,13 @@ cj_Matrix *cj_Matrix_new () {
   matrix->dist = NULL;
   matrix->base = NULL;
   matrix->buff = NULL;
+  matrix->layout = CJ_LAYOUT_COLUMN;
+  matrix->tile_off = NULL;
+  matrix->pinned = FALSE;
+  matrix->fd = -1;
+  matrix->map_off = 0;
+  matrix->map_len = 0;
+  for (i = 0; i < CJ_STAT_NUM; i++) matrix->stats.count[i] = 0;
   return matrix; 
 }
 
@@ -596,7 +1044,7 @@ void cj_Matrix_cont_with_3x3_to_2x2 (cj_Object *ATL, cj_Object *ATR, cj_Object *
 
   if (quadrant == CJ_TL) {
     atl->m    = a00->m + a10->m;
-    atl->n    = a00->n + a10->n;
+    atl->n    = a00->n + a01->n;
     atl->offm = a00->offm;
     atl->offn = a00->offn;
     atl->base = a00->base;
@@ -713,12 +1161,12 @@ void cj_Matrix_set_lowertril_one (cj_Object *object) {
   for (j = 0; j < matrix->n; j++) {
     for (i = 0; i < matrix->m; i++) {
       if (matrix->eletype == CJ_SINGLE) {
-        ((float *) (matrix->buff))[i + j*matrix->m] = 0.0;
-        if (i >= j) ((float *) (matrix->buff))[i + j*matrix->m] = 1.0;
+        cj_Matrix_elem(matrix, float, i, j) = 0.0;
+        if (i >= j) cj_Matrix_elem(matrix, float, i, j) = 1.0;
       }
       else {
-        ((double *) (matrix->buff))[i + j*matrix->m] = 0.0;
-        if (i >= j) ((double *) (matrix->buff))[i + j*matrix->m] = 1.0;
+        cj_Matrix_elem(matrix, double, i, j) = 0.0;
+        if (i >= j) cj_Matrix_elem(matrix, double, i, j) = 1.0;
       }
     }
   }
@@ -737,16 +1185,16 @@ void cj_Matrix_set_special_chol (cj_Object *object) {
   for (j = 0; j < matrix->n; j++) {
     for (i = 0; i < matrix->m; i++) {
       if (matrix->eletype == CJ_SINGLE) {
-        ((float *) (matrix->buff))[i + j*matrix->m] = 0.0;
+        cj_Matrix_elem(matrix, float, i, j) = 0.0;
 		if ((i == 0 && j == 1) || (i == 1 && j == 0) ) 
-		  ((float *) (matrix->buff))[i + j*matrix->m] = 1.0;
-		else if (i == j) ((float *) (matrix->buff))[i + j*matrix->m] = 2.0;
+		  cj_Matrix_elem(matrix, float, i, j) = 1.0;
+		else if (i == j) cj_Matrix_elem(matrix, float, i, j) = 2.0;
       }
       else {
-        ((double *) (matrix->buff))[i + j*matrix->m] = 0.0;
+        cj_Matrix_elem(matrix, double, i, j) = 0.0;
 		if ((i == 0 && j == 1) || (i == 1 && j == 0) ) 
-		  ((double *) (matrix->buff))[i + j*matrix->m] = 1.0;
-		else if (i == j) ((double *) (matrix->buff))[i + j*matrix->m] = 2.0;
+		  cj_Matrix_elem(matrix, double, i, j) = 1.0;
+		else if (i == j) cj_Matrix_elem(matrix, double, i, j) = 2.0;
       }
     }
   }
@@ -763,12 +1211,12 @@ void cj_Matrix_set_2identity (cj_Object *object) {
   for (j = 0; j < matrix->n; j++) {
     for (i = 0; i < matrix->m; i++) {
       if (matrix->eletype == CJ_SINGLE) {
-        ((float *) (matrix->buff))[i + j*matrix->m] = 0.0;
-        if (i == j) ((float *) (matrix->buff))[i + j*matrix->m] = 2.0;
+        cj_Matrix_elem(matrix, float, i, j) = 0.0;
+        if (i == j) cj_Matrix_elem(matrix, float, i, j) = 2.0;
       }
       else {
-        ((double *) (matrix->buff))[i + j*matrix->m] = 0.0;
-        if (i == j) ((double *) (matrix->buff))[i + j*matrix->m] = 2.0;
+        cj_Matrix_elem(matrix, double, i, j) = 0.0;
+        if (i == j) cj_Matrix_elem(matrix, double, i, j) = 2.0;
       }
     }
   }
@@ -785,12 +1233,12 @@ void cj_Matrix_set_identity (cj_Object *object) {
   for (j = 0; j < matrix->n; j++) {
     for (i = 0; i < matrix->m; i++) {
       if (matrix->eletype == CJ_SINGLE) {
-        ((float *) (matrix->buff))[i + j*matrix->m] = 0.0;
-        if (i == j) ((float *) (matrix->buff))[i + j*matrix->m] = 1.0;
+        cj_Matrix_elem(matrix, float, i, j) = 0.0;
+        if (i == j) cj_Matrix_elem(matrix, float, i, j) = 1.0;
       }
       else {
-        ((double *) (matrix->buff))[i + j*matrix->m] = 0.0;
-        if (i == j) ((double *) (matrix->buff))[i + j*matrix->m] = 1.0;
+        cj_Matrix_elem(matrix, double, i, j) = 0.0;
+        if (i == j) cj_Matrix_elem(matrix, double, i, j) = 1.0;
       }
     }
   }
@@ -814,10 +1262,10 @@ void cj_Matrix_print (cj_Object *object) {
       fprintf(stderr, "     ");
       for (j = 0; j < matrix->n; j++) {
         if (matrix->eletype == CJ_SINGLE) {
-          fprintf(stderr, "%4.2f ", ((float *) (matrix->buff))[i + j*matrix->m]);
+          fprintf(stderr, "%4.2f ", cj_Matrix_elem(matrix, float, i, j));
         }
         else {
-          fprintf(stderr, "%4.2lf ", ((double *) (matrix->buff))[i + j*matrix->m]);
+          fprintf(stderr, "%4.2lf ", cj_Matrix_elem(matrix, double, i, j));
         }
       }
       fprintf(stderr, "\n");
@@ -865,33 +1313,39 @@ void cj_Object_acquire (cj_Object *object) {
   if (object->objtype == CJ_MATRIX) {
     cj_Matrix *matrix = object->matrix;
     cj_Matrix *base   = matrix->base;
-    cj_Object *view_obj = cj_Object_new(CJ_MATRIX);
-    cj_Matrix *view = view_obj->matrix;
-    view->base = matrix->base;
 
-    int i, j, k;
-    for (i = 0; i < matrix->m/BLOCK_SIZE; i ++) {
-      for (j = 0; j < matrix->n/BLOCK_SIZE; j ++) {
+    int i, j;
+    for (i = 0; i < (matrix->m - 1)/BLOCK_SIZE + 1; i ++) {
+      for (j = 0; j < (matrix->n - 1)/BLOCK_SIZE + 1; j ++) {
         cj_Distribution *dist = base->dist[matrix->offm/BLOCK_SIZE + i][matrix->offn/BLOCK_SIZE + j];
 
-        view->offm = i*BLOCK_SIZE;
-        view->offn = j*BLOCK_SIZE;
-        view->m    = min(BLOCK_SIZE, matrix->m - i*BLOCK_SIZE);
-        view->n    = min(BLOCK_SIZE, matrix->n - j*BLOCK_SIZE);
-
-        if (dist->avail[0] == FALSE) {
-          for (k = 1; k < MAX_DEV + 1; k++) {
-            if (dist->avail[k] == TRUE) {
-              cj_Cache_write_back(dist->device[k], dist->line[k], view_obj);
-              break;
-            }
-          }
-        }
+        cj_Lock_acquire(&dist->lock);
+        cj_Distribution_fetch(dist, 0, dist->tile);
+        cj_Lock_release(&dist->lock);
       }
     }
   }
 }
 
+cj_Constant *cj_Constant_new () {
+  cj_Constant *constant = (cj_Constant *) malloc(sizeof(cj_Constant));
+  if (!constant) cj_Object_error("Constant_new", "memory allocation failed.");
+  constant->eletype   = CJ_DOUBLE;
+  constant->dconstant = 0.0;
+  constant->sconstnat = 0.0;
+  return constant;
+}
+
+void cj_Constant_set (cj_Object *object, double value) {
+  if (object->objtype != CJ_CONSTANT) cj_Object_error("Constant_set", "The object is not a constant.");
+  object->constant->dconstant = value;
+  object->constant->sconstnat = (float) value;
+}
+
+double cj_Constant_get (cj_Object *object) {
+  if (object->objtype != CJ_CONSTANT) cj_Object_error("Constant_get", "The object is not a constant.");
+  return object->constant->dconstant;
+}
 
 cj_Object *cj_Object_append (cj_objType type, void *ptr) {
   cj_Object *object;
@@ -922,6 +1376,14 @@ cj_Object *cj_Object_append (cj_objType type, void *ptr) {
     object->objtype = CJ_DISTRIBUTION;
     object->distribution = (cj_Distribution *) ptr;
   }
+  else if (type == CJ_FILE) {
+    object->objtype = CJ_FILE;
+    object->file = (cj_File *) ptr;
+  }
+  else if (type == CJ_CONSTANT) {
+    object->objtype = CJ_CONSTANT;
+    object->constant = (cj_Constant *) ptr;
+  }
 
   object->prev = NULL;
   object->next = NULL;
@@ -971,6 +1433,10 @@ cj_Object *cj_Object_new (cj_objType type) {
     object->objtype = CJ_EVENT;
     object->event = cj_Event_new();
   }
+  else if (type == CJ_CONSTANT) {
+    object->objtype = CJ_CONSTANT;
+    object->constant = cj_Constant_new();
+  }
 
   object->prev = NULL;
   object->next = NULL;
@@ -13,6 +13,12 @@
 
 static cj_Profile profile;
 
+void cj_Profile_error (const char *func_name, char* msg_text) {
+  fprintf(stderr, "CJ_PROFILE_ERROR: %s(): %s\n", func_name, msg_text);
+  abort();
+  exit(0);
+}
+
 
 /* ---------------------------------------------------------------------
  * cj_Event
@@ -67,6 +73,7 @@ void cj_Profile_init () {
   for (i = 0; i < MAX_WORKER; i++) {
     profile.worker_timeline[i] = cj_Object_new(CJ_DQUEUE);
   }
+  cj_Lock_new(&profile.stats_lock);
 };
 
 void cj_Profile_output_timeline () {
@@ -107,3 +114,86 @@ void cj_Profile_output_timeline () {
 
   fclose(pFile);
 }
+
+/* ---------------------------------------------------------------------
+ * cj_Stats
+ * ---------------------------------------------------------------------
+ *  */
+
+/**
+ * @brief  Count a data-movement event of a tile on a device, for the device
+ *         and for the matrix of the tile. A transfer also heats the tile.
+ * @param  *device the device
+ * @param  *target the tile, NULL if unknown
+ * @param  type counter
+ * @param  value increment, bytes for transfers
+ */
+void cj_Stats_count (cj_Device *device, cj_Object *target, cj_statType type, long long value) {
+  cj_Matrix *base = NULL;
+  cj_Distribution *dist = NULL;
+
+  if (target && target->objtype == CJ_MATRIX) {
+    base = target->matrix->base;
+    dist = base->dist[target->matrix->offm/BLOCK_SIZE][target->matrix->offn/BLOCK_SIZE];
+  }
+  cj_Lock_acquire(&profile.stats_lock);
+  {
+    if (device) device->stats.count[type] += value;
+    if (base) base->stats.count[type] += value;
+    if (dist && (type == CJ_STAT_H2D || type == CJ_STAT_D2H || type == CJ_STAT_D2D)) dist->heat ++;
+  }
+  cj_Lock_release(&profile.stats_lock);
+}
+
+/**
+ * @brief  Return a data-movement counter of a matrix, summed over its tiles
+ *         and the devices.
+ * @param  *object matrix object
+ * @param  type counter
+ * @return count, or bytes for transfers
+ */
+long long cj_Matrix_stats (cj_Object *object, cj_statType type) {
+  if (object->objtype != CJ_MATRIX) cj_Profile_error("Matrix_stats", "The object is not a matrix.");
+  return object->matrix->base->stats.count[type];
+}
+
+/* Clear the data-movement counters and the heat map of a matrix. */
+void cj_Matrix_stats_reset (cj_Object *object) {
+  cj_Matrix *base;
+  int i, j;
+
+  if (object->objtype != CJ_MATRIX) cj_Profile_error("Matrix_stats_reset", "The object is not a matrix.");
+  base = object->matrix->base;
+  for (i = 0; i < CJ_STAT_NUM; i++) base->stats.count[i] = 0;
+  for (i = 0; i < base->mb; i++) {
+    for (j = 0; j < base->nb; j++) base->dist[i][j]->heat = 0;
+  }
+}
+
+/**
+ * @brief  Write the number of transfers of every tile of a matrix as a 
+ *         MATLAB script drawing the heat map.
+ * @param  *object matrix object
+ * @param  *filename output file name
+ */
+void cj_Matrix_output_heat (cj_Object *object, const char *filename) {
+  cj_Matrix *base;
+  FILE *pFile;
+  int i, j;
+
+  if (object->objtype != CJ_MATRIX) cj_Profile_error("Matrix_output_heat", "The object is not a matrix.");
+  base = object->matrix->base;
+  pFile = fopen(filename, "w");
+  if (!pFile) cj_Profile_error("Matrix_output_heat", "Could not open the file.");
+
+  fprintf(pFile, "heat = [\n");
+  for (i = 0; i < base->mb; i++) {
+    for (j = 0; j < base->nb; j++) fprintf(pFile, "%d ", base->dist[i][j]->heat);
+    fprintf(pFile, "\n");
+  }
+  fprintf(pFile, "];\n");
+  fprintf(pFile, "figure;\n");
+  fprintf(pFile, "imagesc(heat);\n");
+  fprintf(pFile, "colorbar;\n");
+  fclose(pFile);
+}
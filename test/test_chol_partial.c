@@ -0,0 +1,111 @@
+/* 
+ * test_chol_partial.c
+ * Test file for the partial Cholesky factorization and its Schur complement
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+
+#include <cj.h>
+
+/* Symmetric positive definite: random entries and n on the diagonal. */
+static void set_spd (cj_Object *object) {
+  cj_Matrix *matrix = object->matrix;
+  int i, j;
+
+  for (j = 0; j < matrix->n; j++) {
+    for (i = j; i < matrix->m; i++) {
+      cj_Matrix_elem(matrix, double, i, j) = (i == j) ? matrix->n : (double) rand()/RAND_MAX - 0.5;
+      cj_Matrix_elem(matrix, double, j, i) = cj_Matrix_elem(matrix, double, i, j);
+    }
+  }
+}
+
+/* Largest difference of the lower triangles of two views, relative to the
+ * largest entry of the first. */
+static double diff_lower (cj_Object *object, cj_Object *other) {
+  cj_Matrix *a = object->matrix, *b = other->matrix;
+  double diff = 0.0, norm = 0.0, value;
+  int i, j;
+
+  for (j = 0; j < a->n; j++) {
+    for (i = j; i < a->m; i++) {
+      value = cj_Matrix_elem(a->base, double, a->offm + i, a->offn + j);
+      norm = fmax(norm, fabs(value));
+      diff = fmax(diff, fabs(value - cj_Matrix_elem(b->base, double, b->offm + i, b->offn + j)));
+    }
+  }
+  return diff/norm;
+}
+
+int main () {
+  cj_Object *A, *B, *F, *S, *minus_one, *one;
+  cj_Object *ATL, *ATR, *ABL, *ABR, *BTL, *BTR, *BBL, *BBR, *STL, *STR, *SBL, *SBR;
+  cj_Object *AL, *AR, *FL, *FR;
+  /* 3 x 3 tiles, the last ones partial: A22 is 2 x 2 tiles. */
+  int n = 2*BLOCK_SIZE + 64, k = BLOCK_SIZE;
+  int nworker = 4;
+  double diff[3];
+
+  cj_Init(nworker);
+
+  A = cj_Object_new(CJ_MATRIX);
+  B = cj_Object_new(CJ_MATRIX);
+  F = cj_Object_new(CJ_MATRIX);
+  S = cj_Object_new(CJ_MATRIX);
+  one = cj_Object_new(CJ_CONSTANT);
+  minus_one = cj_Object_new(CJ_CONSTANT);
+  cj_Constant_set(one, 1.0);
+  cj_Constant_set(minus_one, -1.0);
+  ATL = cj_Object_new(CJ_MATRIX); ATR = cj_Object_new(CJ_MATRIX);
+  ABL = cj_Object_new(CJ_MATRIX); ABR = cj_Object_new(CJ_MATRIX);
+  BTL = cj_Object_new(CJ_MATRIX); BTR = cj_Object_new(CJ_MATRIX);
+  BBL = cj_Object_new(CJ_MATRIX); BBR = cj_Object_new(CJ_MATRIX);
+  STL = cj_Object_new(CJ_MATRIX); STR = cj_Object_new(CJ_MATRIX);
+  SBL = cj_Object_new(CJ_MATRIX); SBR = cj_Object_new(CJ_MATRIX);
+  AL = cj_Object_new(CJ_MATRIX); AR = cj_Object_new(CJ_MATRIX);
+  FL = cj_Object_new(CJ_MATRIX); FR = cj_Object_new(CJ_MATRIX);
+
+  cj_Matrix_set(A, n, n);
+  cj_Matrix_set(B, n, n);
+  cj_Matrix_set(F, n, n);
+  cj_Matrix_set(S, n, n);
+
+  srand(49);
+  set_spd(A);
+  cj_Copy(A, B);
+  cj_Copy(A, F);
+  cj_Copy(A, S);
+  cj_Matrix_part_2x2(A, ATL, ATR, ABL, ABR, k, k, CJ_TL);
+  cj_Matrix_part_2x2(B, BTL, BTR, BBL, BBR, k, k, CJ_TL);
+  cj_Matrix_part_2x2(S, STL, STR, SBL, SBR, k, k, CJ_TL);
+
+  /* F -> LL^T in full */
+  cj_Chol_l(F);
+  /* The first k columns of A, then S22 = A22 - L21 * L21' */
+  cj_Chol_l_partial(A, k);
+  cj_Gemm(CJ_NOTRANS, CJ_TRANS, minus_one, ABL, ABL, one, SBR);
+  /* The first k columns of B, then its A22 -> L22 * L22' behind the update
+   * of each tile */
+  cj_Chol_l_partial(B, k);
+  cj_Chol_l(BBR);
+
+  cj_Sync();
+  cj_Object_acquire(A);
+  cj_Object_acquire(B);
+  cj_Object_acquire(F);
+  cj_Object_acquire(S);
+  cj_Matrix_part_1x2(F, FL, FR, k, CJ_LEFT);
+  cj_Matrix_part_1x2(A, AL, AR, k, CJ_LEFT);
+  diff[0] = diff_lower(FL, AL);
+  diff[1] = diff_lower(SBR, ABR);
+  diff[2] = diff_lower(F, B);
+  fprintf(stdout, "max |[L11; L21] - chol(A)(:, 0:k-1)| / max |L| = %.3e\n", diff[0]);
+  fprintf(stdout, "max |A22 - (A22 - L21 L21')| / max |A22| = %.3e\n", diff[1]);
+  fprintf(stdout, "max |chol(A22 - L21 L21') - L22| / max |L| = %.3e\n", diff[2]);
+
+  cj_Term();
+
+  return (diff[0] < 1e-14 && diff[1] < 1e-14 && diff[2] < 1e-14) ? 0 : 1;
+}
@@ -0,0 +1,124 @@
+/* 
+ * test_chol_solve.c
+ * Test file for the solve, inverse and log-determinant on a Cholesky factor
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+
+#include <cj.h>
+
+/* Uniform entries in [-0.5, 0.5). */
+static void set_random (cj_Object *object) {
+  cj_Matrix *matrix = object->matrix;
+  int i, j;
+
+  for (j = 0; j < matrix->n; j++) {
+    for (i = 0; i < matrix->m; i++) cj_Matrix_elem(matrix, double, i, j) = (double) rand()/RAND_MAX - 0.5;
+  }
+}
+
+/* Symmetric positive definite: random entries and n on the diagonal. */
+static void set_spd (cj_Object *object) {
+  cj_Matrix *matrix = object->matrix;
+  int i, j;
+
+  for (j = 0; j < matrix->n; j++) {
+    for (i = j; i < matrix->m; i++) {
+      cj_Matrix_elem(matrix, double, i, j) = (i == j) ? matrix->n : (double) rand()/RAND_MAX - 0.5;
+      cj_Matrix_elem(matrix, double, j, i) = cj_Matrix_elem(matrix, double, i, j);
+    }
+  }
+}
+
+/* Largest magnitude of the entries. */
+static double norm_max (cj_Object *object) {
+  cj_Matrix *matrix = object->matrix;
+  double norm = 0.0;
+  int i, j;
+
+  for (j = 0; j < matrix->n; j++) {
+    for (i = 0; i < matrix->m; i++) norm = fmax(norm, fabs(cj_Matrix_elem(matrix, double, i, j)));
+  }
+  return norm;
+}
+
+int main () {
+  cj_Object *A, *B, *C, *A0, *R, *S, *E, *one, *minus_one;
+  /* 2 x 2 tiles, the last ones partial, so that the log-determinant is
+   * summed by the reduction tree. */
+  int ma = BLOCK_SIZE + 64, na = ma, mb = ma, nb = 16;
+  int nworker = 4, i, j;
+  double logdet, sum = 0.0, residual, inverse, difference;
+
+  cj_Init(nworker);
+
+  A = cj_Object_new(CJ_MATRIX);
+  B = cj_Object_new(CJ_MATRIX);
+  C = cj_Object_new(CJ_MATRIX);
+  A0 = cj_Object_new(CJ_MATRIX);
+  R = cj_Object_new(CJ_MATRIX);
+  S = cj_Object_new(CJ_MATRIX);
+  E = cj_Object_new(CJ_MATRIX);
+  one = cj_Object_new(CJ_CONSTANT);
+  minus_one = cj_Object_new(CJ_CONSTANT);
+  cj_Constant_set(one, 1.0);
+  cj_Constant_set(minus_one, -1.0);
+
+  cj_Matrix_set(A, ma, na);
+  cj_Matrix_set(B, mb, nb);
+  cj_Matrix_set(C, ma, na);
+  cj_Matrix_set(A0, ma, na);
+  cj_Matrix_set(R, mb, nb);
+  cj_Matrix_set(S, ma, na);
+  cj_Matrix_set(E, ma, na);
+
+  srand(47);
+  set_spd(A);
+  set_random(B);
+  cj_Copy(A, A0);
+  cj_Copy(B, R);
+
+  /* One graph: A -> LL^T, B = A^(-1) * B, log(det(A)), then C = A^(-1) */
+  cj_Chol_l(A);
+  cj_Chol_solve(A, B);
+  cj_Chol_logdet(A, &logdet);
+  cj_Copy(A, C);
+  cj_Chol_inverse(C);
+  /* R = B - A * X */
+  cj_Gemm(CJ_NOTRANS, CJ_NOTRANS, minus_one, A0, B, one, R);
+
+  cj_Sync();
+  cj_Object_acquire(A0);
+  cj_Object_acquire(A);
+  cj_Object_acquire(B);
+  cj_Object_acquire(R);
+  cj_Object_acquire(C);
+  residual = norm_max(R)/(na*norm_max(A0)*norm_max(B));
+  fprintf(stdout, "||B - A X|| / (n ||A|| ||X||) = %.3e\n", residual);
+
+  /* log(det(A)) = 2 * sum(log(L_ii)) */
+  for (i = 0; i < na; i++) sum += 2.0*log(cj_Matrix_elem(A->matrix, double, i, i));
+  difference = fabs(logdet - sum)/fabs(sum);
+  fprintf(stdout, "log(det(A)) = %.15e, |logdet - 2 sum(log(L_ii))| / |logdet| = %.3e\n", logdet, difference);
+
+  /* The inverse is in the lower triangle of C, S is it in full. E = A * S - I */
+  for (j = 0; j < na; j++) {
+    for (i = j; i < ma; i++) {
+      cj_Matrix_elem(S->matrix, double, i, j) = cj_Matrix_elem(C->matrix, double, i, j);
+      cj_Matrix_elem(S->matrix, double, j, i) = cj_Matrix_elem(C->matrix, double, i, j);
+    }
+  }
+  cj_Matrix_set_identity(E);
+  cj_Gemm(CJ_NOTRANS, CJ_NOTRANS, one, A0, S, minus_one, E);
+  cj_Sync();
+  cj_Object_acquire(S);
+  cj_Object_acquire(E);
+  inverse = norm_max(E)/(na*norm_max(A0)*norm_max(S));
+  fprintf(stdout, "||A inv(A) - I|| / (n ||A|| ||inv(A)||) = %.3e\n", inverse);
+
+  cj_Term();
+
+  return (residual < 1e-13 && difference < 1e-13 && inverse < 1e-13) ? 0 : 1;
+}
@@ -0,0 +1,106 @@
+/* 
+ * test_chol_update.c
+ * Test file for the rank-k update and downdate of a Cholesky factor
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+
+#include <cj.h>
+
+/* Uniform entries in [-0.5, 0.5). */
+static void set_random (cj_Object *object) {
+  cj_Matrix *matrix = object->matrix;
+  int i, j;
+
+  for (j = 0; j < matrix->n; j++) {
+    for (i = 0; i < matrix->m; i++) cj_Matrix_elem(matrix, double, i, j) = (double) rand()/RAND_MAX - 0.5;
+  }
+}
+
+/* Symmetric positive definite: random entries and n on the diagonal. */
+static void set_spd (cj_Object *object) {
+  cj_Matrix *matrix = object->matrix;
+  int i, j;
+
+  for (j = 0; j < matrix->n; j++) {
+    for (i = j; i < matrix->m; i++) {
+      cj_Matrix_elem(matrix, double, i, j) = (i == j) ? matrix->n : (double) rand()/RAND_MAX - 0.5;
+      cj_Matrix_elem(matrix, double, j, i) = cj_Matrix_elem(matrix, double, i, j);
+    }
+  }
+}
+
+/* Largest difference of the lower triangles, relative to the largest entry
+ * of the first. */
+static double diff_lower (cj_Object *object, cj_Object *other) {
+  cj_Matrix *matrix = object->matrix;
+  double diff = 0.0, norm = 0.0;
+  int i, j;
+
+  for (j = 0; j < matrix->n; j++) {
+    for (i = j; i < matrix->m; i++) {
+      norm = fmax(norm, fabs(cj_Matrix_elem(matrix, double, i, j)));
+      diff = fmax(diff, fabs(cj_Matrix_elem(matrix, double, i, j) - cj_Matrix_elem(other->matrix, double, i, j)));
+    }
+  }
+  return diff/norm;
+}
+
+int main () {
+  cj_Object *A, *C, *D, *X, *Y, *one;
+  /* 2 x 2 tiles, the last ones partial, so the rotations cross tiles. */
+  int ma = BLOCK_SIZE + 64, na = ma, k = 16;
+  int nworker = 4;
+  double diff[2];
+
+  cj_Init(nworker);
+
+  A = cj_Object_new(CJ_MATRIX);
+  C = cj_Object_new(CJ_MATRIX);
+  D = cj_Object_new(CJ_MATRIX);
+  X = cj_Object_new(CJ_MATRIX);
+  Y = cj_Object_new(CJ_MATRIX);
+  one = cj_Object_new(CJ_CONSTANT);
+  cj_Constant_set(one, 1.0);
+
+  cj_Matrix_set(A, ma, na);
+  cj_Matrix_set(C, ma, na);
+  cj_Matrix_set(D, ma, na);
+  cj_Matrix_set(X, ma, k);
+  cj_Matrix_set(Y, ma, k);
+
+  srand(48);
+  set_spd(A);
+  set_random(X);
+  cj_Copy(A, C);
+  cj_Copy(A, D);
+  cj_Copy(X, Y);
+
+  /* C -> LL^T, D + XX^T -> LL^T */
+  cj_Chol_l(C);
+  cj_Gemm(CJ_NOTRANS, CJ_TRANS, one, X, X, one, D);
+  cj_Chol_l(D);
+
+  /* A -> LL^T, LL^T + XX^T -> LL^T, the factor of D */
+  cj_Chol_l(A);
+  cj_Chol_update(A, X);
+  cj_Sync();
+  cj_Object_acquire(A);
+  cj_Object_acquire(D);
+  diff[0] = diff_lower(D, A);
+  fprintf(stdout, "update:   max |L - chol(A + X X')| / max |L| = %.3e\n", diff[0]);
+
+  /* LL^T - YY^T -> LL^T with Y = X, the factor of C again */
+  cj_Chol_downdate(A, Y);
+  cj_Sync();
+  cj_Object_acquire(A);
+  cj_Object_acquire(C);
+  diff[1] = diff_lower(C, A);
+  fprintf(stdout, "downdate: max |L - chol(A)| / max |L| = %.3e\n", diff[1]);
+
+  cj_Term();
+
+  return (diff[0] < 1e-13 && diff[1] < 1e-13) ? 0 : 1;
+}
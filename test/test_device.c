@@ -0,0 +1,86 @@
+/* 
+ * test_device.c
+ * Test file for the device cache, run on devices emulated in host memory
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include <cj.h>
+
+static cj_Object *A, *B, *C, *D, *E;
+static char *state_name[] = {"I", "S", "E", "O", "M", "F"};
+
+/* Print every state transition of a copy, location 0 is the main memory, F is in flight. */
+void trace (cj_Distribution *dist, int loc, cj_cohState from, cj_cohState to) {
+  char name = '?';
+  if (dist == A->matrix->dist[0][0]) name = 'A';
+  if (dist == B->matrix->dist[0][0]) name = 'B';
+  if (dist == C->matrix->dist[0][0]) name = 'C';
+  if (dist == D->matrix->dist[0][0]) name = 'D';
+  if (dist == E->matrix->dist[0][0]) name = 'E';
+  fprintf(stdout, "  %c(0, 0) @%d : %s -> %s\n", name, loc, state_name[from], state_name[to]);
+}
+
+int main () {
+  int ma = 8, na = 8, mb = na, nb = 8, mc = ma, nc = nb;
+  int md = ma, nd = nc;
+  int nworker = 4;
+  int iter, i;
+  long long overlap = 0, wait = 0;
+
+  /* Workers 1 and 2 own a device each, worker 3 runs on the host. */
+  cj_Device_emulate(2);
+  cj_Init(nworker);
+
+  A = cj_Object_new(CJ_MATRIX);
+  B = cj_Object_new(CJ_MATRIX);
+  C = cj_Object_new(CJ_MATRIX);
+  D = cj_Object_new(CJ_MATRIX);
+  E = cj_Object_new(CJ_MATRIX);
+
+  /* A lives in pageable memory of our own and is staged to the devices. */
+  cj_Matrix_attach(A, ma, na, (char *) malloc(ma*na*sizeof(double)));
+  cj_Matrix_set(B, mb, nb);
+  cj_Matrix_set(C, mc, nc);
+  cj_Matrix_set(D, md, nd);
+  cj_Matrix_set(E, md, nd);
+
+  cj_Matrix_set_identity(A);
+  cj_Matrix_set_identity(B);
+  cj_Matrix_set_identity(C);
+  cj_Matrix_set_identity(D);
+  cj_Matrix_set_identity(E);
+  cj_Distribution_trace(&trace);
+
+  /* C = (iter + 1)*I, D = I + C*C. The updates of E = (iter + 1)*I only
+   * share their inputs with those of C, so a device keeps both in flight on
+   * different streams, and the updates of one tile wait for each other. */
+  for (iter = 0; iter < 4; iter++) {
+    cj_Gemm_nn(A, B, C);
+    cj_Gemm_nn(A, B, E);
+  }
+  cj_Gemm_nn(C, C, D);
+
+  cj_Term();
+
+  /* C = 5*I, D = 26*I, E = 5*I */
+  cj_Object_acquire(C);
+  cj_Object_acquire(D);
+  cj_Object_acquire(E);
+  cj_Matrix_print(C);
+  cj_Matrix_print(D);
+  cj_Matrix_print(E);
+
+  cj_Stats_print();
+  fprintf(stdout, "  A: %lld bytes to the devices, %lld prefetch hits\n", 
+      cj_Matrix_stats(A, CJ_STAT_H2D), cj_Matrix_stats(A, CJ_STAT_PREFETCH_HIT));
+  for (i = 0; i < 2; i++) {
+    overlap += cj_Device_stats(i, CJ_STAT_OVERLAP);
+    wait    += cj_Device_stats(i, CJ_STAT_STREAM_WAIT);
+  }
+  fprintf(stdout, "  streams: %lld tasks issued next to others in flight, %lld waits between streams\n", 
+      overlap, wait);
+
+  return 0;
+}
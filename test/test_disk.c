@@ -0,0 +1,56 @@
+/* 
+ * test_disk.c
+ * Test file for the Cholesky Decomposition of a matrix kept in a file
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <math.h>
+
+#include <cj.h>
+
+int main () {
+  cj_Object *A, *B;
+  /* 3 x 3 tiles, the last ones partial. */
+  int ma = 2*BLOCK_SIZE + 16, na = ma;
+  int nworker = 4, i, j, resident = 0;
+  double diff = 0.0;
+
+  cj_Init(nworker);
+
+  /* Main memory may hold a single tile of A at a time. */
+  cj_Disk_budget(BLOCK_SIZE*BLOCK_SIZE*sizeof(double));
+
+  A = cj_Object_new(CJ_MATRIX);
+  B = cj_Object_new(CJ_MATRIX);
+  cj_Matrix_set_disk(A, ma, na, "cj_disk.bin");
+  cj_Matrix_set(B, ma, na);
+  cj_Matrix_set_special_chol(A);
+  cj_Matrix_set_special_chol(B);
+
+  /* A -> LL^T out of core, B -> LL^T in main memory */
+  cj_Chol_l(A);
+  cj_Chol_l(B);
+
+  cj_Term();
+
+  cj_Object_acquire(A);
+  cj_Object_acquire(B);
+  cj_Matrix_flush_disk(A);
+  for (i = 0; i < A->matrix->mb; i++) {
+    for (j = 0; j < A->matrix->nb; j++) {
+      if (cj_Disk_resident(A->matrix->dist[i][j]->tile) == TRUE) resident ++;
+    }
+  }
+  for (j = 0; j < na; j++) {
+    for (i = j; i < ma; i++) {
+      diff = fmax(diff, fabs(cj_Matrix_elem(A->matrix, double, i, j) - cj_Matrix_elem(B->matrix, double, i, j)));
+    }
+  }
+  fprintf(stdout, "%d of %d tiles resident, max |L_disk - L_memory| = %.3e\n", 
+      resident, A->matrix->mb*A->matrix->nb, diff);
+  unlink("cj_disk.bin");
+
+  return (diff == 0.0) ? 0 : 1;
+}
@@ -0,0 +1,95 @@
+/* 
+ * test_eig.c
+ * Test file for the eigenvalues and eigenvectors of symmetric matrices
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+
+#include <cj.h>
+
+/* Symmetric, uniform entries in [-0.5, 0.5). */
+static void set_symmetric (cj_Object *object) {
+  cj_Matrix *matrix = object->matrix;
+  int i, j;
+
+  for (j = 0; j < matrix->n; j++) {
+    for (i = j; i < matrix->m; i++) {
+      cj_Matrix_elem(matrix, double, i, j) = (double) rand()/RAND_MAX - 0.5;
+      cj_Matrix_elem(matrix, double, j, i) = cj_Matrix_elem(matrix, double, i, j);
+    }
+  }
+}
+
+/* Largest magnitude of the entries. */
+static double norm_max (cj_Object *object) {
+  cj_Matrix *matrix = object->matrix;
+  double norm = 0.0;
+  int i, j;
+
+  for (j = 0; j < matrix->n; j++) {
+    for (i = 0; i < matrix->m; i++) norm = fmax(norm, fabs(cj_Matrix_elem(matrix, double, i, j)));
+  }
+  return norm;
+}
+
+int main () {
+  cj_Object *A, *Z, *A0, *R, *S, *one, *zero;
+  /* 2 x 2 tiles, the last ones partial: the panels of EIG_NB columns reduced
+   * to the band reach down into the second tile row. */
+  int ma = BLOCK_SIZE + 64, na = ma;
+  int nworker = 4, i, j;
+  double *w = (double *) malloc(na*sizeof(double));
+  double residual, orthogonality;
+
+  cj_Init(nworker);
+
+  A = cj_Object_new(CJ_MATRIX);
+  Z = cj_Object_new(CJ_MATRIX);
+  A0 = cj_Object_new(CJ_MATRIX);
+  R = cj_Object_new(CJ_MATRIX);
+  S = cj_Object_new(CJ_MATRIX);
+  one = cj_Object_new(CJ_CONSTANT);
+  zero = cj_Object_new(CJ_CONSTANT);
+  cj_Constant_set(one, 1.0);
+  cj_Constant_set(zero, 0.0);
+
+  cj_Matrix_set(A, ma, na);
+  cj_Matrix_set(Z, ma, na);
+  cj_Matrix_set(A0, ma, na);
+  cj_Matrix_set(R, ma, na);
+  cj_Matrix_set(S, na, na);
+
+  srand(50);
+  set_symmetric(A);
+  cj_Copy(A, A0);
+
+  /* A = Z * diag(w) * Z' */
+  cj_Eig(A, w, Z);
+
+  /* R = A * Z, S = Z' * Z */
+  cj_Gemm(CJ_NOTRANS, CJ_NOTRANS, one, A0, Z, zero, R);
+  cj_Gemm(CJ_TRANS, CJ_NOTRANS, one, Z, Z, zero, S);
+  cj_Sync();
+  cj_Object_acquire(A0);
+  cj_Object_acquire(Z);
+  cj_Object_acquire(R);
+  cj_Object_acquire(S);
+
+  /* R = A * Z - Z * diag(w), S = Z' * Z - I */
+  for (j = 0; j < na; j++) {
+    for (i = 0; i < ma; i++) cj_Matrix_elem(R->matrix, double, i, j) -= w[j]*cj_Matrix_elem(Z->matrix, double, i, j);
+    cj_Matrix_elem(S->matrix, double, j, j) -= 1.0;
+  }
+  residual = norm_max(R)/(na*norm_max(A0));
+  orthogonality = norm_max(S)/na;
+  fprintf(stdout, "eigenvalues %.6f to %.6f\n", w[0], w[na - 1]);
+  fprintf(stdout, "||A Z - Z W|| / (n ||A||) = %.3e\n", residual);
+  fprintf(stdout, "||Z' Z - I|| / n = %.3e\n", orthogonality);
+
+  cj_Term();
+  free(w);
+
+  return (residual < 1e-13 && orthogonality < 1e-13) ? 0 : 1;
+}
@@ -0,0 +1,99 @@
+/* 
+ * test_file.c
+ * Test file for storing and loading matrices in tiled matrix files
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include <cj.h>
+
+/* Uniform entries in [-0.5, 0.5). */
+static void set_random (cj_Object *object) {
+  cj_Matrix *matrix = object->matrix;
+  int i, j;
+
+  for (j = 0; j < matrix->n; j++) {
+    for (i = 0; i < matrix->m; i++) cj_Matrix_elem(matrix, double, i, j) = (double) rand()/RAND_MAX - 0.5;
+  }
+}
+
+/* A new m x n matrix in the given layout. */
+static cj_Object *new_matrix (cj_layoutType layout, int m, int n) {
+  cj_Object *object = cj_Object_new(CJ_MATRIX);
+  cj_Matrix_set_layout(object, layout);
+  cj_Matrix_set(object, m, n);
+  return object;
+}
+
+/* Number of elements of two matrices of the same size that differ. */
+static int count_diff (cj_Object *object, cj_Object *other) {
+  cj_Matrix *matrix = object->matrix;
+  int i, j, count = 0;
+
+  if (matrix->m != other->matrix->m || matrix->n != other->matrix->n) return matrix->m*matrix->n;
+  for (j = 0; j < matrix->n; j++) {
+    for (i = 0; i < matrix->m; i++) {
+      if (cj_Matrix_elem(matrix, double, i, j) != cj_Matrix_elem(other->matrix, double, i, j)) count ++;
+    }
+  }
+  return count;
+}
+
+int main () {
+  cj_Object *A0, *A[3], *B[3], *C[3], *R[3];
+  /* 3 x 2 tiles, the last ones partial: the Morton order of the tiles is not
+   * their column order. */
+  int m = 2*BLOCK_SIZE + 64, n = BLOCK_SIZE + 64;
+  int nworker = 4, l, count, fail = 0;
+  const char *name[3] = {"column", "tile", "morton"};
+  const char *filename[3] = {"cj_column.bin", "cj_tile.bin", "cj_morton.bin"};
+  cj_layoutType layout[3] = {CJ_LAYOUT_COLUMN, CJ_LAYOUT_TILE, CJ_LAYOUT_MORTON};
+
+  cj_Init(nworker);
+
+  A0 = new_matrix(CJ_LAYOUT_COLUMN, m, n);
+  srand(36);
+  set_random(A0);
+
+  /* A in each layout is stored in a file of that layout, loaded back into the
+   * column-major B and mapped as C, which tasks copy to the column-major R. */
+  for (l = 0; l < 3; l++) {
+    A[l] = new_matrix(layout[l], m, n);
+    B[l] = cj_Object_new(CJ_MATRIX);
+    C[l] = cj_Object_new(CJ_MATRIX);
+    R[l] = new_matrix(CJ_LAYOUT_COLUMN, m, n);
+    cj_Copy(A0, A[l]);
+    cj_Matrix_store(A[l], filename[l], layout[l]);
+    cj_Matrix_load(B[l], filename[l]);
+    cj_Matrix_map(C[l], filename[l], FALSE);
+    cj_Copy(C[l], R[l]);
+  }
+
+  cj_Sync();
+  cj_Object_acquire(A0);
+  for (l = 0; l < 3; l++) {
+    cj_Object_acquire(B[l]);
+    cj_Object_acquire(C[l]);
+    cj_Object_acquire(R[l]);
+  }
+  for (l = 0; l < 3; l++) {
+    count = count_diff(B[l], A0);
+    fprintf(stdout, "%-6s: load %d", name[l], count);
+    fail += count;
+    count = count_diff(C[l], A0);
+    fprintf(stdout, ", map %d", count);
+    fail += count;
+    count = count_diff(R[l], A0);
+    fprintf(stdout, ", copy of the map %d elements differ\n", count);
+    fail += count;
+    if (C[l]->matrix->layout != layout[l]) fail ++;
+  }
+
+  cj_Term();
+
+  for (l = 0; l < 3; l++) unlink(filename[l]);
+
+  return fail ? 1 : 0;
+}
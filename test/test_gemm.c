@@ -5,50 +5,119 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <math.h>
 
 #include <cj.h>
 
+/* Uniform entries in [-0.5, 0.5). */
+static void set_random (cj_Object *object) {
+  cj_Matrix *matrix = object->matrix;
+  int i, j;
+
+  for (j = 0; j < matrix->n; j++) {
+    for (i = 0; i < matrix->m; i++) cj_Matrix_elem(matrix, double, i, j) = (double) rand()/RAND_MAX - 0.5;
+  }
+}
+
+/* Largest magnitude of the entries. */
+static double norm_max (cj_Object *object) {
+  cj_Matrix *matrix = object->matrix;
+  double norm = 0.0;
+  int i, j;
+
+  for (j = 0; j < matrix->n; j++) {
+    for (i = 0; i < matrix->m; i++) norm = fmax(norm, fabs(cj_Matrix_elem(matrix, double, i, j)));
+  }
+  return norm;
+}
+
+/* y = op(A) * x on the host. */
+static void host_gemv (cj_Trans trans, cj_Object *A, const double *x, double *y) {
+  cj_Matrix *a = A->matrix;
+  int m = (trans == CJ_NOTRANS) ? a->m : a->n, i, j;
+
+  for (i = 0; i < m; i++) y[i] = 0.0;
+  for (j = 0; j < a->n; j++) {
+    for (i = 0; i < a->m; i++) {
+      if (trans == CJ_NOTRANS) y[i] += cj_Matrix_elem(a, double, i, j)*x[j];
+      else y[j] += cj_Matrix_elem(a, double, i, j)*x[i];
+    }
+  }
+}
+
 int main () {
-  cj_Object *A, *B, *C, *D;
-  //int ma = 4, na = 4, mb = na, nb = 4, mc = ma, nc = nb;
-  int ma = 8, na = 8, mb = na, nb = 8, mc = ma, nc = nb;
-  //int ma = 16, na = 16, mb = na, nb = 16, mc = ma, nc = nb;
-  //int ma = 256, na = 256, mb = na, nb = 256, mc = ma, nc = nb;
-  //int ma = 128, na = 128, mb = na, nb = 128, mc = ma, nc = nb;
-  //int ma = 2048, na = 2048, mb = na, nb = 2048, mc = ma, nc = nb;
-  //int ma = 4096, na = 4096, mb = na, nb = 4096, mc = ma, nc = nb;
-  //int ma = 8192, na = 8192, mb = na, nb = 8192, mc = ma, nc = nb;
-  //int ma = 64, na = 64, mb = na, nb = 64, mc = ma, nc = nb;
-  int md = ma, nd = nc;
-  int nworker = 4;
+  cj_Object *A[2], *B[2], *C0, *C[8], *alpha, *beta[2];
+  /* op(A) and op(B) of 2 x 2 tiles, the last ones partial, C as well */
+  int m = BLOCK_SIZE + 64, n = BLOCK_SIZE + 16, k = BLOCK_SIZE + 32;
+  int nworker = 4, ta, tb, b, t, i, fail = 0;
+  cj_Trans trans[2] = {CJ_NOTRANS, CJ_TRANS};
+  double alpha_value = 0.75, beta_value[2] = {0.0, -1.0};
+  double *x, *u, *y, *r, *c0x, residual, scale;
 
   cj_Init(nworker);
 
-  A = cj_Object_new(CJ_MATRIX);
-  B = cj_Object_new(CJ_MATRIX);
-  C = cj_Object_new(CJ_MATRIX);
-  D = cj_Object_new(CJ_MATRIX);
- 
-  cj_Matrix_set(A, ma, na);
-  cj_Matrix_set(B, mb, nb);
-  cj_Matrix_set(C, mc, nc);
-  cj_Matrix_set(D, md, nd);
-
-  cj_Matrix_set_identity(A);
-  cj_Matrix_set_identity(B);
-  cj_Matrix_set_identity(C);
-  cj_Matrix_set_identity(D);
-
-  /* C = A*B */
-  cj_Gemm_nn(A, B, C);
-  //cj_Gemm_nn(C, B, D);
-  sleep(2);
-  cj_Object_acquire(C);
-  cj_Object_acquire(D);
-  cj_Matrix_print(C);
-  cj_Matrix_print(D);
+  alpha = cj_Object_new(CJ_CONSTANT);
+  cj_Constant_set(alpha, alpha_value);
+  for (b = 0; b < 2; b++) {
+    beta[b] = cj_Object_new(CJ_CONSTANT);
+    cj_Constant_set(beta[b], beta_value[b]);
+  }
+
+  /* A[1] and B[1] hold the transposes of the shapes of A[0] and B[0]. */
+  for (t = 0; t < 2; t++) {
+    A[t] = cj_Object_new(CJ_MATRIX);
+    B[t] = cj_Object_new(CJ_MATRIX);
+    cj_Matrix_set(A[t], t ? k : m, t ? m : k);
+    cj_Matrix_set(B[t], t ? n : k, t ? k : n);
+  }
+  C0 = cj_Object_new(CJ_MATRIX);
+  cj_Matrix_set(C0, m, n);
+
+  srand(41);
+  for (t = 0; t < 2; t++) {
+    set_random(A[t]);
+    set_random(B[t]);
+  }
+  set_random(C0);
+
+  /* C = alpha * op(A) * op(B) + beta * C for every op(A), op(B) and beta */
+  for (t = 0; t < 8; t++) {
+    ta = t/4; tb = (t/2)%2; b = t%2;
+    C[t] = cj_Object_new(CJ_MATRIX);
+    cj_Matrix_set(C[t], m, n);
+    cj_Copy(C0, C[t]);
+    cj_Gemm(trans[ta], trans[tb], alpha, A[ta], B[tb], beta[b], C[t]);
+  }
+
+  cj_Sync();
+  x = (double *) malloc((2*n + 3*m + k)*sizeof(double));
+  u = x + n; y = u + k; r = y + m; c0x = r + m;
+  for (i = 0; i < n; i++) x[i] = (double) rand()/RAND_MAX - 0.5;
+  for (t = 0; t < 2; t++) {
+    cj_Object_acquire(A[t]);
+    cj_Object_acquire(B[t]);
+  }
+  cj_Object_acquire(C0);
+  host_gemv(CJ_NOTRANS, C0, x, c0x);
+
+  /* C * x against alpha * op(A) * (op(B) * x) + beta * C0 * x */
+  for (t = 0; t < 8; t++) {
+    ta = t/4; tb = (t/2)%2; b = t%2;
+    cj_Object_acquire(C[t]);
+    host_gemv(trans[tb], B[tb], x, u);
+    host_gemv(trans[ta], A[ta], u, y);
+    host_gemv(CJ_NOTRANS, C[t], x, r);
+    residual = 0.0;
+    for (i = 0; i < m; i++) residual = fmax(residual, fabs(r[i] - alpha_value*y[i] - beta_value[b]*c0x[i]));
+    scale = n*(fabs(alpha_value)*k*norm_max(A[ta])*norm_max(B[tb]) + fabs(beta_value[b])*norm_max(C0));
+    residual /= scale;
+    fprintf(stdout, "C = %.2f * A%s * B%s + %4.1f * C: ||C x - reference|| / (n (|alpha| k ||A|| ||B|| + |beta| ||C||)) = %.3e\n",
+        alpha_value, ta ? "'" : " ", tb ? "'" : " ", beta_value[b], residual);
+    if (!(residual < 1e-15)) fail ++;
+  }
 
   cj_Term();
+  free(x);
 
-  return 0;
+  return fail ? 1 : 0;
 }
@@ -0,0 +1,122 @@
+/* 
+ * test_layout.c
+ * Test file for the tile and Morton storage layouts of matrices
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+
+#include <cj.h>
+
+/* Uniform entries in [-0.5, 0.5). */
+static void set_random (cj_Object *object) {
+  cj_Matrix *matrix = object->matrix;
+  int i, j;
+
+  for (j = 0; j < matrix->n; j++) {
+    for (i = 0; i < matrix->m; i++) cj_Matrix_elem(matrix, double, i, j) = (double) rand()/RAND_MAX - 0.5;
+  }
+}
+
+/* Symmetric positive definite: random entries and n on the diagonal. */
+static void set_spd (cj_Object *object) {
+  cj_Matrix *matrix = object->matrix;
+  int i, j;
+
+  for (j = 0; j < matrix->n; j++) {
+    for (i = j; i < matrix->m; i++) {
+      cj_Matrix_elem(matrix, double, i, j) = (i == j) ? matrix->n : (double) rand()/RAND_MAX - 0.5;
+      cj_Matrix_elem(matrix, double, j, i) = cj_Matrix_elem(matrix, double, i, j);
+    }
+  }
+}
+
+/* A new m x n matrix in the given layout. */
+static cj_Object *new_matrix (cj_layoutType layout, int m, int n) {
+  cj_Object *object = cj_Object_new(CJ_MATRIX);
+  cj_Matrix_set_layout(object, layout);
+  cj_Matrix_set(object, m, n);
+  return object;
+}
+
+/* Number of elements of two matrices that differ, in the lower triangle only
+ * if lower. */
+static int count_diff (cj_Object *object, cj_Object *other, cj_Bool lower) {
+  cj_Matrix *matrix = object->matrix;
+  int i, j, count = 0;
+
+  for (j = 0; j < matrix->n; j++) {
+    for (i = (lower == TRUE) ? j : 0; i < matrix->m; i++) {
+      if (cj_Matrix_elem(matrix, double, i, j) != cj_Matrix_elem(other->matrix, double, i, j)) count ++;
+    }
+  }
+  return count;
+}
+
+int main () {
+  cj_Object *A0, *B0, *C0, *S0, *A[3], *B[3], *C[3], *S[3], *R[3], *alpha, *beta;
+  /* A and C are 3 x 2 tiles, B and S 2 x 2, the last ones partial: the
+   * Morton order of the tiles of A and C is not their column order. */
+  int m = 2*BLOCK_SIZE + 64, n = BLOCK_SIZE + 64, k = BLOCK_SIZE + 32;
+  int nworker = 4, l, count, fail = 0;
+  const char *name[3] = {"column", "tile", "morton"};
+  cj_layoutType layout[3] = {CJ_LAYOUT_COLUMN, CJ_LAYOUT_TILE, CJ_LAYOUT_MORTON};
+
+  cj_Init(nworker);
+
+  alpha = cj_Object_new(CJ_CONSTANT);
+  beta = cj_Object_new(CJ_CONSTANT);
+  cj_Constant_set(alpha, 0.5);
+  cj_Constant_set(beta, -1.0);
+
+  A0 = new_matrix(CJ_LAYOUT_COLUMN, m, k);
+  B0 = new_matrix(CJ_LAYOUT_COLUMN, k, n);
+  C0 = new_matrix(CJ_LAYOUT_COLUMN, m, n);
+  S0 = new_matrix(CJ_LAYOUT_COLUMN, n, n);
+  srand(37);
+  set_random(A0);
+  set_random(B0);
+  set_random(C0);
+  set_spd(S0);
+
+  /* The same work in every layout: copies in, C = 0.5 * A * B - C and
+   * S -> LL^T, then A copied back out. */
+  for (l = 0; l < 3; l++) {
+    A[l] = new_matrix(layout[l], m, k);
+    B[l] = new_matrix(layout[l], k, n);
+    C[l] = new_matrix(layout[l], m, n);
+    S[l] = new_matrix(layout[l], n, n);
+    R[l] = new_matrix(CJ_LAYOUT_COLUMN, m, k);
+    cj_Copy(A0, A[l]);
+    cj_Copy(B0, B[l]);
+    cj_Copy(C0, C[l]);
+    cj_Copy(S0, S[l]);
+    cj_Gemm(CJ_NOTRANS, CJ_NOTRANS, alpha, A[l], B[l], beta, C[l]);
+    cj_Chol_l(S[l]);
+    cj_Copy(A[l], R[l]);
+  }
+
+  cj_Sync();
+  cj_Object_acquire(A0);
+  for (l = 0; l < 3; l++) {
+    cj_Object_acquire(C[l]);
+    cj_Object_acquire(S[l]);
+    cj_Object_acquire(R[l]);
+  }
+  for (l = 0; l < 3; l++) {
+    count = count_diff(R[l], A0, FALSE);
+    fprintf(stdout, "%-6s: copy round trip %d", name[l], count);
+    fail += count;
+    count = count_diff(C[l], C[0], FALSE);
+    fprintf(stdout, ", gemm %d", count);
+    fail += count;
+    count = count_diff(S[l], S[0], TRUE);
+    fprintf(stdout, ", chol %d elements differ from column major\n", count);
+    fail += count;
+  }
+
+  cj_Term();
+
+  return fail ? 1 : 0;
+}
@@ -0,0 +1,114 @@
+/* 
+ * test_ldlt.c
+ * Test file for the LDL' Decomposition of symmetric indefinite matrices
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+
+#include <cj.h>
+
+/* Symmetric, uniform entries in [-0.5, 0.5): indefinite, about half of
+ * the eigenvalues of each sign. */
+static void set_symmetric (cj_Object *object) {
+  cj_Matrix *matrix = object->matrix;
+  int i, j;
+
+  for (j = 0; j < matrix->n; j++) {
+    for (i = j; i < matrix->m; i++) {
+      cj_Matrix_elem(matrix, double, i, j) = (double) rand()/RAND_MAX - 0.5;
+      cj_Matrix_elem(matrix, double, j, i) = cj_Matrix_elem(matrix, double, i, j);
+    }
+  }
+}
+
+/* Uniform entries in [-0.5, 0.5). */
+static void set_random (cj_Object *object) {
+  cj_Matrix *matrix = object->matrix;
+  int i, j;
+
+  for (j = 0; j < matrix->n; j++) {
+    for (i = 0; i < matrix->m; i++) cj_Matrix_elem(matrix, double, i, j) = (double) rand()/RAND_MAX - 0.5;
+  }
+}
+
+/* Largest magnitude of the entries. */
+static double norm_max (cj_Object *object) {
+  cj_Matrix *matrix = object->matrix;
+  double norm = 0.0;
+  int i, j;
+
+  for (j = 0; j < matrix->n; j++) {
+    for (i = 0; i < matrix->m; i++) norm = fmax(norm, fabs(cj_Matrix_elem(matrix, double, i, j)));
+  }
+  return norm;
+}
+
+int main () {
+  cj_Object *A, *U, *B, *A0, *B0, *R, *one, *minus_one;
+  /* 2 x 2 tiles, the last ones partial, so the butterfly pairs across tiles. */
+  int ma = BLOCK_SIZE + 64, na = ma, mb = ma, nb = 16;
+  int nworker = 4, inertia[3];
+  double residual[2];
+  int i, j, step;
+
+  cj_Init(nworker);
+
+  A = cj_Object_new(CJ_MATRIX);
+  U = cj_Object_new(CJ_MATRIX);
+  B = cj_Object_new(CJ_MATRIX);
+  A0 = cj_Object_new(CJ_MATRIX);
+  B0 = cj_Object_new(CJ_MATRIX);
+  R = cj_Object_new(CJ_MATRIX);
+  one = cj_Object_new(CJ_CONSTANT);
+  minus_one = cj_Object_new(CJ_CONSTANT);
+  cj_Constant_set(one, 1.0);
+  cj_Constant_set(minus_one, -1.0);
+
+  cj_Matrix_set(A, ma, na);
+  cj_Matrix_set(B, mb, nb);
+  cj_Matrix_set(A0, ma, na);
+  cj_Matrix_set(B0, mb, nb);
+  cj_Matrix_set(R, mb, nb);
+
+  srand(46);
+  set_symmetric(A);
+  set_random(B);
+  cj_Copy(A, A0);
+  cj_Copy(B, B0);
+
+  /* U' A U -> L D L', the butterfly U is drawn by cj_Ldlt */
+  cj_Ldlt(A, U);
+  /* B = A^(-1) * B */
+  cj_Ldlt_solve(A, U, B);
+
+  cj_Ldlt_inertia(A, inertia);
+  fprintf(stdout, "inertia: %d positive, %d negative, %d zero\n", inertia[0], inertia[1], inertia[2]);
+
+  /* Without pivoting the growth in L D L' is only bounded in probability, so
+   * one step of iterative refinement, X += A^(-1) (B - A X), recovers the
+   * backward error of a pivoted solver. */
+  for (step = 0; step < 2; step++) {
+    /* R = B - A * X */
+    cj_Copy(B0, R);
+    cj_Gemm(CJ_NOTRANS, CJ_NOTRANS, minus_one, A0, B, one, R);
+    cj_Sync();
+    cj_Object_acquire(A0);
+    cj_Object_acquire(B);
+    cj_Object_acquire(R);
+    residual[step] = norm_max(R)/(na*norm_max(A0)*norm_max(B));
+    fprintf(stdout, "refinement %d: ||B - A X|| / (n ||A|| ||X||) = %.3e\n", step, residual[step]);
+    if (step == 1) break;
+    cj_Ldlt_solve(A, U, R);
+    cj_Sync();
+    cj_Object_acquire(R);
+    for (j = 0; j < nb; j++) {
+      for (i = 0; i < mb; i++) cj_Matrix_elem(B->matrix, double, i, j) += cj_Matrix_elem(R->matrix, double, i, j);
+    }
+  }
+
+  cj_Term();
+
+  return (residual[1] < 1e-14 && inertia[0] + inertia[1] + inertia[2] == na) ? 0 : 1;
+}
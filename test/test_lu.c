@@ -0,0 +1,83 @@
+/* 
+ * test_lu.c
+ * Test file for the LU Decomposition routine in the LAPACK
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+
+#include <cj.h>
+
+/* Uniform entries in [-0.5, 0.5), which need pivoting. */
+static void set_random (cj_Object *object) {
+  cj_Matrix *matrix = object->matrix;
+  int i, j;
+
+  for (j = 0; j < matrix->n; j++) {
+    for (i = 0; i < matrix->m; i++) cj_Matrix_elem(matrix, double, i, j) = (double) rand()/RAND_MAX - 0.5;
+  }
+}
+
+/* Largest magnitude of the entries. */
+static double norm_max (cj_Object *object) {
+  cj_Matrix *matrix = object->matrix;
+  double norm = 0.0;
+  int i, j;
+
+  for (j = 0; j < matrix->n; j++) {
+    for (i = 0; i < matrix->m; i++) norm = fmax(norm, fabs(cj_Matrix_elem(matrix, double, i, j)));
+  }
+  return norm;
+}
+
+int main () {
+  cj_Object *A, *B, *A0, *R, *one, *minus_one;
+  /* 2 x 2 tiles, the last ones partial. */
+  int ma = BLOCK_SIZE + 64, na = ma, mb = na, nb = 16;
+  int *ipiv;
+  int nworker = 4;
+  double residual;
+
+  cj_Init(nworker);
+
+  A = cj_Object_new(CJ_MATRIX);
+  B = cj_Object_new(CJ_MATRIX);
+  A0 = cj_Object_new(CJ_MATRIX);
+  R = cj_Object_new(CJ_MATRIX);
+  one = cj_Object_new(CJ_CONSTANT);
+  minus_one = cj_Object_new(CJ_CONSTANT);
+  cj_Constant_set(one, 1.0);
+  cj_Constant_set(minus_one, -1.0);
+
+  cj_Matrix_set(A, ma, na);
+  cj_Matrix_set(B, mb, nb);
+  cj_Matrix_set(A0, ma, na);
+  cj_Matrix_set(R, mb, nb);
+
+  srand(44);
+  set_random(A);
+  set_random(B);
+  cj_Copy(A, A0);
+  cj_Copy(B, R);
+  ipiv = (int *) malloc(((na + BLOCK_SIZE - 1)/BLOCK_SIZE)*na*sizeof(int));
+
+  /* A -> LU */
+  cj_Lu(A, ipiv);
+  /* B = A^(-1) * B */
+  cj_Lu_solve(A, ipiv, B);
+  /* R = B - A * X */
+  cj_Gemm(CJ_NOTRANS, CJ_NOTRANS, minus_one, A0, B, one, R);
+
+  cj_Sync();
+  cj_Object_acquire(A0);
+  cj_Object_acquire(B);
+  cj_Object_acquire(R);
+  residual = norm_max(R)/(na*norm_max(A0)*norm_max(B));
+  fprintf(stdout, "||B - A X|| / (n ||A|| ||X||) = %.3e\n", residual);
+
+  cj_Term();
+  free(ipiv);
+
+  return (residual < 1e-13) ? 0 : 1;
+}
@@ -0,0 +1,113 @@
+/* 
+ * test_mixed.c
+ * Test file for the mixed-precision Cholesky solve with iterative refinement
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+
+#include <cj.h>
+
+/* Uniform entries in [-0.5, 0.5). */
+static void set_random (cj_Object *object) {
+  cj_Matrix *matrix = object->matrix;
+  int i, j;
+
+  for (j = 0; j < matrix->n; j++) {
+    for (i = 0; i < matrix->m; i++) cj_Matrix_elem(matrix, double, i, j) = (double) rand()/RAND_MAX - 0.5;
+  }
+}
+
+/* A new m x n matrix. */
+static cj_Object *new_matrix (int m, int n) {
+  cj_Object *object = cj_Object_new(CJ_MATRIX);
+  cj_Matrix_set(object, m, n);
+  return object;
+}
+
+/* Largest absolute entry. */
+static double norm_max (cj_Object *object) {
+  cj_Matrix *matrix = object->matrix;
+  double norm = 0.0;
+  int i, j;
+
+  for (j = 0; j < matrix->n; j++) {
+    for (i = 0; i < matrix->m; i++) norm = fmax(norm, fabs(cj_Matrix_elem(matrix, double, i, j)));
+  }
+  return norm;
+}
+
+/* Solve X A = B and check max |B - X A| / (max |A| max |X|). */
+static int check_solve (const char *name, cj_Object *A, cj_Object *B, cj_Object *X, int *iter) {
+  cj_Object *R, *one, *minus_one;
+  int n = A->matrix->m;
+  double residual;
+
+  one = cj_Object_new(CJ_CONSTANT);
+  minus_one = cj_Object_new(CJ_CONSTANT);
+  cj_Constant_set(one, 1.0);
+  cj_Constant_set(minus_one, -1.0);
+
+  *iter = cj_Chol_solve_mixed(A, B, X);
+
+  R = new_matrix(B->matrix->m, n);
+  cj_Copy(B, R);
+  cj_Gemm(CJ_NOTRANS, CJ_NOTRANS, minus_one, X, A, one, R);
+  cj_Sync();
+  cj_Object_acquire(A);
+  cj_Object_acquire(X);
+  cj_Object_acquire(R);
+  residual = norm_max(R)/(norm_max(A)*norm_max(X));
+  fprintf(stdout, "%s: refinement steps = %d, max |B - X A| / (max |A| max |X|) = %.3e\n", name, *iter, residual);
+  return residual < 1e-13;
+}
+
+int main () {
+  cj_Object *A, *C, *V, *B, *X, *Y, *one, *zero;
+  /* A is 2 x 2 tiles, the last ones partial; k right-hand sides as rows. */
+  int n = BLOCK_SIZE + 64, k = 16, r = 8, i, j, iter, fail = 0;
+  int nworker = 4;
+
+  cj_Init(nworker);
+
+  one = cj_Object_new(CJ_CONSTANT);
+  zero = cj_Object_new(CJ_CONSTANT);
+  cj_Constant_set(one, 1.0);
+  cj_Constant_set(zero, 0.0);
+
+  srand(38);
+  A = new_matrix(n, n);
+  C = new_matrix(n, n);
+  V = new_matrix(n, r);
+  B = new_matrix(k, n);
+  X = new_matrix(k, n);
+  Y = new_matrix(k, n);
+  set_random(B);
+
+  /* Well conditioned: symmetric noise and n on the diagonal, so single
+   * precision refinement must converge. */
+  for (j = 0; j < n; j++) {
+    for (i = j; i < n; i++) {
+      cj_Matrix_elem(A->matrix, double, i, j) = (i == j) ? n : (double) rand()/RAND_MAX - 0.5;
+      cj_Matrix_elem(A->matrix, double, j, i) = cj_Matrix_elem(A->matrix, double, i, j);
+    }
+  }
+  if (!check_solve("well conditioned", A, B, X, &iter) || iter < 0) fail ++;
+  cj_Matrix_print(X);
+
+  /* Ill conditioned: C = V V' + 1e-6 I with V n x r, so cond(C) is about 1e8,
+   * beyond 1 / FLT_EPSILON; the single precision factor is useless and the
+   * solve must fall back to double precision. */
+  set_random(V);
+  cj_Gemm(CJ_NOTRANS, CJ_TRANS, one, V, V, zero, C);
+  cj_Sync();
+  cj_Object_acquire(C);
+  for (i = 0; i < n; i++) cj_Matrix_elem(C->matrix, double, i, i) += 1e-6;
+  if (!check_solve("ill conditioned", C, B, Y, &iter) || iter >= 0) fail ++;
+  cj_Matrix_print(Y);
+
+  cj_Term();
+
+  return fail ? 1 : 0;
+}
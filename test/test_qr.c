@@ -0,0 +1,93 @@
+/* 
+ * test_qr.c
+ * Test file for the QR Decomposition routine in the LAPACK
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+
+#include <cj.h>
+
+/* Uniform entries in [-0.5, 0.5). */
+static void set_random (cj_Object *object) {
+  cj_Matrix *matrix = object->matrix;
+  int i, j;
+
+  for (j = 0; j < matrix->n; j++) {
+    for (i = 0; i < matrix->m; i++) cj_Matrix_elem(matrix, double, i, j) = (double) rand()/RAND_MAX - 0.5;
+  }
+}
+
+/* Largest magnitude of the entries. */
+static double norm_max (cj_Object *object) {
+  cj_Matrix *matrix = object->matrix;
+  double norm = 0.0;
+  int i, j;
+
+  for (j = 0; j < matrix->n; j++) {
+    for (i = 0; i < matrix->m; i++) {
+      norm = fmax(norm, fabs(cj_Matrix_elem(matrix->base, double, matrix->offm + i, matrix->offn + j)));
+    }
+  }
+  return norm;
+}
+
+int main () {
+  cj_Object *A, *T, *B, *A0, *R, *S, *X, *XB, *one, *minus_one, *zero;
+  /* 3 x 2 tiles, the last ones partial: a domain of two tile rows chained
+   * by the TS kernels, and a second one merged into it by the TT kernels. */
+  int ma = 2*BLOCK_SIZE + 64, na = BLOCK_SIZE + 16, mb = ma, nb = 16;
+  int nworker = 4;
+  double residual;
+
+  cj_Init(nworker);
+
+  A = cj_Object_new(CJ_MATRIX);
+  T = cj_Object_new(CJ_MATRIX);
+  B = cj_Object_new(CJ_MATRIX);
+  A0 = cj_Object_new(CJ_MATRIX);
+  R = cj_Object_new(CJ_MATRIX);
+  S = cj_Object_new(CJ_MATRIX);
+  X = cj_Object_new(CJ_MATRIX);
+  XB = cj_Object_new(CJ_MATRIX);
+  one = cj_Object_new(CJ_CONSTANT);
+  minus_one = cj_Object_new(CJ_CONSTANT);
+  zero = cj_Object_new(CJ_CONSTANT);
+  cj_Constant_set(one, 1.0);
+  cj_Constant_set(minus_one, -1.0);
+  cj_Constant_set(zero, 0.0);
+
+  cj_Matrix_set(A, ma, na);
+  cj_Matrix_set(B, mb, nb);
+  cj_Matrix_set(A0, ma, na);
+  cj_Matrix_set(R, mb, nb);
+  cj_Matrix_set(S, na, nb);
+
+  srand(45);
+  set_random(A);
+  set_random(B);
+  cj_Copy(A, A0);
+  cj_Copy(B, R);
+
+  /* A -> QR, T is allocated by cj_Qr */
+  cj_Qr(A, T);
+  /* B(0:na-1, :) = argmin ||A * X - B|| */
+  cj_Qr_solve(A, T, B);
+  cj_Matrix_part_2x1(B, X, XB, na, CJ_TOP);
+  /* R = B - A * X, S = A' * R, zero at the least-squares solution */
+  cj_Gemm(CJ_NOTRANS, CJ_NOTRANS, minus_one, A0, X, one, R);
+  cj_Gemm(CJ_TRANS, CJ_NOTRANS, one, A0, R, zero, S);
+
+  cj_Sync();
+  cj_Object_acquire(A0);
+  cj_Object_acquire(B);
+  cj_Object_acquire(R);
+  cj_Object_acquire(S);
+  residual = norm_max(S)/(ma*norm_max(A0)*(norm_max(A0)*norm_max(X) + norm_max(R)));
+  fprintf(stdout, "||A' (B - A X)|| / (m ||A|| (||A|| ||X|| + ||B - A X||)) = %.3e\n", residual);
+
+  cj_Term();
+
+  return (residual < 1e-13) ? 0 : 1;
+}
@@ -1,57 +1,167 @@
 /* 
  * test_syrk.c
- * Test file for the SYRK routine in the BLAS
+ * Test file for the SYRK, SYR2K and SYMM routines in the BLAS
  */
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <math.h>
 
 #include <cj.h>
 
+/* Uniform entries in [-0.5, 0.5). */
+static void set_random (cj_Object *object) {
+  cj_Matrix *matrix = object->matrix;
+  int i, j;
+
+  for (j = 0; j < matrix->n; j++) {
+    for (i = 0; i < matrix->m; i++) cj_Matrix_elem(matrix, double, i, j) = (double) rand()/RAND_MAX - 0.5;
+  }
+}
+
+/* A new m x n matrix. */
+static cj_Object *new_matrix (int m, int n) {
+  cj_Object *object = cj_Object_new(CJ_MATRIX);
+  cj_Matrix_set(object, m, n);
+  return object;
+}
+
+/* Largest difference between C and the reference R on the triangle *uplo,
+ * relative to the largest entry of R; the other triangle must still be C0. A
+ * general C, uplo NULL, is compared in full. */
+static double diff_triangle (const cj_Uplo *uplo, cj_Object *C, cj_Object *R, cj_Object *C0) {
+  cj_Matrix *c = C->matrix;
+  double diff = 0.0, norm = 0.0, value;
+  int i, j;
+
+  for (j = 0; j < c->n; j++) {
+    for (i = 0; i < c->m; i++) {
+      value = cj_Matrix_elem(c, double, i, j);
+      if (uplo == NULL || i == j || (*uplo == CJ_LOWER) == (i > j)) {
+        norm = fmax(norm, fabs(cj_Matrix_elem(R->matrix, double, i, j)));
+        diff = fmax(diff, fabs(value - cj_Matrix_elem(R->matrix, double, i, j)));
+      }
+      else if (value != cj_Matrix_elem(C0->matrix, double, i, j)) return HUGE_VAL;
+    }
+  }
+  return diff/norm;
+}
+
 int main () {
-  cj_Object *A, *B, *C, *D;
-  //int ma = 4, na = 4, mb = na, nb = 4, mc = ma, nc = nb;
-  int ma = 8, na = 8, mb = na, nb = 8, mc = ma, nc = nb;
-  //int ma = 16, na = 16, mb = na, nb = 16, mc = ma, nc = nb;
-  //int ma = 256, na = 256, mb = na, nb = 256, mc = ma, nc = nb;
-  //int ma = 128, na = 128, mb = na, nb = 128, mc = ma, nc = nb;
-  //int ma = 4096, na = 4096, mb = na, nb = 4096, mc = ma, nc = nb;
-  //int ma = 2048, na = 2048, mb = na, nb = 2048, mc = ma, nc = nb;
-  //int ma = 64, na = 64, mb = na, nb = 64, mc = ma, nc = nb;
-  int md = ma, nd = nc;
-  int nworker = 4;
+  cj_Object *A[2], *B[2], *C0, *C[8], *R[4], *S, *Su[2], *Bs[2], *Cs0[2], *Cs[4], *Rs[2];
+  cj_Object *alpha, *beta, *one;
+  /* C and the symmetric S are 2 x 2 tiles, the last ones partial, A and B n x k
+   * or k x n, so the inner loop spans two tiles as well. SYMM multiplies S by
+   * q columns or rows. */
+  int n = BLOCK_SIZE + 64, k = BLOCK_SIZE + 32, q = 96;
+  int nworker = 4, t, u, s, c, i, j, fail = 0;
+  cj_Uplo uplo[2] = {CJ_LOWER, CJ_UPPER};
+  cj_Trans trans[2] = {CJ_NOTRANS, CJ_TRANS};
+  cj_Side side[2] = {CJ_LEFT, CJ_RIGHT};
+  const char *uplo_name[2] = {"lower", "upper"};
+  const char *trans_name[2] = {"notrans", "trans"};
+  const char *side_name[2] = {"left", "right"};
+  double diff;
 
   cj_Init(nworker);
 
-  A = cj_Object_new(CJ_MATRIX);
-  B = cj_Object_new(CJ_MATRIX);
-  C = cj_Object_new(CJ_MATRIX);
-  D = cj_Object_new(CJ_MATRIX);
- 
-  cj_Matrix_set(A, ma, na);
-  cj_Matrix_set(B, mb, nb);
-  cj_Matrix_set(C, mc, nc);
-  cj_Matrix_set(D, md, nd);
-
-  cj_Matrix_set_identity(A);
-  cj_Matrix_set_identity(B);
-  cj_Matrix_set_identity(C);
+  alpha = cj_Object_new(CJ_CONSTANT);
+  beta = cj_Object_new(CJ_CONSTANT);
+  one = cj_Object_new(CJ_CONSTANT);
+  cj_Constant_set(alpha, 0.75);
+  cj_Constant_set(beta, -0.5);
+  cj_Constant_set(one, 1.0);
 
-  /* C = C + A*A' */
-  cj_Syrk_ln(A, C);
-  //cj_Syrk_ln(B, C);
+  srand(43);
+  for (t = 0; t < 2; t++) {
+    A[t] = new_matrix(t ? k : n, t ? n : k);
+    B[t] = new_matrix(t ? k : n, t ? n : k);
+    set_random(A[t]);
+    set_random(B[t]);
+  }
+  C0 = new_matrix(n, n);
+  set_random(C0);
 
-  sleep(2);
+  /* S symmetric in full, Su[u] the triangle uplo[u] of it and noise in the
+   * other one. */
+  S = new_matrix(n, n);
+  for (u = 0; u < 2; u++) Su[u] = new_matrix(n, n);
+  for (j = 0; j < n; j++) {
+    for (i = j; i < n; i++) {
+      cj_Matrix_elem(S->matrix, double, i, j) = (double) rand()/RAND_MAX - 0.5;
+      cj_Matrix_elem(S->matrix, double, j, i) = cj_Matrix_elem(S->matrix, double, i, j);
+    }
+  }
+  for (j = 0; j < n; j++) {
+    for (i = 0; i < n; i++) {
+      for (u = 0; u < 2; u++) {
+        cj_Matrix_elem(Su[u]->matrix, double, i, j) = (i == j || (u == 0) == (i > j)) ?
+          cj_Matrix_elem(S->matrix, double, i, j) : 1e3;
+      }
+    }
+  }
+  for (s = 0; s < 2; s++) {
+    Bs[s] = new_matrix(s ? q : n, s ? n : q);
+    Cs0[s] = new_matrix(s ? q : n, s ? n : q);
+    set_random(Bs[s]);
+    set_random(Cs0[s]);
+  }
 
-  cj_Matrix_distribution_print(C);
-  //cj_Object_acquire(C);
+  /* The references by GEMM on the whole of C */
+  for (t = 0; t < 2; t++) {
+    R[t] = new_matrix(n, n);
+    cj_Copy(C0, R[t]);
+    cj_Gemm(trans[t], trans[1 - t], alpha, A[t], A[t], beta, R[t]);
+    R[2 + t] = new_matrix(n, n);
+    cj_Copy(C0, R[2 + t]);
+    cj_Gemm(trans[t], trans[1 - t], alpha, A[t], B[t], beta, R[2 + t]);
+    cj_Gemm(trans[t], trans[1 - t], alpha, B[t], A[t], one, R[2 + t]);
+  }
+  for (s = 0; s < 2; s++) {
+    Rs[s] = new_matrix(s ? q : n, s ? n : q);
+    cj_Copy(Cs0[s], Rs[s]);
+    if (s == 0) cj_Gemm(CJ_NOTRANS, CJ_NOTRANS, alpha, S, Bs[s], beta, Rs[s]);
+    else cj_Gemm(CJ_NOTRANS, CJ_NOTRANS, alpha, Bs[s], S, beta, Rs[s]);
+  }
 
-  sleep(2);
+  /* SYRK and SYR2K for every uplo and trans, SYMM for every side and uplo */
+  for (c = 0; c < 4; c++) {
+    u = c/2; t = c%2;
+    C[c] = new_matrix(n, n);
+    cj_Copy(C0, C[c]);
+    cj_Syrk(uplo[u], trans[t], alpha, A[t], beta, C[c]);
+    C[4 + c] = new_matrix(n, n);
+    cj_Copy(C0, C[4 + c]);
+    cj_Syr2k(uplo[u], trans[t], alpha, A[t], B[t], beta, C[4 + c]);
+  }
+  for (c = 0; c < 4; c++) {
+    s = c/2; u = c%2;
+    Cs[c] = new_matrix(s ? q : n, s ? n : q);
+    cj_Copy(Cs0[s], Cs[c]);
+    cj_Symm(side[s], uplo[u], alpha, Su[u], Bs[s], beta, Cs[c]);
+  }
 
-  cj_Matrix_distribution_print(C);
-  cj_Matrix_print(C);
+  cj_Sync();
+  cj_Object_acquire(C0);
+  for (t = 0; t < 4; t++) cj_Object_acquire(R[t]);
+  for (c = 0; c < 8; c++) {
+    u = (c%4)/2; t = c%2;
+    cj_Object_acquire(C[c]);
+    diff = diff_triangle(&uplo[u], C[c], R[(c/4)*2 + t], C0);
+    fprintf(stdout, "%-5s %-5s %-7s: max |C - GEMM reference| / max |C| = %.3e\n",
+        (c < 4) ? "syrk" : "syr2k", uplo_name[u], trans_name[t], diff);
+    if (!(diff < 1e-14)) fail ++;
+  }
+  for (c = 0; c < 4; c++) {
+    s = c/2; u = c%2;
+    cj_Object_acquire(Cs[c]);
+    cj_Object_acquire(Rs[s]);
+    diff = diff_triangle(NULL, Cs[c], Rs[s], NULL);
+    fprintf(stdout, "symm  %-5s %-5s: max |C - GEMM reference| / max |C| = %.3e\n", side_name[s], uplo_name[u], diff);
+    if (!(diff < 1e-14)) fail ++;
+  }
 
   cj_Term();
 
-  return 0;
+  return fail ? 1 : 0;
 }
@@ -1,57 +1,151 @@
 /* 
  * test_trsm.c
- * Test file for the TRSM routine in the BLAS
+ * Test file for the TRSM and TRMM routines in the BLAS
  */
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <math.h>
 
 #include <cj.h>
 
-int main () {
-  cj_Object *A, *B, *C, *D;
-  //int ma = 4, na = 4, mb = na, nb = 4, mc = ma, nc = nb;
-  //int ma = 8, na = 8, mb = na, nb = 8, mc = ma, nc = nb;
-  int ma = 16, na = 16, mb = na, nb = 16, mc = ma, nc = nb;
-  //int ma = 256, na = 256, mb = na, nb = 256, mc = ma, nc = nb;
-  //int ma = 128, na = 128, mb = na, nb = 128, mc = ma, nc = nb;
-  //int ma = 4096, na = 4096, mb = na, nb = 4096, mc = ma, nc = nb;
-  //int ma = 2048, na = 2048, mb = na, nb = 2048, mc = ma, nc = nb;
-  //int ma = 64, na = 64, mb = na, nb = 64, mc = ma, nc = nb;
-  int md = ma, nd = nc;
-  int nworker = 4;
+/* Uniform entries in [-0.5, 0.5). */
+static void set_random (cj_Object *object) {
+  cj_Matrix *matrix = object->matrix;
+  int i, j;
 
-  cj_Init(nworker);
+  for (j = 0; j < matrix->n; j++) {
+    for (i = 0; i < matrix->m; i++) cj_Matrix_elem(matrix, double, i, j) = (double) rand()/RAND_MAX - 0.5;
+  }
+}
 
-  A = cj_Object_new(CJ_MATRIX);
-  B = cj_Object_new(CJ_MATRIX);
-  C = cj_Object_new(CJ_MATRIX);
-  D = cj_Object_new(CJ_MATRIX);
- 
-  cj_Matrix_set(A, ma, na);
-  cj_Matrix_set(B, mb, nb);
-  cj_Matrix_set(C, mc, nc);
-  cj_Matrix_set(D, md, nd);
+/* Both triangles random and small, the diagonal about 2, so that either
+ * triangle is well conditioned with its diagonal or a unit one. */
+static void set_triangles (cj_Object *object) {
+  cj_Matrix *matrix = object->matrix;
+  int i, j;
+
+  for (j = 0; j < matrix->n; j++) {
+    for (i = 0; i < matrix->m; i++) {
+      cj_Matrix_elem(matrix, double, i, j) = ((double) rand()/RAND_MAX - 0.5)/matrix->n + ((i == j) ? 2.0 : 0.0);
+    }
+  }
+}
+
+/* Element (i, j) of op(A) for the triangle uplo of the n x n array a. */
+static double op_elem (const double *a, int n, cj_Uplo uplo, cj_Trans trans, cj_Diag diag, int i, int j) {
+  if (trans == CJ_TRANS) { int s = i; i = j; j = s; }
+  if (i == j) return (diag == CJ_UNIT) ? 1.0 : a[i + (size_t) j*n];
+  if ((uplo == CJ_LOWER) == (i > j)) return a[i + (size_t) j*n];
+  return 0.0;
+}
+
+/* Largest magnitude of the len entries of x, or of x - y if y is set. */
+static double norm_max (const double *x, const double *y, size_t len) {
+  double norm = 0.0;
+  size_t i;
 
-  cj_Matrix_set_lowertril_one(A);
-  //cj_Matrix_set_2identity(A);
-  cj_Matrix_set_identity(B);
-  cj_Matrix_set_identity(C);
+  for (i = 0; i < len; i++) norm = fmax(norm, fabs(x[i] - (y ? y[i] : 0.0)));
+  return norm;
+}
 
-  /* B = B * tril(A') */
-  cj_Trsm_rlt(A, B);
+/* The elements of a matrix in a column major array. */
+static double *host_copy (cj_Object *object) {
+  cj_Matrix *matrix = object->matrix;
+  double *buff = (double *) malloc((size_t) matrix->m*matrix->n*sizeof(double));
+  int i, j;
 
-  sleep(2);
+  cj_Object_acquire(object);
+  for (j = 0; j < matrix->n; j++) {
+    for (i = 0; i < matrix->m; i++) buff[i + (size_t) j*matrix->m] = cj_Matrix_elem(matrix, double, i, j);
+  }
+  return buff;
+}
 
-  cj_Matrix_distribution_print(B);
-  //cj_Object_acquire(C);
+int main () {
+  cj_Object *A, *B[2], *X[16], *Y[16], *alpha, *alpha_inv;
+  /* A is 2 x 2 tiles, the last ones partial, B 2 x 1 (left) or 1 x 2 (right) */
+  int n = BLOCK_SIZE + 64, p = 32;
+  int nworker = 4, c, s, i, j, l, m, nb, fail = 0;
+  cj_Side side[2] = {CJ_LEFT, CJ_RIGHT};
+  cj_Uplo uplo[2] = {CJ_LOWER, CJ_UPPER};
+  cj_Trans trans[2] = {CJ_NOTRANS, CJ_TRANS};
+  cj_Diag diag[2] = {CJ_NONUNIT, CJ_UNIT};
+  double alpha_value = 1.5, *a, *t, *b[2], *x[16], *y[16], *r, residual, inverse;
 
-  sleep(2);
+  cj_Init(nworker);
 
-  cj_Matrix_distribution_print(B);
-  cj_Matrix_print(B);
+  alpha = cj_Object_new(CJ_CONSTANT);
+  alpha_inv = cj_Object_new(CJ_CONSTANT);
+  cj_Constant_set(alpha, alpha_value);
+  cj_Constant_set(alpha_inv, 1.0/alpha_value);
 
+  A = cj_Object_new(CJ_MATRIX);
+  cj_Matrix_set(A, n, n);
+  for (s = 0; s < 2; s++) {
+    B[s] = cj_Object_new(CJ_MATRIX);
+    cj_Matrix_set(B[s], s ? p : n, s ? n : p);
+  }
+
+  srand(42);
+  set_triangles(A);
+  set_random(B[0]);
+  set_random(B[1]);
+
+  /* For every side, uplo, trans and diag: X = alpha * op(A)^(-1) * B or
+   * alpha * B * op(A)^(-1), then Y = alpha^(-1) * op(A) * X or alpha^(-1) *
+   * X * op(A), which is B again. */
+  for (c = 0; c < 16; c++) {
+    s = c/8;
+    X[c] = cj_Object_new(CJ_MATRIX);
+    Y[c] = cj_Object_new(CJ_MATRIX);
+    cj_Matrix_set(X[c], B[s]->matrix->m, B[s]->matrix->n);
+    cj_Matrix_set(Y[c], B[s]->matrix->m, B[s]->matrix->n);
+    cj_Copy(B[s], X[c]);
+    cj_Trsm(side[s], uplo[(c/4)%2], trans[(c/2)%2], diag[c%2], alpha, A, X[c]);
+    cj_Copy(X[c], Y[c]);
+    cj_Trmm(side[s], uplo[(c/4)%2], trans[(c/2)%2], diag[c%2], alpha_inv, A, Y[c]);
+  }
+
+  /* The results are checked on the host once the workers have stopped. */
+  cj_Sync();
+  a = host_copy(A);
+  for (s = 0; s < 2; s++) b[s] = host_copy(B[s]);
+  for (c = 0; c < 16; c++) {
+    x[c] = host_copy(X[c]);
+    y[c] = host_copy(Y[c]);
+  }
   cj_Term();
 
-  return 0;
+  t = (double *) malloc((size_t) n*n*sizeof(double));
+  r = (double *) malloc((size_t) n*p*sizeof(double));
+  for (c = 0; c < 16; c++) {
+    s = c/8;
+    m = s ? p : n; nb = s ? n : p;
+    /* r = op(A) * X or X * op(A), against alpha * B */
+    for (j = 0; j < n; j++) {
+      for (i = 0; i < n; i++) t[i + (size_t) j*n] = op_elem(a, n, uplo[(c/4)%2], trans[(c/2)%2], diag[c%2], i, j);
+    }
+    for (i = 0; i < m*nb; i++) r[i] = -alpha_value*b[s][i];
+    for (j = 0; j < nb; j++) {
+      for (l = 0; l < n; l++) {
+        if (s == 0) {
+          for (i = 0; i < m; i++) r[i + (size_t) j*m] += t[i + (size_t) l*n]*x[c][l + (size_t) j*m];
+        }
+        else {
+          for (i = 0; i < m; i++) r[i + (size_t) j*m] += x[c][i + (size_t) l*m]*t[l + (size_t) j*n];
+        }
+      }
+    }
+    residual = norm_max(r, NULL, (size_t) m*nb)/(n*norm_max(a, NULL, (size_t) n*n)*norm_max(x[c], NULL, (size_t) m*nb));
+    inverse = norm_max(y[c], b[s], (size_t) m*nb)/norm_max(b[s], NULL, (size_t) m*nb);
+    fprintf(stdout, "%-5s %-5s %-7s %-7s: ||op(A) X - alpha B|| = %.3e, ||trmm(trsm(B)) - B|| = %.3e\n",
+        s ? "right" : "left", ((c/4)%2) ? "upper" : "lower", ((c/2)%2) ? "trans" : "notrans",
+        (c%2) ? "unit" : "nonunit", residual, inverse);
+    if (!(residual < 1e-13 && inverse < 1e-13)) fail ++;
+    free(x[c]); free(y[c]);
+  }
+  free(a); free(b[0]); free(b[1]); free(t); free(r);
+
+  return fail ? 1 : 0;
 }
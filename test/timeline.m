@@ -0,0 +1,308 @@
+figure;
+worker0 = { 
+};
+for i = 1:length(worker0)
+  tmp = worker0{i, 3};
+  x = [tmp(1, 1) tmp(1, 2) tmp(1, 2) tmp(1, 1)];
+  if (strcmp(worker0{i, 1}, 'FETCH'))
+    y = [0 0 0+0.4 0+0.4];
+  else
+    y = [0-0.4 0-0.4 0 0];
+  end
+  c = worker0{i, 2};
+  patch(x, y, c);
+end
+worker1 = { 
+'FETCH' [0 1 0] [6.714753 6.714758]
+'TASK_RUN' [1 0 0] [6.714759 7.061482]
+'FETCH' [0 1 0] [7.061502 7.061505]
+'TASK_RUN' [1 0 0] [7.061507 7.816197]
+'FETCH' [0 1 0] [7.816220 7.816224]
+'TASK_RUN' [1 0 0] [7.816226 8.824939]
+'FETCH' [0 1 0] [8.824962 8.824965]
+'TASK_RUN' [1 0 0] [8.824967 9.836586]
+'FETCH' [0 1 0] [9.838964 9.838968]
+'TASK_RUN' [1 0 0] [9.838974 10.639917]
+'FETCH' [0 1 0] [10.649249 10.649255]
+'TASK_RUN' [1 0 0] [10.649258 12.432073]
+'FETCH' [0 1 0] [12.432085 12.432088]
+'TASK_RUN' [1 0 0] [12.432092 14.142588]
+'FETCH' [0 1 0] [14.150670 14.150676]
+'TASK_RUN' [1 0 0] [14.150680 14.794441]
+'FETCH' [0 1 0] [14.802585 14.802589]
+'TASK_RUN' [1 0 0] [14.802594 16.187845]
+'FETCH' [0 1 0] [16.187860 16.187864]
+'TASK_RUN' [1 0 0] [16.187868 17.041771]
+'FETCH' [0 1 0] [17.046848 17.046852]
+'TASK_RUN' [1 0 0] [17.046854 18.858030]
+'FETCH' [0 1 0] [18.858049 18.858055]
+'TASK_RUN' [1 0 0] [18.858057 20.538296]
+'FETCH' [0 1 0] [20.538311 20.538313]
+'TASK_RUN' [1 0 0] [20.538317 20.859056]
+'FETCH' [0 1 0] [20.867632 20.867638]
+'TASK_RUN' [1 0 0] [20.867641 21.149748]
+'FETCH' [0 1 0] [21.151493 21.151497]
+'TASK_RUN' [1 0 0] [21.151497 21.932100]
+'FETCH' [0 1 0] [21.940256 21.940260]
+'TASK_RUN' [1 0 0] [21.940264 22.611305]
+'FETCH' [0 1 0] [22.616039 22.616045]
+'TASK_RUN' [1 0 0] [22.616049 23.311672]
+'FETCH' [0 1 0] [23.318081 23.318085]
+'TASK_RUN' [1 0 0] [23.318089 24.015936]
+'FETCH' [0 1 0] [24.024263 24.024267]
+'TASK_RUN' [1 0 0] [24.024271 25.468220]
+'FETCH' [0 1 0] [25.468233 25.468237]
+'TASK_RUN' [1 0 0] [25.468239 26.140324]
+'FETCH' [0 1 0] [26.148977 26.148983]
+'TASK_RUN' [1 0 0] [26.148985 27.611515]
+'FETCH' [0 1 0] [27.611530 27.611536]
+'TASK_RUN' [1 0 0] [27.611536 29.048031]
+'FETCH' [0 1 0] [29.054405 29.054407]
+'TASK_RUN' [1 0 0] [29.054409 29.791084]
+'FETCH' [0 1 0] [29.795567 29.795572]
+'TASK_RUN' [1 0 0] [29.795572 30.615555]
+'FETCH' [0 1 0] [30.615572 30.615576]
+'TASK_RUN' [1 0 0] [30.615580 31.850838]
+'FETCH' [0 1 0] [31.850855 31.850859]
+'TASK_RUN' [1 0 0] [31.850859 32.550297]
+'FETCH' [0 1 0] [32.558392 32.558395]
+'TASK_RUN' [1 0 0] [32.558399 33.369453]
+'FETCH' [0 1 0] [33.375679 33.375687]
+'TASK_RUN' [1 0 0] [33.375687 34.959667]
+'FETCH' [0 1 0] [34.959686 34.959690]
+'TASK_RUN' [1 0 0] [34.959694 35.801689]
+'FETCH' [0 1 0] [35.804871 35.804878]
+'TASK_RUN' [1 0 0] [35.804878 37.322788]
+'TASK_RUN' [1 0 0] [37.322807 37.960434]
+'FETCH' [0 1 0] [37.960449 37.960453]
+'TASK_RUN' [1 0 0] [37.960457 38.296879]
+'FETCH' [0 1 0] [38.302193 38.302200]
+'TASK_RUN' [1 0 0] [38.302200 39.791756]
+'FETCH' [0 1 0] [40.195000 40.195007]
+'TASK_RUN' [1 0 0] [40.195007 41.069893]
+'FETCH' [0 1 0] [41.961327 41.961330]
+'TASK_RUN' [1 0 0] [41.961330 42.339699]
+'FETCH' [0 1 0] [42.733433 42.733437]
+'TASK_RUN' [1 0 0] [42.733437 43.471397]
+'FETCH' [0 1 0] [44.256824 44.256828]
+'TASK_RUN' [1 0 0] [44.256832 44.548985]
+};
+for i = 1:length(worker1)
+  tmp = worker1{i, 3};
+  x = [tmp(1, 1) tmp(1, 2) tmp(1, 2) tmp(1, 1)];
+  if (strcmp(worker1{i, 1}, 'FETCH'))
+    y = [1 1 1+0.4 1+0.4];
+  else
+    y = [1-0.4 1-0.4 1 1];
+  end
+  c = worker1{i, 2};
+  patch(x, y, c);
+end
+worker2 = { 
+'FETCH' [0 1 0] [6.730830 6.730834]
+'TASK_RUN' [1 0 0] [6.730835 7.069903]
+'FETCH' [0 1 0] [7.069922 7.069924]
+'TASK_RUN' [1 0 0] [7.069926 8.160652]
+'FETCH' [0 1 0] [8.169797 8.169800]
+'TASK_RUN' [1 0 0] [8.169805 8.928202]
+'FETCH' [0 1 0] [8.936453 8.936458]
+'TASK_RUN' [1 0 0] [8.936463 9.965410]
+'FETCH' [0 1 0] [9.969422 9.969427]
+'TASK_RUN' [1 0 0] [9.969430 11.480379]
+'FETCH' [0 1 0] [11.489799 11.489803]
+'TASK_RUN' [1 0 0] [11.489811 12.287442]
+'FETCH' [0 1 0] [12.293003 12.293008]
+'TASK_RUN' [1 0 0] [12.293012 13.999625]
+'FETCH' [0 1 0] [13.999640 13.999642]
+'TASK_RUN' [1 0 0] [13.999647 15.405917]
+'FETCH' [0 1 0] [15.408380 15.408384]
+'TASK_RUN' [1 0 0] [15.408389 16.988497]
+'FETCH' [0 1 0] [16.994892 16.994896]
+'TASK_RUN' [1 0 0] [16.994900 17.756699]
+'FETCH' [0 1 0] [17.763151 17.763157]
+'TASK_RUN' [1 0 0] [17.763157 19.614733]
+'FETCH' [0 1 0] [19.623741 19.623749]
+'TASK_RUN' [1 0 0] [19.623749 21.140556]
+'FETCH' [0 1 0] [21.143484 21.143488]
+'TASK_RUN' [1 0 0] [21.143488 21.919203]
+'FETCH' [0 1 0] [21.924288 21.924294]
+'TASK_RUN' [1 0 0] [21.924295 22.604097]
+'FETCH' [0 1 0] [22.604115 22.604118]
+'TASK_RUN' [1 0 0] [22.604120 23.295759]
+'FETCH' [0 1 0] [23.302082 23.302088]
+'TASK_RUN' [1 0 0] [23.302092 24.658371]
+'FETCH' [0 1 0] [24.658384 24.658388]
+'TASK_RUN' [1 0 0] [24.658392 25.446598]
+'FETCH' [0 1 0] [25.446611 25.446615]
+'TASK_RUN' [1 0 0] [25.446617 26.855654]
+'FETCH' [0 1 0] [26.863808 26.863813]
+'TASK_RUN' [1 0 0] [26.863815 28.278980]
+'FETCH' [0 1 0] [28.278992 28.278996]
+'TASK_RUN' [1 0 0] [28.278996 28.593346]
+'FETCH' [0 1 0] [28.598427 28.598433]
+'TASK_RUN' [1 0 0] [28.598433 28.922913]
+'FETCH' [0 1 0] [28.922932 28.922935]
+'TASK_RUN' [1 0 0] [28.922937 29.666080]
+'FETCH' [0 1 0] [29.670488 29.670494]
+'TASK_RUN' [1 0 0] [29.670496 30.503508]
+'FETCH' [0 1 0] [30.503523 30.503527]
+'TASK_RUN' [1 0 0] [30.503531 31.135832]
+'FETCH' [0 1 0] [31.141237 31.141241]
+'TASK_RUN' [1 0 0] [31.141245 32.423553]
+'FETCH' [0 1 0] [32.430389 32.430393]
+'TASK_RUN' [1 0 0] [32.430397 33.248165]
+'FETCH' [0 1 0] [33.253773 33.253777]
+'TASK_RUN' [1 0 0] [33.253780 34.828327]
+'FETCH' [0 1 0] [34.830345 34.830349]
+'TASK_RUN' [1 0 0] [34.830349 35.686401]
+'FETCH' [0 1 0] [35.694489 35.694496]
+'TASK_RUN' [1 0 0] [35.694496 36.531033]
+'FETCH' [0 1 0] [36.531872 36.531876]
+'TASK_RUN' [1 0 0] [36.531876 37.870594]
+'FETCH' [0 1 0] [37.876610 37.876614]
+'TASK_RUN' [1 0 0] [37.876614 38.676407]
+'FETCH' [0 1 0] [38.682823 38.682831]
+'TASK_RUN' [1 0 0] [38.682831 40.177242]
+'FETCH' [0 1 0] [41.072010 41.072014]
+'TASK_RUN' [1 0 0] [41.072014 41.954758]
+'FETCH' [0 1 0] [43.484848 43.484856]
+'TASK_RUN' [1 0 0] [43.484856 44.242687]
+};
+for i = 1:length(worker2)
+  tmp = worker2{i, 3};
+  x = [tmp(1, 1) tmp(1, 2) tmp(1, 2) tmp(1, 1)];
+  if (strcmp(worker2{i, 1}, 'FETCH'))
+    y = [2 2 2+0.4 2+0.4];
+  else
+    y = [2-0.4 2-0.4 2 2];
+  end
+  c = worker2{i, 2};
+  patch(x, y, c);
+end
+worker3 = { 
+'FETCH' [0 1 0] [7.065505 7.065511]
+'TASK_RUN' [1 0 0] [7.065513 7.832364]
+'FETCH' [0 1 0] [7.834072 7.834076]
+'TASK_RUN' [1 0 0] [7.834079 8.793886]
+'FETCH' [0 1 0] [8.796803 8.796808]
+'TASK_RUN' [1 0 0] [8.796811 9.571459]
+'FETCH' [0 1 0] [9.571485 9.571488]
+'TASK_RUN' [1 0 0] [9.571492 10.508214]
+'FETCH' [0 1 0] [10.510227 10.510233]
+'TASK_RUN' [1 0 0] [10.510237 11.321118]
+'FETCH' [0 1 0] [11.323756 11.323761]
+'TASK_RUN' [1 0 0] [11.323765 13.096880]
+'FETCH' [0 1 0] [13.102015 13.102021]
+'TASK_RUN' [1 0 0] [13.102026 14.563990]
+'FETCH' [0 1 0] [14.569180 14.569185]
+'TASK_RUN' [1 0 0] [14.569190 16.079319]
+'FETCH' [0 1 0] [16.082363 16.082367]
+'TASK_RUN' [1 0 0] [16.082373 16.942984]
+'FETCH' [0 1 0] [16.943001 16.943005]
+'TASK_RUN' [1 0 0] [16.943007 18.452707]
+'FETCH' [0 1 0] [18.452724 18.452728]
+'TASK_RUN' [1 0 0] [18.452728 20.161411]
+'FETCH' [0 1 0] [20.161432 20.161434]
+'TASK_RUN' [1 0 0] [20.161436 21.757061]
+'FETCH' [0 1 0] [21.757076 21.757080]
+'TASK_RUN' [1 0 0] [21.757082 22.485723]
+'FETCH' [0 1 0] [22.493914 22.493919]
+'TASK_RUN' [1 0 0] [22.493923 23.181553]
+'FETCH' [0 1 0] [23.190231 23.190235]
+'TASK_RUN' [1 0 0] [23.190237 23.911489]
+'FETCH' [0 1 0] [23.911510 23.911512]
+'TASK_RUN' [1 0 0] [23.911516 25.373461]
+'FETCH' [0 1 0] [25.378195 25.378199]
+'TASK_RUN' [1 0 0] [25.378202 26.708336]
+'FETCH' [0 1 0] [26.717205 26.717213]
+'TASK_RUN' [1 0 0] [26.717213 27.464104]
+'FETCH' [0 1 0] [27.464115 27.464119]
+'TASK_RUN' [1 0 0] [27.464121 28.876612]
+'FETCH' [0 1 0] [28.882198 28.882204]
+'TASK_RUN' [1 0 0] [28.882208 29.621698]
+'FETCH' [0 1 0] [29.626642 29.626648]
+'TASK_RUN' [1 0 0] [29.626648 30.460293]
+'FETCH' [0 1 0] [30.463377 30.463383]
+'TASK_RUN' [1 0 0] [30.463385 31.121031]
+'FETCH' [0 1 0] [31.129244 31.129248]
+'TASK_RUN' [1 0 0] [31.129250 32.363468]
+'FETCH' [0 1 0] [32.363483 32.363487]
+'TASK_RUN' [1 0 0] [32.363487 33.933262]
+'FETCH' [0 1 0] [33.943024 33.943027]
+'TASK_RUN' [1 0 0] [33.943031 34.771885]
+'FETCH' [0 1 0] [34.774712 34.774715]
+'TASK_RUN' [1 0 0] [34.774719 36.410896]
+'TASK_RUN' [1 0 0] [36.411877 37.133194]
+'FETCH' [0 1 0] [37.135895 37.135899]
+'TASK_RUN' [1 0 0] [37.135902 38.541405]
+'FETCH' [0 1 0] [38.550838 38.550842]
+'TASK_RUN' [1 0 0] [38.550842 39.377258]
+'FETCH' [0 1 0] [39.383625 39.383633]
+'TASK_RUN' [1 0 0] [39.383633 40.117374]
+'FETCH' [0 1 0] [41.076008 41.076012]
+'TASK_RUN' [1 0 0] [41.076015 42.724903]
+};
+for i = 1:length(worker3)
+  tmp = worker3{i, 3};
+  x = [tmp(1, 1) tmp(1, 2) tmp(1, 2) tmp(1, 1)];
+  if (strcmp(worker3{i, 1}, 'FETCH'))
+    y = [3 3 3+0.4 3+0.4];
+  else
+    y = [3-0.4 3-0.4 3 3];
+  end
+  c = worker3{i, 2};
+  patch(x, y, c);
+end
+worker4 = { 
+};
+for i = 1:length(worker4)
+  tmp = worker4{i, 3};
+  x = [tmp(1, 1) tmp(1, 2) tmp(1, 2) tmp(1, 1)];
+  if (strcmp(worker4{i, 1}, 'FETCH'))
+    y = [4 4 4+0.4 4+0.4];
+  else
+    y = [4-0.4 4-0.4 4 4];
+  end
+  c = worker4{i, 2};
+  patch(x, y, c);
+end
+worker5 = { 
+};
+for i = 1:length(worker5)
+  tmp = worker5{i, 3};
+  x = [tmp(1, 1) tmp(1, 2) tmp(1, 2) tmp(1, 1)];
+  if (strcmp(worker5{i, 1}, 'FETCH'))
+    y = [5 5 5+0.4 5+0.4];
+  else
+    y = [5-0.4 5-0.4 5 5];
+  end
+  c = worker5{i, 2};
+  patch(x, y, c);
+end
+worker6 = { 
+};
+for i = 1:length(worker6)
+  tmp = worker6{i, 3};
+  x = [tmp(1, 1) tmp(1, 2) tmp(1, 2) tmp(1, 1)];
+  if (strcmp(worker6{i, 1}, 'FETCH'))
+    y = [6 6 6+0.4 6+0.4];
+  else
+    y = [6-0.4 6-0.4 6 6];
+  end
+  c = worker6{i, 2};
+  patch(x, y, c);
+end
+worker7 = { 
+};
+for i = 1:length(worker7)
+  tmp = worker7{i, 3};
+  x = [tmp(1, 1) tmp(1, 2) tmp(1, 2) tmp(1, 1)];
+  if (strcmp(worker7{i, 1}, 'FETCH'))
+    y = [7 7 7+0.4 7+0.4];
+  else
+    y = [7-0.4 7-0.4 7 7];
+  end
+  c = worker7{i, 2};
+  patch(x, y, c);
+end
+grid;
\ No newline at end of file